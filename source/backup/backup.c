@@ -0,0 +1,708 @@
+#include "backup.h"
+#include "progress.h"
+#include "upload.h"
+#include "manifest.h"
+#include "journal.h"
+#include "throttle.h"
+#include "dedup.h"
+#include "pack.h"
+#include "snapshot.h"
+#include "trigger.h"
+#include "../util/hash.h"
+#include "../util/log.h"
+#include "../util/fspool.h"
+#include "../util/service.h"
+#include "../util/mempool.h"
+#include "../util/metrics.h"
+#include "../util/threading.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define BACKUP_PATH_MAX 512
+#define BACKUP_HASH_BUFFER_SIZE 0x10000 // 没有缓冲池时的读块大小
+#define BACKUP_BUFFER_WAIT_NS (10 * 1000000000ULL)
+
+static Throttle s_throttle;
+static bool s_throttle_ready;
+static UploadPool s_upload_pool;       // 两次备份之间保留的 FTP 连接（只由备份线程访问）
+static BufPool s_io_pool;              // 启动时预留的 I/O 缓冲块（上传环形缓冲、哈希读块）
+static bool s_io_pool_ready;
+static MemArena s_run_arena;           // 每次备份的路径与任务队列，备份开始时复位
+static bool s_memory_ready;
+
+static void backup_throttle_init(const AppConfig *cfg) {
+    if (s_throttle_ready) return;
+    throttle_init(&s_throttle, (u64)cfg->bg_disk_kbps * 1024, (u64)cfg->bg_net_kbps * 1024);
+    s_throttle_ready = true;
+}
+
+// 缓冲池按启动时的 upload_buffer_kb 切块；预留失败时照常运行，缓冲改为临时在堆上申请
+static void backup_memory_init(const AppConfig *cfg) {
+    if (s_memory_ready) return;
+    u32 blocks = cfg->io_pool_kb / cfg->upload_buffer_kb;
+    Result rc = bufpool_init(&s_io_pool, cfg->upload_buffer_kb * 1024, blocks < 2 ? 2 : blocks);
+    s_io_pool_ready = R_SUCCEEDED(rc);
+    if (!s_io_pool_ready) log_warning("无法预留 I/O 缓冲池（%u KB）: 0x%x", cfg->io_pool_kb, rc);
+    mem_arena_init(&s_run_arena, (size_t)cfg->run_arena_kb * 1024);
+    s_memory_ready = true;
+}
+
+static void backup_memory_exit(void) {
+    if (!s_memory_ready) return;
+    if (s_io_pool_ready) bufpool_exit(&s_io_pool);
+    mem_arena_exit(&s_run_arena);
+    s_io_pool_ready = s_memory_ready = false;
+}
+
+static void backup_log_memory(void) {
+    const MemArena *a = &s_run_arena;
+    if (s_io_pool_ready) {
+        BufPoolStats ps;
+        bufpool_stats(&s_io_pool, &ps);
+        log_info("内存：I/O 缓冲池 %u × %u KB，峰值占用 %u 块，等待 %llu 次（%llu ms），申请落空 %llu 次；运行区本次 %zu KB，峰值 %zu KB / 预算 %zu KB，超出 %llu 次",
+                 ps.count, ps.block_size / 1024, ps.high_water, (unsigned long long)ps.waits,
+                 (unsigned long long)(ps.wait_ns / 1000000), (unsigned long long)ps.failures,
+                 a->used / 1024, a->high_water / 1024, a->budget / 1024, (unsigned long long)a->failures);
+    } else {
+        log_info("内存：运行区本次 %zu KB，峰值 %zu KB / 预算 %zu KB，超出 %llu 次",
+                 a->used / 1024, a->high_water / 1024, a->budget / 1024, (unsigned long long)a->failures);
+    }
+}
+
+// 只读不传：size 相同但 mtime 变了的文件先比较内容哈希（例如只被 touch 过），读一遍远比上传便宜
+static bool hash_local_file(const char *path, u64 *out) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    size_t size = s_io_pool_ready ? s_io_pool.block_size : BACKUP_HASH_BUFFER_SIZE;
+    u8 *buf = s_io_pool_ready ? bufpool_acquire(&s_io_pool, BACKUP_BUFFER_WAIT_NS) : malloc(size);
+    bool ok = buf != NULL;
+    FastHash h;
+    fasthash_init(&h);
+    while (ok) {
+        throttle_acquire(&s_throttle, ThrottleKind_Disk, size);
+        fspool_enter(FsRole_Data);
+        ssize_t n = read(fd, buf, size);
+        fspool_leave(FsRole_Data);
+        if (n < 0) ok = false;
+        if (n <= 0) break;
+        fasthash_update(&h, buf, (size_t)n);
+    }
+    if (s_io_pool_ready) bufpool_release(&s_io_pool, buf);
+    else free(buf);
+    close(fd);
+    if (ok) *out = fasthash_final(&h);
+    return ok;
+}
+
+// 换了备份源、目标或压缩设置时旧清单失效
+static u64 backup_target_hash(const AppConfig *cfg) {
+    FastHash h;
+    fasthash_init(&h);
+    fasthash_update(&h, cfg->backup_source, strlen(cfg->backup_source) + 1);
+    fasthash_update(&h, cfg->ftp_url, strlen(cfg->ftp_url) + 1);
+    fasthash_update(&h, &cfg->compression, sizeof(cfg->compression)); // 压缩与否远端文件名不同
+    fasthash_update(&h, &cfg->pack_small_kb, sizeof(cfg->pack_small_kb)); // 阈值变了哪些文件在归档里也变了
+    return fasthash_final(&h);
+}
+
+// 小文件打包：每个顶层目录一组（根目录下的文件自成一组），组内的小文件打进 <组>/.smallfiles.tar。
+// 远端归档总是对应组内当前全部小文件：任何一个变了（或增删、越过阈值）整组重新打包，
+// 所以在组目录下解开归档即可覆盖镜像里可能残留的旧版本
+typedef struct {
+    char *path;             // 远端归档路径
+    PackArchive archive;
+    u32 first;              // 成员在 BackupPackPlan.members 中的起点
+    u32 count;
+    u32 prefix_len;
+} BackupPack;
+
+typedef struct {
+    u64 limit;              // 小文件上限（字节）；0 = 不打包
+    MemArena *arena;        // 成员表与归档路径的来源
+    PackMember *members;
+    u32 member_count;
+    BackupPack *packs;      // 需要重新上传的归档
+    u32 count;
+    u32 capacity;
+    u32 groups_clean;       // 归档仍是最新、整组跳过
+    u32 files_clean;
+} BackupPackPlan;
+
+// 组目录部分的长度（含结尾 /）；根目录下的文件为 0
+static u32 backup_group_len(const char *path) {
+    const char *slash = strchr(path, '/');
+    return slash ? (u32)(slash - path + 1) : 0;
+}
+
+static bool backup_packable(const BackupPackPlan *p, const BackupFile *f) {
+    return p->limit && f->size <= p->limit && pack_name_fits(f->path + backup_group_len(f->path));
+}
+
+// 收集 [start, end) 中属于该组的小文件；归档仍是最新（成员的路径、大小、修改时间都没变，
+// 且上次都成功打进了归档）时沿用旧条目，否则排进待上传。组里已没有小文件但远端还有归档时
+// 上传一个空归档，免得旧归档在恢复时盖掉后来单独上传的文件
+static Result backup_plan_group(BackupPackPlan *p, const BackupFileList *files, u32 start, u32 end, u32 prefix_len,
+                                const Manifest *old, Manifest *next) {
+    u32 first = p->member_count;
+    for (u32 i = start; i < end; ++i) {
+        const BackupFile *f = &files->items[i];
+        if (backup_group_len(f->path) != prefix_len || !backup_packable(p, f)) continue;
+        p->members[p->member_count++] = (PackMember){ .path = f->path, .size = f->size, .mtime = f->mtime };
+    }
+    u32 count = p->member_count - first;
+    char path[BACKUP_PATH_MAX];
+    snprintf(path, sizeof(path), "%.*s%s", (int)prefix_len, files->items[start].path, PACK_ARCHIVE_NAME);
+    const ManifestEntry *archive = manifest_find(old, fasthash_str(path));
+    if (!archive && count == 0) return 0;
+
+    bool clean = archive && archive->mtime == (s64)pack_version(p->members + first, count);
+    for (u32 i = 0; clean && i < count; ++i) clean = manifest_find(old, fasthash_str(p->members[first + i].path)) != NULL;
+    if (clean) {
+        Result rc = manifest_append(next, archive, manifest_entry_crcs(old, archive));
+        for (u32 i = 0; i < count && R_SUCCEEDED(rc); ++i) {
+            const ManifestEntry *e = manifest_find(old, fasthash_str(p->members[first + i].path));
+            rc = manifest_append(next, e, manifest_entry_crcs(old, e));
+        }
+        p->groups_clean++;
+        p->files_clean += count;
+        return rc;
+    }
+
+    if (p->count == p->capacity) {
+        u32 cap = p->capacity ? p->capacity * 2 : 16;
+        BackupPack *packs = realloc(p->packs, cap * sizeof(BackupPack));
+        if (!packs) return MAKERESULT(Module_Libnx, LibnxError_OutOfMemory);
+        p->packs = packs;
+        p->capacity = cap;
+    }
+    BackupPack *pack = &p->packs[p->count];
+    memset(pack, 0, sizeof(*pack));
+    pack->path = mem_arena_strdup(p->arena, path);
+    if (!pack->path) return MAKERESULT(Module_Libnx, LibnxError_OutOfMemory);
+    pack->first = first;
+    pack->count = count;
+    pack->prefix_len = prefix_len;
+    p->count++;
+    return 0;
+}
+
+// files 按路径排序，同一顶层目录下的文件相邻；根目录下的文件散在各组之间，最后单独收一遍
+static Result backup_plan_packs(BackupPackPlan *p, const BackupFileList *files, const Manifest *old, Manifest *next) {
+    if (!p->limit || !files->count) return 0;
+    p->members = mem_arena_alloc(p->arena, files->count * sizeof(PackMember));
+    if (!p->members) return MAKERESULT(Module_Libnx, LibnxError_OutOfMemory);
+    Result rc = 0;
+    for (u32 i = 0; i < files->count && R_SUCCEEDED(rc);) {
+        u32 g = backup_group_len(files->items[i].path);
+        if (g == 0) {
+            ++i;
+            continue;
+        }
+        u32 end = i + 1;
+        while (end < files->count && strncmp(files->items[end].path, files->items[i].path, g) == 0) ++end;
+        rc = backup_plan_group(p, files, i, end, g, old, next);
+        i = end;
+    }
+    if (R_SUCCEEDED(rc)) rc = backup_plan_group(p, files, 0, files->count, 0, old, next);
+    return rc;
+}
+
+static void backup_pack_plan_free(BackupPackPlan *p) {
+    for (u32 i = 0; i < p->count; ++i) pack_archive_free(&p->packs[i].archive);
+    free(p->packs);
+    memset(p, 0, sizeof(*p));
+}
+
+// 把本次要读的文件（待上传的文件与要重新打包的成员）复制到暂存区，结果接到 pending 与成员上。
+// 没能复制的待上传文件从 pending 中去掉（不写入清单，下次再传），没能复制的成员按读取失败处理。
+// 返回上传时的本地根目录；快照整体失败时照常从备份源读取
+static const char *backup_take_snapshot(const AppConfig *cfg, Snapshot *snap, const BackupFileList *files,
+                                        u32 *pending, u32 *pending_count, u64 *pending_bytes, const u8 **pending_data,
+                                        BackupPackPlan *packs, u32 *dropped) {
+    memset(snap, 0, sizeof(*snap));
+    u32 members = 0;
+    for (u32 i = 0; i < packs->count; ++i) members += packs->packs[i].count;
+    u32 count = *pending_count + members;
+    if (count == 0) return cfg->backup_source;
+    SnapshotItem *items = mem_arena_alloc(&s_run_arena, count * sizeof(SnapshotItem));
+    if (!items) {
+        log_warning("运行区不足，本次不做快照");
+        return cfg->backup_source;
+    }
+    for (u32 i = 0; i < *pending_count; ++i) {
+        const BackupFile *f = &files->items[pending[i]];
+        items[i] = (SnapshotItem){ .path = f->path, .size = f->size };
+    }
+    u32 k = *pending_count;
+    for (u32 i = 0; i < packs->count; ++i) {
+        const BackupPack *pk = &packs->packs[i];
+        for (u32 j = 0; j < pk->count; ++j) {
+            const PackMember *m = &packs->members[pk->first + j];
+            items[k++] = (SnapshotItem){ .path = m->path, .size = m->size };
+        }
+    }
+    Result rc = snapshot_take(snap, cfg->backup_source, items, count, (u64)cfg->snapshot_ram_kb * 1024,
+                              s_io_pool_ready ? &s_io_pool : NULL, &s_throttle);
+    if (R_FAILED(rc)) {
+        log_warning("快照失败，直接从备份源上传: 0x%x", rc);
+        snapshot_release(snap);
+        return cfg->backup_source;
+    }
+    u32 kept = 0;
+    for (u32 i = 0; i < *pending_count; ++i) {
+        if (!items[i].ok) {
+            *pending_bytes -= items[i].size;
+            (*dropped)++;
+            continue;
+        }
+        pending_data[kept] = items[i].data;
+        pending[kept++] = pending[i];
+    }
+    *pending_count = kept;
+    k = count - members;
+    for (u32 i = 0; i < packs->count; ++i) {
+        const BackupPack *pk = &packs->packs[i];
+        for (u32 j = 0; j < pk->count; ++j, ++k) {
+            PackMember *m = &packs->members[pk->first + j];
+            m->data = items[k].data;
+            m->missing = !items[k].ok;
+        }
+    }
+    return snap->mode == SnapshotMode_Sd ? SNAPSHOT_DIR : cfg->backup_source;
+}
+
+// 去重模式：不用清单与上传引擎，配方本身记录了每个文件上次的 size/mtime
+static Result backup_run_dedup(const AppConfig *cfg, const BackupFileList *files) {
+    DedupOptions opt = {
+        .local_root = cfg->backup_source,
+        .url = cfg->ftp_url,
+        .user = cfg->ftp_user,
+        .password = cfg->ftp_password,
+        .throttle = &s_throttle,
+    };
+    DedupStats s;
+    Result rc = dedup_backup(&opt, files, &s);
+    u64 dedup_bytes = s.bytes_read > s.bytes_new ? s.bytes_read - s.bytes_new : 0;
+    double mbps = s.elapsed_ns ? (double)s.bytes_read / (1024.0 * 1024.0) / ((double)s.elapsed_ns / 1e9) : 0.0;
+    log_info("去重备份 #%u 结束：共 %u 个文件（沿用 %u，失败 %u），%llu 字节；读入 %llu 字节切成 %llu 块，新块 %llu 个 / %llu 字节，免传 %llu 字节，读取 %.2f MB/s",
+             s.generation, s.files, s.files_carried, s.files_failed, (unsigned long long)s.bytes_total,
+             (unsigned long long)s.bytes_read, (unsigned long long)s.chunks,
+             (unsigned long long)s.chunks_new, (unsigned long long)s.bytes_new, (unsigned long long)dedup_bytes, mbps);
+    return rc;
+}
+
+static Result backup_run_once(const AppConfig *cfg) {
+    Result rc = service_require(ServiceId_Socket);
+    if (R_FAILED(rc)) {
+        log_error("socket 初始化失败: 0x%x", rc);
+        return rc;
+    }
+    static bool curl_ready;
+    if (!curl_ready) {
+        if (curl_global_init(CURL_GLOBAL_DEFAULT) != CURLE_OK) return MAKERESULT(Module_Libnx, LibnxError_NotInitialized);
+        curl_ready = true;
+    }
+
+    backup_throttle_init(cfg);
+    backup_memory_init(cfg);
+    mem_arena_reset(&s_run_arena);
+    ThrottleStats throttle_before;
+    throttle_stats(&s_throttle, &throttle_before);
+
+    BackupFileList files;
+    ScanOptions scan_opt = {
+        .root = cfg->backup_source,
+        .threads = cfg->worker_threads,
+        .cache_path = cfg->scan_cache ? SCAN_CACHE_FILE_PATH : NULL,
+        .arena = &s_run_arena,
+    };
+    ScanStats scan_stats;
+    rc = scan_tree(&scan_opt, &files, &scan_stats);
+    if (R_FAILED(rc)) {
+        log_error("扫描备份目录失败 %s: 0x%x", cfg->backup_source, rc);
+        backup_log_memory();
+        return rc;
+    }
+    log_info("扫描：%u 个目录（缓存命中 %u）、%u 个文件（来自缓存 %u），跳过 %u，%u 线程，%llu ms",
+             scan_stats.dirs, scan_stats.dirs_cached, scan_stats.files, scan_stats.files_cached, scan_stats.skipped,
+             scan_stats.threads, (unsigned long long)(scan_stats.elapsed_ns / 1000000));
+    if (cfg->dedup) {
+        rc = backup_run_dedup(cfg, &files);
+        backup_log_memory();
+        backup_file_list_free(&files);
+        return rc;
+    }
+
+    // 对照旧清单分出未变化与待上传的文件；新清单只收录本次仍存在且已确认备份的文件
+    Manifest old_manifest, new_manifest;
+    u64 target_hash = backup_target_hash(cfg);
+    manifest_load(&old_manifest, MANIFEST_FILE_PATH, target_hash);
+    manifest_init(&new_manifest, target_hash);
+    u32 *pending = mem_arena_alloc(&s_run_arena, (files.count ? files.count : 1) * sizeof(u32));
+    if (!pending) {
+        log_error("运行区不足（run_arena_kb = %u）", cfg->run_arena_kb);
+        manifest_free(&old_manifest);
+        backup_file_list_free(&files);
+        return MAKERESULT(Module_Libnx, LibnxError_OutOfMemory);
+    }
+    u32 pending_count = 0;
+    u64 pending_bytes = 0;
+    u32 rehashed = 0;
+    BackupPackPlan packs = { .limit = (u64)cfg->pack_small_kb * 1024, .arena = &s_run_arena };
+    rc = backup_plan_packs(&packs, &files, &old_manifest, &new_manifest);
+    char local[BACKUP_PATH_MAX];
+    for (u32 i = 0; i < files.count && R_SUCCEEDED(rc); ++i) {
+        const BackupFile *f = &files.items[i];
+        if (backup_packable(&packs, f)) continue; // 随所在组的归档处理
+        ManifestEntry entry = { .path_hash = fasthash_str(f->path), .size = f->size, .mtime = f->mtime };
+        const ManifestEntry *old = manifest_find(&old_manifest, entry.path_hash);
+        bool unchanged = false;
+        if (old && old->size == f->size) {
+            if (old->mtime == f->mtime) {
+                unchanged = true;
+            } else {
+                snprintf(local, sizeof(local), "%s/%s", cfg->backup_source, f->path);
+                u64 h;
+                unchanged = hash_local_file(local, &h) && h == old->content_hash;
+                ++rehashed;
+            }
+        }
+        if (unchanged) {
+            // 内容没变，沿用旧条目的哈希与校验摘要
+            entry = *old;
+            entry.mtime = f->mtime;
+            rc = manifest_append(&new_manifest, &entry, manifest_entry_crcs(&old_manifest, old));
+        } else {
+            pending[pending_count++] = i;
+            pending_bytes += f->size;
+        }
+    }
+    manifest_free(&old_manifest);
+
+    // 快照之后备份源不再被读取，上传只读副本
+    Snapshot snap = {0};
+    const char *read_root = cfg->backup_source;
+    const u8 **pending_data = NULL;
+    u32 snap_dropped = 0;
+    if (R_SUCCEEDED(rc) && cfg->snapshot && (pending_count || packs.count)) {
+        pending_data = mem_arena_calloc(&s_run_arena, pending_count ? pending_count : 1, sizeof(const u8*));
+        if (pending_data) {
+            read_root = backup_take_snapshot(cfg, &snap, &files, pending, &pending_count, &pending_bytes, pending_data,
+                                             &packs, &snap_dropped);
+        } else {
+            log_warning("运行区不足，本次不做快照");
+        }
+    }
+
+    UploadOptions opt = {
+        .local_root = read_root,
+        .url = cfg->ftp_url,
+        .user = cfg->ftp_user,
+        .password = cfg->ftp_password,
+        .connections = cfg->upload_connections,
+        .buffer_count = cfg->upload_buffers,
+        .buffer_size = cfg->upload_buffer_kb * 1024,
+        .buffers = s_io_pool_ready ? &s_io_pool : NULL,
+        .compress = cfg->compression != 0,
+        .compress_level = (int)cfg->compression_level,
+        .chunk_size = (u64)cfg->upload_chunk_mb * 1024 * 1024,
+        .throttle = &s_throttle,
+        .pool = &s_upload_pool,
+        .remote_cache = cfg->remote_cache != 0,
+    };
+    // 续传日志与清单共用目标哈希；打不开时照常上传，只是无法断点续传
+    static Journal journal;
+    if (R_SUCCEEDED(rc) && (pending_count || packs.count)) {
+        Result jrc = journal_open(&journal, JOURNAL_FILE_PATH, target_hash);
+        if (R_SUCCEEDED(jrc)) opt.journal = &journal;
+        else log_warning("无法打开续传日志: 0x%x", jrc);
+    }
+    // 普通文件在前，归档在后（上传引擎自己按大小排序）
+    u32 job_count = pending_count + packs.count;
+    static UploadEngine engine;
+    memset(&engine.stats, 0, sizeof(engine.stats));
+    UploadJob *jobs = NULL;
+    if (R_SUCCEEDED(rc) && job_count) {
+        jobs = mem_arena_calloc(&s_run_arena, job_count, sizeof(UploadJob));
+        if (!jobs) {
+            log_error("运行区不足（run_arena_kb = %u，%u 个任务）", cfg->run_arena_kb, job_count);
+            rc = MAKERESULT(Module_Libnx, LibnxError_OutOfMemory);
+        }
+    }
+    if (R_SUCCEEDED(rc) && job_count) rc = upload_engine_init(&engine, &opt);
+    if (R_SUCCEEDED(rc) && job_count && (engine.lane_count < opt.connections || engine.slot_count < opt.buffer_count)) {
+        log_warning("I/O 缓冲池空闲块不足：本次用 %u 条连接、每条 %u 块", engine.lane_count, engine.slot_count);
+    }
+    // 成员的 CRC 分块与逐个上传时相同，取引擎定下的值
+    for (u32 i = 0; i < packs.count && R_SUCCEEDED(rc); ++i) {
+        BackupPack *pk = &packs.packs[i];
+        rc = pack_archive_init(&pk->archive, read_root, packs.members + pk->first, pk->count, pk->prefix_len, engine.crc_chunk);
+    }
+    if (R_FAILED(rc)) {
+        log_error("上传引擎初始化失败: 0x%x", rc);
+        if (job_count && engine.multi) upload_engine_exit(&engine);
+        if (opt.journal) journal_close(&journal, JOURNAL_FILE_PATH, false);
+        snapshot_release(&snap);
+        backup_log_memory();
+        backup_pack_plan_free(&packs);
+        manifest_free(&new_manifest);
+        backup_file_list_free(&files);
+        return rc;
+    }
+
+    for (u32 i = 0; i < pending_count; ++i) {
+        jobs[i].path = files.items[pending[i]].path;
+        jobs[i].size = files.items[pending[i]].size;
+        jobs[i].mtime = files.items[pending[i]].mtime;
+        jobs[i].data = pending_data && snap.mode == SnapshotMode_Ram ? pending_data[i] : NULL;
+    }
+    u32 packed_files = 0;
+    for (u32 i = 0; i < packs.count; ++i) {
+        UploadJob *job = &jobs[pending_count + i];
+        job->path = packs.packs[i].path;
+        job->size = packs.packs[i].archive.size;
+        job->mtime = (s64)packs.packs[i].archive.version; // 续传日志据此判断远端的半截归档是否还能接上
+        job->pack = &packs.packs[i].archive;
+        pending_bytes += job->size;
+        packed_files += packs.packs[i].count;
+    }
+    progress_begin(job_count, pending_bytes);
+    rc = upload_run(&engine, jobs, job_count);
+    snapshot_release(&snap);
+    // 上传失败的文件不写入清单，下次重新上传
+    u32 pack_failed = 0;
+    for (u32 i = 0; i < job_count; ++i) {
+        if (R_FAILED(jobs[i].rc)) continue;
+        ManifestEntry entry = {
+            .path_hash = fasthash_str(jobs[i].path),
+            .size = jobs[i].size,
+            .mtime = jobs[i].mtime,
+            .content_hash = jobs[i].content_hash,
+            .chunk_size = jobs[i].crc_chunk,
+        };
+        memcpy(entry.sha256, jobs[i].sha256, sizeof(entry.sha256));
+        // 扫描后文件又变了大小时块数对不上，这次不记摘要
+        const u32 *crcs = jobs[i].crc_count == manifest_crc_count(&entry) ? upload_job_crcs(&engine, &jobs[i]) : NULL;
+        Result mrc = manifest_append(&new_manifest, &entry, crcs);
+        if (R_FAILED(mrc)) rc = mrc;
+        if (!jobs[i].pack) continue;
+        // 归档成功后记下成员。读不出来的成员（已补零）不记，下次整组重新打包；
+        // 续传日志表明归档上次已传完、这次没有生成时成员没有摘要
+        const PackArchive *a = jobs[i].pack;
+        bool generated = jobs[i].crc_chunk != 0;
+        for (u32 j = 0; j < a->count; ++j) {
+            const PackMember *m = &a->members[j];
+            if (generated && !m->ok) {
+                pack_failed++;
+                log_warning("打包时读取 %s 失败，下次重新打包", m->path);
+                continue;
+            }
+            ManifestEntry me = { .path_hash = fasthash_str(m->path), .size = m->size, .mtime = m->mtime };
+            if (m->ok) {
+                me.content_hash = m->content_hash;
+                me.chunk_size = a->crc_chunk;
+                memcpy(me.sha256, m->sha256, sizeof(me.sha256));
+            }
+            mrc = manifest_append(&new_manifest, &me, m->ok ? pack_member_crcs(a, m) : NULL);
+            if (R_FAILED(mrc)) rc = mrc;
+        }
+    }
+
+    // 所有文件处理完后一次性替换清单；部分失败时已成功的文件照样记入
+    manifest_sort(&new_manifest);
+    Result mrc = manifest_save(&new_manifest, MANIFEST_FILE_PATH);
+    if (R_FAILED(mrc)) log_error("保存清单失败: 0x%x", mrc);
+    // 全部成功且清单已落盘后日志就没用了；否则保留，下次从记录处续传
+    if (opt.journal) journal_close(&journal, JOURNAL_FILE_PATH, R_SUCCEEDED(rc) && R_SUCCEEDED(mrc));
+    progress_end(R_SUCCEEDED(rc));
+
+    // 单行汇总：各连接吞吐按其忙碌时间计算；读线程等待多说明网络是瓶颈，暂停多说明 SD 是瓶颈
+    const UploadStats *s = &engine.stats;
+    char lanes[160];
+    size_t pos = 0;
+    lanes[0] = '\0';
+    for (u32 i = 0; i < s->connections && pos < sizeof(lanes); ++i) {
+        const UploadLaneStats *ls = &s->lanes[i];
+        double lane_mbps = ls->busy_ns ? (double)ls->bytes_sent / (1024.0 * 1024.0) / ((double)ls->busy_ns / 1e9) : 0.0;
+        pos += (size_t)snprintf(lanes + pos, sizeof(lanes) - pos, " #%u:%llu个/%.2fMB/s", i, (unsigned long long)ls->files, lane_mbps);
+    }
+    double mbps = s->elapsed_ns ? (double)s->bytes_sent / (1024.0 * 1024.0) / ((double)s->elapsed_ns / 1e9) : 0.0;
+    log_info("备份结束：共 %u 个文件，跳过未变化 %u（其中比对哈希 %u），成功 %llu / 失败 %llu，%llu 字节，合计 %.2f MB/s，%u 连接%s，读线程空闲 %llu ms，缺数据暂停 %llu 次",
+             files.count, files.count - pending_count - packed_files - snap_dropped, rehashed,
+             (unsigned long long)s->files_ok, (unsigned long long)s->files_failed,
+             (unsigned long long)s->bytes_sent, mbps, s->connections, lanes,
+             (unsigned long long)(s->reader_wait_ns / 1000000), (unsigned long long)s->sender_stalls);
+    if (snap.files || snap.failed) {
+        double snap_mbps = snap.elapsed_ns ? (double)snap.bytes / (1024.0 * 1024.0) / ((double)snap.elapsed_ns / 1e9) : 0.0;
+        log_info("快照：%u 个文件（%llu 字节）复制到%s，用时 %llu ms（%.2f MB/s），失败 %u（下次重传）；上传用时 %llu ms",
+                 snap.files, (unsigned long long)snap.bytes, snap.mode == SnapshotMode_Ram ? "内存" : " SD 暂存目录",
+                 (unsigned long long)(snap.elapsed_ns / 1000000), snap_mbps, snap.failed,
+                 (unsigned long long)(s->elapsed_ns / 1000000));
+    }
+    if (packs.limit) {
+        log_info("小文件打包（不超过 %u KB）：上传 %u 个归档（%u 个文件，读取失败 %u），%u 个组未变化（%u 个文件）",
+                 cfg->pack_small_kb, packs.count, packed_files, pack_failed, packs.groups_clean, packs.files_clean);
+    }
+    if (s->resumed_files || s->retries) {
+        log_info("续传：%llu 个文件接续上次进度，免传 %llu 字节，断线重试 %llu 次，共 %llu 次 STOR/APPE，日志写入 %u 次",
+                 (unsigned long long)s->resumed_files, (unsigned long long)s->resumed_bytes,
+                 (unsigned long long)s->retries, (unsigned long long)s->chunks, opt.journal ? journal.flushes : 0);
+    }
+    // 省去的往返 = 估计的逐级 CWD - 实际的 CWD + 免去的 SIZE + 缺失目录（逐级方式要先 CWD 失败再 MKD）- 列目录的命令
+    if (s->remote_cache && UPLOAD_COUNT_COMMANDS) {
+        s64 saved = (s64)s->cwd_estimate - (s64)s->cwd + (s64)s->probes_saved + (s64)s->mkd - (s64)s->list_commands;
+        log_info("远端目录缓存：列出 %u 个目录（%u 条命令），MKD %u 次，免去 SIZE %llu 次，CWD %llu 次（逐级方式约 %llu 次），净省约 %lld 次往返；控制命令共 %llu 条，%s",
+                 s->dirs_listed, s->list_commands, s->mkd, (unsigned long long)s->probes_saved,
+                 (unsigned long long)s->cwd, (unsigned long long)s->cwd_estimate, (long long)saved,
+                 (unsigned long long)s->commands, s->pool_reused ? "沿用上次的连接" : "新建连接");
+    } else if (s->remote_cache) {
+        // 没有统计命令：只记缓存省下的部分
+        log_info("远端目录缓存：列出 %u 个目录，MKD %u 次，免去 SIZE %llu 次（逐级 CWD 方式约需 CWD %llu 次），%s",
+                 s->dirs_listed, s->mkd, (unsigned long long)s->probes_saved, (unsigned long long)s->cwd_estimate,
+                 s->pool_reused ? "沿用上次的连接" : "新建连接");
+    } else if (job_count && UPLOAD_COUNT_COMMANDS) {
+        log_info("控制命令共 %llu 条（CWD %llu），%s", (unsigned long long)s->commands, (unsigned long long)s->cwd,
+                 s->pool_reused ? "沿用上次的连接" : "新建连接");
+    }
+    ThrottleStats ts;
+    throttle_stats(&s_throttle, &ts);
+    for (int i = 0; i < ThrottleKind_Count; ++i) {
+        ts.throttled_ns[i] -= throttle_before.throttled_ns[i];
+        ts.waits[i] -= throttle_before.waits[i];
+    }
+    if (ts.waits[ThrottleKind_Disk] || ts.waits[ThrottleKind_Net]) {
+        log_info("限速（前台有应用时）：SD 受限 %llu ms（%llu 次），网络受限 %llu ms（%llu 次）",
+                 (unsigned long long)(ts.throttled_ns[ThrottleKind_Disk] / 1000000), (unsigned long long)ts.waits[ThrottleKind_Disk],
+                 (unsigned long long)(ts.throttled_ns[ThrottleKind_Net] / 1000000), (unsigned long long)ts.waits[ThrottleKind_Net]);
+    }
+    FsPoolStats fs;
+    fspool_stats(&fs);
+    log_info("文件系统会话槽 %u 个（启动以来）：日志 %llu 次/等待 %llu ms，遍历 %llu 次/等待 %llu ms，读取 %llu 次/等待 %llu ms",
+             fs.sessions,
+             (unsigned long long)fs.ops[FsRole_Log], (unsigned long long)(fs.wait_ns[FsRole_Log] / 1000000),
+             (unsigned long long)fs.ops[FsRole_Scan], (unsigned long long)(fs.wait_ns[FsRole_Scan] / 1000000),
+             (unsigned long long)fs.ops[FsRole_Data], (unsigned long long)(fs.wait_ns[FsRole_Data] / 1000000));
+    if (s->compress_in) {
+        double ratio = s->compress_out ? (double)s->compress_in / (double)s->compress_out : 0.0;
+        double zmbps = s->compress_ns ? (double)s->compress_in / (1024.0 * 1024.0) / ((double)s->compress_ns / 1e9) : 0.0;
+        log_info("压缩：%llu -> %llu 字节（%.2f:1），%.2f MB/s，最终级别 %d（调整 %u 次）",
+                 (unsigned long long)s->compress_in, (unsigned long long)s->compress_out, ratio, zmbps,
+                 s->compress_level, s->compress_level_changes);
+    }
+
+    if (job_count) upload_engine_exit(&engine);
+    backup_log_memory();
+    backup_pack_plan_free(&packs);
+    manifest_free(&new_manifest);
+    backup_file_list_free(&files);
+    return rc;
+}
+
+Result backup_run(const AppConfig *cfg) {
+    u64 start = armGetSystemTick();
+    Result rc = backup_run_once(cfg);
+    metrics_inc(Metric_Backups);
+    if (R_FAILED(rc)) metrics_inc(Metric_BackupFailures);
+    metrics_observe(Metric_BackupDuration, armTicksToNs(armGetSystemTick() - start));
+    threading_log_summary();
+    return rc;
+}
+
+static AppThread s_backup_thread;
+static bool s_backup_started;
+static Mutex s_backup_config_lock;
+static AppConfig s_backup_config;      // 下一次备份使用的配置（热更新时整体替换）
+static TriggerEngine s_trigger;
+static TriggerTitleSource s_trigger_title;
+static TriggerDirSource s_trigger_dir;
+static TriggerScheduleSource s_trigger_schedule;
+
+static void backup_trigger_policy(const AppConfig *cfg, TriggerPolicy *out) {
+    out->debounce_ns = (u64)cfg->trigger_debounce_s * 1000000000ULL;
+    out->max_delay_ns = (u64)cfg->trigger_max_delay_s * 1000000000ULL;
+}
+
+static void backup_trigger_run(void *user, const TriggerBatch *batch) {
+    AppConfig cfg;
+    mutexLock(&s_backup_config_lock);
+    cfg = s_backup_config;
+    mutexUnlock(&s_backup_config_lock);
+    if (!cfg.ftp_url[0]) {
+        log_info("ftp_url 已清空，跳过本次备份");
+        return;
+    }
+    backup_run(&cfg);
+}
+
+static void backup_thread_main(void *arg) {
+    trigger_engine_run(&s_trigger, backup_trigger_run, NULL);
+    TriggerStats st;
+    trigger_engine_stats(&s_trigger, &st);
+    log_info("触发引擎退出：唤醒 %llu 次，事件 %llu 个，备份 %llu 次（合并 %llu 个事件）",
+             (unsigned long long)st.wakeups, (unsigned long long)st.events,
+             (unsigned long long)st.runs, (unsigned long long)st.coalesced);
+    trigger_engine_exit(&s_trigger);
+}
+
+static Result backup_trigger_init(const AppConfig *cfg) {
+    TriggerPolicy policy;
+    backup_trigger_policy(cfg, &policy);
+    Result rc = trigger_engine_init(&s_trigger, &policy);
+    if (R_FAILED(rc)) return rc;
+    TriggerSource src;
+    if (cfg->trigger_title_exit) {
+        trigger_title_source(&src, &s_trigger_title, TRIGGER_TITLE_POLL_NS);
+        trigger_engine_add_source(&s_trigger, &src);
+    }
+    if (cfg->trigger_dir_poll_s) {
+        trigger_dir_source(&src, &s_trigger_dir, cfg->backup_source, (u64)cfg->trigger_dir_poll_s * 1000000000ULL);
+        trigger_engine_add_source(&s_trigger, &src);
+    }
+    if (cfg->trigger_interval_min) {
+        trigger_schedule_source(&src, &s_trigger_schedule, (u64)cfg->trigger_interval_min * 60000000000ULL);
+        trigger_engine_add_source(&s_trigger, &src);
+    }
+    // 与以前一样，启动后马上备份一次
+    trigger_engine_kick(&s_trigger, TriggerKind_Startup);
+    return 0;
+}
+
+Result backup_start(const AppConfig *cfg) {
+    if (!cfg->ftp_url[0] || s_backup_started) return 0;
+    s_backup_config = *cfg;
+    backup_throttle_init(cfg);
+    backup_memory_init(cfg);
+    Result rc = backup_trigger_init(cfg);
+    if (R_FAILED(rc)) return rc;
+    rc = app_thread_start(&s_backup_thread, ThreadRole_Backup, NULL, backup_thread_main, NULL);
+    if (R_FAILED(rc)) {
+        trigger_engine_exit(&s_trigger);
+        return rc;
+    }
+    s_backup_started = true;
+    return 0;
+}
+
+void backup_update_config(const AppConfig *cfg) {
+    if (s_throttle_ready) throttle_set_rates(&s_throttle, (u64)cfg->bg_disk_kbps * 1024, (u64)cfg->bg_net_kbps * 1024);
+    if (!s_backup_started) return;
+    mutexLock(&s_backup_config_lock);
+    s_backup_config = *cfg;
+    mutexUnlock(&s_backup_config_lock);
+    TriggerPolicy policy;
+    backup_trigger_policy(cfg, &policy);
+    trigger_engine_set_policy(&s_trigger, &policy);
+}
+
+void backup_wait(void) {
+    if (!s_backup_started) return;
+    trigger_engine_stop(&s_trigger);
+    app_thread_join(&s_backup_thread);
+    upload_pool_release(&s_upload_pool);
+    backup_memory_exit();
+    s_backup_started = false;
+}
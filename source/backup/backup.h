@@ -0,0 +1,15 @@
+#pragma once
+// 备份任务：遍历 backup_source 下的全部文件，逐个流式上传到 ftp_url，进度写入 progress
+#include "../util/platform.h"
+#include "../util/config.h"
+#include "scan.h"
+
+// 同步执行一次增量备份：只上传清单（manifest.h）中没有或已变化的文件，结束时整体替换清单
+Result backup_run(const AppConfig *cfg);
+// 启动后台备份线程（cfg 会被复制）：先备份一次，之后由触发引擎（trigger.h）按事件备份；
+// 未配置 ftp_url 时不做任何事
+Result backup_start(const AppConfig *cfg);
+// 停止触发引擎，等待正在进行的备份结束
+void backup_wait(void);
+// 配置热更新：限速与去抖参数立即生效，其余设置从下一次备份开始生效；事件源的开关与间隔在启动时确定
+void backup_update_config(const AppConfig *cfg);
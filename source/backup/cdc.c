@@ -0,0 +1,182 @@
+#include "cdc.h"
+#include "../util/hash.h"
+#include "../util/log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// 归一化分块：平均长度之前用更严的掩码（少切），之后用更松的掩码（多切），块长更集中在平均值附近。
+// 取哈希的高位：(h << 1) 使第 63 位只受最近 64 字节影响
+#define CDC_MASK_STRICT 0xFFFF000000000000ULL  // 16 位，约 1/65536
+#define CDC_MASK_LOOSE  0xFFF0000000000000ULL  // 12 位，约 1/4096
+#define CHUNK_INDEX_MIN_CAPACITY 1024
+
+// gear 表：固定种子的 splitmix64 序列。改动会改变所有切点（结果仍正确，只是与旧块库不再去重）
+static u64 s_gear[256];
+static bool s_gear_ready;
+
+static void cdc_gear_init(void) {
+    u64 x = 0x6D6172696F2D706FULL;
+    for (int i = 0; i < 256; ++i) {
+        u64 z = (x += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        s_gear[i] = z ^ (z >> 31);
+    }
+    __atomic_store_n(&s_gear_ready, true, __ATOMIC_RELEASE);
+}
+
+size_t cdc_cut(const u8 *data, size_t len, bool eof) {
+    if (!__atomic_load_n(&s_gear_ready, __ATOMIC_ACQUIRE)) cdc_gear_init();
+    if (len < CDC_MAX_SIZE && !eof) return 0;
+    if (len <= CDC_MIN_SIZE) return len;
+    size_t end = len < CDC_MAX_SIZE ? len : CDC_MAX_SIZE;
+    size_t normal = end < CDC_AVG_SIZE ? end : CDC_AVG_SIZE;
+    u64 h = 0;
+    size_t i = CDC_MIN_SIZE;
+    for (; i < normal; ++i) {
+        h = (h << 1) + s_gear[data[i]];
+        if (!(h & CDC_MASK_STRICT)) return i + 1;
+    }
+    for (; i < end; ++i) {
+        h = (h << 1) + s_gear[data[i]];
+        if (!(h & CDC_MASK_LOOSE)) return i + 1;
+    }
+    return end;
+}
+
+// ---- 块索引 ----
+
+static u64 digest_key(const u8 *digest) {
+    u64 k;
+    memcpy(&k, digest, sizeof(k));
+    return k;
+}
+
+static ChunkIndexEntry *index_slot(const ChunkIndex *idx, const u8 *digest) {
+    u32 mask = idx->capacity - 1;
+    for (u32 i = (u32)digest_key(digest) & mask;; i = (i + 1) & mask) {
+        ChunkIndexEntry *e = &idx->slots[i];
+        if (!e->used || memcmp(e->digest, digest, SHA256_DIGEST_SIZE) == 0) return e;
+    }
+}
+
+static Result index_rehash(ChunkIndex *idx, u32 capacity) {
+    ChunkIndexEntry *slots = calloc(capacity, sizeof(ChunkIndexEntry));
+    if (!slots) return MAKERESULT(Module_Libnx, LibnxError_OutOfMemory);
+    ChunkIndexEntry *old = idx->slots;
+    u32 old_capacity = idx->capacity;
+    idx->slots = slots;
+    idx->capacity = capacity;
+    for (u32 i = 0; i < old_capacity; ++i) {
+        if (old[i].used) *index_slot(idx, old[i].digest) = old[i];
+    }
+    free(old);
+    return 0;
+}
+
+// 装载率不超过 3/4
+static Result index_reserve(ChunkIndex *idx, u32 count) {
+    u32 capacity = idx->capacity ? idx->capacity : CHUNK_INDEX_MIN_CAPACITY;
+    while ((u64)count * 4 > (u64)capacity * 3) capacity *= 2;
+    return capacity == idx->capacity ? 0 : index_rehash(idx, capacity);
+}
+
+void chunk_index_free(ChunkIndex *idx) {
+    free(idx->slots);
+    memset(idx, 0, sizeof(*idx));
+}
+
+bool chunk_index_contains(const ChunkIndex *idx, const u8 digest[SHA256_DIGEST_SIZE]) {
+    return idx->capacity && index_slot(idx, digest)->used;
+}
+
+Result chunk_index_add(ChunkIndex *idx, const u8 digest[SHA256_DIGEST_SIZE], u32 size) {
+    Result rc = index_reserve(idx, idx->count + 1);
+    if (R_FAILED(rc)) return rc;
+    ChunkIndexEntry *e = index_slot(idx, digest);
+    if (e->used) return 0;
+    memcpy(e->digest, digest, SHA256_DIGEST_SIZE);
+    e->size = size;
+    e->used = 1;
+    idx->count++;
+    idx->added++;
+    return 0;
+}
+
+// 文件中按表内顺序只存有效条目；任何不一致都视为无效
+static bool index_read_file(ChunkIndex *idx, const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+    ChunkIndexHeader hdr;
+    bool ok = fread(&hdr, sizeof(hdr), 1, f) == 1 &&
+              memcmp(hdr.magic, CHUNK_INDEX_MAGIC, 4) == 0 &&
+              hdr.version == CHUNK_INDEX_VERSION &&
+              hdr.target_hash == idx->target_hash;
+    ChunkIndexEntry *entries = NULL;
+    if (ok) {
+        entries = malloc((hdr.count ? hdr.count : 1) * sizeof(ChunkIndexEntry));
+        ok = entries && fread(entries, sizeof(ChunkIndexEntry), hdr.count, f) == hdr.count &&
+             fasthash(entries, (size_t)hdr.count * sizeof(ChunkIndexEntry)) == hdr.entries_hash &&
+             R_SUCCEEDED(index_reserve(idx, hdr.count));
+    }
+    fclose(f);
+    for (u32 i = 0; ok && i < hdr.count; ++i) {
+        ChunkIndexEntry *e = index_slot(idx, entries[i].digest);
+        if (e->used) continue;
+        *e = entries[i];
+        e->used = 1;
+        idx->count++;
+    }
+    free(entries);
+    return ok;
+}
+
+Result chunk_index_load(ChunkIndex *idx, const char *path, u64 target_hash) {
+    memset(idx, 0, sizeof(*idx));
+    idx->target_hash = target_hash;
+    Result rc = index_reserve(idx, 0);
+    if (R_FAILED(rc)) return rc;
+    if (index_read_file(idx, path)) return 0;
+    // 上次保存在删除旧文件与改名之间中断：.tmp 已完整写入
+    char tmp[256];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    index_read_file(idx, tmp);
+    return 0;
+}
+
+Result chunk_index_save(const ChunkIndex *idx, const char *path) {
+    char tmp[256];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *f = fopen(tmp, "wb");
+    if (!f) return MAKERESULT(Module_Libnx, LibnxError_IoError);
+
+    ChunkIndexHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, CHUNK_INDEX_MAGIC, 4);
+    hdr.version = CHUNK_INDEX_VERSION;
+    hdr.target_hash = idx->target_hash;
+    hdr.count = idx->count;
+    FastHash h;
+    fasthash_init(&h);
+    for (u32 i = 0; i < idx->capacity; ++i) {
+        if (idx->slots[i].used) fasthash_update(&h, &idx->slots[i], sizeof(ChunkIndexEntry));
+    }
+    hdr.entries_hash = fasthash_final(&h);
+    bool ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1;
+    for (u32 i = 0; i < idx->capacity && ok; ++i) {
+        if (idx->slots[i].used) ok = fwrite(&idx->slots[i], sizeof(ChunkIndexEntry), 1, f) == 1;
+    }
+    ok = fclose(f) == 0 && ok;
+    if (!ok) {
+        remove(tmp);
+        return MAKERESULT(Module_Libnx, LibnxError_IoError);
+    }
+    // 与清单相同：sdmc 上 rename 不能覆盖，先删旧文件
+    remove(path);
+    if (rename(tmp, path) != 0) {
+        log_error("块索引改名失败: %s", tmp);
+        return MAKERESULT(Module_Libnx, LibnxError_IoError);
+    }
+    return 0;
+}
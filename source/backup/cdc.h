@@ -0,0 +1,51 @@
+#pragma once
+// 内容定义分块（FastCDC 式 gear 滚动哈希）与本地块索引。
+// 切点只取决于附近 64 字节的内容，文件中间插入或改动几个字节只影响相邻的一两块，其余块的内容与 SHA-256 不变；
+// 块索引记录远端块库中已有的块（以 SHA-256 为键），去重备份只上传索引里没有的块
+#include "../util/platform.h"
+#include "../util/checksum.h"
+
+#define CDC_MIN_SIZE (4 * 1024)
+#define CDC_AVG_SIZE (16 * 1024)
+#define CDC_MAX_SIZE (64 * 1024)
+
+#define CHUNK_INDEX_FILE_PATH "/config/mario-pop/chunks.bin"
+#define CHUNK_INDEX_MAGIC "MCKI"
+#define CHUNK_INDEX_VERSION 1
+
+// 返回 data 开头这一块的长度。len 不足 CDC_MAX_SIZE 时只有 eof 为真（文件末尾）才允许切在 len 处，
+// 否则调用方应先补足数据；eof 为假且 len < CDC_MAX_SIZE 时返回 0
+size_t cdc_cut(const u8 *data, size_t len, bool eof);
+
+typedef struct {
+    u8 digest[SHA256_DIGEST_SIZE];
+    u32 size;
+    u32 used;               // 0 = 空槽
+} ChunkIndexEntry;
+
+typedef struct {
+    char magic[4];
+    u32 version;
+    u64 target_hash;        // 块库所在的远端；换了目标索引作废
+    u32 count;
+    u32 reserved;
+    u64 entries_hash;
+} ChunkIndexHeader;
+
+// 开放寻址哈希表（SHA-256 本身足够均匀，直接取前 8 字节作槽位）
+typedef struct {
+    ChunkIndexEntry *slots;
+    u32 capacity;           // 2 的幂
+    u32 count;
+    u64 target_hash;
+    u32 added;              // 本次新加入的块
+} ChunkIndex;
+
+// 读取索引；文件不存在或目标不一致时为空索引（rc 仍为 0，仅内存不足时失败）
+Result chunk_index_load(ChunkIndex *idx, const char *path, u64 target_hash);
+void chunk_index_free(ChunkIndex *idx);
+bool chunk_index_contains(const ChunkIndex *idx, const u8 digest[SHA256_DIGEST_SIZE]);
+// 记录远端已有的块（已存在时不重复计）
+Result chunk_index_add(ChunkIndex *idx, const u8 digest[SHA256_DIGEST_SIZE], u32 size);
+// 先写 path.tmp 再替换 path
+Result chunk_index_save(const ChunkIndex *idx, const char *path);
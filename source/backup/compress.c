@@ -0,0 +1,122 @@
+#include "compress.h"
+#include <stdlib.h>
+#include <string.h>
+
+// zlib 分配器：在固定区域里顺序划分，释放为空操作；deflateReset 不会再分配
+static voidpf arena_alloc(voidpf opaque, uInt items, uInt size) {
+    CompressStream *s = (CompressStream*)opaque;
+    size_t bytes = ((size_t)items * size + 15) & ~(size_t)15;
+    if (s->arena_used + bytes > COMPRESS_ARENA_SIZE) return Z_NULL;
+    void *p = s->arena + s->arena_used;
+    s->arena_used += bytes;
+    return p;
+}
+
+static void arena_free(voidpf opaque, voidpf address) {
+    (void)opaque;
+    (void)address;
+}
+
+static int clamp_level(int level) {
+    if (level < COMPRESS_LEVEL_MIN) return COMPRESS_LEVEL_MIN;
+    if (level > COMPRESS_LEVEL_MAX) return COMPRESS_LEVEL_MAX;
+    return level;
+}
+
+Result compress_stream_init(CompressStream *s, int level) {
+    memset(s, 0, sizeof(*s));
+    s->arena = aligned_alloc(16, COMPRESS_ARENA_SIZE);
+    if (!s->arena) return MAKERESULT(Module_Libnx, LibnxError_OutOfMemory);
+    s->level = clamp_level(level);
+    s->zs.zalloc = arena_alloc;
+    s->zs.zfree = arena_free;
+    s->zs.opaque = s;
+    // windowBits + 16：输出 gzip 封装，远端文件可以直接用 gunzip 解开
+    if (deflateInit2(&s->zs, s->level, Z_DEFLATED, COMPRESS_WINDOW_BITS + 16, COMPRESS_MEM_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK) {
+        free(s->arena);
+        s->arena = NULL;
+        return MAKERESULT(Module_Libnx, LibnxError_OutOfMemory);
+    }
+    return 0;
+}
+
+void compress_stream_exit(CompressStream *s) {
+    if (!s->arena) return;
+    deflateEnd(&s->zs);
+    free(s->arena);
+    s->arena = NULL;
+}
+
+void compress_stream_reset(CompressStream *s, int level) {
+    deflateReset(&s->zs);
+    s->finished = false;
+    level = clamp_level(level);
+    // 刚 reset 时没有待输出数据，切换级别一定成功
+    if (level != s->level && deflateParams(&s->zs, level, Z_DEFAULT_STRATEGY) == Z_OK) s->level = level;
+}
+
+void compress_stream_set_level(CompressStream *s, int level, u8 *out, size_t *out_len, size_t out_cap) {
+    level = clamp_level(level);
+    if (level == s->level || s->finished) return;
+    // 切换前 zlib 以旧级别把已缓冲的输入压成一个块写到 out；空间不够时返回 Z_BUF_ERROR，保持原级别
+    s->zs.next_in = Z_NULL;
+    s->zs.avail_in = 0;
+    s->zs.next_out = out + *out_len;
+    s->zs.avail_out = (uInt)(out_cap - *out_len);
+    int zr = deflateParams(&s->zs, level, Z_DEFAULT_STRATEGY);
+    *out_len = out_cap - s->zs.avail_out;
+    if (zr == Z_OK) s->level = level;
+}
+
+Result compress_stream_run(CompressStream *s, const u8 *in, size_t *in_len, u8 *out, size_t *out_len, size_t out_cap, bool finish) {
+    s->zs.next_in = (Bytef*)in;
+    s->zs.avail_in = (uInt)*in_len;
+    s->zs.next_out = out + *out_len;
+    s->zs.avail_out = (uInt)(out_cap - *out_len);
+    int zr = deflate(&s->zs, finish ? Z_FINISH : Z_NO_FLUSH);
+    *in_len -= s->zs.avail_in;
+    *out_len = out_cap - s->zs.avail_out;
+    if (zr == Z_STREAM_END) {
+        s->finished = true;
+        return 0;
+    }
+    // Z_BUF_ERROR 只表示这次没有进展（输出满或输入空），不是错误
+    if (zr != Z_OK && zr != Z_BUF_ERROR) return MAKERESULT(Module_Libnx, LibnxError_IoError);
+    return 0;
+}
+
+void compress_control_init(CompressControl *c, int level) {
+    memset(c, 0, sizeof(*c));
+    c->fixed = level != 0;
+    c->level = c->fixed ? clamp_level(level) : COMPRESS_LEVEL_START;
+    c->window_start = armGetSystemTick();
+}
+
+void compress_control_add_work(CompressControl *c, u64 out_bytes, u64 ns) {
+    c->window_out += out_bytes;
+    c->window_ns += ns;
+}
+
+void compress_control_add_sent(CompressControl *c, u64 bytes) {
+    c->window_sent += bytes;
+}
+
+int compress_control_update(CompressControl *c) {
+    u64 now = armGetSystemTick();
+    u64 wall_ns = armTicksToNs(now - c->window_start);
+    if (c->fixed || wall_ns < COMPRESS_ADAPT_INTERVAL_NS || c->window_ns == 0) return c->level;
+    // 以字节/秒比较；P < 1.25U 视为 CPU 跟不上，P > 2U 视为网络跟不上，中间保持（避免来回抖动）
+    double produce = (double)c->window_out * 1e9 / (double)c->window_ns;
+    double upload = (double)c->window_sent * 1e9 / (double)wall_ns;
+    int level = c->level;
+    if (produce < upload * 1.25) level--;
+    else if (produce > upload * 2.0) level++;
+    level = clamp_level(level);
+    if (level != c->level) {
+        c->level = level;
+        c->changes++;
+    }
+    c->window_start = now;
+    c->window_out = c->window_ns = c->window_sent = 0;
+    return c->level;
+}
@@ -0,0 +1,53 @@
+#pragma once
+// 流式压缩（gzip 封装的 deflate）：每条上传连接一个压缩流，状态内存从预分配的固定区域中划出，
+// 跨文件只 deflateReset，不再分配；压缩级别由 CompressControl 按压缩产出速度与上传速度自动调整
+#include "../util/platform.h"
+#include <zlib.h>
+
+// 窗口 8KB、memLevel 7：单个流的状态约 110KB（默认参数需要约 270KB），存档类数据的压缩率损失很小
+#define COMPRESS_WINDOW_BITS 13
+#define COMPRESS_MEM_LEVEL 7
+#define COMPRESS_ARENA_SIZE 0x20000
+#define COMPRESS_LEVEL_MIN 1
+#define COMPRESS_LEVEL_MAX 9
+#define COMPRESS_LEVEL_START 6
+#define COMPRESS_ADAPT_INTERVAL_NS 250000000ULL
+#define COMPRESS_SUFFIX ".gz"
+
+typedef struct {
+    z_stream zs;
+    u8 *arena;          // zlib 的全部内部分配都落在这里
+    size_t arena_used;
+    int level;
+    bool finished;      // 已输出 gzip 尾
+} CompressStream;
+
+Result compress_stream_init(CompressStream *s, int level);
+void compress_stream_exit(CompressStream *s);
+// 开始新文件（不分配内存）
+void compress_stream_reset(CompressStream *s, int level);
+// 切换级别：已缓冲的输入先以旧级别输出到 out[*out_len..out_cap)；空间不够时保持原级别，稍后再试
+void compress_stream_set_level(CompressStream *s, int level, u8 *out, size_t *out_len, size_t out_cap);
+// 压缩 in[0..*in_len)，输出追加到 out[*out_len..out_cap)；返回后 *in_len 为实际消耗的字节数。
+// finish 为真表示这是文件的最后一段输入；流结束时 s->finished 置位
+Result compress_stream_run(CompressStream *s, const u8 *in, size_t *in_len, u8 *out, size_t *out_len, size_t out_cap, bool finish);
+
+// 级别控制：在一个观测窗口内比较产出速度 P（压缩输出字节 / 读线程读盘+压缩的忙碌时间）与上传速度 U。
+// 读线程是瓶颈时网络发完就等，U 会贴近 P，此时降级；P 远大于 U 说明网络是瓶颈，CPU 还有富余，升级
+typedef struct {
+    int level;          // 当前目标级别；fixed 时不变
+    bool fixed;
+    u64 window_start;   // armGetSystemTick
+    u64 window_out;     // 窗口内压缩输出字节
+    u64 window_ns;      // 窗口内读线程忙碌时间
+    u64 window_sent;    // 窗口内已发送字节
+    u32 changes;        // 级别调整次数
+} CompressControl;
+
+// level 为 0 表示自动
+void compress_control_init(CompressControl *c, int level);
+// 记录读线程产出的一块（压缩输出字节与读盘+压缩耗时）
+void compress_control_add_work(CompressControl *c, u64 out_bytes, u64 ns);
+void compress_control_add_sent(CompressControl *c, u64 bytes);
+// 窗口到期时重新评估级别；返回当前目标级别
+int compress_control_update(CompressControl *c);
@@ -0,0 +1,635 @@
+#include "dedup.h"
+#include "cdc.h"
+#include "progress.h"
+#include "../util/hash.h"
+#include "../util/log.h"
+#include "../util/fspool.h"
+#include "../util/metrics.h"
+#include <curl/curl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define DEDUP_NEW_RECIPE_PATH DEDUP_RECIPE_FILE_PATH ".new"
+
+// ---- 远端：一个 curl 句柄顺序收发，连接在各次传输之间复用 ----
+
+typedef struct {
+    CURL *curl;
+    char base_url[256];
+    char userpwd[132];
+    // 上传源：内存块或本地文件
+    const u8 *src;
+    size_t src_len;
+    size_t src_off;
+    FILE *src_file;
+    // 下载目标（按需增长，不超过 dst_limit）
+    u8 *dst;
+    size_t dst_len;
+    size_t dst_cap;
+    size_t dst_limit;
+} DedupRemote;
+
+static size_t remote_read_cb(char *dst, size_t size, size_t nitems, void *userdata) {
+    DedupRemote *r = (DedupRemote*)userdata;
+    size_t want = size * nitems;
+    size_t n;
+    if (r->src_file) {
+        n = fread(dst, 1, want, r->src_file);
+    } else {
+        n = r->src_len - r->src_off;
+        if (n > want) n = want;
+        memcpy(dst, r->src + r->src_off, n);
+        r->src_off += n;
+    }
+    metrics_add(Metric_UploadBytes, n);
+    return n;
+}
+
+static size_t remote_write_cb(char *ptr, size_t size, size_t nmemb, void *userdata) {
+    DedupRemote *r = (DedupRemote*)userdata;
+    size_t n = size * nmemb;
+    if (r->dst_len + n > r->dst_limit) return 0;
+    if (r->dst_len + n > r->dst_cap) {
+        size_t cap = r->dst_cap ? r->dst_cap : CDC_MAX_SIZE;
+        while (cap < r->dst_len + n) cap *= 2;
+        u8 *dst = realloc(r->dst, cap);
+        if (!dst) return 0;
+        r->dst = dst;
+        r->dst_cap = cap;
+    }
+    memcpy(r->dst + r->dst_len, ptr, n);
+    r->dst_len += n;
+    return n;
+}
+
+static Result remote_init(DedupRemote *r, const DedupOptions *opt) {
+    memset(r, 0, sizeof(*r));
+    if (!opt->url || !opt->url[0]) return MAKERESULT(Module_Libnx, LibnxError_BadInput);
+    snprintf(r->base_url, sizeof(r->base_url), "%s", opt->url);
+    size_t len = strlen(r->base_url);
+    while (len > 0 && r->base_url[len - 1] == '/') r->base_url[--len] = '\0';
+    snprintf(r->userpwd, sizeof(r->userpwd), "%s:%s", opt->user ? opt->user : "anonymous", opt->password ? opt->password : "");
+    r->curl = curl_easy_init();
+    if (!r->curl) return MAKERESULT(Module_Libnx, LibnxError_OutOfMemory);
+    curl_easy_setopt(r->curl, CURLOPT_READFUNCTION, remote_read_cb);
+    curl_easy_setopt(r->curl, CURLOPT_READDATA, r);
+    curl_easy_setopt(r->curl, CURLOPT_WRITEFUNCTION, remote_write_cb);
+    curl_easy_setopt(r->curl, CURLOPT_WRITEDATA, r);
+    curl_easy_setopt(r->curl, CURLOPT_USERPWD, r->userpwd);
+    curl_easy_setopt(r->curl, CURLOPT_FTP_CREATE_MISSING_DIRS, (long)CURLFTP_CREATE_DIR_RETRY);
+    curl_easy_setopt(r->curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(r->curl, CURLOPT_CONNECTTIMEOUT, 10L);
+    curl_easy_setopt(r->curl, CURLOPT_LOW_SPEED_LIMIT, 1L);   // 30 秒内没有任何进展视为断线
+    curl_easy_setopt(r->curl, CURLOPT_LOW_SPEED_TIME, 30L);
+    return 0;
+}
+
+static void remote_exit(DedupRemote *r) {
+    if (r->curl) curl_easy_cleanup(r->curl);
+    free(r->dst);
+    memset(r, 0, sizeof(*r));
+}
+
+// rel 只由十六进制、数字与 / 组成，不需要转义
+static CURLcode remote_perform(DedupRemote *r, const char *rel) {
+    char url[512];
+    snprintf(url, sizeof(url), "%s/%s", r->base_url, rel);
+    curl_easy_setopt(r->curl, CURLOPT_URL, url);
+    CURLcode cc = CURLE_OK;
+    for (u32 attempt = 0; attempt <= DEDUP_MAX_RETRIES; ++attempt) {
+        r->src_off = 0;
+        if (r->src_file) rewind(r->src_file);
+        r->dst_len = 0;
+        cc = curl_easy_perform(r->curl);
+        if (cc == CURLE_OK || cc == CURLE_REMOTE_FILE_NOT_FOUND || cc == CURLE_WRITE_ERROR) break;
+        if (attempt < DEDUP_MAX_RETRIES) {
+            metrics_inc(Metric_UploadRetries);
+            log_warning("传输中断 %s（%s），第 %u 次重试", rel, curl_easy_strerror(cc), attempt + 1);
+        }
+    }
+    return cc;
+}
+
+// 上传内存块（file 为 NULL）或整个本地文件
+static Result remote_put(DedupRemote *r, const char *rel, const u8 *data, size_t len, FILE *file) {
+    r->src = data;
+    r->src_len = len;
+    r->src_file = file;
+    curl_easy_setopt(r->curl, CURLOPT_UPLOAD, 1L);
+    curl_easy_setopt(r->curl, CURLOPT_INFILESIZE_LARGE, (curl_off_t)len);
+    CURLcode cc = remote_perform(r, rel);
+    r->src = NULL;
+    r->src_file = NULL;
+    if (cc == CURLE_OK) return 0;
+    log_error("上传失败 %s: %s", rel, curl_easy_strerror(cc));
+    return MAKERESULT(Module_Libnx, LibnxError_IoError);
+}
+
+// 下载到 r->dst；超过 limit 字节视为失败
+static Result remote_get(DedupRemote *r, const char *rel, size_t limit) {
+    r->dst_limit = limit;
+    curl_easy_setopt(r->curl, CURLOPT_UPLOAD, 0L);
+    CURLcode cc = remote_perform(r, rel);
+    if (cc == CURLE_OK) return 0;
+    if (cc == CURLE_REMOTE_FILE_NOT_FOUND) return MAKERESULT(Module_Libnx, LibnxError_NotFound);
+    log_error("下载失败 %s: %s", rel, curl_easy_strerror(cc));
+    return MAKERESULT(Module_Libnx, LibnxError_IoError);
+}
+
+static void chunk_rel_path(const u8 *digest, char *out, size_t size) {
+    char hex[SHA256_DIGEST_SIZE * 2 + 1];
+    for (int i = 0; i < SHA256_DIGEST_SIZE; ++i) snprintf(hex + i * 2, 3, "%02x", digest[i]);
+    snprintf(out, size, "chunks/%.2s/%s", hex, hex);
+}
+
+// ---- 配方读写 ----
+
+typedef struct {
+    FILE *f;                // 本地文件；为 NULL 时读 mem
+    const u8 *mem;
+    size_t mem_len;
+    size_t mem_off;
+    RecipeHeader hdr;
+    FastHash hash;
+    u32 files_left;
+    u32 chunks_left;        // 当前文件还没读的块引用
+    bool ok;                // 目前读到的内容都合法
+    RecipeFile cur;
+    char path[SCAN_PATH_MAX];
+} RecipeReader;
+
+static bool reader_raw(RecipeReader *r, void *out, size_t len) {
+    if (!r->ok) return false;
+    if (r->f) {
+        r->ok = fread(out, 1, len, r->f) == len;
+    } else {
+        r->ok = r->mem_len - r->mem_off >= len;
+        if (r->ok) {
+            memcpy(out, r->mem + r->mem_off, len);
+            r->mem_off += len;
+        }
+    }
+    if (r->ok) fasthash_update(&r->hash, out, len);
+    return r->ok;
+}
+
+// 读入并校验头（头本身不计入 body_hash）
+static bool reader_begin(RecipeReader *r, u64 target_hash) {
+    r->ok = true;
+    if (r->f) {
+        r->ok = fread(&r->hdr, sizeof(r->hdr), 1, r->f) == 1;
+    } else {
+        r->ok = r->mem_len >= sizeof(r->hdr);
+        if (r->ok) memcpy(&r->hdr, r->mem, sizeof(r->hdr));
+        r->mem_off = sizeof(r->hdr);
+    }
+    r->ok = r->ok && memcmp(r->hdr.magic, DEDUP_RECIPE_MAGIC, 4) == 0 &&
+            r->hdr.version == DEDUP_RECIPE_VERSION && r->hdr.target_hash == target_hash;
+    fasthash_init(&r->hash);
+    r->files_left = r->ok ? r->hdr.file_count : 0;
+    r->chunks_left = 0;
+    return r->ok;
+}
+
+static bool reader_chunk(RecipeReader *r, RecipeChunk *c) {
+    if (r->chunks_left == 0 || !reader_raw(r, c, sizeof(*c))) return false;
+    r->chunks_left--;
+    return true;
+}
+
+// 跳过当前文件剩下的块引用，读入下一个文件；没有了（或内容不合法）返回 false
+static bool reader_next(RecipeReader *r) {
+    RecipeChunk c;
+    while (reader_chunk(r, &c)) {}
+    if (!r->ok || r->files_left == 0) return false;
+    if (!reader_raw(r, &r->cur, sizeof(r->cur)) || r->cur.path_len >= SCAN_PATH_MAX ||
+        !reader_raw(r, r->path, r->cur.path_len)) {
+        r->ok = false;
+        return false;
+    }
+    r->path[r->cur.path_len] = '\0';
+    r->files_left--;
+    r->chunks_left = r->cur.chunk_count;
+    return true;
+}
+
+// 读完剩余内容并核对整体哈希
+static bool reader_finish(RecipeReader *r) {
+    while (reader_next(r)) {}
+    return r->ok && fasthash_final(&r->hash) == r->hdr.body_hash;
+}
+
+typedef struct {
+    FILE *f;
+    FastHash hash;
+    RecipeHeader hdr;
+    bool ok;
+} RecipeWriter;
+
+static void writer_raw(RecipeWriter *w, const void *data, size_t len) {
+    if (!w->ok) return;
+    w->ok = fwrite(data, 1, len, w->f) == len;
+    fasthash_update(&w->hash, data, len);
+}
+
+// 头先占位，结束时回填
+static bool writer_open(RecipeWriter *w, const char *path) {
+    memset(w, 0, sizeof(*w));
+    w->f = fopen(path, "wb");
+    w->ok = w->f && fwrite(&w->hdr, sizeof(w->hdr), 1, w->f) == 1;
+    fasthash_init(&w->hash);
+    return w->ok;
+}
+
+static void writer_file(RecipeWriter *w, const RecipeFile *rf, const char *path) {
+    writer_raw(w, rf, sizeof(*rf));
+    writer_raw(w, path, rf->path_len);
+    w->hdr.file_count++;
+    w->hdr.chunk_refs += rf->chunk_count;
+}
+
+static bool writer_close(RecipeWriter *w, u32 generation, u64 target_hash) {
+    if (!w->f) return false;
+    memcpy(w->hdr.magic, DEDUP_RECIPE_MAGIC, 4);
+    w->hdr.version = DEDUP_RECIPE_VERSION;
+    w->hdr.generation = generation;
+    w->hdr.target_hash = target_hash;
+    w->hdr.body_hash = fasthash_final(&w->hash);
+    w->ok = w->ok && fseek(w->f, 0, SEEK_SET) == 0 && fwrite(&w->hdr, sizeof(w->hdr), 1, w->f) == 1;
+    w->ok = fclose(w->f) == 0 && w->ok;
+    w->f = NULL;
+    return w->ok;
+}
+
+// 沿用旧配方中的当前文件（连同块引用）
+static void recipe_copy_file(RecipeReader *r, RecipeWriter *w) {
+    writer_file(w, &r->cur, r->path);
+    RecipeChunk c;
+    while (reader_chunk(r, &c)) writer_raw(w, &c, sizeof(c));
+}
+
+// ---- 备份 ----
+
+typedef struct {
+    DedupRemote remote;
+    ChunkIndex index;
+    Throttle *throttle;
+    u8 *buf;
+    RecipeChunk *refs;      // 当前文件的块引用
+    u32 ref_count;
+    u32 ref_capacity;
+    DedupStats *stats;
+} DedupContext;
+
+static ssize_t read_full(int fd, u8 *dst, size_t len) {
+    size_t got = 0;
+    while (got < len) {
+        ssize_t n = read(fd, dst + got, len - got);
+        if (n < 0) return -1;
+        if (n == 0) break;
+        got += (size_t)n;
+    }
+    return (ssize_t)got;
+}
+
+// 算出块的 SHA-256；块库里没有时上传并记入索引
+static Result dedup_store_chunk(DedupContext *c, const u8 *data, size_t len, RecipeChunk *ref) {
+    Sha256 sha;
+    sha256_init(&sha);
+    sha256_update(&sha, data, len);
+    sha256_final(&sha, ref->digest);
+    ref->size = (u32)len;
+    c->stats->chunks++;
+    if (chunk_index_contains(&c->index, ref->digest)) return 0;
+
+    char rel[96];
+    chunk_rel_path(ref->digest, rel, sizeof(rel));
+    if (c->throttle) throttle_acquire(c->throttle, ThrottleKind_Net, len);
+    Result rc = remote_put(&c->remote, rel, data, len, NULL);
+    if (R_FAILED(rc)) return rc;
+    c->stats->chunks_new++;
+    c->stats->bytes_new += len;
+    return chunk_index_add(&c->index, ref->digest, (u32)len);
+}
+
+// 读文件、切块、存入块库；成功时 rf 与 c->refs 描述这个文件
+static Result dedup_chunk_file(DedupContext *c, const char *path, RecipeFile *rf) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return MAKERESULT(Module_Libnx, LibnxError_NotFound);
+    Sha256 whole;
+    sha256_init(&whole);
+    c->ref_count = 0;
+    size_t have = 0;
+    bool eof = false;
+    u64 total = 0;
+    Result rc = 0;
+    while (R_SUCCEEDED(rc)) {
+        if (!eof) {
+            size_t want = DEDUP_READ_BUFFER_SIZE - have;
+            if (c->throttle) throttle_acquire(c->throttle, ThrottleKind_Disk, want);
+            fspool_enter(FsRole_Data);
+            ssize_t n = read_full(fd, c->buf + have, want);
+            fspool_leave(FsRole_Data);
+            if (n < 0) {
+                rc = MAKERESULT(Module_Libnx, LibnxError_IoError);
+                break;
+            }
+            eof = (size_t)n < want;
+            have += (size_t)n;
+            total += (u64)n;
+            c->stats->bytes_read += (u64)n;
+        }
+        size_t off = 0;
+        size_t len;
+        while (R_SUCCEEDED(rc) && (len = cdc_cut(c->buf + off, have - off, eof)) > 0) {
+            if (c->ref_count == c->ref_capacity) {
+                u32 cap = c->ref_capacity ? c->ref_capacity * 2 : 64;
+                RecipeChunk *refs = realloc(c->refs, cap * sizeof(RecipeChunk));
+                if (!refs) {
+                    rc = MAKERESULT(Module_Libnx, LibnxError_OutOfMemory);
+                    break;
+                }
+                c->refs = refs;
+                c->ref_capacity = cap;
+            }
+            sha256_update(&whole, c->buf + off, len);
+            rc = dedup_store_chunk(c, c->buf + off, len, &c->refs[c->ref_count++]);
+            off += len;
+            progress_add_bytes(len);
+        }
+        memmove(c->buf, c->buf + off, have - off);
+        have -= off;
+        if (eof && have == 0) break;
+    }
+    close(fd);
+    rf->size = total;
+    rf->chunk_count = c->ref_count;
+    sha256_final(&whole, rf->sha256);
+    return rc;
+}
+
+// 本地没有可用的旧配方时，从远端 latest 的头里取代数，避免覆盖已有的配方
+static u32 dedup_remote_generation(DedupRemote *r, u64 target_hash) {
+    char rel[64];
+    snprintf(rel, sizeof(rel), "recipes/%s.rcp", DEDUP_LATEST_RECIPE);
+    if (R_FAILED(remote_get(r, rel, DEDUP_MAX_RECIPE_SIZE))) return 0;
+    RecipeReader rd;
+    memset(&rd, 0, sizeof(rd));
+    rd.mem = r->dst;
+    rd.mem_len = r->dst_len;
+    return reader_begin(&rd, target_hash) ? rd.hdr.generation : 0;
+}
+
+static Result dedup_upload_recipe(DedupContext *c, u32 generation) {
+    FILE *f = fopen(DEDUP_NEW_RECIPE_PATH, "rb");
+    if (!f) return MAKERESULT(Module_Libnx, LibnxError_IoError);
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    char rel[64];
+    snprintf(rel, sizeof(rel), "recipes/%08u.rcp", generation);
+    Result rc = remote_put(&c->remote, rel, NULL, (size_t)len, f);
+    if (R_SUCCEEDED(rc)) {
+        snprintf(rel, sizeof(rel), "recipes/%s.rcp", DEDUP_LATEST_RECIPE);
+        rc = remote_put(&c->remote, rel, NULL, (size_t)len, f);
+    }
+    fclose(f);
+    return rc;
+}
+
+Result dedup_backup(const DedupOptions *opt, const BackupFileList *files, DedupStats *stats) {
+    memset(stats, 0, sizeof(*stats));
+    u64 start = armGetSystemTick();
+    DedupContext c;
+    memset(&c, 0, sizeof(c));
+    c.throttle = opt->throttle;
+    c.stats = stats;
+    u64 target_hash = fasthash_str(opt->url);
+    Result rc = remote_init(&c.remote, opt);
+    if (R_SUCCEEDED(rc)) rc = chunk_index_load(&c.index, CHUNK_INDEX_FILE_PATH, target_hash);
+    if (R_SUCCEEDED(rc)) {
+        c.buf = malloc(DEDUP_READ_BUFFER_SIZE);
+        if (!c.buf) rc = MAKERESULT(Module_Libnx, LibnxError_OutOfMemory);
+    }
+    RecipeWriter w;
+    if (R_SUCCEEDED(rc) && !writer_open(&w, DEDUP_NEW_RECIPE_PATH)) {
+        if (w.f) fclose(w.f);
+        rc = MAKERESULT(Module_Libnx, LibnxError_IoError);
+    }
+    if (R_FAILED(rc)) {
+        free(c.buf);
+        chunk_index_free(&c.index);
+        remote_exit(&c.remote);
+        return rc;
+    }
+
+    // 旧配方与 files 同样按路径排序，边走边对齐
+    RecipeReader old;
+    memset(&old, 0, sizeof(old));
+    old.f = fopen(DEDUP_RECIPE_FILE_PATH, "rb");
+    bool have_old = old.f && reader_begin(&old, target_hash);
+    bool old_more = have_old && reader_next(&old);
+
+    progress_begin(files->count, files->total_bytes);
+    char local[SCAN_PATH_MAX + 256];
+    for (u32 i = 0; i < files->count; ++i) {
+        const BackupFile *f = &files->items[i];
+        while (old_more && strcmp(old.path, f->path) < 0) old_more = reader_next(&old);
+        bool old_match = old_more && strcmp(old.path, f->path) == 0;
+        stats->files++;
+        if (old_match && old.cur.size == f->size && old.cur.mtime == f->mtime) {
+            recipe_copy_file(&old, &w);
+            stats->files_carried++;
+            stats->bytes_total += f->size;
+            progress_add_bytes(f->size);
+            progress_file_done();
+            continue;
+        }
+
+        snprintf(local, sizeof(local), "%s/%s", opt->local_root, f->path);
+        RecipeFile rf;
+        memset(&rf, 0, sizeof(rf));
+        rf.mtime = f->mtime;
+        rf.path_len = (u16)strlen(f->path);
+        Result frc = dedup_chunk_file(&c, local, &rf);
+        if (R_SUCCEEDED(frc)) {
+            writer_file(&w, &rf, f->path);
+            writer_raw(&w, c.refs, (size_t)c.ref_count * sizeof(RecipeChunk));
+            stats->bytes_total += rf.size;
+            metrics_inc(Metric_UploadFiles);
+        } else {
+            rc = frc;
+            stats->files_failed++;
+            metrics_inc(Metric_UploadFailedFiles);
+            log_error("去重备份失败 %s: 0x%x", f->path, frc);
+            if (old_match) {
+                recipe_copy_file(&old, &w);
+                stats->bytes_total += old.cur.size;
+            }
+        }
+        progress_file_done();
+    }
+
+    // 旧配方损坏时其中沿用的块列表不可信，这次不提交，并删掉它让下次全部重新切块
+    bool old_ok = true;
+    if (have_old) old_ok = reader_finish(&old);
+    if (old.f) fclose(old.f);
+    if (!old_ok) {
+        log_error("本地配方损坏，本次去重备份不提交");
+        remove(DEDUP_RECIPE_FILE_PATH);
+        rc = MAKERESULT(Module_Libnx, LibnxError_IoError);
+    }
+
+    u32 prev = have_old && old_ok ? old.hdr.generation : dedup_remote_generation(&c.remote, target_hash);
+    stats->generation = prev + 1;
+    bool written = writer_close(&w, stats->generation, target_hash);
+    if (old_ok && written) {
+        Result urc = dedup_upload_recipe(&c, stats->generation);
+        if (R_SUCCEEDED(urc)) {
+            remove(DEDUP_RECIPE_FILE_PATH);
+            if (rename(DEDUP_NEW_RECIPE_PATH, DEDUP_RECIPE_FILE_PATH) != 0) log_error("配方改名失败");
+        } else {
+            rc = urc;
+        }
+    } else if (!written) {
+        rc = MAKERESULT(Module_Libnx, LibnxError_IoError);
+    }
+    remove(DEDUP_NEW_RECIPE_PATH);
+    // 已上传的块无论配方是否提交都在块库里
+    if (c.index.added) {
+        Result irc = chunk_index_save(&c.index, CHUNK_INDEX_FILE_PATH);
+        if (R_FAILED(irc)) log_error("保存块索引失败: 0x%x", irc);
+    }
+    progress_end(R_SUCCEEDED(rc));
+
+    free(c.refs);
+    free(c.buf);
+    chunk_index_free(&c.index);
+    remote_exit(&c.remote);
+    stats->elapsed_ns = armTicksToNs(armGetSystemTick() - start);
+    return rc;
+}
+
+// ---- 恢复 ----
+
+// 逐级创建 path 的上级目录
+static void make_parent_dirs(char *path) {
+    for (char *p = path + 1; *p; ++p) {
+        if (*p != '/') continue;
+        *p = '\0';
+        if (mkdir(path, 0777) != 0 && errno != EEXIST) log_warning("无法创建目录 %s", path);
+        *p = '/';
+    }
+}
+
+// 配方中的路径只能落在目标目录之内
+static bool restore_path_safe(const char *path) {
+    if (!path[0] || path[0] == '/') return false;
+    for (const char *p = path; *p;) {
+        const char *end = strchr(p, '/');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        if (len == 0 || (len == 2 && p[0] == '.' && p[1] == '.')) return false;
+        p += len;
+        if (*p) ++p;
+    }
+    return true;
+}
+
+// 按块下载并校验，写入 path；整个文件的 SHA-256 也要一致
+static Result restore_file(DedupRemote *r, RecipeReader *rd, const char *path, DedupRestoreStats *stats) {
+    FILE *out = fopen(path, "wb");
+    if (!out) return MAKERESULT(Module_Libnx, LibnxError_IoError);
+    Sha256 whole;
+    sha256_init(&whole);
+    Result rc = 0;
+    RecipeChunk ref;
+    u64 total = 0;
+    while (R_SUCCEEDED(rc) && reader_chunk(rd, &ref)) {
+        char rel[96];
+        chunk_rel_path(ref.digest, rel, sizeof(rel));
+        rc = remote_get(r, rel, CDC_MAX_SIZE);
+        if (R_FAILED(rc)) break;
+        u8 digest[SHA256_DIGEST_SIZE];
+        Sha256 sha;
+        sha256_init(&sha);
+        sha256_update(&sha, r->dst, r->dst_len);
+        sha256_final(&sha, digest);
+        if (r->dst_len != ref.size || memcmp(digest, ref.digest, SHA256_DIGEST_SIZE) != 0) {
+            log_error("块内容不符 %s", rel);
+            rc = MAKERESULT(Module_Libnx, LibnxError_IoError);
+            break;
+        }
+        sha256_update(&whole, r->dst, r->dst_len);
+        if (fwrite(r->dst, 1, r->dst_len, out) != r->dst_len) rc = MAKERESULT(Module_Libnx, LibnxError_IoError);
+        total += r->dst_len;
+        stats->chunks++;
+    }
+    if (fclose(out) != 0 && R_SUCCEEDED(rc)) rc = MAKERESULT(Module_Libnx, LibnxError_IoError);
+    if (R_SUCCEEDED(rc)) {
+        u8 digest[SHA256_DIGEST_SIZE];
+        sha256_final(&whole, digest);
+        if (total != rd->cur.size || rd->chunks_left || memcmp(digest, rd->cur.sha256, SHA256_DIGEST_SIZE) != 0) {
+            log_error("文件校验失败 %s", path);
+            rc = MAKERESULT(Module_Libnx, LibnxError_IoError);
+        }
+    }
+    if (R_FAILED(rc)) remove(path);
+    else stats->bytes += total;
+    return rc;
+}
+
+Result dedup_restore(const DedupOptions *opt, const char *name, DedupRestoreStats *stats) {
+    memset(stats, 0, sizeof(*stats));
+    u64 start = armGetSystemTick();
+    u64 target_hash = fasthash_str(opt->url);
+    DedupRemote r;
+    Result rc = remote_init(&r, opt);
+    char rel[96];
+    snprintf(rel, sizeof(rel), "recipes/%s.rcp", name ? name : DEDUP_LATEST_RECIPE);
+    if (R_SUCCEEDED(rc)) rc = remote_get(&r, rel, DEDUP_MAX_RECIPE_SIZE);
+    if (R_FAILED(rc)) {
+        remote_exit(&r);
+        return rc;
+    }
+    // 配方留在自己的缓冲里，r.dst 接着用来收块
+    u8 *recipe = r.dst;
+    size_t recipe_len = r.dst_len;
+    r.dst = NULL;
+    r.dst_len = r.dst_cap = 0;
+
+    // 先整体核对一遍，再逐个文件恢复
+    RecipeReader rd;
+    memset(&rd, 0, sizeof(rd));
+    rd.mem = recipe;
+    rd.mem_len = recipe_len;
+    if (!reader_begin(&rd, target_hash) || !reader_finish(&rd)) {
+        log_error("配方无效: %s", rel);
+        rc = MAKERESULT(Module_Libnx, LibnxError_BadInput);
+    }
+    stats->generation = rd.hdr.generation;
+    if (R_SUCCEEDED(rc)) reader_begin(&rd, target_hash);
+    char path[SCAN_PATH_MAX + 256];
+    // 个别文件失败时继续恢复其余文件
+    while (R_SUCCEEDED(rc) && reader_next(&rd)) {
+        stats->files++;
+        Result frc = MAKERESULT(Module_Libnx, LibnxError_BadInput);
+        if (restore_path_safe(rd.path)) {
+            snprintf(path, sizeof(path), "%s/%s", opt->local_root, rd.path);
+            make_parent_dirs(path);
+            frc = restore_file(&r, &rd, path, stats);
+        }
+        if (R_FAILED(frc)) {
+            stats->files_failed++;
+            log_error("恢复失败 %s: 0x%x", rd.path, frc);
+        }
+    }
+    if (stats->files_failed) rc = MAKERESULT(Module_Libnx, LibnxError_IoError);
+    free(recipe);
+    remote_exit(&r);
+    stats->elapsed_ns = armTicksToNs(armGetSystemTick() - start);
+    return rc;
+}
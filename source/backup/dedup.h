@@ -0,0 +1,81 @@
+#pragma once
+// 去重备份：文件按内容定义分块（cdc.h），远端块库只存每个不同内容的块一份，
+// 每次备份另写一份配方（recipe），按路径顺序列出每个文件的大小、SHA-256 与组成它的块。
+// 远端布局（相对 ftp_url）：
+//   chunks/<SHA-256 前两位>/<SHA-256>   块内容（原样，不压缩）
+//   recipes/<代数 8 位>.rcp             每次备份的配方；recipes/latest.rcp 为最近一次
+// 配方在本地另留一份（DEDUP_RECIPE_FILE_PATH）：size/mtime 都没变的文件直接沿用其中的块列表，不再读文件
+#include "../util/platform.h"
+#include "../util/checksum.h"
+#include "scan.h"
+#include "throttle.h"
+
+#define DEDUP_RECIPE_FILE_PATH "/config/mario-pop/recipe.bin"
+#define DEDUP_RECIPE_MAGIC "MRCP"
+#define DEDUP_RECIPE_VERSION 1
+#define DEDUP_LATEST_RECIPE "latest"
+#define DEDUP_READ_BUFFER_SIZE (256 * 1024) // CDC_MAX_SIZE 的数倍，切块后不足一块的尾部搬回开头
+#define DEDUP_MAX_RETRIES 3
+#define DEDUP_MAX_RECIPE_SIZE (16 * 1024 * 1024) // 恢复时整份下载到内存
+
+typedef struct {
+    char magic[4];
+    u32 version;
+    u32 generation;         // 第几次去重备份（从 1 开始）
+    u32 file_count;
+    u64 target_hash;        // 块库所在的远端（与块索引相同）
+    u64 chunk_refs;         // 所有文件的块引用总数
+    u64 body_hash;          // 头之后全部内容的 fasthash
+} RecipeHeader;
+
+// 每个文件：RecipeFile + path_len 字节路径（不含结尾 0）+ chunk_count 个 RecipeChunk
+typedef struct {
+    u64 size;
+    s64 mtime;
+    u8 sha256[SHA256_DIGEST_SIZE];
+    u32 chunk_count;
+    u16 path_len;
+    u16 reserved;
+} RecipeFile;
+
+typedef struct {
+    u8 digest[SHA256_DIGEST_SIZE];
+    u32 size;
+} RecipeChunk;
+
+typedef struct {
+    const char *local_root;     // 备份时为源目录，恢复时为目标目录
+    const char *url;            // 远端根目录
+    const char *user;
+    const char *password;
+    Throttle *throttle;         // 可为 NULL
+} DedupOptions;
+
+typedef struct {
+    u32 generation;
+    u32 files;
+    u32 files_carried;          // size/mtime 未变、沿用上次块列表的文件
+    u32 files_failed;
+    u64 bytes_total;            // 本次配方覆盖的文件总字节数
+    u64 bytes_read;             // 为切块而读入的字节
+    u64 chunks;                 // 读入文件切出的块
+    u64 chunks_new;             // 其中块库里没有、需要上传的块
+    u64 bytes_new;              // 上传的块字节
+    u64 elapsed_ns;
+} DedupStats;
+
+typedef struct {
+    u32 generation;
+    u32 files;
+    u32 files_failed;
+    u64 bytes;
+    u64 chunks;
+    u64 elapsed_ns;
+} DedupRestoreStats;
+
+// 一次去重备份（files 须按路径排序，即 scan_tree 的输出）；有文件失败时返回最后一个错误，
+// 失败的文件在配方里沿用上一次的版本（没有则不列入）
+Result dedup_backup(const DedupOptions *opt, const BackupFileList *files, DedupStats *stats);
+// 按配方（recipes/<name>.rcp；name 为 NULL 时取 latest）把全部文件还原到 opt->local_root 下，
+// 每块与每个文件都校验 SHA-256
+Result dedup_restore(const DedupOptions *opt, const char *name, DedupRestoreStats *stats);
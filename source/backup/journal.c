@@ -0,0 +1,104 @@
+#include "journal.h"
+#include "../util/log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// 按 path_hash 排序；同一文件后写入的（文件中位置靠后）排在前面，去重时保留它
+static int record_cmp(const void *a, const void *b) {
+    const JournalRecord *x = *(JournalRecord* const*)a;
+    const JournalRecord *y = *(JournalRecord* const*)b;
+    if (x->path_hash != y->path_hash) return x->path_hash < y->path_hash ? -1 : 1;
+    return x > y ? -1 : x < y ? 1 : 0;
+}
+
+static void journal_load(Journal *j, FILE *f) {
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    JournalHeader hdr;
+    if (size < (long)sizeof(hdr) || fread(&hdr, sizeof(hdr), 1, f) != 1) return;
+    if (memcmp(hdr.magic, JOURNAL_MAGIC, 4) != 0 || hdr.version != JOURNAL_VERSION || hdr.target_hash != j->target_hash) return;
+    // 末尾写了一半的记录（写入时掉电）直接忽略
+    u32 count = (u32)((size_t)(size - (long)sizeof(hdr)) / sizeof(JournalRecord));
+    if (count == 0) return;
+    JournalRecord *raw = malloc(count * sizeof(JournalRecord));
+    JournalRecord **order = malloc(count * sizeof(JournalRecord*));
+    j->entries = malloc(count * sizeof(JournalRecord));
+    if (raw && order && j->entries) {
+        count = (u32)fread(raw, sizeof(JournalRecord), count, f);
+        for (u32 i = 0; i < count; ++i) order[i] = &raw[i];
+        qsort(order, count, sizeof(JournalRecord*), record_cmp);
+        for (u32 i = 0; i < count; ++i) {
+            if (j->count > 0 && j->entries[j->count - 1].path_hash == order[i]->path_hash) continue;
+            j->entries[j->count++] = *order[i];
+        }
+    }
+    free(order);
+    free(raw);
+}
+
+Result journal_open(Journal *j, const char *path, u64 target_hash) {
+    memset(j, 0, sizeof(*j));
+    j->target_hash = target_hash;
+    j->last_flush_tick = armGetSystemTick();
+    FILE *f = fopen(path, "rb");
+    if (f) {
+        journal_load(j, f);
+        fclose(f);
+    }
+    // 旧记录已在内存中：重写一个只含表头和有效记录的新文件，之后只追加
+    j->file = fopen(path, "wb");
+    if (!j->file) return MAKERESULT(Module_Libnx, LibnxError_IoError);
+    JournalHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, JOURNAL_MAGIC, 4);
+    hdr.version = JOURNAL_VERSION;
+    hdr.target_hash = target_hash;
+    fwrite(&hdr, sizeof(hdr), 1, j->file);
+    if (j->count) fwrite(j->entries, sizeof(JournalRecord), j->count, j->file);
+    fflush(j->file);
+    return 0;
+}
+
+const JournalRecord *journal_find(const Journal *j, u64 path_hash) {
+    u32 lo = 0, hi = j->count;
+    while (lo < hi) {
+        u32 mid = lo + (hi - lo) / 2;
+        u64 h = j->entries[mid].path_hash;
+        if (h == path_hash) return &j->entries[mid];
+        if (h < path_hash) lo = mid + 1;
+        else hi = mid;
+    }
+    return NULL;
+}
+
+void journal_flush(Journal *j) {
+    j->last_flush_tick = armGetSystemTick();
+    if (!j->file || j->pending_count == 0) return;
+    if (fwrite(j->pending, sizeof(JournalRecord), j->pending_count, j->file) != j->pending_count)
+        log_warning("续传日志写入失败");
+    fflush(j->file);
+    j->pending_count = 0;
+    j->flushes++;
+}
+
+void journal_append(Journal *j, const JournalRecord *rec) {
+    j->pending[j->pending_count++] = *rec;
+    if (j->pending_count == JOURNAL_BATCH_RECORDS ||
+        armTicksToNs(armGetSystemTick() - j->last_flush_tick) >= JOURNAL_FLUSH_INTERVAL_NS) {
+        journal_flush(j);
+    }
+}
+
+void journal_close(Journal *j, const char *path, bool discard) {
+    if (j->file) {
+        if (!discard) journal_flush(j);
+        fclose(j->file);
+        j->file = NULL;
+    }
+    if (discard) remove(path);
+    free(j->entries);
+    j->entries = NULL;
+    j->count = 0;
+}
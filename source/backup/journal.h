@@ -0,0 +1,48 @@
+#pragma once
+// 断点续传日志：大文件分块上传，每块被服务器确认（226）后记录已确认的偏移。
+// 日志只追加、成批写入（攒满一批或超过间隔才写一次 SD），中断后下次备份从记录的位置续传
+#include "../util/platform.h"
+#include <stdio.h>
+
+#define JOURNAL_FILE_PATH "/config/mario-pop/journal.bin"
+#define JOURNAL_MAGIC "MJNL"
+#define JOURNAL_VERSION 1
+#define JOURNAL_BATCH_RECORDS 32
+#define JOURNAL_FLUSH_INTERVAL_NS 2000000000ULL
+
+typedef struct {
+    u64 path_hash;      // fasthash_str(相对路径)
+    u64 offset;         // 服务器已确认的字节数；等于 size 表示整个文件已上传
+    u64 size;           // 记录时的文件大小与修改时间，不一致则记录作废
+    s64 mtime;
+    u64 content_hash;   // 文件完成时的内容哈希（未完成时为 0）
+} JournalRecord;
+
+typedef struct {
+    char magic[4];
+    u32 version;
+    u64 target_hash;    // 与清单相同：换了备份源或目标则日志作废
+} JournalHeader;
+
+typedef struct {
+    FILE *file;
+    u64 target_hash;
+    // 上次运行留下的记录（按 path_hash 排序，同一文件只保留最后一条）
+    JournalRecord *entries;
+    u32 count;
+    // 待写入的一批
+    JournalRecord pending[JOURNAL_BATCH_RECORDS];
+    u32 pending_count;
+    u64 last_flush_tick;
+    u32 flushes;
+} Journal;
+
+// 读取旧记录并以追加方式打开；目标不一致或文件损坏时从空日志开始
+Result journal_open(Journal *j, const char *path, u64 target_hash);
+// 查找上次运行留下的记录（本次新写入的不参与查找）
+const JournalRecord *journal_find(const Journal *j, u64 path_hash);
+// 追加一条记录（攒批，可能触发写入）
+void journal_append(Journal *j, const JournalRecord *rec);
+void journal_flush(Journal *j);
+// 关闭；discard 为真时删除日志文件（本次备份全部完成、清单已保存）
+void journal_close(Journal *j, const char *path, bool discard);
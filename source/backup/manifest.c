@@ -0,0 +1,210 @@
+#include "manifest.h"
+#include "../util/hash.h"
+#include "../util/log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void manifest_init(Manifest *m, u64 target_hash) {
+    memset(m, 0, sizeof(*m));
+    m->target_hash = target_hash;
+}
+
+void manifest_free(Manifest *m) {
+    free(m->entries);
+    free(m->crcs);
+    m->entries = NULL;
+    m->crcs = NULL;
+    m->count = m->capacity = 0;
+    m->crc_count = m->crc_capacity = 0;
+}
+
+static Result manifest_reserve(Manifest *m, u32 capacity) {
+    if (capacity <= m->capacity) return 0;
+    ManifestEntry *entries = realloc(m->entries, (size_t)capacity * sizeof(ManifestEntry));
+    if (!entries) return MAKERESULT(Module_Libnx, LibnxError_OutOfMemory);
+    m->entries = entries;
+    m->capacity = capacity;
+    return 0;
+}
+
+static Result manifest_reserve_crcs(Manifest *m, u32 capacity) {
+    if (capacity <= m->crc_capacity) return 0;
+    u32 *crcs = realloc(m->crcs, (size_t)capacity * sizeof(u32));
+    if (!crcs) return MAKERESULT(Module_Libnx, LibnxError_OutOfMemory);
+    m->crcs = crcs;
+    m->crc_capacity = capacity;
+    return 0;
+}
+
+u32 manifest_crc_count(const ManifestEntry *entry) {
+    if (!entry->chunk_size) return 0;
+    return (u32)((entry->size + entry->chunk_size - 1) / entry->chunk_size);
+}
+
+const u32 *manifest_entry_crcs(const Manifest *m, const ManifestEntry *entry) {
+    u32 n = manifest_crc_count(entry);
+    if (n == 0) return NULL;
+    return n == 1 ? &entry->crc : m->crcs + entry->crc;
+}
+
+// 版本 1 的条目只有前四个字段
+typedef struct {
+    u64 path_hash;
+    u64 size;
+    s64 mtime;
+    u64 content_hash;
+} ManifestEntryV1;
+
+static bool manifest_read_v1(Manifest *m, FILE *f, const ManifestHeader *hdr) {
+    FastHash h;
+    fasthash_init(&h);
+    for (u32 i = 0; i < hdr->count; ++i) {
+        ManifestEntryV1 v1;
+        if (fread(&v1, sizeof(v1), 1, f) != 1) return false;
+        fasthash_update(&h, &v1, sizeof(v1));
+        ManifestEntry *e = &m->entries[i];
+        memset(e, 0, sizeof(*e));
+        e->path_hash = v1.path_hash;
+        e->size = v1.size;
+        e->mtime = v1.mtime;
+        e->content_hash = v1.content_hash;
+    }
+    return fasthash_final(&h) == hdr->entries_hash;
+}
+
+static bool manifest_read_v2(Manifest *m, FILE *f, const ManifestHeader *hdr) {
+    if (fread(m->entries, sizeof(ManifestEntry), hdr->count, f) != hdr->count ||
+        R_FAILED(manifest_reserve_crcs(m, hdr->crc_count ? hdr->crc_count : 1)) ||
+        fread(m->crcs, sizeof(u32), hdr->crc_count, f) != hdr->crc_count) {
+        return false;
+    }
+    FastHash h;
+    fasthash_init(&h);
+    fasthash_update(&h, m->entries, (size_t)hdr->count * sizeof(ManifestEntry));
+    fasthash_update(&h, m->crcs, (size_t)hdr->crc_count * sizeof(u32));
+    if (fasthash_final(&h) != hdr->entries_hash) return false;
+    for (u32 i = 0; i < hdr->count; ++i) {
+        u32 n = manifest_crc_count(&m->entries[i]);
+        if (n > 1 && ((u64)m->entries[i].crc + n > hdr->crc_count)) return false;
+    }
+    m->crc_count = hdr->crc_count;
+    return true;
+}
+
+// 读取并校验一个清单文件；任何不一致都视为无效
+static bool manifest_read_file(Manifest *m, const char *path, u64 target_hash) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+    ManifestHeader hdr;
+    bool ok = fread(&hdr, sizeof(hdr), 1, f) == 1 &&
+              memcmp(hdr.magic, MANIFEST_MAGIC, 4) == 0 &&
+              (hdr.version == 1 || hdr.version == MANIFEST_VERSION) &&
+              hdr.target_hash == target_hash &&
+              R_SUCCEEDED(manifest_reserve(m, hdr.count ? hdr.count : 1));
+    if (ok) ok = hdr.version == 1 ? manifest_read_v1(m, f, &hdr) : manifest_read_v2(m, f, &hdr);
+    fclose(f);
+    m->count = ok ? hdr.count : 0;
+    if (!ok) m->crc_count = 0;
+    return ok;
+}
+
+Result manifest_load(Manifest *m, const char *path, u64 target_hash) {
+    manifest_init(m, target_hash);
+    if (manifest_read_file(m, path, target_hash)) return 0;
+    // 上次保存在删除旧文件与改名之间中断：.tmp 已完整写入
+    char tmp[256];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    manifest_read_file(m, tmp, target_hash);
+    return 0;
+}
+
+Result manifest_append(Manifest *m, const ManifestEntry *entry, const u32 *crcs) {
+    if (m->count == m->capacity) {
+        Result rc = manifest_reserve(m, m->capacity ? m->capacity * 2 : 256);
+        if (R_FAILED(rc)) return rc;
+    }
+    ManifestEntry e = *entry;
+    u32 n = manifest_crc_count(&e);
+    if (n > 0 && !crcs) {
+        // 缺 CRC 时整份摘要都不记（空文件没有块，摘要照记）
+        memset(e.sha256, 0, sizeof(e.sha256));
+        e.chunk_size = 0;
+        n = 0;
+    }
+    if (n == 0) {
+        e.crc = 0;
+    } else if (n == 1) {
+        e.crc = crcs[0];
+    } else {
+        if (m->crc_count + n > m->crc_capacity) {
+            u32 cap = m->crc_capacity ? m->crc_capacity * 2 : 256;
+            while (cap < m->crc_count + n) cap *= 2;
+            Result rc = manifest_reserve_crcs(m, cap);
+            if (R_FAILED(rc)) return rc;
+        }
+        memcpy(m->crcs + m->crc_count, crcs, (size_t)n * sizeof(u32));
+        e.crc = m->crc_count;
+        m->crc_count += n;
+    }
+    m->entries[m->count++] = e;
+    return 0;
+}
+
+static int entry_cmp(const void *a, const void *b) {
+    u64 x = ((const ManifestEntry*)a)->path_hash;
+    u64 y = ((const ManifestEntry*)b)->path_hash;
+    return x < y ? -1 : x > y;
+}
+
+void manifest_sort(Manifest *m) {
+    if (m->count > 1) qsort(m->entries, m->count, sizeof(ManifestEntry), entry_cmp);
+}
+
+const ManifestEntry *manifest_find(const Manifest *m, u64 path_hash) {
+    u32 lo = 0, hi = m->count;
+    while (lo < hi) {
+        u32 mid = lo + (hi - lo) / 2;
+        u64 h = m->entries[mid].path_hash;
+        if (h == path_hash) return &m->entries[mid];
+        if (h < path_hash) lo = mid + 1;
+        else hi = mid;
+    }
+    return NULL;
+}
+
+Result manifest_save(const Manifest *m, const char *path) {
+    char tmp[256];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *f = fopen(tmp, "wb");
+    if (!f) return MAKERESULT(Module_Libnx, LibnxError_IoError);
+
+    ManifestHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, MANIFEST_MAGIC, 4);
+    hdr.version = MANIFEST_VERSION;
+    hdr.target_hash = m->target_hash;
+    hdr.count = m->count;
+    hdr.crc_count = m->crc_count;
+    FastHash h;
+    fasthash_init(&h);
+    fasthash_update(&h, m->entries, (size_t)m->count * sizeof(ManifestEntry));
+    fasthash_update(&h, m->crcs, (size_t)m->crc_count * sizeof(u32));
+    hdr.entries_hash = fasthash_final(&h);
+    bool ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1 &&
+              fwrite(m->entries, sizeof(ManifestEntry), m->count, f) == m->count &&
+              fwrite(m->crcs, sizeof(u32), m->crc_count, f) == m->crc_count;
+    ok = fclose(f) == 0 && ok;
+    if (!ok) {
+        remove(tmp);
+        return MAKERESULT(Module_Libnx, LibnxError_IoError);
+    }
+    // sdmc 上 rename 不能覆盖已存在的文件，只能先删旧文件；
+    // 两步之间断电时由 manifest_load 回退读取 .tmp
+    remove(path);
+    if (rename(tmp, path) != 0) {
+        log_error("清单改名失败: %s", tmp);
+        return MAKERESULT(Module_Libnx, LibnxError_IoError);
+    }
+    return 0;
+}
@@ -0,0 +1,57 @@
+#pragma once
+// 备份清单：记录每个已成功上传文件的 size/mtime/内容哈希，下次只上传新增或变化的文件；
+// 另记录上传时顺带算出的整文件 SHA-256 与按块的 CRC32C，供事后校验远端副本。
+// 条目按路径哈希排序，查找为二分；不保存路径字符串本身，每条 72 字节，
+// 数万个文件也只占 1～2 MB（64 位路径哈希在这个规模下碰撞概率可忽略）。
+// 只有一块的文件 CRC 直接存在条目里，多块文件的 CRC 连续存放在条目区之后
+#include "../util/platform.h"
+#include "../util/checksum.h"
+
+#define MANIFEST_FILE_PATH "/config/mario-pop/manifest.bin"
+#define MANIFEST_MAGIC "MFST"
+#define MANIFEST_VERSION 2
+
+typedef struct {
+    u64 path_hash;      // fasthash_str(相对路径)
+    u64 size;
+    s64 mtime;
+    u64 content_hash;   // fasthash（XXH64）
+    u8 sha256[SHA256_DIGEST_SIZE];
+    u32 chunk_size;     // CRC32C 的分块大小；0 = 没有摘要（旧版清单或续传时上次已传完的文件）
+    u32 crc;            // 只有一块时是它的 CRC32C，多块时是在 Manifest.crcs 中的起始下标
+} ManifestEntry;
+
+typedef struct {
+    char magic[4];
+    u32 version;
+    u64 target_hash;    // 备份源与目标的哈希；换了目标就不能沿用旧清单
+    u32 count;
+    u32 crc_count;      // 条目区之后的 CRC 个数（版本 1 中为保留字段）
+    u64 entries_hash;   // 条目区与 CRC 区的 fasthash，用于识别写了一半的文件
+} ManifestHeader;
+
+typedef struct {
+    ManifestEntry *entries;
+    u32 count;
+    u32 capacity;
+    u32 *crcs;
+    u32 crc_count;
+    u32 crc_capacity;
+    u64 target_hash;
+} Manifest;
+
+void manifest_init(Manifest *m, u64 target_hash);
+void manifest_free(Manifest *m);
+// 读取清单；文件不存在或目标不一致时返回空清单（rc 仍为 0）。版本 1 的清单照常读入，只是没有摘要
+Result manifest_load(Manifest *m, const char *path, u64 target_hash);
+// 追加条目（不排序；写完后调用 manifest_sort）。crcs 为各块的 CRC32C（manifest_crc_count 个），
+// 为 NULL 时条目不带摘要；条目的 crc 字段由本函数填写
+Result manifest_append(Manifest *m, const ManifestEntry *entry, const u32 *crcs);
+u32 manifest_crc_count(const ManifestEntry *entry);
+// 条目的各块 CRC32C；没有摘要时返回 NULL
+const u32 *manifest_entry_crcs(const Manifest *m, const ManifestEntry *entry);
+void manifest_sort(Manifest *m);
+// 二分查找（清单须已排序）
+const ManifestEntry *manifest_find(const Manifest *m, u64 path_hash);
+// 先写 path.tmp，再替换 path；中途断电时旧清单或 .tmp 至少有一个完整
+Result manifest_save(const Manifest *m, const char *path);
@@ -0,0 +1,295 @@
+#include "pack.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define PACK_PATH_MAX 768
+
+bool pack_name_fits(const char *name) {
+    size_t len = strlen(name);
+    if (len == 0) return false;
+    if (len <= PACK_NAME_MAX) return true;
+    for (size_t i = 0; i < len && i <= PACK_PREFIX_MAX; ++i) {
+        if (name[i] == '/' && len - i - 1 <= PACK_NAME_MAX && len - i - 1 > 0) return true;
+    }
+    return false;
+}
+
+u64 pack_member_span(u64 size) {
+    return PACK_BLOCK_SIZE + (size + PACK_BLOCK_SIZE - 1) / PACK_BLOCK_SIZE * PACK_BLOCK_SIZE;
+}
+
+// 定长八进制字段：width - 1 位数字（前面补 0）加结尾 0；放不下的高位截掉
+static void put_octal(char *field, size_t width, u64 value) {
+    field[width - 1] = '\0';
+    for (size_t i = width - 1; i-- > 0; value >>= 3) field[i] = (char)('0' + (value & 7));
+}
+
+static void pack_build_header(u8 *block, const char *name, u64 size, s64 mtime) {
+    memset(block, 0, PACK_BLOCK_SIZE);
+    char *h = (char*)block;
+    size_t len = strlen(name);
+    if (len <= PACK_NAME_MAX) {
+        memcpy(h, name, len);
+    } else {
+        // 在第一个能让剩余部分放进 name 字段的 / 处拆开，前半部分进 prefix 字段
+        size_t split = 0;
+        while (name[split] != '/' || len - split - 1 > PACK_NAME_MAX) split++;
+        memcpy(h + 345, name, split);
+        memcpy(h, name + split + 1, len - split - 1);
+    }
+    put_octal(h + 100, 8, 0644);
+    put_octal(h + 108, 8, 0);
+    put_octal(h + 116, 8, 0);
+    put_octal(h + 124, 12, size);
+    put_octal(h + 136, 12, mtime > 0 ? (u64)mtime : 0);
+    h[156] = '0';
+    memcpy(h + 257, "ustar", 6);
+    memcpy(h + 263, "00", 2);
+    // 校验和按校验和字段全为空格计算
+    memset(h + 148, ' ', 8);
+    u32 sum = 0;
+    for (u32 i = 0; i < PACK_BLOCK_SIZE; ++i) sum += block[i];
+    snprintf(h + 148, 7, "%06o", sum);
+    h[155] = ' ';
+}
+
+u64 pack_version(const PackMember *members, u32 count) {
+    FastHash h;
+    fasthash_init(&h);
+    for (u32 i = 0; i < count; ++i) {
+        fasthash_update(&h, members[i].path, strlen(members[i].path) + 1);
+        fasthash_update(&h, &members[i].size, sizeof(members[i].size));
+        fasthash_update(&h, &members[i].mtime, sizeof(members[i].mtime));
+    }
+    return fasthash_final(&h);
+}
+
+Result pack_archive_init(PackArchive *a, const char *local_root, PackMember *members, u32 count, u32 prefix_len, u32 crc_chunk) {
+    memset(a, 0, sizeof(*a));
+    a->local_root = local_root;
+    a->members = members;
+    a->count = count;
+    a->prefix_len = prefix_len;
+    a->crc_chunk = crc_chunk;
+    a->fd = -1;
+
+    u64 crcs = 0;
+    a->size = PACK_TRAILER_SIZE;
+    for (u32 i = 0; i < count; ++i) {
+        a->size += pack_member_span(members[i].size);
+        crcs += (members[i].size + crc_chunk - 1) / crc_chunk;
+    }
+    a->version = pack_version(members, count);
+    if (crcs > UINT32_MAX) return MAKERESULT(Module_Libnx, LibnxError_BadInput);
+    if (crcs) {
+        a->crcs = malloc((size_t)crcs * sizeof(u32));
+        if (!a->crcs) return MAKERESULT(Module_Libnx, LibnxError_OutOfMemory);
+        a->crc_capacity = (u32)crcs;
+    }
+    pack_archive_rewind(a);
+    return 0;
+}
+
+void pack_archive_free(PackArchive *a) {
+    if (a->fd >= 0) close(a->fd);
+    free(a->crcs);
+    memset(a, 0, sizeof(*a));
+    a->fd = -1;
+}
+
+void pack_archive_rewind(PackArchive *a) {
+    if (a->fd >= 0) close(a->fd);
+    a->fd = -1;
+    a->index = 0;
+    a->phase = a->count ? PackPhase_Header : PackPhase_Trailer;
+    a->phase_off = 0;
+    a->crc_count = 0;
+    for (u32 i = 0; i < a->count; ++i) {
+        a->members[i].ok = false;
+        a->members[i].crc_count = 0;
+    }
+}
+
+// 开始一个成员：生成头并打开文件；打不开或大小与扫描时不同都按原定长度占位，内容补零
+static void pack_begin_member(PackArchive *a) {
+    PackMember *m = &a->members[a->index];
+    pack_build_header(a->header, m->path + a->prefix_len, m->size, m->mtime);
+    a->data = m->data;
+    a->failed = m->missing;
+    if (!a->failed && !m->data) {
+        char path[PACK_PATH_MAX];
+        int n = snprintf(path, sizeof(path), "%s/%s", a->local_root, m->path);
+        struct stat st;
+        a->failed = n < 0 || (size_t)n >= sizeof(path) || (a->fd = open(path, O_RDONLY)) < 0;
+        if (!a->failed && (fstat(a->fd, &st) != 0 || (u64)st.st_size != m->size)) a->failed = true;
+    }
+    fasthash_init(&a->hash);
+    sha256_init(&a->sha);
+    a->crc = 0;
+    a->digest_off = 0;
+    m->crc_index = a->crc_count;
+    m->crc_count = 0;
+}
+
+// 与上传引擎逐文件计算的摘要相同：内容哈希、SHA-256 与按 crc_chunk 分块的 CRC32C
+static void pack_digest(PackArchive *a, PackMember *m, const u8 *data, size_t len) {
+    fasthash_update(&a->hash, data, len);
+    sha256_update(&a->sha, data, len);
+    while (len > 0) {
+        u64 left = a->crc_chunk - a->digest_off % a->crc_chunk;
+        size_t n = len < left ? len : (size_t)left;
+        a->crc = crc32c(a->crc, data, n);
+        a->digest_off += n;
+        data += n;
+        len -= n;
+        if (n == left && a->crc_count < a->crc_capacity) {
+            a->crcs[a->crc_count++] = a->crc;
+            m->crc_count++;
+            a->crc = 0;
+        }
+    }
+}
+
+static void pack_end_member(PackArchive *a) {
+    PackMember *m = &a->members[a->index];
+    if (a->fd >= 0) close(a->fd);
+    a->fd = -1;
+    if (a->failed) {
+        a->crc_count = m->crc_index; // 丢掉这个成员已记下的 CRC
+        m->crc_count = 0;
+        return;
+    }
+    if (a->digest_off % a->crc_chunk != 0 && a->crc_count < a->crc_capacity) {
+        a->crcs[a->crc_count++] = a->crc;
+        m->crc_count++;
+    }
+    m->content_hash = fasthash_final(&a->hash);
+    sha256_final(&a->sha, m->sha256);
+    m->ok = true;
+}
+
+size_t pack_archive_read(PackArchive *a, u8 *dst, size_t len) {
+    size_t out = 0;
+    while (out < len && a->phase != PackPhase_Done) {
+        PackMember *m = a->index < a->count ? &a->members[a->index] : NULL;
+        size_t want = len - out;
+        switch (a->phase) {
+        case PackPhase_Header: {
+            if (a->phase_off == 0) pack_begin_member(a);
+            size_t n = PACK_BLOCK_SIZE - (size_t)a->phase_off;
+            if (n > want) n = want;
+            memcpy(dst + out, a->header + a->phase_off, n);
+            out += n;
+            a->phase_off += n;
+            if (a->phase_off == PACK_BLOCK_SIZE) {
+                a->phase = PackPhase_Data;
+                a->phase_off = 0;
+            }
+            break;
+        }
+        case PackPhase_Data: {
+            u64 left = m->size - a->phase_off;
+            size_t n = left < want ? (size_t)left : want;
+            if (!a->failed && a->data) {
+                memcpy(dst + out, a->data + a->phase_off, n);
+                pack_digest(a, m, dst + out, n);
+            } else if (!a->failed) {
+                size_t got = 0;
+                while (got < n) {
+                    ssize_t r = read(a->fd, dst + out + got, n - got);
+                    if (r <= 0) break;
+                    got += (size_t)r;
+                }
+                // 读取过程中被截断或出错：已读的照常发出，其余补零
+                if (got < n) a->failed = true;
+                else pack_digest(a, m, dst + out, n);
+                if (a->failed) memset(dst + out + got, 0, n - got);
+            } else {
+                memset(dst + out, 0, n);
+            }
+            out += n;
+            a->phase_off += n;
+            if (a->phase_off == m->size) {
+                pack_end_member(a);
+                a->phase = PackPhase_Pad;
+                a->phase_off = 0;
+            }
+            break;
+        }
+        case PackPhase_Pad: {
+            u64 pad = (PACK_BLOCK_SIZE - m->size % PACK_BLOCK_SIZE) % PACK_BLOCK_SIZE;
+            size_t n = pad - a->phase_off < want ? (size_t)(pad - a->phase_off) : want;
+            memset(dst + out, 0, n);
+            out += n;
+            a->phase_off += n;
+            if (a->phase_off == pad) {
+                a->index++;
+                a->phase = a->index < a->count ? PackPhase_Header : PackPhase_Trailer;
+                a->phase_off = 0;
+            }
+            break;
+        }
+        case PackPhase_Trailer: {
+            size_t n = PACK_TRAILER_SIZE - a->phase_off < want ? (size_t)(PACK_TRAILER_SIZE - a->phase_off) : want;
+            memset(dst + out, 0, n);
+            out += n;
+            a->phase_off += n;
+            if (a->phase_off == PACK_TRAILER_SIZE) a->phase = PackPhase_Done;
+            break;
+        }
+        case PackPhase_Done:
+            break;
+        }
+    }
+    return out;
+}
+
+const u32 *pack_member_crcs(const PackArchive *a, const PackMember *member) {
+    return member->ok && member->crc_count ? a->crcs + member->crc_index : NULL;
+}
+
+static bool get_octal(const u8 *field, size_t width, u64 *out) {
+    u64 v = 0;
+    size_t i = 0;
+    while (i < width && field[i] == ' ') i++;
+    bool any = false;
+    for (; i < width && field[i] >= '0' && field[i] <= '7'; ++i) {
+        v = (v << 3) | (u64)(field[i] - '0');
+        any = true;
+    }
+    // 数字之后只能是空格或 0
+    for (; i < width; ++i) {
+        if (field[i] != ' ' && field[i] != '\0') return false;
+    }
+    *out = v;
+    return any;
+}
+
+bool pack_header_parse(const u8 *block, char *name, size_t name_size, char *type, u64 *size, s64 *mtime, bool *end) {
+    *end = false;
+    u32 sum = 0;
+    bool zero = true;
+    for (u32 i = 0; i < PACK_BLOCK_SIZE; ++i) {
+        sum += (i >= 148 && i < 156) ? ' ' : block[i];
+        zero = zero && block[i] == 0;
+    }
+    if (zero) {
+        *end = true;
+        return false;
+    }
+    u64 check, v;
+    if (!get_octal(block + 148, 8, &check) || check != sum) return false;
+    if (memcmp(block + 257, "ustar", 5) != 0) return false;
+    if (!get_octal(block + 124, 12, size)) return false;
+    *mtime = get_octal(block + 136, 12, &v) ? (s64)v : 0;
+    *type = block[156] ? (char)block[156] : '0';
+    size_t prefix_len = strnlen((const char*)block + 345, PACK_PREFIX_MAX);
+    size_t name_len = strnlen((const char*)block, PACK_NAME_MAX);
+    int n = prefix_len ? snprintf(name, name_size, "%.*s/%.*s", (int)prefix_len, (const char*)block + 345, (int)name_len, (const char*)block)
+                       : snprintf(name, name_size, "%.*s", (int)name_len, (const char*)block);
+    return n > 0 && (size_t)n < name_size;
+}
@@ -0,0 +1,83 @@
+#pragma once
+// 小文件打包：按顶层目录分组，把组内不超过阈值的小文件边读边拼成一个 ustar 归档
+// （<组>/.smallfiles.tar），作为一个文件交给上传引擎，省去每个小文件各自的 STOR 与数据连接。
+// 归档不落地：读线程需要数据时才生成头、读成员内容并补齐 512 字节边界。
+// 归档总长按扫描时的大小事先算出（续传与分块都要用）；成员在读取时大小变了或读不出来，
+// 按原定长度补零并记为失败，下次备份重新打包。
+// 成员路径相对于组目录，在组目录下直接 tar -xf 即可还原
+#include "../util/platform.h"
+#include "../util/hash.h"
+#include "../util/checksum.h"
+
+#define PACK_ARCHIVE_NAME ".smallfiles.tar"
+#define PACK_BLOCK_SIZE 512
+#define PACK_NAME_MAX 100
+#define PACK_PREFIX_MAX 155
+#define PACK_TRAILER_SIZE (2 * PACK_BLOCK_SIZE) // 归档以两个全零块结束
+
+// 一个成员；ok 及其后的字段在归档读完后有效
+typedef struct {
+    const char *path;       // 相对本地根目录
+    u64 size;               // 扫描时的大小，归档中按它占位
+    s64 mtime;
+    const u8 *data;         // 非 NULL 时内容在内存里（快照），不再打开文件
+    bool missing;           // 快照没能复制：按读取失败处理（补零）
+    bool ok;
+    u64 content_hash;       // 与逐个上传时相同的摘要（清单用）
+    u8 sha256[SHA256_DIGEST_SIZE];
+    u32 crc_index;          // 各块 CRC32C 在 PackArchive.crcs 中的起始下标
+    u32 crc_count;
+} PackMember;
+
+typedef enum {
+    PackPhase_Header,
+    PackPhase_Data,
+    PackPhase_Pad,
+    PackPhase_Trailer,
+    PackPhase_Done,
+} PackPhase;
+
+typedef struct PackArchive {
+    const char *local_root;
+    PackMember *members;
+    u32 count;
+    u32 prefix_len;         // 成员路径中组目录部分的长度（含结尾 /）
+    u64 size;               // 归档总长
+    u64 version;            // 成员路径、大小、修改时间的哈希：没变时归档内容也不变
+    u32 crc_chunk;
+    // 读取状态（只由上传引擎的读线程访问）
+    u32 index;
+    PackPhase phase;
+    u64 phase_off;
+    int fd;
+    const u8 *data;         // 当前成员在内存里的内容
+    bool failed;            // 当前成员打不开、大小变了或读取出错：其余部分补零
+    u8 header[PACK_BLOCK_SIZE];
+    FastHash hash;
+    Sha256 sha;
+    u32 crc;
+    u64 digest_off;
+    u32 *crcs;
+    u32 crc_count;
+    u32 crc_capacity;
+} PackArchive;
+
+// 路径（相对组目录）能否放进 ustar 头：名字不超过 100 字节，或能在某个 / 处拆成不超过 155 + 100 字节
+bool pack_name_fits(const char *name);
+// 成员在归档中占的字节数（头 + 按 512 补齐的内容）
+u64 pack_member_span(u64 size);
+// 成员集合的版本（PackArchive.version）：不生成归档也能判断上次上传的归档是否还是最新
+u64 pack_version(const PackMember *members, u32 count);
+// members 的 path 须以同一个组目录（prefix_len 字节，含结尾 /；根目录为 0）开头
+Result pack_archive_init(PackArchive *a, const char *local_root, PackMember *members, u32 count, u32 prefix_len, u32 crc_chunk);
+void pack_archive_free(PackArchive *a);
+// 回到开头（断线重传时从头重新生成），成员的结果一并清除
+void pack_archive_rewind(PackArchive *a);
+// 顺序生成归档内容，返回写入 dst 的字节数（到结尾时少于 len）
+size_t pack_archive_read(PackArchive *a, u8 *dst, size_t len);
+// 成功成员的各块 CRC32C（member->crc_count 个）
+const u32 *pack_member_crcs(const PackArchive *a, const PackMember *member);
+
+// 解析一个 ustar 头：校验和正确时输出成员名（prefix/name）、类型、大小与修改时间；
+// 全零块（归档结尾）返回 false 且 *end 为真
+bool pack_header_parse(const u8 *block, char *name, size_t name_size, char *type, u64 *size, s64 *mtime, bool *end);
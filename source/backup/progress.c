@@ -0,0 +1,66 @@
+#include "progress.h"
+#include <stdatomic.h>
+
+// 计数器全部为原子量：bytes_done/files_done 单调递增，可独立读取；
+// 总量与状态在 begin/end 时成组改变，用序号（seqlock）保证读端拿到一致的一组值
+static atomic_uint s_seq;
+static _Atomic u32 s_state;
+static _Atomic u64 s_files_total;
+static _Atomic u64 s_files_done;
+static _Atomic u64 s_bytes_total;
+static _Atomic u64 s_bytes_done;
+static _Atomic u64 s_start_tick;
+
+static inline void seq_write_begin(void) {
+    atomic_fetch_add_explicit(&s_seq, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+static inline void seq_write_end(void) {
+    atomic_fetch_add_explicit(&s_seq, 1, memory_order_release);
+}
+
+void progress_begin(u64 files_total, u64 bytes_total) {
+    seq_write_begin();
+    atomic_store_explicit(&s_files_total, files_total, memory_order_relaxed);
+    atomic_store_explicit(&s_bytes_total, bytes_total, memory_order_relaxed);
+    atomic_store_explicit(&s_files_done, 0, memory_order_relaxed);
+    atomic_store_explicit(&s_bytes_done, 0, memory_order_relaxed);
+    atomic_store_explicit(&s_start_tick, armGetSystemTick(), memory_order_relaxed);
+    atomic_store_explicit(&s_state, BackupState_Running, memory_order_relaxed);
+    seq_write_end();
+}
+
+void progress_add_bytes(u64 bytes) {
+    atomic_fetch_add_explicit(&s_bytes_done, bytes, memory_order_relaxed);
+}
+
+void progress_file_done(void) {
+    atomic_fetch_add_explicit(&s_files_done, 1, memory_order_relaxed);
+}
+
+void progress_end(bool ok) {
+    seq_write_begin();
+    atomic_store_explicit(&s_state, ok ? BackupState_Succeeded : BackupState_Failed, memory_order_relaxed);
+    seq_write_end();
+}
+
+void progress_snapshot(BackupProgress *out) {
+    if (!out) return;
+    // 读端只重试有限次：写端极少进入临界区，拿不到一致快照时用最后一次读到的值即可
+    for (int attempt = 0; attempt < 4; ++attempt) {
+        unsigned s1 = atomic_load_explicit(&s_seq, memory_order_acquire);
+        out->state       = atomic_load_explicit(&s_state, memory_order_relaxed);
+        out->files_total = atomic_load_explicit(&s_files_total, memory_order_relaxed);
+        out->bytes_total = atomic_load_explicit(&s_bytes_total, memory_order_relaxed);
+        out->start_tick  = atomic_load_explicit(&s_start_tick, memory_order_relaxed);
+        out->files_done  = atomic_load_explicit(&s_files_done, memory_order_relaxed);
+        out->bytes_done  = atomic_load_explicit(&s_bytes_done, memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+        unsigned s2 = atomic_load_explicit(&s_seq, memory_order_relaxed);
+        if (s1 == s2 && (s1 & 1) == 0) break;
+    }
+    // 总量未知（流式扫描中）时不做裁剪
+    if (out->files_total && out->files_done > out->files_total) out->files_done = out->files_total;
+    if (out->bytes_total && out->bytes_done > out->bytes_total) out->bytes_done = out->bytes_total;
+}
@@ -0,0 +1,29 @@
+#pragma once
+// 备份进度计数器：上传线程单写，渲染线程无锁读取
+#include "../util/platform.h"
+
+typedef enum {
+    BackupState_Idle = 0,
+    BackupState_Running,
+    BackupState_Succeeded,
+    BackupState_Failed,
+} BackupState;
+
+// 某一时刻的进度快照（由 progress_snapshot 填充）
+typedef struct {
+    u32 state;          // BackupState
+    u64 files_total;
+    u64 files_done;
+    u64 bytes_total;
+    u64 bytes_done;
+    u64 start_tick;     // progress_begin 时的 armGetSystemTick()
+} BackupProgress;
+
+// 写端（仅备份线程调用）
+void progress_begin(u64 files_total, u64 bytes_total);
+void progress_add_bytes(u64 bytes);
+void progress_file_done(void);
+void progress_end(bool ok);
+
+// 读端（任意线程，无锁，不会阻塞）
+void progress_snapshot(BackupProgress *out);
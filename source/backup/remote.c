@@ -0,0 +1,133 @@
+#include "remote.h"
+#include "../util/hash.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+static RemoteEntry *cache_slot(const RemoteCache *c, u64 hash) {
+    u32 mask = c->capacity - 1;
+    for (u32 i = (u32)hash & mask;; i = (i + 1) & mask) {
+        RemoteEntry *e = &c->slots[i];
+        if (!e->type || e->hash == hash) return e;
+    }
+}
+
+// 装载率不超过 3/4
+static Result cache_reserve(RemoteCache *c, u32 count) {
+    u32 capacity = c->capacity ? c->capacity : REMOTE_CACHE_MIN_CAPACITY;
+    while ((u64)count * 4 > (u64)capacity * 3) capacity *= 2;
+    if (capacity == c->capacity) return 0;
+    RemoteEntry *slots = calloc(capacity, sizeof(RemoteEntry));
+    if (!slots) return MAKERESULT(Module_Libnx, LibnxError_OutOfMemory);
+    RemoteEntry *old = c->slots;
+    u32 old_capacity = c->capacity;
+    c->slots = slots;
+    c->capacity = capacity;
+    for (u32 i = 0; i < old_capacity; ++i) {
+        if (old[i].type) *cache_slot(c, old[i].hash) = old[i];
+    }
+    free(old);
+    return 0;
+}
+
+void remote_cache_init(RemoteCache *c) {
+    memset(c, 0, sizeof(*c));
+}
+
+void remote_cache_free(RemoteCache *c) {
+    free(c->slots);
+    memset(c, 0, sizeof(*c));
+}
+
+const RemoteEntry *remote_cache_find(const RemoteCache *c, const char *path, size_t len) {
+    if (!c->capacity) return NULL;
+    const RemoteEntry *e = cache_slot(c, fasthash(path, len));
+    return e->type ? e : NULL;
+}
+
+Result remote_cache_put(RemoteCache *c, const char *path, size_t len, RemoteEntryType type, u64 size, bool listed) {
+    Result rc = cache_reserve(c, c->count + 1);
+    if (R_FAILED(rc)) return rc;
+    u64 hash = fasthash(path, len);
+    RemoteEntry *e = cache_slot(c, hash);
+    if (!e->type) c->count++;
+    e->hash = hash;
+    e->size = size;
+    e->type = (u8)type;
+    e->listed = e->listed || listed;
+    return 0;
+}
+
+bool remote_cache_exists(const RemoteCache *c, const char *path, size_t len) {
+    return remote_cache_find(c, path, len) != NULL;
+}
+
+bool remote_cache_missing(const RemoteCache *c, const char *path, size_t len) {
+    if (!len || remote_cache_find(c, path, len)) return false; // 根目录没有父目录可查
+    size_t parent_len = len;
+    while (parent_len && path[parent_len - 1] != '/') parent_len--;
+    if (parent_len) parent_len--;
+    const RemoteEntry *parent = remote_cache_find(c, path, parent_len);
+    if (parent) return parent->type == RemoteEntry_Dir && parent->listed;
+    // 父目录本身确定不存在时子项也不存在
+    return remote_cache_missing(c, path, parent_len);
+}
+
+// "type=file;size=123;modify=...; name"：事实之间以 ; 分隔，最后一个 ; 之后是一个空格和名字
+static bool mlsd_line(const char *line, size_t len, RemoteEntryType *type, u64 *size, const char **name, size_t *name_len) {
+    const char *sp = memchr(line, ' ', len);
+    if (!sp) return false;
+    *name = sp + 1;
+    *name_len = len - (size_t)(sp + 1 - line);
+    *type = 0;
+    *size = 0;
+    const char *p = line;
+    while (p < sp) {
+        const char *end = memchr(p, ';', (size_t)(sp - p));
+        if (!end) end = sp;
+        const char *eq = memchr(p, '=', (size_t)(end - p));
+        if (eq) {
+            size_t key_len = (size_t)(eq - p);
+            const char *val = eq + 1;
+            size_t val_len = (size_t)(end - val);
+            if (key_len == 4 && strncasecmp(p, "type", 4) == 0) {
+                if (val_len == 4 && strncasecmp(val, "file", 4) == 0) *type = RemoteEntry_File;
+                else if (val_len == 3 && strncasecmp(val, "dir", 3) == 0) *type = RemoteEntry_Dir;
+            } else if (key_len == 4 && strncasecmp(p, "size", 4) == 0) {
+                *size = strtoull(val, NULL, 10);
+            }
+        }
+        p = end + 1;
+    }
+    // cdir/pdir（. 与 ..）及其他类型不记
+    return *type != 0 && *name_len > 0;
+}
+
+u32 remote_cache_parse_mlsd(RemoteCache *c, const char *dir, const char *text, size_t len) {
+    char path[1024];
+    size_t dir_len = strlen(dir);
+    if (dir_len + 2 > sizeof(path)) return 0;
+    memcpy(path, dir, dir_len);
+    size_t prefix = dir_len;
+    if (dir_len) path[prefix++] = '/';
+
+    u32 count = 0;
+    const char *p = text, *end = text + len;
+    while (p < end) {
+        const char *nl = memchr(p, '\n', (size_t)(end - p));
+        const char *line_end = nl ? nl : end;
+        size_t line_len = (size_t)(line_end - p);
+        if (line_len && p[line_len - 1] == '\r') line_len--;
+        RemoteEntryType type;
+        u64 size;
+        const char *name;
+        size_t name_len;
+        if (mlsd_line(p, line_len, &type, &size, &name, &name_len) && prefix + name_len <= sizeof(path)) {
+            memcpy(path + prefix, name, name_len);
+            if (R_SUCCEEDED(remote_cache_put(c, path, prefix + name_len, type, size, false))) count++;
+        }
+        p = nl ? nl + 1 : end;
+    }
+    remote_cache_put(c, dir, dir_len, RemoteEntry_Dir, 0, true);
+    return count;
+}
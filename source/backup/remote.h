@@ -0,0 +1,38 @@
+#pragma once
+// 远端目录缓存：上传开始前用 MLSD 列出待传文件所在的各级远端目录（每个目录每次备份最多列一次），
+// 记下其中的子目录与文件大小。上传时据此只对确实缺失的目录发 MKD、续传时直接取远端长度，
+// 传输改用 NOCWD 方式（STOR 带完整路径），不再为每个文件逐级 CWD
+#include "../util/platform.h"
+
+#define REMOTE_CACHE_MIN_CAPACITY 256
+
+typedef enum {
+    RemoteEntry_File = 1,
+    RemoteEntry_Dir,
+} RemoteEntryType;
+
+// 以相对远端根目录的路径（不带首尾 /，根目录为 ""）的哈希为键
+typedef struct {
+    u64 hash;
+    u64 size;
+    u8 type;                // RemoteEntryType；0 = 空槽
+    u8 listed;              // 目录：其内容已列出（不在缓存里的子项即不存在）
+    u8 reserved[6];
+} RemoteEntry;
+
+typedef struct {
+    RemoteEntry *slots;
+    u32 capacity;           // 2 的幂
+    u32 count;
+} RemoteCache;
+
+void remote_cache_init(RemoteCache *c);
+void remote_cache_free(RemoteCache *c);
+const RemoteEntry *remote_cache_find(const RemoteCache *c, const char *path, size_t len);
+Result remote_cache_put(RemoteCache *c, const char *path, size_t len, RemoteEntryType type, u64 size, bool listed);
+// 路径是否确定存在 / 确定不存在（父目录已列出且其中没有它）；两者都为假表示未知
+bool remote_cache_exists(const RemoteCache *c, const char *path, size_t len);
+bool remote_cache_missing(const RemoteCache *c, const char *path, size_t len);
+// 解析目录 dir 的 MLSD 输出（每行 "fact=value;...; name"），子项写入缓存并把 dir 记为已列出；
+// 返回解析出的子项数
+u32 remote_cache_parse_mlsd(RemoteCache *c, const char *dir, const char *text, size_t len);
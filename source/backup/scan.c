@@ -0,0 +1,575 @@
+#include "scan.h"
+#include "../util/hash.h"
+#include "../util/fspool.h"
+#include "../util/threading.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#ifdef __SWITCH__
+#include <switch/runtime/devices/fs_dev.h>
+#endif
+
+// 缓存文件：表头之后是各目录的记录，每条为 ScanCacheDir + 文件项 + 子目录项，紧密排列（读取时 memcpy，不要求对齐）。
+// 文件项：u64 size, s64 mtime, u16 name_len, name；子目录项：u16 name_len, name
+typedef struct {
+    char magic[4];
+    u32 version;
+    u64 root_hash;
+    u32 dir_count;
+    u32 reserved;
+} ScanCacheHeader;
+
+typedef struct {
+    u64 path_hash;      // fasthash_str(相对路径)，根目录为 ""
+    s64 mtime;          // 目录自身的修改时间；0 表示取不到，不参与缓存
+    u32 file_count;
+    u32 dir_count;
+    u32 payload_size;
+    u32 reserved;
+} ScanCacheDir;
+
+typedef struct {
+    u64 path_hash;
+    const u8 *rec;
+} ScanCacheIndex;
+
+typedef struct {
+    u8 *data;
+    size_t len;
+    size_t cap;
+} ScanBuf;
+
+typedef struct ScanContext ScanContext;
+
+typedef struct {
+    ScanContext *ctx;
+    BackupFileList files;
+    ScanBuf cache_out;      // 本线程写出的缓存记录
+    u32 cache_dirs;
+    ScanBuf subdirs;        // 正在列的目录的子目录名
+    u32 file_count;
+    u32 subdir_count;
+    ScanStats stats;
+    Result rc;
+    AppThread thread;
+    bool started;
+#ifdef __SWITCH__
+    FsDirectoryEntry *entries;
+#endif
+    char full[SCAN_PATH_MAX];
+    char child[SCAN_PATH_MAX];
+} ScanWorker;
+
+struct ScanContext {
+    const char *root;
+    u8 *cache_blob;
+    ScanCacheIndex *cache_index;
+    u32 cache_count;
+    bool cache_enabled;
+
+    // 待遍历目录栈（相对路径，各自 malloc）；active 为正在处理目录的线程数，栈空且 active 为 0 即遍历结束
+    Mutex lock;
+    CondVar cv;
+    char **stack;
+    u32 stack_count;
+    u32 stack_cap;
+    u32 active;
+    bool failed;
+
+    ScanWorker workers[SCAN_MAX_THREADS];
+    u32 worker_count;
+#ifdef __SWITCH__
+    FsFileSystem *fs;
+#endif
+};
+
+static bool buf_append(ScanBuf *b, const void *data, size_t len) {
+    if (b->len + len > b->cap) {
+        size_t cap = b->cap ? b->cap * 2 : 0x10000;
+        while (cap < b->len + len) cap *= 2;
+        u8 *p = realloc(b->data, cap);
+        if (!p) return false;
+        b->data = p;
+        b->cap = cap;
+    }
+    memcpy(b->data + b->len, data, len);
+    b->len += len;
+    return true;
+}
+
+static bool buf_append_name(ScanBuf *b, const char *name) {
+    u16 len = (u16)strlen(name);
+    return buf_append(b, &len, sizeof(len)) && buf_append(b, name, len);
+}
+
+static bool file_list_push(BackupFileList *list, const char *rel, u64 size, s64 mtime) {
+    if (list->count == list->capacity) {
+        u32 cap = list->capacity ? list->capacity * 2 : 64;
+        BackupFile *items = realloc(list->items, cap * sizeof(BackupFile));
+        if (!items) return false;
+        list->items = items;
+        list->capacity = cap;
+    }
+    char *path = list->arena ? mem_arena_strdup(list->arena, rel) : strdup(rel);
+    if (!path) return false;
+    list->items[list->count].path = path;
+    list->items[list->count].size = size;
+    list->items[list->count].mtime = mtime;
+    list->count++;
+    list->total_bytes += size;
+    return true;
+}
+
+void backup_file_list_free(BackupFileList *list) {
+    if (!list->arena) {
+        for (u32 i = 0; i < list->count; ++i) free(list->items[i].path);
+    }
+    free(list->items);
+    memset(list, 0, sizeof(*list));
+}
+
+// rel 为空表示根；name 为 NULL 时只拼目录本身
+static bool join_path(char *out, const char *base, const char *rel, const char *name) {
+    int n;
+    if (!name) n = snprintf(out, SCAN_PATH_MAX, rel[0] ? "%s/%s" : "%s", base, rel);
+    else if (!base) n = snprintf(out, SCAN_PATH_MAX, rel[0] ? "%s/%s" : "%.0s%s", rel, name);
+    else n = snprintf(out, SCAN_PATH_MAX, rel[0] ? "%s/%s/%s" : "%s/%.0s%s", base, rel, name);
+    return n >= 0 && n < SCAN_PATH_MAX;
+}
+
+static bool push_dir(ScanContext *c, const char *rel) {
+    char *copy = strdup(rel);
+    if (!copy) return false;
+    mutexLock(&c->lock);
+    if (c->stack_count == c->stack_cap) {
+        u32 cap = c->stack_cap ? c->stack_cap * 2 : 64;
+        char **stack = realloc(c->stack, cap * sizeof(char*));
+        if (!stack) {
+            mutexUnlock(&c->lock);
+            free(copy);
+            return false;
+        }
+        c->stack = stack;
+        c->stack_cap = cap;
+    }
+    c->stack[c->stack_count++] = copy;
+    condvarWakeOne(&c->cv);
+    mutexUnlock(&c->lock);
+    return true;
+}
+
+static const u8 *cache_find(const ScanContext *c, u64 path_hash) {
+    u32 lo = 0, hi = c->cache_count;
+    while (lo < hi) {
+        u32 mid = lo + (hi - lo) / 2;
+        u64 h = c->cache_index[mid].path_hash;
+        if (h == path_hash) return c->cache_index[mid].rec;
+        if (h < path_hash) lo = mid + 1;
+        else hi = mid;
+    }
+    return NULL;
+}
+
+// ---- 目录读取：Switch 上直接用 fsDirRead 成批取目录项（自带类型与大小），主机上用 readdir + stat ----
+
+typedef struct {
+    const char *name;
+    bool is_dir;
+    u64 size;
+    s64 mtime;
+} ScanEntry;
+
+#ifdef __SWITCH__
+
+static s64 entry_mtime(ScanContext *c, const char *path) {
+    FsTimeStampRaw ts;
+    if (R_FAILED(fsFsGetFileTimeStampRaw(c->fs, path, &ts)) || !ts.is_valid) return 0;
+    return (s64)ts.modified;
+}
+
+static s64 dir_mtime(ScanWorker *w) {
+    return entry_mtime(w->ctx, w->full);
+}
+
+typedef bool (*ScanEntryFn)(ScanWorker *w, const char *rel, const ScanEntry *e);
+
+static Result list_dir(ScanWorker *w, const char *rel, ScanEntryFn fn) {
+    ScanContext *c = w->ctx;
+    FsDir dir;
+    Result rc = fsFsOpenDirectory(c->fs, w->full, FsDirOpenMode_ReadDirs | FsDirOpenMode_ReadFiles, &dir);
+    if (R_FAILED(rc)) return rc;
+    for (;;) {
+        s64 total = 0;
+        rc = fsDirRead(&dir, &total, SCAN_DIR_BATCH, w->entries);
+        if (R_FAILED(rc) || total <= 0) break;
+        for (s64 i = 0; i < total; ++i) {
+            const FsDirectoryEntry *ent = &w->entries[i];
+            ScanEntry e = { ent->name, ent->type == FsDirEntryType_Dir, (u64)ent->file_size, 0 };
+            if (!e.is_dir) {
+                if (!join_path(w->child, c->root, rel, ent->name)) {
+                    w->stats.skipped++;
+                    continue;
+                }
+                e.mtime = entry_mtime(c, w->child);
+            }
+            if (!fn(w, rel, &e)) {
+                fsDirClose(&dir);
+                return MAKERESULT(Module_Libnx, LibnxError_OutOfMemory);
+            }
+        }
+    }
+    fsDirClose(&dir);
+    return R_FAILED(rc) ? rc : 0;
+}
+
+#else
+
+static s64 dir_mtime(ScanWorker *w) {
+    struct stat st;
+    return stat(w->full, &st) == 0 ? (s64)st.st_mtime : 0;
+}
+
+typedef bool (*ScanEntryFn)(ScanWorker *w, const char *rel, const ScanEntry *e);
+
+static Result list_dir(ScanWorker *w, const char *rel, ScanEntryFn fn) {
+    ScanContext *c = w->ctx;
+    DIR *dir = opendir(w->full);
+    if (!dir) return MAKERESULT(Module_Libnx, LibnxError_NotFound);
+    struct dirent *ent;
+    while ((ent = readdir(dir)) != NULL) {
+        if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0) continue;
+        ScanEntry e = { ent->d_name, ent->d_type == DT_DIR, 0, 0 };
+        // 目录只需类型；文件与类型未知的项才 stat
+        if (ent->d_type != DT_DIR) {
+            struct stat st;
+            if (!join_path(w->child, c->root, rel, ent->d_name) || stat(w->child, &st) != 0) {
+                w->stats.skipped++;
+                continue;
+            }
+            if (!S_ISDIR(st.st_mode) && !S_ISREG(st.st_mode)) continue;
+            e.is_dir = S_ISDIR(st.st_mode);
+            e.size = (u64)st.st_size;
+            e.mtime = (s64)st.st_mtime;
+        }
+        if (!fn(w, rel, &e)) {
+            closedir(dir);
+            return MAKERESULT(Module_Libnx, LibnxError_OutOfMemory);
+        }
+    }
+    closedir(dir);
+    return 0;
+}
+
+#endif
+
+// 列目录时每一项的处理：文件写入输出与缓存记录，子目录名写入 subdirs，列完后接到记录末尾并入栈
+static bool on_entry(ScanWorker *w, const char *rel, const ScanEntry *e) {
+    if (e->is_dir) {
+        w->subdir_count++;
+        return buf_append_name(&w->subdirs, e->name);
+    }
+    if (!join_path(w->child, NULL, rel, e->name)) {
+        w->stats.skipped++;
+        return true;
+    }
+    w->file_count++;
+    return file_list_push(&w->files, w->child, e->size, e->mtime) &&
+           buf_append(&w->cache_out, &e->size, sizeof(e->size)) &&
+           buf_append(&w->cache_out, &e->mtime, sizeof(e->mtime)) &&
+           buf_append_name(&w->cache_out, e->name);
+}
+
+// 按缓存记录（或刚写入的记录）中的子目录名入栈；p 指向第一个子目录项
+static bool push_subdirs(ScanWorker *w, const char *rel, const u8 *p, u32 count) {
+    char name[SCAN_PATH_MAX];
+    for (u32 i = 0; i < count; ++i) {
+        u16 len;
+        memcpy(&len, p, sizeof(len));
+        p += sizeof(len);
+        memcpy(name, p, len < SCAN_PATH_MAX ? len : SCAN_PATH_MAX - 1);
+        name[len < SCAN_PATH_MAX ? len : SCAN_PATH_MAX - 1] = '\0';
+        p += len;
+        if (!join_path(w->child, NULL, rel, name)) {
+            w->stats.skipped++;
+            continue;
+        }
+        if (!push_dir(w->ctx, w->child)) return false;
+    }
+    return true;
+}
+
+// 命中缓存：按记录输出文件、子目录入栈，并把记录原样拷入新缓存
+static Result scan_cached_dir(ScanWorker *w, const char *rel, const u8 *rec) {
+    ScanCacheDir hdr;
+    memcpy(&hdr, rec, sizeof(hdr));
+    const u8 *p = rec + sizeof(hdr);
+    char name[SCAN_PATH_MAX];
+    for (u32 i = 0; i < hdr.file_count; ++i) {
+        u64 size;
+        s64 mtime;
+        u16 len;
+        memcpy(&size, p, sizeof(size));
+        memcpy(&mtime, p + 8, sizeof(mtime));
+        memcpy(&len, p + 16, sizeof(len));
+        p += 18;
+        memcpy(name, p, len < SCAN_PATH_MAX ? len : SCAN_PATH_MAX - 1);
+        name[len < SCAN_PATH_MAX ? len : SCAN_PATH_MAX - 1] = '\0';
+        p += len;
+        if (!join_path(w->child, NULL, rel, name)) {
+            w->stats.skipped++;
+            continue;
+        }
+        if (!file_list_push(&w->files, w->child, size, mtime)) return MAKERESULT(Module_Libnx, LibnxError_OutOfMemory);
+    }
+    w->stats.files += hdr.file_count;
+    w->stats.files_cached += hdr.file_count;
+    w->stats.dirs_cached++;
+    if (!buf_append(&w->cache_out, rec, sizeof(hdr) + hdr.payload_size)) return MAKERESULT(Module_Libnx, LibnxError_OutOfMemory);
+    w->cache_dirs++;
+    return push_subdirs(w, rel, p, hdr.dir_count) ? 0 : MAKERESULT(Module_Libnx, LibnxError_OutOfMemory);
+}
+
+static Result scan_one_dir(ScanWorker *w, const char *rel) {
+    ScanContext *c = w->ctx;
+    if (!join_path(w->full, c->root, rel, NULL)) {
+        w->stats.skipped++;
+        return 0;
+    }
+    w->stats.dirs++;
+    fspool_enter(FsRole_Scan);
+    ScanCacheDir hdr = { fasthash_str(rel), dir_mtime(w), 0, 0, 0, 0 };
+    fspool_leave(FsRole_Scan);
+    if (c->cache_enabled && hdr.mtime != 0) {
+        const u8 *rec = cache_find(c, hdr.path_hash);
+        ScanCacheDir old;
+        if (rec) memcpy(&old, rec, sizeof(old));
+        if (rec && old.mtime == hdr.mtime) return scan_cached_dir(w, rel, rec);
+    }
+
+    size_t rec_start = w->cache_out.len;
+    if (!buf_append(&w->cache_out, &hdr, sizeof(hdr))) return MAKERESULT(Module_Libnx, LibnxError_OutOfMemory);
+    w->subdirs.len = 0;
+    w->file_count = w->subdir_count = 0;
+    // 一个目录的全部读取占用同一个会话槽
+    fspool_enter(FsRole_Scan);
+    Result rc = list_dir(w, rel, on_entry);
+    fspool_leave(FsRole_Scan);
+    if (R_FAILED(rc)) {
+        // 根目录打不开是错误；子目录打不开（如遍历期间被删除）只跳过
+        w->cache_out.len = rec_start;
+        if (!rel[0]) return rc;
+        w->stats.skipped++;
+        return 0;
+    }
+    if (!buf_append(&w->cache_out, w->subdirs.data, w->subdirs.len)) return MAKERESULT(Module_Libnx, LibnxError_OutOfMemory);
+    w->stats.files += w->file_count;
+    if (hdr.mtime != 0) {
+        hdr.file_count = w->file_count;
+        hdr.dir_count = w->subdir_count;
+        hdr.payload_size = (u32)(w->cache_out.len - rec_start - sizeof(hdr));
+        memcpy(w->cache_out.data + rec_start, &hdr, sizeof(hdr));
+        w->cache_dirs++;
+    }
+    const u8 *names = w->cache_out.data + w->cache_out.len - w->subdirs.len;
+    if (hdr.mtime == 0) names = w->subdirs.data;
+    bool ok = push_subdirs(w, rel, names, w->subdir_count);
+    if (hdr.mtime == 0) w->cache_out.len = rec_start; // 取不到修改时间的目录不写入缓存
+    return ok ? 0 : MAKERESULT(Module_Libnx, LibnxError_OutOfMemory);
+}
+
+static void scan_worker_main(void *arg) {
+    ScanWorker *w = (ScanWorker*)arg;
+    ScanContext *c = w->ctx;
+    mutexLock(&c->lock);
+    for (;;) {
+        while (c->stack_count == 0 && c->active > 0 && !c->failed) condvarWait(&c->cv, &c->lock);
+        if (c->stack_count == 0 || c->failed) break;
+        char *rel = c->stack[--c->stack_count];
+        c->active++;
+        mutexUnlock(&c->lock);
+
+        Result rc = scan_one_dir(w, rel);
+        free(rel);
+
+        mutexLock(&c->lock);
+        c->active--;
+        if (R_FAILED(rc)) {
+            w->rc = rc;
+            c->failed = true;
+        }
+        if ((c->stack_count == 0 && c->active == 0) || c->failed) condvarWakeAll(&c->cv);
+    }
+    mutexUnlock(&c->lock);
+}
+
+// 整个缓存文件读入内存，建立按 path_hash 排序的索引；格式不符或根目录不同时视为没有缓存
+static int cache_index_cmp(const void *a, const void *b) {
+    u64 x = ((const ScanCacheIndex*)a)->path_hash;
+    u64 y = ((const ScanCacheIndex*)b)->path_hash;
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static void cache_load(ScanContext *c, const char *path, u64 root_hash) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    ScanCacheHeader hdr;
+    u8 *blob = NULL;
+    if (size > (long)sizeof(hdr) && fread(&hdr, sizeof(hdr), 1, f) == 1 &&
+        memcmp(hdr.magic, SCAN_CACHE_MAGIC, 4) == 0 && hdr.version == SCAN_CACHE_VERSION && hdr.root_hash == root_hash) {
+        size_t blob_size = (size_t)size - sizeof(hdr);
+        blob = malloc(blob_size);
+        c->cache_index = malloc((hdr.dir_count ? hdr.dir_count : 1) * sizeof(ScanCacheIndex));
+        if (blob && c->cache_index && fread(blob, 1, blob_size, f) == blob_size) {
+            size_t off = 0;
+            while (c->cache_count < hdr.dir_count && off + sizeof(ScanCacheDir) <= blob_size) {
+                ScanCacheDir d;
+                memcpy(&d, blob + off, sizeof(d));
+                if (off + sizeof(d) + d.payload_size > blob_size) break;
+                c->cache_index[c->cache_count].path_hash = d.path_hash;
+                c->cache_index[c->cache_count].rec = blob + off;
+                c->cache_count++;
+                off += sizeof(d) + d.payload_size;
+            }
+            qsort(c->cache_index, c->cache_count, sizeof(ScanCacheIndex), cache_index_cmp);
+        } else {
+            c->cache_count = 0;
+        }
+    }
+    fclose(f);
+    c->cache_blob = blob;
+}
+
+// 各线程的记录依次写出；先写 .tmp 再替换，写到一半断电时保留旧缓存
+static void cache_save(ScanContext *c, const char *path, u64 root_hash) {
+    char tmp[SCAN_PATH_MAX];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *f = fopen(tmp, "wb");
+    if (!f) return;
+    ScanCacheHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, SCAN_CACHE_MAGIC, 4);
+    hdr.version = SCAN_CACHE_VERSION;
+    hdr.root_hash = root_hash;
+    for (u32 i = 0; i < c->worker_count; ++i) hdr.dir_count += c->workers[i].cache_dirs;
+    bool ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1;
+    for (u32 i = 0; i < c->worker_count && ok; ++i) {
+        const ScanBuf *b = &c->workers[i].cache_out;
+        if (b->len) ok = fwrite(b->data, 1, b->len, f) == b->len;
+    }
+    ok = fclose(f) == 0 && ok;
+    if (ok) {
+        remove(path);
+        ok = rename(tmp, path) == 0;
+    }
+    if (!ok) remove(tmp);
+}
+
+static int file_path_cmp(const void *a, const void *b) {
+    return strcmp(((const BackupFile*)a)->path, ((const BackupFile*)b)->path);
+}
+
+Result scan_tree(const ScanOptions *opt, BackupFileList *out, ScanStats *stats) {
+    memset(out, 0, sizeof(*out));
+    memset(stats, 0, sizeof(*stats));
+    u64 start = armGetSystemTick();
+    ScanContext *c = calloc(1, sizeof(ScanContext));
+    if (!c) return MAKERESULT(Module_Libnx, LibnxError_OutOfMemory);
+    c->root = opt->root;
+#ifdef __SWITCH__
+    // 原生接口的路径不带设备名
+    if (strncmp(c->root, "sdmc:", 5) == 0) c->root += 5;
+    c->fs = fsdevGetDeviceFileSystem("sdmc");
+    if (!c->fs) {
+        free(c);
+        return MAKERESULT(Module_Libnx, LibnxError_NotInitialized);
+    }
+#endif
+    u64 root_hash = fasthash_str(c->root);
+    c->cache_enabled = opt->cache_path != NULL;
+    if (c->cache_enabled) cache_load(c, opt->cache_path, root_hash);
+    mutexInit(&c->lock);
+    condvarInit(&c->cv);
+    c->worker_count = opt->threads < 1 ? 1 : opt->threads > SCAN_MAX_THREADS ? SCAN_MAX_THREADS : opt->threads;
+
+    Result rc = push_dir(c, "") ? 0 : MAKERESULT(Module_Libnx, LibnxError_OutOfMemory);
+    for (u32 i = 0; i < c->worker_count && R_SUCCEEDED(rc); ++i) {
+        ScanWorker *w = &c->workers[i];
+        w->ctx = c;
+        w->files.arena = opt->arena;
+#ifdef __SWITCH__
+        w->entries = malloc(SCAN_DIR_BATCH * sizeof(FsDirectoryEntry));
+        if (!w->entries) rc = MAKERESULT(Module_Libnx, LibnxError_OutOfMemory);
+#endif
+    }
+    // 0 号由调用线程担任；其余线程创建失败时少用几个线程照样完成
+    for (u32 i = 1; i < c->worker_count && R_SUCCEEDED(rc); ++i) {
+        ScanWorker *w = &c->workers[i];
+        if (R_FAILED(app_thread_start(&w->thread, ThreadRole_Scan, NULL, scan_worker_main, w))) continue;
+        w->started = true;
+    }
+    if (R_SUCCEEDED(rc)) scan_worker_main(&c->workers[0]);
+    for (u32 i = 1; i < c->worker_count; ++i) {
+        ScanWorker *w = &c->workers[i];
+        if (!w->started) continue;
+        app_thread_join(&w->thread);
+        stats->threads++;
+    }
+    stats->threads++;
+
+    // 合并各线程的结果
+    u32 total = 0;
+    for (u32 i = 0; i < c->worker_count; ++i) {
+        ScanWorker *w = &c->workers[i];
+        if (R_FAILED(w->rc)) rc = w->rc;
+        total += w->files.count;
+        stats->dirs += w->stats.dirs;
+        stats->dirs_cached += w->stats.dirs_cached;
+        stats->files += w->stats.files;
+        stats->files_cached += w->stats.files_cached;
+        stats->skipped += w->stats.skipped;
+    }
+    if (R_SUCCEEDED(rc) && total) {
+        out->items = malloc(total * sizeof(BackupFile));
+        if (!out->items) rc = MAKERESULT(Module_Libnx, LibnxError_OutOfMemory);
+    }
+    for (u32 i = 0; i < c->worker_count; ++i) {
+        ScanWorker *w = &c->workers[i];
+        if (R_SUCCEEDED(rc) && w->files.count) {
+            memcpy(out->items + out->count, w->files.items, w->files.count * sizeof(BackupFile));
+            out->count += w->files.count;
+            out->total_bytes += w->files.total_bytes;
+            free(w->files.items);
+        } else {
+            backup_file_list_free(&w->files);
+        }
+    }
+    out->capacity = out->count;
+    out->arena = opt->arena;
+    if (R_SUCCEEDED(rc)) {
+        qsort(out->items, out->count, sizeof(BackupFile), file_path_cmp);
+        if (c->cache_enabled) cache_save(c, opt->cache_path, root_hash);
+    } else {
+        backup_file_list_free(out);
+    }
+
+    for (u32 i = 0; i < c->stack_count; ++i) free(c->stack[i]);
+    free(c->stack);
+    for (u32 i = 0; i < c->worker_count; ++i) {
+        free(c->workers[i].cache_out.data);
+        free(c->workers[i].subdirs.data);
+#ifdef __SWITCH__
+        free(c->workers[i].entries);
+#endif
+    }
+    free(c->cache_index);
+    free(c->cache_blob);
+    free(c);
+    stats->elapsed_ns = armTicksToNs(armGetSystemTick() - start);
+    return rc;
+}
@@ -0,0 +1,51 @@
+#pragma once
+// 并行目录遍历：几个线程共享一个待遍历目录栈，各自批量读取目录项；
+// 每个目录的列表（文件名、大小、修改时间与子目录名）连同目录自身的修改时间缓存到 SD，
+// 下次遍历时目录修改时间未变就直接复用缓存，不再列目录、也不再逐个 stat 其中的文件。
+// 注意：原地改写已有文件不会改变所在目录的修改时间（FAT 与大多数文件系统都是如此），
+// 这种情况要靠关闭缓存（scan_cache = 0）发现
+#include "../util/platform.h"
+#include "../util/mempool.h"
+
+#define SCAN_CACHE_FILE_PATH "/config/mario-pop/scancache.bin"
+#define SCAN_CACHE_MAGIC "SCNC"
+#define SCAN_CACHE_VERSION 1
+#define SCAN_MAX_THREADS 4
+#define SCAN_PATH_MAX 512
+#define SCAN_DIR_BATCH 32           // Switch 上一次 fsDirRead 取回的目录项数
+
+// 待上传的文件（路径相对于遍历根目录，以 / 分隔，不带前导 /）
+typedef struct {
+    char *path;
+    u64 size;
+    s64 mtime;
+} BackupFile;
+
+typedef struct {
+    BackupFile *items;
+    u32 count;
+    u32 capacity;
+    u64 total_bytes;
+    MemArena *arena;            // 路径取自这个运行区（随之复位，不逐个释放）；NULL = 各自 malloc
+} BackupFileList;
+
+typedef struct {
+    const char *root;
+    u32 threads;                // 1..SCAN_MAX_THREADS（含调用线程）
+    const char *cache_path;     // NULL = 不使用缓存
+    MemArena *arena;            // 文件路径的来源，可为 NULL
+} ScanOptions;
+
+typedef struct {
+    u32 dirs;
+    u32 dirs_cached;            // 命中缓存、未重新列出的目录
+    u32 files;
+    u32 files_cached;
+    u32 skipped;                // 路径过长或无法访问而跳过的项
+    u32 threads;
+    u64 elapsed_ns;
+} ScanStats;
+
+// 遍历 root 下的全部普通文件，输出按路径排序；使用缓存时结束后写回新缓存
+Result scan_tree(const ScanOptions *opt, BackupFileList *out, ScanStats *stats);
+void backup_file_list_free(BackupFileList *list);
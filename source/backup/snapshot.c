@@ -0,0 +1,162 @@
+#include "snapshot.h"
+#include "../util/fspool.h"
+#include "../util/log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#define SNAPSHOT_IO_SIZE (128 * 1024) // 没有缓冲池时的读块大小
+#define SNAPSHOT_BUFFER_WAIT_NS (10 * 1000000000ULL)
+
+static const u8 s_empty[1]; // 空文件的内容指针（非 NULL 表示有副本）
+
+// 删除 path 下的全部内容（不删 path 本身）
+static void snapshot_clear_dir(char *path, size_t cap) {
+    DIR *dir = opendir(path);
+    if (!dir) return;
+    size_t len = strlen(path);
+    struct dirent *de;
+    while ((de = readdir(dir)) != NULL) {
+        if (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0) continue;
+        if ((size_t)snprintf(path + len, cap - len, "/%s", de->d_name) >= cap - len) continue;
+        struct stat st;
+        if (stat(path, &st) == 0 && S_ISDIR(st.st_mode)) {
+            snapshot_clear_dir(path, cap);
+            rmdir(path);
+        } else {
+            unlink(path);
+        }
+        path[len] = '\0';
+    }
+    closedir(dir);
+}
+
+static bool snapshot_make_parents(char *path) {
+    for (char *p = strchr(path + 1, '/'); p; p = strchr(p + 1, '/')) {
+        *p = '\0';
+        bool ok = mkdir(path, 0777) == 0 || errno == EEXIST;
+        *p = '/';
+        if (!ok) return false;
+    }
+    return true;
+}
+
+// 读入 src 的前 size 字节；文件此时的大小与扫描时不同也算失败
+static bool snapshot_read_ram(const char *src, u8 *dst, u64 size, Throttle *throttle) {
+    fspool_enter(FsRole_Data);
+    int fd = open(src, O_RDONLY);
+    struct stat st;
+    bool ok = fd >= 0 && fstat(fd, &st) == 0 && (u64)st.st_size == size;
+    fspool_leave(FsRole_Data);
+    for (u64 off = 0; ok && off < size;) {
+        size_t want = size - off < SNAPSHOT_IO_SIZE ? (size_t)(size - off) : SNAPSHOT_IO_SIZE;
+        if (throttle) throttle_acquire(throttle, ThrottleKind_Disk, want);
+        fspool_enter(FsRole_Data);
+        ssize_t n = read(fd, dst + off, want);
+        fspool_leave(FsRole_Data);
+        if (n <= 0) ok = false;
+        else off += (u64)n;
+    }
+    if (fd >= 0) close(fd);
+    return ok;
+}
+
+static bool snapshot_copy_file(const char *src, char *dst, u64 size, u8 *buf, size_t buf_size, Throttle *throttle) {
+    fspool_enter(FsRole_Data);
+    int in = open(src, O_RDONLY);
+    struct stat st;
+    bool ok = in >= 0 && fstat(in, &st) == 0 && (u64)st.st_size == size;
+    int out = ok && snapshot_make_parents(dst) ? open(dst, O_WRONLY | O_CREAT | O_TRUNC, 0666) : -1;
+    fspool_leave(FsRole_Data);
+    ok = ok && out >= 0;
+    for (u64 off = 0; ok && off < size;) {
+        size_t want = size - off < buf_size ? (size_t)(size - off) : buf_size;
+        // 读和写各算一次 SD 流量
+        if (throttle) throttle_acquire(throttle, ThrottleKind_Disk, want * 2);
+        fspool_enter(FsRole_Data);
+        ssize_t n = read(in, buf, want);
+        ok = n > 0 && write(out, buf, (size_t)n) == n;
+        fspool_leave(FsRole_Data);
+        if (ok) off += (u64)n;
+    }
+    if (in >= 0) close(in);
+    if (out >= 0 && close(out) != 0) ok = false;
+    if (!ok && out >= 0) unlink(dst);
+    return ok;
+}
+
+Result snapshot_take(Snapshot *s, const char *src_root, SnapshotItem *items, u32 count, u64 ram_limit,
+                     BufPool *buffers, Throttle *throttle) {
+    memset(s, 0, sizeof(*s));
+    u64 total = 0;
+    for (u32 i = 0; i < count; ++i) {
+        items[i].data = NULL;
+        items[i].ok = false;
+        total += items[i].size;
+    }
+    if (count == 0) return 0;
+    u64 start = armGetSystemTick();
+    char src[SNAPSHOT_PATH_MAX], dst[SNAPSHOT_PATH_MAX];
+
+    if (total <= ram_limit) {
+        s->ram = malloc(total ? (size_t)total : 1);
+        if (s->ram) s->mode = SnapshotMode_Ram;
+    }
+    u8 *buf = NULL;
+    size_t buf_size = SNAPSHOT_IO_SIZE;
+    if (s->mode != SnapshotMode_Ram) {
+        // 暂存目录里可能还有上次中断留下的副本
+        snprintf(dst, sizeof(dst), "%s", SNAPSHOT_DIR);
+        if (mkdir(SNAPSHOT_DIR, 0777) != 0 && errno != EEXIST) return MAKERESULT(Module_Libnx, LibnxError_IoError);
+        snapshot_clear_dir(dst, sizeof(dst));
+        if (buffers) {
+            buf = bufpool_acquire(buffers, SNAPSHOT_BUFFER_WAIT_NS);
+            buf_size = buffers->block_size;
+        } else {
+            buf = malloc(buf_size);
+        }
+        if (!buf) return MAKERESULT(Module_Libnx, LibnxError_OutOfMemory);
+        s->mode = SnapshotMode_Sd;
+    }
+
+    u64 ram_off = 0;
+    for (u32 i = 0; i < count; ++i) {
+        SnapshotItem *it = &items[i];
+        int n = snprintf(src, sizeof(src), "%s/%s", src_root, it->path);
+        int m = snprintf(dst, sizeof(dst), "%s/%s", SNAPSHOT_DIR, it->path);
+        bool fits = n > 0 && (size_t)n < sizeof(src) && m > 0 && (size_t)m < sizeof(dst);
+        if (s->mode == SnapshotMode_Ram) {
+            it->ok = fits && snapshot_read_ram(src, s->ram + ram_off, it->size, throttle);
+            it->data = !it->ok ? NULL : it->size ? s->ram + ram_off : s_empty;
+            ram_off += it->size;
+        } else {
+            it->ok = fits && snapshot_copy_file(src, dst, it->size, buf, buf_size, throttle);
+        }
+        if (it->ok) {
+            s->files++;
+            s->bytes += it->size;
+        } else {
+            s->failed++;
+            log_warning("快照复制 %s 失败", it->path);
+        }
+    }
+    if (buffers && buf) bufpool_release(buffers, buf);
+    else free(buf);
+    s->elapsed_ns = armTicksToNs(armGetSystemTick() - start);
+    return 0;
+}
+
+void snapshot_release(Snapshot *s) {
+    if (s->mode == SnapshotMode_Sd) {
+        char path[SNAPSHOT_PATH_MAX];
+        snprintf(path, sizeof(path), "%s", SNAPSHOT_DIR);
+        snapshot_clear_dir(path, sizeof(path));
+    }
+    free(s->ram);
+    s->ram = NULL;
+}
@@ -0,0 +1,42 @@
+#pragma once
+// 快照：上传前把需要读取的文件全速复制到暂存区，之后的上传只读副本。
+// 直接从备份源上传时，源文件在整个网络传输期间都开着，游戏可能同时改写存档，
+// 上传到一半的文件前后不属于同一个版本；复制只需 SD 顺序读写的时间，源目录的占用时间随之缩短。
+// 总量不超过 ram_limit 时副本放在内存里（一次申请，按文件首尾相接），否则写到 SD 上的暂存目录
+#include "../util/platform.h"
+#include "../util/mempool.h"
+#include "throttle.h"
+
+#define SNAPSHOT_DIR "/config/mario-pop/snapshot"
+#define SNAPSHOT_PATH_MAX 768
+
+typedef enum {
+    SnapshotMode_None,      // 没有副本（不用快照或没有要复制的文件）
+    SnapshotMode_Ram,
+    SnapshotMode_Sd,
+} SnapshotMode;
+
+// 一个要复制的文件；data 与 ok 由 snapshot_take 填写
+typedef struct {
+    const char *path;       // 相对备份源
+    u64 size;               // 扫描时的大小；复制时大小变了或读不全记为失败
+    const u8 *data;         // Ram 模式下的内容
+    bool ok;
+} SnapshotItem;
+
+typedef struct {
+    SnapshotMode mode;
+    u8 *ram;
+    u32 files;
+    u32 failed;
+    u64 bytes;
+    u64 elapsed_ns;         // 从打开第一个源文件到关闭最后一个
+} Snapshot;
+
+// 复制 items 中的文件（src_root 下 → 内存或 SNAPSHOT_DIR 下的同名路径）；
+// 读块取自 buffers（可为 NULL），SD 读写照常受 throttle 限速（前台有应用时）。
+// 整体失败（内存不足、暂存目录建不起来）时返回错误，单个文件失败只记在 item 上
+Result snapshot_take(Snapshot *s, const char *src_root, SnapshotItem *items, u32 count, u64 ram_limit,
+                     BufPool *buffers, Throttle *throttle);
+// 释放内存副本或清空暂存目录（统计字段保留）
+void snapshot_release(Snapshot *s);
@@ -0,0 +1,134 @@
+#include "throttle.h"
+#include "../util/service.h"
+#include <string.h>
+
+#ifdef __SWITCH__
+// pm:dmnt 能取到应用进程号即表示有应用在运行；服务不可用时保守地按前台有应用处理
+static bool query_foreground(void) {
+    if (R_FAILED(service_require(ServiceId_PmDmnt))) return true;
+    u64 pid = 0;
+    return R_SUCCEEDED(pmdmntGetApplicationProcessId(&pid));
+}
+#else
+static bool s_mock_foreground;
+
+void throttle_mock_set_foreground(bool running) {
+    s_mock_foreground = running;
+}
+
+static bool query_foreground(void) {
+    return s_mock_foreground;
+}
+#endif
+
+static s64 bucket_capacity(const ThrottleBucket *b) {
+    s64 cap = (s64)(b->rate * THROTTLE_BURST_NS / 1000000000ULL);
+    return cap > 0 ? cap : 1;
+}
+
+// 按经过的时间补充令牌；调用方持有 t->lock
+static void bucket_refill(ThrottleBucket *b, u64 now) {
+    u64 elapsed = armTicksToNs(now - b->last_tick);
+    b->last_tick = now;
+    if (elapsed > 1000000000ULL) elapsed = 1000000000ULL; // 桶早已满，避免乘法溢出
+    b->tokens += (s64)(b->rate * elapsed / 1000000000ULL);
+    s64 cap = bucket_capacity(b);
+    if (b->tokens > cap) b->tokens = cap;
+}
+
+static void bucket_unblock(ThrottleBucket *b, u64 now) {
+    if (!b->blocked_since) return;
+    b->throttled_ns += armTicksToNs(now - b->blocked_since);
+    b->blocked_since = 0;
+}
+
+// 调用方持有 t->lock；limited 为假表示此刻不限速
+static bool throttle_limited(Throttle *t, ThrottleBucket *b, u64 now) {
+    if (armTicksToNs(now - t->foreground_checked) >= THROTTLE_FOREGROUND_POLL_NS || !t->foreground_checked) {
+        t->foreground = query_foreground();
+        t->foreground_checked = now;
+    }
+    return t->foreground && b->rate != 0;
+}
+
+// 检查（take 为真时并取用）令牌；调用方持有 t->lock
+static bool bucket_take(Throttle *t, ThrottleKind kind, u64 bytes, bool take, u64 *wait_ns) {
+    ThrottleBucket *b = &t->buckets[kind];
+    u64 now = armGetSystemTick();
+    bucket_refill(b, now);
+    if (!throttle_limited(t, b, now) || b->tokens > 0) {
+        if (take && b->rate != 0) b->tokens -= (s64)bytes;
+        bucket_unblock(b, now);
+        if (wait_ns) *wait_ns = 0;
+        return true;
+    }
+    if (!b->blocked_since) {
+        b->blocked_since = now;
+        b->waits++;
+    }
+    if (wait_ns) *wait_ns = (u64)(1 - b->tokens) * 1000000000ULL / b->rate;
+    return false;
+}
+
+void throttle_init(Throttle *t, u64 disk_rate, u64 net_rate) {
+    memset(t, 0, sizeof(*t));
+    mutexInit(&t->lock);
+    u64 now = armGetSystemTick();
+    for (int i = 0; i < ThrottleKind_Count; ++i) t->buckets[i].last_tick = now;
+    throttle_set_rates(t, disk_rate, net_rate);
+}
+
+void throttle_set_rates(Throttle *t, u64 disk_rate, u64 net_rate) {
+    mutexLock(&t->lock);
+    u64 rates[ThrottleKind_Count] = { disk_rate, net_rate };
+    u64 now = armGetSystemTick();
+    for (int i = 0; i < ThrottleKind_Count; ++i) {
+        ThrottleBucket *b = &t->buckets[i];
+        bucket_refill(b, now);
+        b->rate = rates[i];
+        // 调低限额时不让旧的欠账或余量拖太久
+        s64 cap = bucket_capacity(b);
+        if (b->tokens > cap) b->tokens = cap;
+        if (b->tokens < -cap) b->tokens = -cap;
+    }
+    mutexUnlock(&t->lock);
+}
+
+u64 throttle_acquire(Throttle *t, ThrottleKind kind, u64 bytes) {
+    u64 start = armGetSystemTick();
+    for (;;) {
+        u64 wait_ns = 0;
+        mutexLock(&t->lock);
+        bool ok = bucket_take(t, kind, bytes, true, &wait_ns);
+        mutexUnlock(&t->lock);
+        if (ok) break;
+        svcSleepThread((s64)(wait_ns < THROTTLE_MAX_SLEEP_NS ? wait_ns : THROTTLE_MAX_SLEEP_NS));
+    }
+    return armTicksToNs(armGetSystemTick() - start);
+}
+
+bool throttle_try_acquire(Throttle *t, ThrottleKind kind, u64 bytes, u64 *wait_ns) {
+    mutexLock(&t->lock);
+    bool ok = bucket_take(t, kind, bytes, true, wait_ns);
+    mutexUnlock(&t->lock);
+    return ok;
+}
+
+bool throttle_ready(Throttle *t, ThrottleKind kind, u64 *wait_ns) {
+    mutexLock(&t->lock);
+    bool ok = bucket_take(t, kind, 0, false, wait_ns);
+    mutexUnlock(&t->lock);
+    return ok;
+}
+
+void throttle_stats(Throttle *t, ThrottleStats *out) {
+    mutexLock(&t->lock);
+    u64 now = armGetSystemTick();
+    for (int i = 0; i < ThrottleKind_Count; ++i) {
+        const ThrottleBucket *b = &t->buckets[i];
+        out->throttled_ns[i] = b->throttled_ns + (b->blocked_since ? armTicksToNs(now - b->blocked_since) : 0);
+        out->waits[i] = b->waits;
+    }
+    out->foreground = t->foreground;
+    mutexUnlock(&t->lock);
+}
@@ -0,0 +1,52 @@
+#pragma once
+// 后台备份限速：有应用（游戏）在前台时，用令牌桶分别限制 SD 读取与网络发送速率，避免抢占游戏的 I/O；
+// 没有应用运行时不限速。限额可在运行中修改（配置热更新），被限速的时间计入统计
+#include "../util/platform.h"
+
+#define THROTTLE_BURST_NS 100000000ULL        // 桶容量 = 速率 × 100ms
+#define THROTTLE_MAX_SLEEP_NS 20000000ULL     // 阻塞等待时每次最多睡 20ms，限额或前台状态变化能及时生效
+#define THROTTLE_FOREGROUND_POLL_NS 500000000ULL
+
+typedef enum {
+    ThrottleKind_Disk = 0,
+    ThrottleKind_Net,
+    ThrottleKind_Count,
+} ThrottleKind;
+
+typedef struct {
+    u64 rate;               // 字节/秒；0 = 不限
+    s64 tokens;             // 可为负：一次取用可以超过桶容量，欠下的按速率还清后才能再取
+    u64 last_tick;
+    u64 blocked_since;      // 令牌不足、有人在等的起始时刻（0 = 未受限）
+    u64 throttled_ns;       // 累计受限时间
+    u64 waits;              // 受限次数
+} ThrottleBucket;
+
+typedef struct {
+    Mutex lock;
+    ThrottleBucket buckets[ThrottleKind_Count];
+    bool foreground;        // 最近一次查询时是否有应用在运行
+    u64 foreground_checked;
+} Throttle;
+
+typedef struct {
+    u64 throttled_ns[ThrottleKind_Count];
+    u64 waits[ThrottleKind_Count];
+    bool foreground;
+} ThrottleStats;
+
+void throttle_init(Throttle *t, u64 disk_rate, u64 net_rate);
+// 运行中修改限额（字节/秒，0 = 不限）
+void throttle_set_rates(Throttle *t, u64 disk_rate, u64 net_rate);
+// 阻塞取用（读线程用）：令牌不足时分段睡眠直到还清；返回等待的纳秒数
+u64 throttle_acquire(Throttle *t, ThrottleKind kind, u64 bytes);
+// 非阻塞取用（curl 回调用）：不足时返回 false，*wait_ns 为预计还需等待的时间
+bool throttle_try_acquire(Throttle *t, ThrottleKind kind, u64 bytes, u64 *wait_ns);
+// 现在取用是否会成功；不成功时 *wait_ns 同上
+bool throttle_ready(Throttle *t, ThrottleKind kind, u64 *wait_ns);
+void throttle_stats(Throttle *t, ThrottleStats *out);
+
+#ifndef __SWITCH__
+// 主机替身：模拟前台有无应用
+void throttle_mock_set_foreground(bool running);
+#endif
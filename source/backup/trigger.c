@@ -0,0 +1,465 @@
+#include "trigger.h"
+#include "../util/hash.h"
+#include "../util/log.h"
+#include "../util/fspool.h"
+#include "../util/service.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __SWITCH__
+#include <switch/runtime/devices/fs_dev.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+static const char *const s_kind_names[TriggerKind_Count] = {
+    "启动", "手动", "应用退出", "存档目录", "定时",
+};
+
+const char *trigger_kind_name(TriggerKind kind) {
+    return kind < TriggerKind_Count ? s_kind_names[kind] : "?";
+}
+
+// ---- 去抖 ----
+
+void trigger_debounce_feed(TriggerDebounce *d, const TriggerPolicy *p, const TriggerEvent *ev) {
+    TriggerBatch *b = &d->batch;
+    if (!b->total) b->first_tick = ev->tick;
+    if (ev->tick > b->last_tick) b->last_tick = ev->tick;
+    b->counts[ev->kind]++;
+    b->total++;
+
+    // 启动与手动不等安静期；已有这类事件待触发时，后来的事件也不再推迟它
+    if (ev->kind == TriggerKind_Startup || ev->kind == TriggerKind_Manual) {
+        if (!d->immediate || ev->tick < d->due_tick) d->due_tick = ev->tick;
+        d->immediate = true;
+    } else if (!d->immediate) {
+        u64 due = ev->tick + armNsToTicks(p->debounce_ns);
+        if (p->max_delay_ns) {
+            u64 limit = b->first_tick + armNsToTicks(p->max_delay_ns);
+            if (due > limit) due = limit;
+        }
+        d->due_tick = due;
+    }
+    if (!d->due_tick) d->due_tick = 1;
+}
+
+bool trigger_debounce_take(TriggerDebounce *d, u64 now, TriggerBatch *out) {
+    if (!d->due_tick || now < d->due_tick) return false;
+    *out = d->batch;
+    memset(d, 0, sizeof(*d));
+    return true;
+}
+
+// ---- 引擎 ----
+
+Result trigger_engine_init(TriggerEngine *e, const TriggerPolicy *policy) {
+    memset(e, 0, sizeof(*e));
+    mutexInit(&e->lock);
+    e->policy = *policy;
+#ifdef __SWITCH__
+    ueventCreate(&e->wake, true);
+#else
+    if (pipe(e->wake_fds) != 0) return MAKERESULT(Module_Libnx, LibnxError_IoError);
+    fcntl(e->wake_fds[0], F_SETFL, O_NONBLOCK);
+    fcntl(e->wake_fds[1], F_SETFL, O_NONBLOCK);
+#endif
+    return 0;
+}
+
+Result trigger_engine_add_source(TriggerEngine *e, const TriggerSource *src) {
+    if (e->source_count >= TRIGGER_MAX_SOURCES) return MAKERESULT(Module_Libnx, LibnxError_OutOfMemory);
+    e->sources[e->source_count++] = *src;
+    return 0;
+}
+
+static void engine_wake(TriggerEngine *e) {
+#ifdef __SWITCH__
+    ueventSignal(&e->wake);
+#else
+    u8 b = 0;
+    if (write(e->wake_fds[1], &b, 1) < 0) {} // 管道已满时引擎反正会被唤醒
+#endif
+}
+
+void trigger_engine_kick(TriggerEngine *e, TriggerKind kind) {
+    if (kind >= TriggerKind_Count) return;
+    mutexLock(&e->lock);
+    e->kicked[kind]++;
+    mutexUnlock(&e->lock);
+    engine_wake(e);
+}
+
+void trigger_engine_set_policy(TriggerEngine *e, const TriggerPolicy *policy) {
+    mutexLock(&e->lock);
+    e->policy = *policy;
+    mutexUnlock(&e->lock);
+    engine_wake(e);
+}
+
+void trigger_engine_stop(TriggerEngine *e) {
+    mutexLock(&e->lock);
+    e->stop = true;
+    mutexUnlock(&e->lock);
+    engine_wake(e);
+}
+
+void trigger_engine_stats(TriggerEngine *e, TriggerStats *out) {
+    mutexLock(&e->lock);
+    *out = e->stats;
+    mutexUnlock(&e->lock);
+    out->coalesced = out->events > out->runs ? out->events - out->runs : 0;
+}
+
+void trigger_engine_exit(TriggerEngine *e) {
+    for (u32 i = 0; i < e->source_count; ++i) {
+        if (e->sources[i].close) e->sources[i].close(e->sources[i].ctx);
+    }
+    e->source_count = 0;
+#ifndef __SWITCH__
+    close(e->wake_fds[0]);
+    close(e->wake_fds[1]);
+#endif
+}
+
+// 阻塞到 deadline（0 = 无限）或任一可等待对象有信号
+static void engine_wait(TriggerEngine *e, u64 now, u64 deadline) {
+#ifdef __SWITCH__
+    Waiter waiters[TRIGGER_MAX_SOURCES + 1];
+    s32 n = 0;
+    waiters[n++] = waiterForUEvent(&e->wake);
+    for (u32 i = 0; i < e->source_count; ++i) {
+        TriggerSource *s = &e->sources[i];
+        if (s->waitable && s->waitable(s->ctx, &waiters[n])) n++;
+    }
+    u64 timeout = deadline ? (deadline > now ? armTicksToNs(deadline - now) : 0) : UINT64_MAX;
+    s32 idx;
+    waitObjects(&idx, waiters, n, timeout);
+#else
+    struct pollfd fds[TRIGGER_MAX_SOURCES + 1];
+    int n = 0;
+    fds[n].fd = e->wake_fds[0];
+    fds[n++].events = POLLIN;
+    for (u32 i = 0; i < e->source_count; ++i) {
+        TriggerSource *s = &e->sources[i];
+        if (s->waitable && s->waitable(s->ctx, &fds[n].fd)) fds[n++].events = POLLIN;
+    }
+    int timeout = -1;
+    if (deadline) timeout = deadline > now ? (int)((armTicksToNs(deadline - now) + 999999) / 1000000) : 0;
+    if (poll(fds, (nfds_t)n, timeout) > 0 && (fds[0].revents & POLLIN)) {
+        u8 drain[64];
+        while (read(e->wake_fds[0], drain, sizeof(drain)) > 0) {}
+    }
+#endif
+}
+
+static void engine_log_batch(const TriggerBatch *b, u64 now) {
+    char kinds[128];
+    size_t len = 0;
+    kinds[0] = 0;
+    for (int k = 0; k < TriggerKind_Count; ++k) {
+        if (!b->counts[k] || len >= sizeof(kinds)) continue;
+        len += (size_t)snprintf(kinds + len, sizeof(kinds) - len, "%s%s×%u", len ? "，" : "", s_kind_names[k], b->counts[k]);
+    }
+    log_info("触发备份：%s（合并 %u 个事件，距第一个事件 %.1f 秒）", kinds, b->total,
+             (double)armTicksToNs(now - b->first_tick) / 1e9);
+}
+
+void trigger_engine_run(TriggerEngine *e, TriggerRunFn run, void *user) {
+    TriggerEvent events[TRIGGER_MAX_EVENTS];
+    for (;;) {
+        u64 now = armGetSystemTick();
+        mutexLock(&e->lock);
+        if (e->stop) {
+            mutexUnlock(&e->lock);
+            break;
+        }
+        TriggerPolicy policy = e->policy;
+        u32 kicked[TriggerKind_Count];
+        memcpy(kicked, e->kicked, sizeof(kicked));
+        memset(e->kicked, 0, sizeof(e->kicked));
+        e->stats.wakeups++;
+        mutexUnlock(&e->lock);
+
+        u32 fed = 0;
+        for (int k = 0; k < TriggerKind_Count; ++k) {
+            TriggerEvent ev = { (TriggerKind)k, now };
+            for (u32 i = 0; i < kicked[k]; ++i, ++fed) trigger_debounce_feed(&e->debounce, &policy, &ev);
+        }
+        for (u32 i = 0; i < e->source_count; ++i) {
+            TriggerSource *s = &e->sources[i];
+            u32 n = s->poll(s->ctx, now, events, TRIGGER_MAX_EVENTS);
+            for (u32 j = 0; j < n; ++j) {
+                if (events[j].kind >= TriggerKind_Count) continue;
+                log_debug("触发事件：%s（%s）", s_kind_names[events[j].kind], s->name);
+                trigger_debounce_feed(&e->debounce, &policy, &events[j]);
+                fed++;
+            }
+        }
+
+        TriggerBatch batch;
+        bool due = trigger_debounce_take(&e->debounce, now, &batch);
+        mutexLock(&e->lock);
+        e->stats.events += fed;
+        if (due) e->stats.runs++;
+        mutexUnlock(&e->lock);
+        if (due) {
+            engine_log_batch(&batch, now);
+            run(user, &batch);
+            now = armGetSystemTick();
+            for (u32 i = 0; i < e->source_count; ++i) {
+                if (e->sources[i].on_run) e->sources[i].on_run(e->sources[i].ctx, now);
+            }
+            continue; // 备份期间的信号与事件马上再取一次
+        }
+
+        u64 deadline = e->debounce.due_tick;
+        for (u32 i = 0; i < e->source_count; ++i) {
+            u64 t = e->sources[i].next_deadline(e->sources[i].ctx, now);
+            if (t && (!deadline || t < deadline)) deadline = t;
+        }
+        engine_wait(e, now, deadline);
+    }
+}
+
+// ---- 定时 ----
+
+static u32 schedule_poll(void *ctx, u64 now, TriggerEvent *out, u32 max) {
+    TriggerScheduleSource *s = ctx;
+    if (!s->next_tick) s->next_tick = now + armNsToTicks(s->interval_ns);
+    if (now < s->next_tick || !max) return 0;
+    s->next_tick = now + armNsToTicks(s->interval_ns);
+    out[0] = (TriggerEvent){ TriggerKind_Schedule, now };
+    return 1;
+}
+
+static u64 schedule_deadline(void *ctx, u64 now) {
+    TriggerScheduleSource *s = ctx;
+    return s->next_tick ? s->next_tick : now + armNsToTicks(s->interval_ns);
+}
+
+static void schedule_on_run(void *ctx, u64 now) {
+    TriggerScheduleSource *s = ctx;
+    s->next_tick = now + armNsToTicks(s->interval_ns);
+}
+
+void trigger_schedule_source(TriggerSource *src, TriggerScheduleSource *ctx, u64 interval_ns) {
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->interval_ns = interval_ns;
+    *src = (TriggerSource){
+        .name = "schedule",
+        .ctx = ctx,
+        .poll = schedule_poll,
+        .next_deadline = schedule_deadline,
+        .on_run = schedule_on_run,
+    };
+}
+
+// ---- 存档目录 ----
+
+static u64 dir_entry_hash(const char *name, s64 mtime) {
+    FastHash h;
+    fasthash_init(&h);
+    fasthash_update(&h, name, strlen(name));
+    fasthash_update(&h, &mtime, sizeof(mtime));
+    return fasthash_final(&h);
+}
+
+// 子目录按读取顺序无关的方式合并（求和）；根目录取不到时返回 0。
+// Switch 上与遍历相同，直接用 fs 接口成批读目录项并取时间戳
+#ifdef __SWITCH__
+
+#define TRIGGER_DIR_BATCH 8
+
+static bool dir_mtime(FsFileSystem *fs, const char *path, s64 *out) {
+    FsTimeStampRaw ts;
+    if (R_FAILED(fsFsGetFileTimeStampRaw(fs, path, &ts)) || !ts.is_valid) return false;
+    *out = (s64)ts.modified;
+    return true;
+}
+
+static u64 dir_stamp(const char *root) {
+    FsFileSystem *fs = fsdevGetDeviceFileSystem("sdmc");
+    s64 mtime;
+    if (!fs || !dir_mtime(fs, root, &mtime)) return 0;
+    u64 stamp = dir_entry_hash("", mtime);
+    FsDir dir;
+    if (R_FAILED(fsFsOpenDirectory(fs, root, FsDirOpenMode_ReadDirs, &dir))) return stamp | 1;
+    FsDirectoryEntry entries[TRIGGER_DIR_BATCH];
+    char path[512];
+    for (;;) {
+        s64 total = 0;
+        if (R_FAILED(fsDirRead(&dir, &total, TRIGGER_DIR_BATCH, entries)) || total <= 0) break;
+        for (s64 i = 0; i < total; ++i) {
+            if ((size_t)snprintf(path, sizeof(path), "%s/%s", root, entries[i].name) >= sizeof(path)) continue;
+            if (dir_mtime(fs, path, &mtime)) stamp += dir_entry_hash(entries[i].name, mtime);
+        }
+    }
+    fsDirClose(&dir);
+    return stamp | 1;
+}
+
+#else
+
+static u64 dir_stamp(const char *root) {
+    struct stat st;
+    if (stat(root, &st) != 0) return 0;
+    u64 stamp = dir_entry_hash("", (s64)st.st_mtime);
+    DIR *dir = opendir(root);
+    if (!dir) return stamp | 1;
+    char path[512];
+    struct dirent *ent;
+    while ((ent = readdir(dir)) != NULL) {
+        if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0) continue;
+        if ((size_t)snprintf(path, sizeof(path), "%s/%s", root, ent->d_name) >= sizeof(path)) continue;
+        if (stat(path, &st) != 0 || !S_ISDIR(st.st_mode)) continue;
+        stamp += dir_entry_hash(ent->d_name, (s64)st.st_mtime);
+    }
+    closedir(dir);
+    return stamp | 1;
+}
+
+#endif
+
+static u32 dir_poll(void *ctx, u64 now, TriggerEvent *out, u32 max) {
+    TriggerDirSource *s = ctx;
+    if (now < s->next_tick || !max) return 0;
+    s->next_tick = now + armNsToTicks(s->interval_ns);
+    fspool_enter(FsRole_Scan);
+    u64 stamp = dir_stamp(s->root);
+    fspool_leave(FsRole_Scan);
+    if (!stamp) return 0;
+    bool changed = s->stamp && stamp != s->stamp;
+    s->stamp = stamp;
+    if (!changed) return 0;
+    out[0] = (TriggerEvent){ TriggerKind_SaveDir, now };
+    return 1;
+}
+
+static u64 dir_deadline(void *ctx, u64 now) {
+    return ((TriggerDirSource*)ctx)->next_tick;
+}
+
+void trigger_dir_source(TriggerSource *src, TriggerDirSource *ctx, const char *root, u64 interval_ns) {
+    memset(ctx, 0, sizeof(*ctx));
+    snprintf(ctx->root, sizeof(ctx->root), "%s", root);
+    ctx->interval_ns = interval_ns;
+    *src = (TriggerSource){
+        .name = "savedir",
+        .ctx = ctx,
+        .poll = dir_poll,
+        .next_deadline = dir_deadline,
+    };
+}
+
+// ---- 应用退出 ----
+
+#ifdef __SWITCH__
+
+static bool title_find_application(TriggerTitleSource *s) {
+    if (R_FAILED(service_require(ServiceId_PmDmnt))) return false;
+    u64 pid = 0;
+    if (R_FAILED(pmdmntGetApplicationProcessId(&pid)) || !pid) return false;
+    NcmProgramLocation loc;
+    CfgOverrideStatus status;
+    Handle process;
+    if (R_FAILED(pmdmntAtmosphereGetProcessInfo(&process, &loc, &status, pid))) return false;
+    s->pid = pid;
+    s->process = process;
+    return true;
+}
+
+// 进程状态每次变化都会触发句柄；还没退出就清掉信号继续等
+static bool title_exited(TriggerTitleSource *s) {
+    s64 state = 0;
+    if (R_FAILED(svcGetProcessInfo(&state, s->process, ProcessInfoType_ProcessState))) return true;
+    if (state == ProcessState_Exiting || state == ProcessState_Exited) return true;
+    svcResetSignal(s->process);
+    return false;
+}
+
+static void title_release(TriggerTitleSource *s) {
+    svcCloseHandle(s->process);
+    s->process = INVALID_HANDLE;
+    s->pid = 0;
+}
+
+static bool title_waitable(void *ctx, TriggerWaitable *out) {
+    TriggerTitleSource *s = ctx;
+    if (!s->pid) return false;
+    *out = waiterForHandle(s->process);
+    return true;
+}
+
+#else
+
+static u64 s_mock_application;
+
+void trigger_mock_set_application(u64 pid) {
+    __atomic_store_n(&s_mock_application, pid, __ATOMIC_RELEASE);
+}
+
+static bool title_find_application(TriggerTitleSource *s) {
+    s->pid = __atomic_load_n(&s_mock_application, __ATOMIC_ACQUIRE);
+    return s->pid != 0;
+}
+
+static bool title_exited(TriggerTitleSource *s) {
+    return __atomic_load_n(&s_mock_application, __ATOMIC_ACQUIRE) != s->pid;
+}
+
+static void title_release(TriggerTitleSource *s) {
+    s->pid = 0;
+}
+
+#endif
+
+static u32 title_poll(void *ctx, u64 now, TriggerEvent *out, u32 max) {
+    TriggerTitleSource *s = ctx;
+    if (!max) return 0;
+    if (s->pid) {
+        if (!title_exited(s)) return 0;
+        log_info("应用已退出（pid %llu）", (unsigned long long)s->pid);
+        title_release(s);
+        s->next_tick = now + armNsToTicks(s->poll_ns);
+        out[0] = (TriggerEvent){ TriggerKind_TitleExit, now };
+        return 1;
+    }
+    if (now < s->next_tick) return 0;
+    s->next_tick = now + armNsToTicks(s->poll_ns);
+    if (title_find_application(s)) log_debug("开始等待应用退出（pid %llu）", (unsigned long long)s->pid);
+    return 0;
+}
+
+static u64 title_deadline(void *ctx, u64 now) {
+    TriggerTitleSource *s = ctx;
+#ifdef __SWITCH__
+    if (s->pid) return 0;
+#endif
+    // 主机替身没有句柄可等，有无应用都按间隔查询
+    return s->next_tick;
+}
+
+static void title_close(void *ctx) {
+    TriggerTitleSource *s = ctx;
+    if (s->pid) title_release(s);
+}
+
+void trigger_title_source(TriggerSource *src, TriggerTitleSource *ctx, u64 poll_ns) {
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->poll_ns = poll_ns;
+    *src = (TriggerSource){
+        .name = "title",
+        .ctx = ctx,
+#ifdef __SWITCH__
+        .waitable = title_waitable,
+#endif
+        .poll = title_poll,
+        .next_deadline = title_deadline,
+        .close = title_close,
+    };
+}
@@ -0,0 +1,149 @@
+#pragma once
+// 备份触发引擎：事件源（应用退出、存档目录变化、定时、回放）产生事件，引擎去抖合并后调用一次备份。
+// 事件之间线程阻塞在内核等待上（Switch 上与渲染循环等 g_vsyncEvent 相同的 Event/Waiter 机制，
+// 主机上是 poll），不轮询；只有事件源声明的下一个时间点才会让等待超时返回。
+// 去抖：第一个事件到来后等安静期（debounce）无新事件再触发，连续事件不断推迟，但距第一个事件最多 max_delay；
+// 备份进行中到来的事件合并为结束后的下一次
+#include "../util/platform.h"
+
+#define TRIGGER_MAX_SOURCES 6
+#define TRIGGER_MAX_EVENTS 16       // 一次等待返回后每个事件源最多取出的事件数
+
+typedef enum {
+    TriggerKind_Startup = 0,        // 启动后的第一次备份
+    TriggerKind_Manual,             // 其他线程调用 trigger_engine_kick
+    TriggerKind_TitleExit,          // 应用（游戏）退出
+    TriggerKind_SaveDir,            // 存档目录变化
+    TriggerKind_Schedule,           // 定时
+    TriggerKind_Count,
+} TriggerKind;
+
+typedef struct {
+    TriggerKind kind;
+    u64 tick;                       // 事件发生时刻（armGetSystemTick）
+} TriggerEvent;
+
+#ifdef __SWITCH__
+typedef Waiter TriggerWaitable;
+#else
+typedef int TriggerWaitable;        // 主机：可 poll 的文件描述符
+#endif
+
+// 事件源接口。全部回调都在引擎线程上调用
+typedef struct TriggerSource {
+    const char *name;
+    void *ctx;
+    // 可选：内核可等待对象，信号到来时引擎调用 poll；返回 false 表示此刻没有（只按 next_deadline 唤醒）
+    bool (*waitable)(void *ctx, TriggerWaitable *out);
+    // 取出到 now 为止已发生的事件，返回个数（≤ max）
+    u32 (*poll)(void *ctx, u64 now, TriggerEvent *out, u32 max);
+    // 下一次需要调用 poll 的时刻（tick）；0 = 只靠 waitable
+    u64 (*next_deadline)(void *ctx, u64 now);
+    // 可选：一次备份结束时调用（定时源据此重新计时）
+    void (*on_run)(void *ctx, u64 now);
+    // 可选
+    void (*close)(void *ctx);
+} TriggerSource;
+
+typedef struct {
+    u64 debounce_ns;                // 安静期
+    u64 max_delay_ns;               // 第一个事件到触发的最长时间（0 = 不限）
+} TriggerPolicy;
+
+// 一次触发合并的事件
+typedef struct {
+    u32 counts[TriggerKind_Count];
+    u32 total;
+    u64 first_tick;
+    u64 last_tick;
+} TriggerBatch;
+
+// 去抖状态机（与等待无关，回放工具直接驱动它）
+typedef struct {
+    TriggerBatch batch;
+    u64 due_tick;                   // 0 = 没有待触发的事件
+    bool immediate;                 // 合并了启动/手动事件：不再等安静期
+} TriggerDebounce;
+
+void trigger_debounce_feed(TriggerDebounce *d, const TriggerPolicy *p, const TriggerEvent *ev);
+// 到期时把合并的事件移到 *out 并返回 true
+bool trigger_debounce_take(TriggerDebounce *d, u64 now, TriggerBatch *out);
+
+typedef struct {
+    u64 wakeups;                    // 等待返回的次数
+    u64 events;
+    u64 runs;
+    u64 coalesced;                  // 被合并掉的事件（events - runs）
+} TriggerStats;
+
+typedef void (*TriggerRunFn)(void *user, const TriggerBatch *batch);
+
+typedef struct {
+    Mutex lock;
+    TriggerPolicy policy;
+    TriggerSource sources[TRIGGER_MAX_SOURCES];
+    u32 source_count;
+    TriggerDebounce debounce;
+    TriggerStats stats;
+    u32 kicked[TriggerKind_Count];  // 其他线程投递、尚未取走的事件
+    bool stop;
+#ifdef __SWITCH__
+    UEvent wake;
+#else
+    int wake_fds[2];
+#endif
+} TriggerEngine;
+
+Result trigger_engine_init(TriggerEngine *e, const TriggerPolicy *policy);
+// 在 trigger_engine_run 之前调用
+Result trigger_engine_add_source(TriggerEngine *e, const TriggerSource *src);
+// 事件循环：直到 trigger_engine_stop 才返回；run 在本线程上同步执行
+void trigger_engine_run(TriggerEngine *e, TriggerRunFn run, void *user);
+// 以下三个可从任意线程调用，都会唤醒引擎
+void trigger_engine_kick(TriggerEngine *e, TriggerKind kind);
+void trigger_engine_set_policy(TriggerEngine *e, const TriggerPolicy *policy);
+void trigger_engine_stop(TriggerEngine *e);
+void trigger_engine_stats(TriggerEngine *e, TriggerStats *out);
+// 关闭全部事件源
+void trigger_engine_exit(TriggerEngine *e);
+const char *trigger_kind_name(TriggerKind kind);
+
+// ---- 内置事件源（ctx 由调用方提供存储，生命周期覆盖引擎运行期） ----
+
+// 定时：上次备份结束 interval_ns 后触发
+typedef struct {
+    u64 interval_ns;
+    u64 next_tick;
+} TriggerScheduleSource;
+
+void trigger_schedule_source(TriggerSource *src, TriggerScheduleSource *ctx, u64 interval_ns);
+
+// 存档目录：每 interval_ns 比较一次根目录与其下一层子目录的修改时间（文件系统没有变更通知）。
+// 存档管理器新建或替换存档槽都会改变对应标题目录的修改时间
+typedef struct {
+    char root[256];
+    u64 interval_ns;
+    u64 next_tick;
+    u64 stamp;                      // 根目录与子目录名、修改时间的哈希；0 = 尚未取得
+} TriggerDirSource;
+
+void trigger_dir_source(TriggerSource *src, TriggerDirSource *ctx, const char *root, u64 interval_ns);
+
+// 应用退出：有应用运行时阻塞等待其进程句柄（进程状态变化时被触发），没有应用时每 poll_ns 查询一次是否有新应用启动
+typedef struct {
+    u64 poll_ns;
+    u64 next_tick;
+    u64 pid;                        // 正在等待的应用；0 = 无
+#ifdef __SWITCH__
+    Handle process;
+#endif
+} TriggerTitleSource;
+
+#define TRIGGER_TITLE_POLL_NS 2000000000ULL
+
+void trigger_title_source(TriggerSource *src, TriggerTitleSource *ctx, u64 poll_ns);
+
+#ifndef __SWITCH__
+// 主机替身：模拟应用启动（pid 非 0）与退出（pid 为 0）
+void trigger_mock_set_application(u64 pid);
+#endif
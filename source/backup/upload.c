@@ -0,0 +1,1095 @@
+#include "upload.h"
+#include "progress.h"
+#include "../util/log.h"
+#include "../util/fspool.h"
+#include "../util/metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// 调用方持有 e->lock
+static void lane_reset_ring(UploadLane *l) {
+    l->head = l->tail = l->filled = 0;
+    l->current = NULL;
+    l->current_off = 0;
+    l->sent_eof = false;
+    l->paused = false;
+    l->throttled = false;
+}
+
+// 读满一块（遇到文件尾或出错才会提前返回）
+static ssize_t read_full(int fd, u8 *dst, size_t len) {
+    size_t got = 0;
+    while (got < len) {
+        ssize_t n = read(fd, dst + got, len - got);
+        if (n < 0) return -1;
+        if (n == 0) break;
+        got += (size_t)n;
+    }
+    return (ssize_t)got;
+}
+
+// 读线程的每次读盘先取 SD 令牌（前台有应用时按限额排队），再占用本线程的文件系统会话槽
+static ssize_t lane_read(UploadEngine *e, UploadLane *l, u8 *dst, size_t len) {
+    const UploadJob *job = l->job;
+    if (job->data) {
+        size_t n = job->size - l->data_off < len ? (size_t)(job->size - l->data_off) : len;
+        memcpy(dst, job->data + l->data_off, n);
+        l->data_off += n;
+        return (ssize_t)n;
+    }
+    if (e->throttle && len) throttle_acquire(e->throttle, ThrottleKind_Disk, len);
+    fspool_enter(FsRole_Data);
+    ssize_t n = l->job->pack ? (ssize_t)pack_archive_read(l->job->pack, dst, len) : read_full(l->fd, dst, len);
+    fspool_leave(FsRole_Data);
+    return n;
+}
+
+// 选一条需要数据的通道（有文件、未读完、环未满）；从上次之后轮转，避免大文件独占 SD
+static UploadLane *reader_pick_lane(UploadEngine *e) {
+    for (u32 i = 0; i < e->lane_count; ++i) {
+        UploadLane *l = &e->lanes[(e->next_lane + i) % e->lane_count];
+        if (l->job && !l->read_done && !l->cancel && l->filled < e->slot_count) {
+            e->next_lane = (l->index + 1) % e->lane_count;
+            return l;
+        }
+    }
+    return NULL;
+}
+
+// 按文件顺序送入读到的数据：内容哈希、SHA-256 与当前块的 CRC32C 一起更新，块满时收下该块的 CRC
+static void lane_digest(UploadEngine *e, UploadLane *l, const u8 *data, size_t len) {
+    fasthash_update(&l->hash, data, len);
+    sha256_update(&l->sha, data, len);
+    while (len > 0) {
+        u64 left = e->crc_chunk - l->digest_off % e->crc_chunk;
+        size_t n = len < left ? len : (size_t)left;
+        l->crc = crc32c(l->crc, data, n);
+        l->digest_off += n;
+        data += n;
+        len -= n;
+        if (n == left && l->crc_count < l->crc_capacity) {
+            l->crcs[l->crc_count++] = l->crc;
+            l->crc = 0;
+        }
+    }
+}
+
+static void lane_digest_reset(UploadLane *l) {
+    fasthash_init(&l->hash);
+    sha256_init(&l->sha);
+    l->digest_off = 0;
+    l->crc = 0;
+    l->crc_count = 0;
+}
+
+// 原样读入一块；返回从 SD 读入的字节数。
+// 续传时先把已在远端的前缀读一遍只算摘要，清单里的哈希与各块 CRC 仍覆盖整个文件
+static u64 lane_fill_raw(UploadEngine *e, UploadLane *l, UploadSlot *slot) {
+    u64 bytes_read = 0;
+    while (l->skip > 0) {
+        size_t want = l->skip < e->slot_size ? (size_t)l->skip : e->slot_size;
+        ssize_t n = lane_read(e, l, slot->data, want);
+        if (n < 0 || (size_t)n != want) {
+            slot->len = slot->raw_len = 0;
+            slot->error = slot->eof = true;
+            return bytes_read;
+        }
+        lane_digest(e, l, slot->data, want);
+        l->skip -= want;
+        bytes_read += want;
+    }
+    size_t want = l->remaining < e->slot_size ? (size_t)l->remaining : e->slot_size;
+    ssize_t n = want ? lane_read(e, l, slot->data, want) : 0;
+    slot->error = n < 0 || (size_t)n != want; // 文件在读取过程中被截断也视为失败
+    slot->len = n > 0 ? (u32)n : 0;
+    slot->raw_len = slot->len;
+    l->remaining -= slot->len;
+    slot->eof = l->remaining == 0 || slot->error;
+    lane_digest(e, l, slot->data, slot->len);
+    return bytes_read + slot->len;
+}
+
+// 读入原始数据并压缩，直到填满一块或压缩流结束；返回从 SD 读入的字节数
+static u64 lane_fill_compressed(UploadEngine *e, UploadLane *l, UploadSlot *slot, int level, u64 *deflate_ns) {
+    size_t out_len = 0;
+    u32 raw_used = 0;
+    u64 bytes_read = 0;
+    bool error = false;
+    compress_stream_set_level(&l->z, level, slot->data, &out_len, e->slot_size);
+    while (out_len < e->slot_size && !l->z.finished && !error) {
+        if (l->raw_off == l->raw_len && !l->raw_eof) {
+            size_t want = l->remaining < e->slot_size ? (size_t)l->remaining : e->slot_size;
+            ssize_t n = want ? lane_read(e, l, l->raw, want) : 0;
+            if (n < 0 || (size_t)n != want) {
+                error = true;
+                break;
+            }
+            lane_digest(e, l, l->raw, (size_t)n);
+            l->remaining -= (u64)n;
+            l->raw_len = (u32)n;
+            l->raw_off = 0;
+            l->raw_eof = l->remaining == 0;
+            bytes_read += (u64)n;
+        }
+        size_t in_len = l->raw_len - l->raw_off;
+        u64 t = armGetSystemTick();
+        error = R_FAILED(compress_stream_run(&l->z, l->raw + l->raw_off, &in_len, slot->data, &out_len, e->slot_size, l->raw_eof));
+        *deflate_ns += armTicksToNs(armGetSystemTick() - t);
+        l->raw_off += (u32)in_len;
+        raw_used += (u32)in_len;
+    }
+    slot->len = (u32)out_len;
+    slot->raw_len = raw_used;
+    slot->error = error;
+    slot->eof = l->z.finished || error;
+    return bytes_read;
+}
+
+// 读线程：常驻，为所有通道顺序读盘（需要时顺带压缩）；没有通道需要数据时阻塞在 reader_cv 上
+static void upload_reader_main(void *arg) {
+    UploadEngine *e = (UploadEngine*)arg;
+    mutexLock(&e->lock);
+    while (!e->quit) {
+        UploadLane *l = reader_pick_lane(e);
+        if (!l) {
+            u64 wait_start = armGetSystemTick();
+            condvarWait(&e->reader_cv, &e->lock);
+            e->stats.reader_wait_ns += armTicksToNs(armGetSystemTick() - wait_start);
+            continue;
+        }
+        UploadSlot *slot = &l->slots[l->tail];
+        int level = e->compress_ctl.level;
+        l->reading = true;
+        mutexUnlock(&e->lock);
+
+        // 读盘与压缩时不持锁，curl 可以同时发送其他块
+        u64 busy_start = armGetSystemTick();
+        u64 deflate_ns = 0;
+        u64 bytes_read = e->compress ? lane_fill_compressed(e, l, slot, level, &deflate_ns) : lane_fill_raw(e, l, slot);
+        u64 busy_ns = armTicksToNs(armGetSystemTick() - busy_start);
+
+        mutexLock(&e->lock);
+        l->reading = false;
+        e->stats.bytes_read += bytes_read;
+        if (e->compress) {
+            e->stats.compress_in += slot->raw_len;
+            e->stats.compress_out += slot->len;
+            e->stats.compress_ns += deflate_ns;
+            compress_control_add_work(&e->compress_ctl, slot->len, busy_ns);
+            compress_control_update(&e->compress_ctl);
+        }
+        if (l->cancel) {
+            condvarWakeAll(&e->idle_cv);
+            continue;
+        }
+        l->tail = (l->tail + 1) % e->slot_count;
+        l->filled++;
+        l->read_done = slot->eof;
+        if (l->paused) {
+            // 该通道的传输因缺数据暂停了，叫醒 I/O 线程恢复它
+            mutexUnlock(&e->lock);
+            curl_multi_wakeup(e->multi);
+            mutexLock(&e->lock);
+        }
+    }
+    mutexUnlock(&e->lock);
+}
+
+// curl 读回调（在 I/O 线程中执行）：从通道的环中取数据拷入 curl 的发送缓冲。
+// curl 的读回调接口只提供目标缓冲，这一次拷贝无法省去。环空时不能阻塞（会拖住所有连接），
+// 返回 PAUSE 暂停本传输，等读线程推入新块后由 I/O 线程恢复
+static size_t upload_read_cb(char *dst, size_t size, size_t nitems, void *userdata) {
+    UploadLane *l = (UploadLane*)userdata;
+    UploadEngine *e = l->engine;
+    size_t want = size * nitems;
+    l->connecting = false;
+    if (l->sent_eof) return 0; // 通知 curl 本文件已发完
+    if (!l->current) {
+        mutexLock(&e->lock);
+        if (l->filled == 0) {
+            l->paused = true;
+            e->stats.sender_stalls++;
+            mutexUnlock(&e->lock);
+            return CURL_READFUNC_PAUSE;
+        }
+        l->current = &l->slots[l->head];
+        l->current_off = 0;
+        mutexUnlock(&e->lock);
+        if (l->current->error) return CURL_READFUNC_ABORT;
+    }
+
+    UploadSlot *slot = l->current;
+    size_t n = slot->len - l->current_off;
+    if (n > want) n = want;
+    if (e->throttle && !throttle_try_acquire(e->throttle, ThrottleKind_Net, n, NULL)) {
+        l->throttled = true;
+        return CURL_READFUNC_PAUSE;
+    }
+    memcpy(dst, slot->data + l->current_off, n);
+    l->current_off += (u32)n;
+
+    if (l->current_off == slot->len) {
+        // 交还后读线程可能立即复用这一块，需要的字段先取出
+        u32 raw_len = slot->raw_len;
+        mutexLock(&e->lock);
+        l->head = (l->head + 1) % e->slot_count;
+        l->filled--;
+        l->current = NULL;
+        l->sent_eof = slot->eof;
+        compress_control_add_sent(&e->compress_ctl, slot->len);
+        condvarWakeOne(&e->reader_cv);
+        mutexUnlock(&e->lock);
+        // 进度按原始字节计，与 progress_begin 的总量一致；重试时重发的部分不再计入
+        l->sent_raw += raw_len;
+        u64 pos = l->chunk_offset + l->sent_raw;
+        if (pos > l->reported) {
+            progress_add_bytes(pos - l->reported);
+            l->reported = pos;
+        }
+    }
+    e->stats.bytes_sent += n;
+    e->stats.lanes[l->index].bytes_sent += n;
+    metrics_add(Metric_UploadBytes, n);
+    return n;
+}
+
+// SIZE 查询时 curl 会把 Content-Length 等信息当作响应体输出，丢弃即可
+static size_t upload_discard_cb(char *ptr, size_t size, size_t nmemb, void *userdata) {
+    (void)ptr;
+    (void)userdata;
+    return size * nmemb;
+}
+
+// MLSD 输出收进通道的列表缓冲；超过上限时中止（该目录按未知处理）
+static size_t upload_list_cb(char *ptr, size_t size, size_t nmemb, void *userdata) {
+    UploadLane *l = (UploadLane*)userdata;
+    size_t n = size * nmemb;
+    l->connecting = false;
+    if (l->list_len + n > l->list_capacity) {
+        size_t cap = l->list_capacity ? l->list_capacity : 0x4000;
+        while (cap < l->list_len + n) cap *= 2;
+        if (cap > UPLOAD_LIST_MAX_BYTES) return 0;
+        char *list = realloc(l->list, cap);
+        if (!list) return 0;
+        l->list = list;
+        l->list_capacity = cap;
+    }
+    memcpy(l->list + l->list_len, ptr, n);
+    l->list_len += n;
+    return n;
+}
+
+#if UPLOAD_COUNT_COMMANDS
+// 统计发出的控制命令（curl 每发一条命令以 HEADER_OUT 报告一次）
+static int upload_debug_cb(CURL *curl, curl_infotype type, char *data, size_t size, void *userdata) {
+    (void)curl;
+    UploadLane *l = (UploadLane*)userdata;
+    if (type != CURLINFO_HEADER_OUT) return 0;
+    l->engine->stats.commands++;
+    if (size >= 4 && memcmp(data, "CWD ", 4) == 0) l->engine->stats.cwd++;
+    return 0;
+}
+#endif
+
+// 池里的块被别的任务占着时等它们归还（背压），不去堆上另要
+static u8 *upload_buffer_alloc(UploadEngine *e) {
+    if (e->buffers) return bufpool_acquire(e->buffers, UPLOAD_BUFFER_WAIT_NS);
+    return aligned_alloc(UPLOAD_BUFFER_ALIGN, e->slot_size);
+}
+
+static void upload_buffer_free(UploadEngine *e, u8 *data) {
+    if (e->buffers) bufpool_release(e->buffers, data);
+    else free(data);
+}
+
+// 按池中空闲块数收缩：每条连接至少两块（压缩时另加一块原始数据缓冲），先减块数，再减连接数
+static void upload_fit_buffers(UploadEngine *e) {
+    e->slot_size = e->buffers->block_size;
+    u32 avail = bufpool_available(e->buffers);
+    u32 extra = e->compress ? 1 : 0;
+    while (e->lane_count * (e->slot_count + extra) > avail) {
+        if (e->slot_count > 2) e->slot_count--;
+        else if (e->lane_count > 1) e->lane_count--;
+        else break;
+    }
+}
+
+static Result lane_init(UploadEngine *e, UploadLane *l, u32 index) {
+    l->engine = e;
+    l->index = index;
+    l->fd = -1;
+    l->cwd_used = e->pool_reused;
+    for (u32 i = 0; i < e->slot_count; ++i) {
+        l->slots[i].data = upload_buffer_alloc(e);
+        if (!l->slots[i].data) return MAKERESULT(Module_Libnx, LibnxError_OutOfMemory);
+    }
+    if (e->compress) {
+        l->raw = upload_buffer_alloc(e);
+        if (!l->raw) return MAKERESULT(Module_Libnx, LibnxError_OutOfMemory);
+        Result rc = compress_stream_init(&l->z, e->compress_ctl.level);
+        if (R_FAILED(rc)) return rc;
+    }
+    // 池里留下的句柄清掉上次的选项；连接在 multi 的连接缓存里，不受影响
+    if (l->curl) curl_easy_reset(l->curl);
+    else l->curl = curl_easy_init();
+    if (!l->curl) return MAKERESULT(Module_Libnx, LibnxError_OutOfMemory);
+    curl_easy_setopt(l->curl, CURLOPT_PRIVATE, l);
+    curl_easy_setopt(l->curl, CURLOPT_READFUNCTION, upload_read_cb);
+    curl_easy_setopt(l->curl, CURLOPT_READDATA, l);
+    curl_easy_setopt(l->curl, CURLOPT_WRITEFUNCTION, upload_discard_cb);
+    curl_easy_setopt(l->curl, CURLOPT_UPLOAD_BUFFERSIZE, (long)e->slot_size);
+    curl_easy_setopt(l->curl, CURLOPT_USERPWD, e->userpwd);
+    curl_easy_setopt(l->curl, CURLOPT_FTP_CREATE_MISSING_DIRS, (long)CURLFTP_CREATE_DIR_RETRY);
+    curl_easy_setopt(l->curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(l->curl, CURLOPT_CONNECTTIMEOUT, 10L);
+    curl_easy_setopt(l->curl, CURLOPT_LOW_SPEED_LIMIT, 1L);   // 30 秒内没有任何进展视为断线
+    curl_easy_setopt(l->curl, CURLOPT_LOW_SPEED_TIME, 30L);
+    // 控制连接在两次备份之间闲置，靠 TCP keepalive 维持路由器上的连接状态
+    curl_easy_setopt(l->curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(l->curl, CURLOPT_TCP_KEEPIDLE, (long)UPLOAD_KEEPALIVE_IDLE_S);
+    curl_easy_setopt(l->curl, CURLOPT_TCP_KEEPINTVL, (long)UPLOAD_KEEPALIVE_INTERVAL_S);
+#if UPLOAD_COUNT_COMMANDS
+    curl_easy_setopt(l->curl, CURLOPT_DEBUGFUNCTION, upload_debug_cb);
+    curl_easy_setopt(l->curl, CURLOPT_DEBUGDATA, l);
+    curl_easy_setopt(l->curl, CURLOPT_VERBOSE, 1L);
+#endif
+    return 0;
+}
+
+void upload_pool_release(UploadPool *pool) {
+    for (u32 i = 0; i < UPLOAD_MAX_CONNECTIONS; ++i) {
+        if (pool->handles[i]) curl_easy_cleanup(pool->handles[i]);
+    }
+    if (pool->multi) curl_multi_cleanup(pool->multi);
+    memset(pool, 0, sizeof(*pool));
+}
+
+// 地址或账号变了、闲置太久的连接不再复用；能复用时把 multi 与句柄接过来
+static void upload_pool_take(UploadEngine *e, UploadPool *pool) {
+    FastHash h;
+    fasthash_init(&h);
+    fasthash_update(&h, e->base_url, strlen(e->base_url) + 1);
+    fasthash_update(&h, e->userpwd, strlen(e->userpwd) + 1);
+    u64 key = fasthash_final(&h);
+    if (pool->multi && (pool->key != key || armTicksToNs(armGetSystemTick() - pool->last_used) > UPLOAD_POOL_IDLE_NS)) {
+        upload_pool_release(pool);
+    }
+    pool->key = key;
+    if (!pool->multi) return;
+    e->multi = pool->multi;
+    pool->multi = NULL;
+    for (u32 i = 0; i < UPLOAD_MAX_CONNECTIONS; ++i) {
+        e->lanes[i].curl = pool->handles[i];
+        pool->handles[i] = NULL;
+    }
+    pool->reused++;
+    e->pool_reused = true;
+}
+
+Result upload_engine_init(UploadEngine *e, const UploadOptions *opt) {
+    memset(e, 0, sizeof(*e));
+    if (!opt->url || !opt->url[0] || opt->buffer_count < 2 || opt->buffer_count > UPLOAD_MAX_BUFFERS || opt->buffer_size == 0 ||
+        opt->connections < 1 || opt->connections > UPLOAD_MAX_CONNECTIONS)
+        return MAKERESULT(Module_Libnx, LibnxError_BadInput);
+
+    snprintf(e->local_root, sizeof(e->local_root), "%s", opt->local_root ? opt->local_root : "");
+    snprintf(e->base_url, sizeof(e->base_url), "%s", opt->url);
+    size_t len = strlen(e->base_url);
+    while (len > 0 && e->base_url[len - 1] == '/') e->base_url[--len] = '\0';
+    snprintf(e->userpwd, sizeof(e->userpwd), "%s:%s", opt->user ? opt->user : "anonymous", opt->password ? opt->password : "");
+
+    e->lane_count = opt->connections;
+    e->slot_count = opt->buffer_count;
+    e->slot_size = (opt->buffer_size + UPLOAD_BUFFER_ALIGN - 1) & ~(UPLOAD_BUFFER_ALIGN - 1);
+    e->compress = opt->compress;
+    e->chunk_size = opt->chunk_size;
+    e->crc_chunk = opt->chunk_size && opt->chunk_size <= UINT32_MAX ? (u32)opt->chunk_size : UPLOAD_CRC_CHUNK_DEFAULT;
+    e->journal = opt->journal;
+    e->throttle = opt->throttle;
+    e->remote_enabled = opt->remote_cache;
+    compress_control_init(&e->compress_ctl, opt->compress_level);
+    e->buffers = opt->buffers;
+    if (e->buffers) upload_fit_buffers(e);
+
+    e->pool = opt->pool;
+    if (e->pool) upload_pool_take(e, e->pool);
+    if (!e->multi) e->multi = curl_multi_init();
+    if (!e->multi) return MAKERESULT(Module_Libnx, LibnxError_OutOfMemory);
+    curl_multi_setopt(e->multi, CURLMOPT_MAX_HOST_CONNECTIONS, (long)e->lane_count);
+    curl_multi_setopt(e->multi, CURLMOPT_MAXCONNECTS, (long)e->lane_count);
+
+    Result rc = 0;
+    for (u32 i = 0; i < e->lane_count && R_SUCCEEDED(rc); ++i) rc = lane_init(e, &e->lanes[i], i);
+    if (R_SUCCEEDED(rc)) rc = app_thread_start(&e->reader, ThreadRole_Reader, NULL, upload_reader_main, e);
+    if (R_FAILED(rc)) {
+        upload_engine_exit(e);
+        return rc;
+    }
+    e->reader_started = true;
+    return 0;
+}
+
+void upload_engine_exit(UploadEngine *e) {
+    if (e->reader_started) {
+        mutexLock(&e->lock);
+        e->quit = true;
+        condvarWakeAll(&e->reader_cv);
+        mutexUnlock(&e->lock);
+        app_thread_join(&e->reader);
+        e->reader_started = false;
+    }
+    // 有池时连接与句柄留给下一次备份
+    if (e->pool && e->multi) {
+        e->pool->multi = e->multi;
+        e->pool->last_used = armGetSystemTick();
+        e->multi = NULL;
+    }
+    for (u32 i = 0; i < UPLOAD_MAX_CONNECTIONS; ++i) {
+        UploadLane *l = &e->lanes[i];
+        if (l->curl && e->pool) {
+            curl_easy_setopt(l->curl, CURLOPT_QUOTE, NULL);
+            e->pool->handles[i] = l->curl;
+            l->curl = NULL;
+        } else if (l->curl) {
+            curl_easy_cleanup(l->curl);
+            l->curl = NULL;
+        }
+        curl_slist_free_all(l->quote);
+        l->quote = NULL;
+        free(l->list);
+        l->list = NULL;
+        l->list_len = l->list_capacity = 0;
+        for (u32 j = 0; j < UPLOAD_MAX_BUFFERS; ++j) {
+            upload_buffer_free(e, l->slots[j].data);
+            l->slots[j].data = NULL;
+        }
+        compress_stream_exit(&l->z);
+        upload_buffer_free(e, l->raw);
+        l->raw = NULL;
+        free(l->crcs);
+        l->crcs = NULL;
+        l->crc_capacity = 0;
+    }
+    free(e->crcs);
+    e->crcs = NULL;
+    e->crc_count = e->crc_capacity = 0;
+    remote_cache_free(&e->remote);
+    if (e->multi) {
+        curl_multi_cleanup(e->multi);
+        e->multi = NULL;
+    }
+}
+
+// base_url + 逐段转义后的 remote_path + suffix
+static bool upload_build_url(UploadEngine *e, CURL *curl, const char *remote_path, const char *suffix, char *out, size_t out_size) {
+    size_t pos = (size_t)snprintf(out, out_size, "%s", e->base_url);
+    const char *p = remote_path;
+    while (*p) {
+        while (*p == '/') ++p;
+        const char *end = strchr(p, '/');
+        int seg_len = end ? (int)(end - p) : (int)strlen(p);
+        if (seg_len == 0) break;
+        char *seg = curl_easy_escape(curl, p, seg_len);
+        if (!seg) return false;
+        int n = snprintf(out + pos, out_size - pos, "/%s", seg);
+        curl_free(seg);
+        if (n < 0 || pos + (size_t)n >= out_size) return false;
+        pos += (size_t)n;
+        p += seg_len;
+    }
+    int n = snprintf(out + pos, out_size - pos, "%s", suffix);
+    return n >= 0 && pos + (size_t)n < out_size;
+}
+
+// SIZE 查询远端已有的长度（curl 的 NOBODY 请求），结果在 lane_done 中处理
+// 估计不用缓存时（逐级 CWD）这次传输要发的 CWD：与这条连接上一次传输同目录时不需要，
+// 否则复用的连接先回到登录目录，再从远端根目录逐级进入
+static void lane_estimate_cwd(UploadEngine *e, UploadLane *l) {
+    if (!e->remote_active) return;
+    const char *path = l->job->path;
+    const char *slash = strrchr(path, '/');
+    size_t len = slash ? (size_t)(slash - path) : 0;
+    u64 dir = fasthash(path, len);
+    if (l->cwd_used && dir == l->cwd_dir) return;
+    u32 depth = e->base_depth + (len ? 1 : 0);
+    for (size_t i = 0; i < len; ++i) depth += path[i] == '/';
+    e->stats.cwd_estimate += depth + (l->cwd_used ? 1 : 0);
+    l->cwd_dir = dir;
+    l->cwd_used = true;
+}
+
+static void lane_begin_probe(UploadEngine *e, UploadLane *l) {
+    lane_estimate_cwd(e, l);
+    l->step = LaneStep_Probe;
+    curl_easy_setopt(l->curl, CURLOPT_UPLOAD, 0L);
+    curl_easy_setopt(l->curl, CURLOPT_NOBODY, 1L);
+    curl_easy_setopt(l->curl, CURLOPT_APPEND, 0L);
+    curl_multi_add_handle(e->multi, l->curl);
+}
+
+// 从 offset 开始上传下一块；rewind 为真时从文件头重新读（前 offset 字节只算哈希），
+// 否则读线程接着上一块的位置读。调用时读线程不在读这条通道
+static void lane_begin_chunk(UploadEngine *e, UploadLane *l, u64 offset, bool rewind) {
+    u64 len = l->file_size - offset;
+    if (!e->compress && e->chunk_size && len > e->chunk_size) len = e->chunk_size;
+    if (rewind && l->job->pack) pack_archive_rewind(l->job->pack);
+    else if (rewind && l->job->data) l->data_off = 0;
+    else if (rewind) lseek(l->fd, 0, SEEK_SET);
+
+    mutexLock(&e->lock);
+    lane_reset_ring(l);
+    l->chunk_offset = offset;
+    l->chunk_len = len;
+    l->sent_raw = 0;
+    l->remaining = len;
+    l->read_done = false;
+    l->cancel = false;
+    if (rewind) {
+        lane_digest_reset(l);
+        l->skip = offset;
+        if (e->compress) {
+            l->raw_len = l->raw_off = 0;
+            l->raw_eof = false;
+            compress_stream_reset(&l->z, e->compress_ctl.level);
+        }
+    }
+    condvarWakeOne(&e->reader_cv);
+    mutexUnlock(&e->lock);
+
+    // 已在远端的部分直接计入进度
+    if (offset > l->reported) {
+        progress_add_bytes(offset - l->reported);
+        l->reported = offset;
+    }
+    lane_estimate_cwd(e, l);
+    l->step = LaneStep_Chunk;
+    e->stats.chunks++;
+    curl_easy_setopt(l->curl, CURLOPT_NOBODY, 0L);
+    curl_easy_setopt(l->curl, CURLOPT_UPLOAD, 1L);
+    curl_easy_setopt(l->curl, CURLOPT_APPEND, offset > 0 ? 1L : 0L);
+    // 压缩后的大小事先未知
+    curl_easy_setopt(l->curl, CURLOPT_INFILESIZE_LARGE, e->compress ? (curl_off_t)-1 : (curl_off_t)len);
+    l->connecting = true;
+    curl_multi_add_handle(e->multi, l->curl);
+}
+
+static void lane_journal(UploadEngine *e, UploadLane *l, u64 offset, u64 content_hash) {
+    if (!e->journal || e->compress) return;
+    JournalRecord rec = { l->path_hash, offset, l->file_size, l->job->mtime, content_hash };
+    journal_append(e->journal, &rec);
+}
+
+// 文件读完且全部确认后收下摘要；各块 CRC 追加到引擎的 crcs，内存不足时这个文件不记摘要
+static void lane_finish_digest(UploadEngine *e, UploadLane *l, UploadJob *job) {
+    if (l->digest_off % e->crc_chunk != 0 && l->crc_count < l->crc_capacity) l->crcs[l->crc_count++] = l->crc;
+    if (l->digest_off != l->file_size || l->crc_count != (l->file_size + e->crc_chunk - 1) / e->crc_chunk) {
+        return; // lane_start 时没能分配 CRC 缓冲
+    }
+    sha256_final(&l->sha, job->sha256);
+    if (e->crc_count + l->crc_count > e->crc_capacity) {
+        u32 cap = e->crc_capacity ? e->crc_capacity * 2 : 1024;
+        while (cap < e->crc_count + l->crc_count) cap *= 2;
+        u32 *crcs = realloc(e->crcs, (size_t)cap * sizeof(u32));
+        if (!crcs) {
+            log_warning("内存不足，不记录 %s 的校验摘要", job->path);
+            return;
+        }
+        e->crcs = crcs;
+        e->crc_capacity = cap;
+    }
+    memcpy(e->crcs + e->crc_count, l->crcs, (size_t)l->crc_count * sizeof(u32));
+    job->crc_index = e->crc_count;
+    job->crc_count = l->crc_count;
+    job->crc_chunk = e->crc_chunk;
+    e->crc_count += l->crc_count;
+}
+
+// 文件结束（成功或放弃）：关闭文件、释放通道
+static void lane_close_job(UploadEngine *e, UploadLane *l, bool ok) {
+    UploadJob *job = l->job;
+    if (l->fd >= 0) close(l->fd);
+    l->fd = -1;
+    UploadLaneStats *ls = &e->stats.lanes[l->index];
+    ls->busy_ns += armTicksToNs(armGetSystemTick() - l->start_tick);
+    if (ok) {
+        e->stats.files_ok++;
+        metrics_inc(Metric_UploadFiles);
+        ls->files++;
+        job->content_hash = fasthash_final(&l->hash);
+        lane_journal(e, l, l->file_size, job->content_hash);
+        lane_finish_digest(e, l, job);
+        if (l->file_size > l->reported) progress_add_bytes(l->file_size - l->reported);
+        progress_file_done();
+    } else {
+        e->stats.files_failed++;
+        metrics_inc(Metric_UploadFailedFiles);
+    }
+    mutexLock(&e->lock);
+    l->job = NULL;
+    mutexUnlock(&e->lock);
+}
+
+// 按远端已有的长度（-1 = 没有这个文件）续传。断线时最后一块可能已部分写入远端；
+// 那部分也是按顺序发出的文件内容，可以直接接上。远端比已确认的还短（被改动过）或比本地长时从头重传
+static void lane_resume_at(UploadEngine *e, UploadLane *l, s64 remote) {
+    u64 offset = remote >= 0 && (u64)remote >= l->resume_hint && (u64)remote <= l->file_size ? (u64)remote : 0;
+    if (l->journal_resume) e->stats.resumed_bytes += offset; // 只统计跨次续传（SIZE 重试过也算）
+    l->journal_resume = false;
+    lane_begin_chunk(e, l, offset, true);
+}
+
+// 远端目录缓存能回答（列出了这个文件，或确定没有它）时不必发 SIZE
+static bool lane_resume_cached(UploadEngine *e, UploadLane *l) {
+    if (!e->remote_active) return false;
+    const char *path = l->job->path;
+    size_t len = strlen(path);
+    const RemoteEntry *r = remote_cache_find(&e->remote, path, len);
+    s64 remote;
+    if (r && r->type == RemoteEntry_File) remote = (s64)r->size;
+    else if (remote_cache_missing(&e->remote, path, len)) remote = -1;
+    else return false;
+    e->stats.probes_saved++;
+    lane_resume_at(e, l, remote);
+    return true;
+}
+
+// NOCWD 方式下 curl 不会自动建目录：把缓存里不能确定存在的各级目录按先父后子排进传输前的 QUOTE。
+// * 前缀表示失败可忽略（别的连接可能刚建好同一个目录）
+static void lane_quote_dirs(UploadEngine *e, UploadLane *l) {
+    curl_slist_free_all(l->quote);
+    l->quote = NULL;
+    const char *path = l->job->path;
+    char cmd[sizeof(e->mkd_prefix) + sizeof(l->local_path)];
+    for (const char *p = strchr(path, '/'); p; p = strchr(p + 1, '/')) {
+        size_t len = (size_t)(p - path);
+        if (remote_cache_exists(&e->remote, path, len)) continue;
+        int n = snprintf(cmd, sizeof(cmd), "*MKD %s%.*s", e->mkd_prefix, (int)len, path);
+        if (n < 0 || (size_t)n >= sizeof(cmd)) continue;
+        struct curl_slist *q = curl_slist_append(l->quote, cmd);
+        if (!q) break;
+        l->quote = q;
+        e->stats.mkd++;
+    }
+    curl_easy_setopt(l->curl, CURLOPT_QUOTE, l->quote);
+}
+
+// 文件的第一次传输成功后它的各级目录都已存在
+static void lane_quote_done(UploadEngine *e, UploadLane *l) {
+    if (!l->quote) return;
+    curl_easy_setopt(l->curl, CURLOPT_QUOTE, NULL);
+    curl_slist_free_all(l->quote);
+    l->quote = NULL;
+    const char *path = l->job->path;
+    for (const char *p = strchr(path, '/'); p; p = strchr(p + 1, '/')) {
+        remote_cache_put(&e->remote, path, (size_t)(p - path), RemoteEntry_Dir, 0, false);
+    }
+}
+
+// 在通道上开始一个文件；返回 false 表示没有占用通道（打不开记为失败，或续传日志表明已传完），调用方取下一个
+static bool lane_start(UploadEngine *e, UploadLane *l, UploadJob *job) {
+    job->rc = 0;
+    struct stat st;
+    int n = snprintf(l->local_path, sizeof(l->local_path), "%s/%s", e->local_root, job->path);
+    if (n < 0 || (size_t)n >= sizeof(l->local_path) || !upload_build_url(e, l->curl, job->path, e->compress ? COMPRESS_SUFFIX : "", l->url, sizeof(l->url))) {
+        job->rc = MAKERESULT(Module_Libnx, LibnxError_BadInput);
+    } else if (job->pack) {
+        st.st_size = (off_t)job->pack->size; // 归档没有本地文件
+    } else if (job->data) {
+        st.st_size = (off_t)job->size;
+    } else if ((l->fd = open(l->local_path, O_RDONLY)) < 0) {
+        job->rc = MAKERESULT(Module_Libnx, LibnxError_NotFound);
+    } else if (fstat(l->fd, &st) != 0) {
+        close(l->fd);
+        l->fd = -1;
+        job->rc = MAKERESULT(Module_Libnx, LibnxError_IoError);
+    }
+    if (R_FAILED(job->rc)) {
+        e->stats.files_failed++;
+        metrics_inc(Metric_UploadFailedFiles);
+        log_error("无法读取 %s: 0x%x", job->path, job->rc);
+        return false;
+    }
+
+    // 读线程在 lane_begin_chunk 清除 cancel 之前不会碰这条通道
+    mutexLock(&e->lock);
+    l->cancel = true;
+    l->job = job;
+    mutexUnlock(&e->lock);
+    l->path_hash = fasthash_str(job->path);
+    l->file_size = (u64)st.st_size;
+    // 块数上限按打开时的大小定；读线程只读这么多
+    u64 blocks = (l->file_size + e->crc_chunk - 1) / e->crc_chunk;
+    if (blocks > l->crc_capacity) {
+        u32 *crcs = realloc(l->crcs, (size_t)blocks * sizeof(u32));
+        if (crcs) {
+            l->crcs = crcs;
+            l->crc_capacity = (u32)blocks;
+        }
+    }
+    l->reported = 0;
+    l->retries = 0;
+    l->journal_resume = false;
+    l->start_tick = armGetSystemTick();
+    curl_easy_setopt(l->curl, CURLOPT_URL, l->url);
+    if (e->remote_active) lane_quote_dirs(e, l);
+
+    const JournalRecord *rec = e->journal && !e->compress ? journal_find(e->journal, l->path_hash) : NULL;
+    if (rec && rec->size == l->file_size && rec->mtime == job->mtime && rec->offset > 0) {
+        e->stats.resumed_files++;
+        if (rec->offset == l->file_size && rec->content_hash) {
+            // 上次已传完，只是没来得及写入清单
+            e->stats.resumed_bytes += l->file_size;
+            e->stats.files_ok++;
+            metrics_inc(Metric_UploadFiles);
+            job->content_hash = rec->content_hash;
+            if (l->fd >= 0) close(l->fd);
+            l->fd = -1;
+            mutexLock(&e->lock);
+            l->job = NULL;
+            mutexUnlock(&e->lock);
+            progress_add_bytes(l->file_size);
+            progress_file_done();
+            return false;
+        }
+        l->resume_hint = rec->offset;
+        l->journal_resume = true;
+        if (!lane_resume_cached(e, l)) lane_begin_probe(e, l);
+        return true;
+    }
+    lane_begin_chunk(e, l, 0, true);
+    return true;
+}
+
+// 从队列中取下一个需要上传的文件
+static bool lane_start_next(UploadEngine *e, UploadLane *l, UploadJob **order, u32 count, u32 *next) {
+    while (*next < count) {
+        if (lane_start(e, l, order[(*next)++])) return true;
+    }
+    return false;
+}
+
+// SIZE 明确答复文件不存在（550）才算远端没有这个文件；其余失败都是没问到，走重试
+static bool probe_file_missing(UploadLane *l, CURLcode cc) {
+    if (cc == CURLE_REMOTE_FILE_NOT_FOUND) return true;
+    long code = 0;
+    return curl_easy_getinfo(l->curl, CURLINFO_RESPONSE_CODE, &code) == CURLE_OK && code == 550;
+}
+
+// 一次 curl 传输结束，推进该通道的文件：下一块、续传或结束。返回 true 表示通道仍被占用
+static bool lane_done(UploadEngine *e, UploadLane *l, CURLcode cc) {
+    curl_multi_remove_handle(e->multi, l->curl);
+    l->connecting = false;
+
+    // 让读线程放弃剩余数据（失败时）；它若正在读这条通道，等它读完这一块
+    mutexLock(&e->lock);
+    l->cancel = true;
+    while (l->reading) condvarWait(&e->idle_cv, &e->lock);
+    lane_reset_ring(l);
+    mutexUnlock(&e->lock);
+
+    UploadJob *job = l->job;
+    if (l->step == LaneStep_Probe && (cc == CURLE_OK || probe_file_missing(l, cc))) {
+        curl_off_t remote = -1;
+        if (cc == CURLE_OK) curl_easy_getinfo(l->curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &remote);
+        lane_resume_at(e, l, (s64)remote);
+        return true;
+    }
+    if (cc == CURLE_OK) {
+        lane_quote_done(e, l);
+        u64 acked = l->chunk_offset + l->chunk_len;
+        if (acked < l->file_size) {
+            lane_journal(e, l, acked, 0);
+            lane_begin_chunk(e, l, acked, false);
+            return true;
+        }
+        lane_close_job(e, l, true);
+        return false;
+    }
+    if (l->retries < UPLOAD_MAX_RETRIES) {
+        l->retries++;
+        e->stats.retries++;
+        metrics_inc(Metric_UploadRetries);
+        log_warning("上传中断 %s（%s），第 %u 次重试", job->path, curl_easy_strerror(cc), l->retries);
+        if (l->step == LaneStep_Probe) {
+            // SIZE 本身没问到（断线、超时、登录失败）：保留续传日志给的偏移，重新查询
+            lane_begin_probe(e, l);
+        } else if (e->compress || l->chunk_offset == 0) {
+            // 第一块失败时 STOR 可能还没截断远端文件，SIZE 量到的会是上次备份留下的旧副本，
+            // 只能从头重传；偏移大于 0 时此前的字节已在本次确认过（块已应答或续传日志经 SIZE 核对）
+            lane_begin_chunk(e, l, 0, true);
+        } else {
+            l->resume_hint = l->chunk_offset;
+            lane_begin_probe(e, l);
+        }
+        return true;
+    }
+    job->rc = MAKERESULT(Module_Libnx, LibnxError_IoError);
+    log_error("上传失败 %s: %s", job->path, curl_easy_strerror(cc));
+    lane_close_job(e, l, false);
+    return false;
+}
+
+// 远端根目录之下的一个目录（相对路径，根目录为空串）
+typedef struct {
+    const char *path;
+    u32 len;
+    u32 depth;
+} UploadDir;
+
+static int dir_cmp(const void *a, const void *b) {
+    const UploadDir *x = a, *y = b;
+    if (x->depth != y->depth) return x->depth < y->depth ? -1 : 1;
+    u32 n = x->len < y->len ? x->len : y->len;
+    int c = memcmp(x->path, y->path, n);
+    if (c) return c;
+    return x->len < y->len ? -1 : x->len > y->len ? 1 : 0;
+}
+
+// MKD 要用登录目录下的完整路径：NOCWD 方式下 QUOTE 在回到登录目录之前执行，连接可能还停在别处
+static void upload_set_mkd_prefix(UploadEngine *e, CURL *curl) {
+    const char *p = strstr(e->base_url, "://");
+    p = p ? strchr(p + 3, '/') : NULL;
+    char *base = p && p[1] ? curl_easy_unescape(curl, p + 1, 0, NULL) : NULL;
+    const char *entry = NULL;
+    curl_easy_getinfo(curl, CURLINFO_FTP_ENTRY_PATH, &entry);
+    const char *b = base ? base : "";
+    // URL 里的路径相对登录目录，以 %2F 开头的才是绝对路径
+    if (b[0] == '/' || !entry) {
+        snprintf(e->mkd_prefix, sizeof(e->mkd_prefix), "%s%s", b, b[0] ? "/" : "");
+    } else {
+        size_t n = strlen(entry);
+        snprintf(e->mkd_prefix, sizeof(e->mkd_prefix), "%s%s%s%s", entry, n && entry[n - 1] == '/' ? "" : "/", b, b[0] ? "/" : "");
+    }
+    e->base_depth = 0;
+    for (const char *q = b; *q; ++q) {
+        if (*q != '/' && (q == b || q[-1] == '/')) e->base_depth++;
+    }
+    curl_free(base);
+}
+
+// curl_multi_poll 的超时：被动模式下 curl 收到 EPSV 应答后，数据连接要到下一次 curl_multi_perform 才真正发起，
+// 而此时它只登记了空闲的控制连接和很长的超时，poll 会白等满超时（多连接传小文件时每秒只传十几个）。
+// 有通道还没开始收发数据（connecting）时改用 UPLOAD_CONNECT_POLL_MS
+static u64 upload_poll_ms(const UploadEngine *e, u64 poll_ms) {
+    for (u32 i = 0; i < e->lane_count; ++i) {
+        if (e->lanes[i].connecting && poll_ms > UPLOAD_CONNECT_POLL_MS) poll_ms = UPLOAD_CONNECT_POLL_MS;
+    }
+    return poll_ms;
+}
+
+// 只列出已知存在的目录：根目录总是列，其他目录要在父目录的列表里出现过
+static bool upload_dir_listable(UploadEngine *e, const UploadDir *d) {
+    if (d->len == 0) return true;
+    const RemoteEntry *r = remote_cache_find(&e->remote, d->path, d->len);
+    return r && r->type == RemoteEntry_Dir;
+}
+
+static bool lane_begin_list(UploadEngine *e, UploadLane *l, const UploadDir *d) {
+    int n = snprintf(l->local_path, sizeof(l->local_path), "%.*s", (int)d->len, d->path);
+    if (n < 0 || (size_t)n >= sizeof(l->local_path) || !upload_build_url(e, l->curl, l->local_path, "/", l->url, sizeof(l->url))) {
+        return false;
+    }
+    l->list_len = 0;
+    curl_easy_setopt(l->curl, CURLOPT_URL, l->url);
+    l->connecting = true;
+    curl_multi_add_handle(e->multi, l->curl);
+    return true;
+}
+
+// 在各条连接上并行列出同一层的目录，全部结束才返回
+static void upload_list_level(UploadEngine *e, const UploadDir *dirs, u32 count) {
+    u32 next = 0, active = 0;
+    for (u32 i = 0; i < e->lane_count; ++i) {
+        while (next < count) {
+            const UploadDir *d = &dirs[next++];
+            if (upload_dir_listable(e, d) && lane_begin_list(e, &e->lanes[i], d)) {
+                ++active;
+                break;
+            }
+        }
+    }
+    while (active > 0) {
+        int running = 0;
+        curl_multi_perform(e->multi, &running);
+        CURLMsg *msg;
+        int queued;
+        while ((msg = curl_multi_info_read(e->multi, &queued)) != NULL) {
+            if (msg->msg != CURLMSG_DONE) continue;
+            UploadLane *l = NULL;
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char**)&l);
+            curl_multi_remove_handle(e->multi, l->curl);
+            l->connecting = false;
+            --active;
+            if (msg->data.result == CURLE_OK) {
+                remote_cache_parse_mlsd(&e->remote, l->local_path, l->list, l->list_len);
+                e->stats.dirs_listed++;
+            }
+            // 列不出来的目录（权限、输出过长）按未知处理：其下的目录照样 MKD，续传照样 SIZE
+            while (next < count) {
+                const UploadDir *d = &dirs[next++];
+                if (upload_dir_listable(e, d) && lane_begin_list(e, l, d)) {
+                    ++active;
+                    break;
+                }
+            }
+        }
+        if (active > 0) curl_multi_poll(e->multi, NULL, 0, (int)upload_poll_ms(e, UPLOAD_POLL_TIMEOUT_MS), NULL);
+    }
+}
+
+// 列出待传文件涉及的各级远端目录（按层进行，不存在的目录不列）。根目录列不出来时
+// （服务器不支持 MLSD，或远端根目录还不存在）返回 false，本次按原来的逐级 CWD 方式上传
+static bool upload_list_remote(UploadEngine *e, UploadJob **order, u32 count) {
+    remote_cache_free(&e->remote);
+    size_t total = 1;
+    for (u32 i = 0; i < count; ++i) {
+        for (const char *p = strchr(order[i]->path, '/'); p; p = strchr(p + 1, '/')) ++total;
+    }
+    UploadDir *dirs = malloc(total * sizeof(UploadDir));
+    if (!dirs) return false;
+    u32 n = 0;
+    dirs[n++] = (UploadDir){ "", 0, 0 };
+    for (u32 i = 0; i < count; ++i) {
+        const char *path = order[i]->path;
+        u32 depth = 0;
+        for (const char *p = strchr(path, '/'); p; p = strchr(p + 1, '/')) {
+            dirs[n++] = (UploadDir){ path, (u32)(p - path), ++depth };
+        }
+    }
+    qsort(dirs, n, sizeof(UploadDir), dir_cmp);
+    u32 unique = 0;
+    for (u32 i = 0; i < n; ++i) {
+        if (unique && dir_cmp(&dirs[unique - 1], &dirs[i]) == 0) continue;
+        dirs[unique++] = dirs[i];
+    }
+
+    u64 commands = e->stats.commands;
+    for (u32 i = 0; i < e->lane_count; ++i) {
+        CURL *curl = e->lanes[i].curl;
+        curl_easy_setopt(curl, CURLOPT_FTP_FILEMETHOD, (long)CURLFTPMETHOD_NOCWD);
+        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "MLSD");
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, upload_list_cb);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &e->lanes[i]);
+    }
+    bool ok = true;
+    for (u32 begin = 0; begin < unique && ok;) {
+        u32 end = begin;
+        while (end < unique && dirs[end].depth == dirs[begin].depth) ++end;
+        upload_list_level(e, dirs + begin, end - begin);
+        // 根目录一层只有它自己
+        if (begin == 0) {
+            const RemoteEntry *root = remote_cache_find(&e->remote, "", 0);
+            ok = root && root->listed;
+        }
+        begin = end;
+    }
+    free(dirs);
+    e->stats.list_commands = (u32)(e->stats.commands - commands);
+
+    for (u32 i = 0; i < e->lane_count; ++i) {
+        CURL *curl = e->lanes[i].curl;
+        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, NULL);
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, upload_discard_cb);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, NULL);
+        if (ok) {
+            curl_easy_setopt(curl, CURLOPT_FTP_CREATE_MISSING_DIRS, (long)CURLFTP_CREATE_DIR_NONE);
+        } else {
+            curl_easy_setopt(curl, CURLOPT_FTP_FILEMETHOD, (long)CURLFTPMETHOD_MULTICWD);
+        }
+    }
+    if (ok) upload_set_mkd_prefix(e, e->lanes[0].curl);
+    else remote_cache_free(&e->remote);
+    return ok;
+}
+
+static int job_size_desc(const void *a, const void *b) {
+    u64 x = (*(UploadJob* const*)a)->size;
+    u64 y = (*(UploadJob* const*)b)->size;
+    return x < y ? 1 : x > y ? -1 : 0;
+}
+
+Result upload_run(UploadEngine *e, UploadJob *jobs, u32 count) {
+    mutexLock(&e->lock);
+    memset(&e->stats, 0, sizeof(e->stats));
+    e->stats.connections = e->lane_count;
+    mutexUnlock(&e->lock);
+    e->crc_count = 0;
+    if (count == 0) return 0;
+    UploadJob **order = malloc(count * sizeof(UploadJob*));
+    if (!order) return MAKERESULT(Module_Libnx, LibnxError_OutOfMemory);
+    for (u32 i = 0; i < count; ++i) order[i] = &jobs[i];
+    qsort(order, count, sizeof(UploadJob*), job_size_desc);
+
+    u64 start = armGetSystemTick();
+    e->stats.pool_reused = e->pool_reused;
+    e->remote_active = e->remote_enabled && upload_list_remote(e, order, count);
+    e->stats.remote_cache = e->remote_active;
+    if (e->remote_enabled && !e->remote_active) log_info("远端根目录列不出来（服务器不支持 MLSD，或目录尚未建立），本次逐级 CWD 上传");
+    u32 next = 0;
+    u32 active = 0;
+    for (u32 i = 0; i < e->lane_count; ++i) {
+        if (lane_start_next(e, &e->lanes[i], order, count, &next)) ++active;
+    }
+
+    while (active > 0) {
+        int running = 0;
+        curl_multi_perform(e->multi, &running);
+
+        CURLMsg *msg;
+        int queued;
+        while ((msg = curl_multi_info_read(e->multi, &queued)) != NULL) {
+            if (msg->msg != CURLMSG_DONE) continue;
+            UploadLane *l = NULL;
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char**)&l);
+            if (lane_done(e, l, msg->data.result)) continue;
+            --active;
+            if (lane_start_next(e, l, order, count, &next)) ++active;
+        }
+
+        // 恢复因缺数据而暂停、现在环中已有数据的传输（恢复时 curl 会立即调用读回调，不能持锁）
+        for (u32 i = 0; i < e->lane_count; ++i) {
+            UploadLane *l = &e->lanes[i];
+            mutexLock(&e->lock);
+            bool resume = l->job && l->paused && l->filled > 0;
+            if (resume) l->paused = false;
+            mutexUnlock(&e->lock);
+            if (resume) curl_easy_pause(l->curl, CURLPAUSE_CONT);
+        }
+        // 因限速暂停的传输在令牌补足后恢复；等待时缩短 poll 超时，恢复延迟不超过预计等待时间
+        u64 poll_ms = UPLOAD_POLL_TIMEOUT_MS;
+        for (u32 i = 0; i < e->lane_count; ++i) {
+            UploadLane *l = &e->lanes[i];
+            if (!l->job || !l->throttled) continue;
+            u64 wait_ns = 0;
+            if (throttle_ready(e->throttle, ThrottleKind_Net, &wait_ns)) {
+                l->throttled = false;
+                curl_easy_pause(l->curl, CURLPAUSE_CONT);
+            } else if (wait_ns / 1000000 + 1 < poll_ms) {
+                poll_ms = wait_ns / 1000000 + 1;
+            }
+        }
+
+        if (active > 0) curl_multi_poll(e->multi, NULL, 0, (int)upload_poll_ms(e, poll_ms), NULL);
+    }
+    e->stats.elapsed_ns = armTicksToNs(armGetSystemTick() - start);
+    free(order);
+    mutexLock(&e->lock);
+    e->stats.compress_level = e->compress ? e->compress_ctl.level : 0;
+    e->stats.compress_level_changes = e->compress_ctl.changes;
+    mutexUnlock(&e->lock);
+
+    Result rc = 0;
+    for (u32 i = 0; i < count; ++i) {
+        if (R_FAILED(jobs[i].rc)) rc = jobs[i].rc;
+    }
+    return rc;
+}
+
+const u32 *upload_job_crcs(const UploadEngine *e, const UploadJob *job) {
+    if (!job->crc_chunk) return NULL;
+    return e->crcs + job->crc_index;
+}
@@ -0,0 +1,243 @@
+#pragma once
+// 流式并行上传：一个 I/O 线程通过 curl multi 同时驱动 N 条 FTP 连接（通道），
+// 一个读线程把各通道当前文件按大块顺序读入该通道的环形缓冲，SD 读取与网络发送重叠进行。
+// 文件按大小降序分派给空闲通道，大文件先开始，小文件填补空隙，各连接的结束时间更接近。
+// 未压缩的文件按 chunk_size 分块上传（首块 STOR，其余 APPE），每块确认后记入续传日志；
+// 断线时先用 SIZE 查询远端已收到的长度，再从那里 APPE 续传。
+// 读线程读入数据时顺带算出内容哈希、整文件 SHA-256 与每块的 CRC32C，不需要再读第二遍。
+// 开启远端目录缓存时先用 MLSD 列出相关的远端目录，之后建目录、查续传长度都不必逐个文件往返；
+// multi 句柄（连同其中已登录的控制连接）与各通道的 easy 句柄可放进 UploadPool 留给下一次备份。
+// 任务也可以是一个小文件归档（pack.h），读线程按需生成其内容，其余处理与普通文件相同
+#include "../util/platform.h"
+#include "../util/hash.h"
+#include "../util/checksum.h"
+#include "../util/mempool.h"
+#include "../util/threading.h"
+#include "compress.h"
+#include "journal.h"
+#include "throttle.h"
+#include "remote.h"
+#include "pack.h"
+#include <curl/curl.h>
+
+#define UPLOAD_MAX_BUFFERS 8
+#define UPLOAD_MAX_CONNECTIONS 4
+#define UPLOAD_BUFFER_ALIGN 0x1000
+#define UPLOAD_POLL_TIMEOUT_MS 1000
+#define UPLOAD_CONNECT_POLL_MS 5    // 有传输在建数据连接时的 poll 超时
+#define UPLOAD_BUFFER_WAIT_NS (30 * 1000000000ULL) // 缓冲池一块都匀不出来时最多等这么久
+#define UPLOAD_MAX_RETRIES 3        // 同一次备份中每个文件断线后的重试次数
+#define UPLOAD_CRC_CHUNK_DEFAULT (8 * 1024 * 1024) // 不分块上传时 CRC32C 的分块大小
+#define UPLOAD_LIST_MAX_BYTES (1024 * 1024)        // 单个目录 MLSD 输出的上限，超出时该目录按未知处理
+#define UPLOAD_POOL_IDLE_NS (10 * 60 * 1000000000ULL) // 连接闲置超过它就不再复用（服务器多半已断开）
+#define UPLOAD_KEEPALIVE_IDLE_S 30
+#define UPLOAD_KEEPALIVE_INTERVAL_S 15
+// 统计控制命令（UploadStats 的 commands、cwd、list_commands）要打开 curl 的 VERBOSE 与调试回调，
+// 每条协议行都要格式化一遍，只在主机端基准里开（构建时加 -DUPLOAD_COUNT_COMMANDS=1）；设备上这几项为 0
+#ifndef UPLOAD_COUNT_COMMANDS
+#define UPLOAD_COUNT_COMMANDS 0
+#endif
+
+// 跨次备份保留的连接：multi 句柄的连接缓存里是已登录的 FTP 控制连接
+typedef struct {
+    CURLM *multi;
+    CURL *handles[UPLOAD_MAX_CONNECTIONS];
+    u64 key;                // 地址与账号的哈希，变了就不能复用
+    u64 last_used;          // tick
+    u32 reused;             // 被复用的次数
+} UploadPool;
+
+// 关闭保留的连接
+void upload_pool_release(UploadPool *pool);
+
+typedef struct {
+    const char *local_root; // 本地根目录（文件路径相对于它）
+    const char *url;        // 远端根目录，如 ftp://192.168.1.2:21/switch
+    const char *user;
+    const char *password;
+    u32 connections;        // 并行连接数（1..UPLOAD_MAX_CONNECTIONS）
+    u32 buffer_count;       // 每条连接的环形缓冲块数（2..UPLOAD_MAX_BUFFERS）
+    u32 buffer_size;        // 每块字节数（同时作为 curl 的上传缓冲大小）
+    BufPool *buffers;       // 非 NULL 时缓冲块取自这里（块大小以池为准）；池里不够时先减少每条连接的块数，再减少连接数
+    bool compress;          // 压缩后上传（远端文件名加 .gz）
+    int compress_level;     // 0 = 按吞吐自动调整，1..9 = 固定级别
+    u64 chunk_size;         // 分块大小；0 = 整个文件一次传完（压缩时总是整个文件）
+    Journal *journal;       // 续传日志，可为 NULL
+    Throttle *throttle;     // 前台有应用时的限速，可为 NULL
+    UploadPool *pool;       // 复用上次留下的连接，结束时把连接留在这里；可为 NULL
+    bool remote_cache;      // 上传前列出远端目录（MLSD），按缓存建目录、查续传长度
+} UploadOptions;
+
+// 一个待上传文件；rc 及其后的字段由 upload_run 填写
+typedef struct {
+    const char *path;        // 相对路径，以 / 分隔；远端自动逐段转义并创建缺失目录
+    u64 size;                // 用于排序；实际大小以打开时为准
+    s64 mtime;               // 与 size 一起校验续传记录
+    PackArchive *pack;       // 非 NULL 时内容由归档生成（path 为远端归档路径，大小取 pack->size）
+    const u8 *data;          // 非 NULL 时内容在内存里（快照，长度为 size），不再打开本地文件
+    Result rc;
+    u64 content_hash;        // 读线程顺带计算的内容哈希（清单用）
+    u8 sha256[SHA256_DIGEST_SIZE];
+    u32 crc_chunk;           // CRC32C 分块大小；0 = 没有摘要（续传日志表明上次已传完，本次没有读文件）
+    u32 crc_count;
+    u32 crc_index;           // 各块 CRC32C 在 UploadEngine.crcs 中的起始下标
+} UploadJob;
+
+typedef struct {
+    u64 files;
+    u64 bytes_sent;
+    u64 busy_ns;            // 有文件在传的时间
+} UploadLaneStats;
+
+typedef struct {
+    u64 files_ok;
+    u64 files_failed;
+    u64 bytes_read;         // 读线程从 SD 读入的字节
+    u64 bytes_sent;         // 交给 curl 的字节
+    u64 reader_wait_ns;     // 读线程无事可做（各通道的环都满：网络是瓶颈）
+    u64 sender_stalls;      // 读回调因环空而暂停传输的次数（SD 是瓶颈）
+    u64 elapsed_ns;         // upload_run 总耗时
+    u64 compress_in;        // 压缩输入（原始）字节
+    u64 compress_out;       // 压缩输出字节
+    u64 compress_ns;        // deflate 耗时
+    int compress_level;     // 结束时的级别
+    u32 compress_level_changes;
+    u64 chunks;             // 发起的 STOR/APPE 次数
+    u64 retries;            // 断线重试次数
+    u64 resumed_files;      // 按续传日志继续（或确认已完成）的文件
+    u64 resumed_bytes;      // 因续传而免于重传的字节
+    u64 commands;           // 发出的 FTP 控制命令（含登录、列目录），仅 UPLOAD_COUNT_COMMANDS
+    u64 cwd;                // 其中的 CWD
+    u32 dirs_listed;        // 用 MLSD 列出的目录
+    u32 list_commands;      // 列目录阶段发出的命令，仅 UPLOAD_COUNT_COMMANDS
+    u32 mkd;                // 按缓存为缺失（或未知）目录发出的 MKD
+    u64 probes_saved;       // 由缓存回答、免去的 SIZE 查询
+    u64 cwd_estimate;       // 估计：逐级 CWD 方式下需要的 CWD 次数
+    bool remote_cache;      // 本次用上了远端目录缓存
+    bool pool_reused;       // 沿用了上次备份留下的连接
+    u32 connections;
+    UploadLaneStats lanes[UPLOAD_MAX_CONNECTIONS];
+} UploadStats;
+
+typedef struct {
+    u8 *data;
+    u32 len;                // 有效字节数
+    u32 raw_len;            // 对应的原始文件字节数（未压缩时等于 len）
+    bool eof;               // 文件的最后一块
+    bool error;             // 读取失败
+} UploadSlot;
+
+struct UploadEngine;
+
+typedef enum {
+    LaneStep_Probe,         // SIZE 查询远端已有长度
+    LaneStep_Chunk,         // 上传 [chunk_offset, chunk_offset + chunk_len)
+} LaneStep;
+
+// 一条连接：curl 句柄 + 环形缓冲 + 当前文件
+typedef struct {
+    struct UploadEngine *engine;
+    CURL *curl;
+    u32 index;
+    UploadSlot slots[UPLOAD_MAX_BUFFERS];
+    // 环形队列：读线程写 tail，curl 读回调消费 head（受 UploadEngine.lock 保护）
+    u32 head;
+    u32 tail;
+    u32 filled;
+    UploadSlot *current;    // 读回调正在发送的块
+    u32 current_off;
+    bool sent_eof;          // 最后一块已交给 curl
+    bool paused;            // 读回调返回了 CURL_READFUNC_PAUSE，等 I/O 线程恢复
+    bool throttled;         // 因网络限速暂停，令牌够了由 I/O 线程恢复（只由 I/O 线程访问）
+    bool connecting;        // 传输已开始、数据还没开始流动（只由 I/O 线程访问）
+
+    // 当前文件；job 为 NULL 表示通道空闲
+    UploadJob *job;
+    int fd;
+    u64 data_off;           // 内容在内存里时的读取位置
+    LaneStep step;
+    u64 path_hash;
+    u64 file_size;
+    u64 chunk_offset;
+    u64 chunk_len;
+    u64 resume_hint;        // 已知被确认过的偏移；SIZE 结果不小于它才续传
+    bool journal_resume;    // resume_hint 来自续传日志（跨次续传），续传开始时计入统计
+    u64 sent_raw;           // 本块已交给 curl 的原始字节（I/O 线程）
+    u64 reported;           // 已计入进度的文件字节（重试时不重复计）
+    u32 retries;
+    u64 skip;               // 读线程先读过（只算摘要不发送）的前缀字节
+    u64 remaining;          // 读线程尚未读入的本块字节
+    bool read_done;         // 读线程已推入最后一块
+    bool reading;           // 读线程正在（不持锁地）读这条通道
+    bool cancel;
+    // 摘要：由读线程按文件顺序更新，从头重读时重置
+    FastHash hash;
+    Sha256 sha;
+    u64 digest_off;         // 已计入摘要的字节数
+    u32 crc;                // 当前块的 CRC32C
+    u32 *crcs;              // 已完成各块的 CRC32C
+    u32 crc_count;
+    u32 crc_capacity;
+    // 压缩：原始数据先读入 raw，再压入环形缓冲块
+    CompressStream z;
+    u8 *raw;
+    u32 raw_len;
+    u32 raw_off;
+    bool raw_eof;
+    u64 start_tick;
+    struct curl_slist *quote; // 本文件传输前要建的目录（*MKD），成功后清除
+    u64 cwd_dir;            // 估计 CWD 用：按逐级 CWD 方式这条连接当前所在目录的哈希
+    bool cwd_used;          // 这条连接上已有过传输（复用的连接要先回到登录目录）
+    char *list;             // MLSD 输出
+    size_t list_len;
+    size_t list_capacity;
+    char url[1024];
+    char local_path[512];
+} UploadLane;
+
+typedef struct UploadEngine {
+    CURLM *multi;
+    UploadPool *pool;
+    bool pool_reused;
+    char base_url[256];
+    char local_root[256];
+    char userpwd[132];
+    u32 lane_count;
+    u32 slot_count;
+    u32 slot_size;
+    BufPool *buffers;       // 缓冲块的来源；NULL 时直接在堆上申请
+    bool compress;
+    u64 chunk_size;
+    u32 crc_chunk;
+    Journal *journal;       // 只由 I/O 线程访问
+    Throttle *throttle;
+    bool remote_enabled;    // 选项要求使用远端目录缓存
+    bool remote_active;     // 本次 upload_run 列目录成功，传输改用 NOCWD
+    RemoteCache remote;     // 只由 I/O 线程访问
+    char mkd_prefix[512];   // MKD 参数前缀：登录目录 + 远端根目录（解码后），以 / 结尾
+    u32 base_depth;         // 远端根目录相对登录目录的层数
+    CompressControl compress_ctl; // 受 lock 保护
+    UploadLane lanes[UPLOAD_MAX_CONNECTIONS];
+
+    Mutex lock;
+    CondVar reader_cv;      // 读线程等待：有通道需要数据 / 退出
+    CondVar idle_cv;        // I/O 线程等待：读线程离开某条通道
+    u32 next_lane;          // 读线程轮转起点
+    bool quit;
+    AppThread reader;
+    bool reader_started;
+
+    UploadStats stats;
+    // 本次 upload_run 各文件的 CRC32C（文件结束时由 I/O 线程追加），到下次 upload_run 前有效
+    u32 *crcs;
+    u32 crc_count;
+    u32 crc_capacity;
+} UploadEngine;
+
+Result upload_engine_init(UploadEngine *e, const UploadOptions *opt);
+void upload_engine_exit(UploadEngine *e);
+// 上传一批文件（按 size 降序分派给空闲连接），每个文件的结果写入 job->rc；
+// 有任何失败时返回最后一个错误。统计写入 e->stats（每次调用前清零）
+Result upload_run(UploadEngine *e, UploadJob *jobs, u32 count);
+// 成功文件的各块 CRC32C（job->crc_count 个）；没有摘要时返回 NULL
+const u32 *upload_job_crcs(const UploadEngine *e, const UploadJob *job);
@@ -4,6 +4,20 @@
 #include <stdlib.h>
 #include <string.h>
 #include "util/log.h"
+#include "util/trace.h"
+#include "util/service.h"
+#include "util/config.h"
+#include "util/assetpack.h"
+#include "util/fspool.h"
+#include "util/metrics.h"
+#include "util/threading.h"
+#include "util/hash.h"
+#include "util/blit.h"
+#include "backup/progress.h"
+#include "backup/backup.h"
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#endif
 
 // libnx 头文件
 #include <switch.h>
@@ -35,7 +49,11 @@ u32 __attribute__((weak)) __nx_nv_transfermem_size = 0x200000; // 将 tmem 从 8
 #define SCREEN_WIDTH 1920
 #define SCREEN_HEIGHT 1080
 
-// 配置项（与 tesla cfg 对齐）
+// 运行时配置（/config/mario-pop/config.ini，缺失或非法项使用默认值）
+static AppConfig g_config;
+static ConfigWatch g_configWatch;
+
+// 配置项（与 tesla cfg 对齐；启动时由 g_config 覆盖）
 static u16 CFG_FramebufferWidth = 448;
 static u16 CFG_FramebufferHeight = 720;
 static u16 CFG_LayerWidth = 0;
@@ -93,17 +111,30 @@ static inline u8 blendColor(u8 src, u8 dst, u8 alpha) {
 // 将 x,y 映射为块线性帧缓冲中的偏移（与 tesla.hpp getPixelOffset 一致）
 static inline u32 getPixelOffset(s32 x, s32 y) {
     // 边界由调用者保证，这里直接映射
-    u32 tmpPos = ((y & 127) / 16) + (x / 32 * 8) + ((y / 16 / 8) * (((CFG_FramebufferWidth / 2) / 16 * 8)));
-    tmpPos *= 16 * 16 * 4;
-    tmpPos += ((y % 16) / 8) * 512 + ((x % 32) / 16) * 256 + ((y % 8) / 2) * 64 + ((x % 16) / 8) * 32 + (y % 2) * 16 + (x % 8) * 2;
-    return tmpPos / 2;
+    return blit_pixel_offset(CFG_FramebufferWidth, x, y);
+}
+
+// 当前帧缓冲作为精灵写入目标
+static inline BlitTarget frame_target(void) {
+    return (BlitTarget){ (u16*)g_currentFramebuffer, (s32)CFG_FramebufferWidth, (s32)CFG_FramebufferHeight };
 }
 
+// 本帧写入的像素数：只有渲染线程写，endFrame 时一次计入指标
+static u64 g_framePixels;
+static u64 g_frameStartTick;
+static u64 g_lastFrameTick;
+
 // 绘制基本原语
-static inline void setPixel(s32 x, s32 y, Color color) {
+// 直接写入已打包的 RGBA4444 值（预渲染的缓存/图集使用，省去 Color 往返转换）
+static inline void setPixelRaw(s32 x, s32 y, u16 raw) {
     if (x < 0 || y < 0 || x >= (s32)CFG_FramebufferWidth || y >= (s32)CFG_FramebufferHeight || g_currentFramebuffer == NULL) return;
     u32 offset = getPixelOffset(x, y);
-    ((u16*)g_currentFramebuffer)[offset] = color_to_u16(color);
+    ((u16*)g_currentFramebuffer)[offset] = raw;
+    g_framePixels++;
+}
+
+static inline void setPixel(s32 x, s32 y, Color color) {
+    setPixelRaw(x, y, color_to_u16(color));
 }
 
 static inline void setPixelBlendDst(s32 x, s32 y, Color color) {
@@ -154,6 +185,23 @@ static inline void drawRectSolid(s32 x, s32 y, s32 w, s32 h, Color color) {
     }
 }
 
+// 单行水平实心线段 [x0, x1)，直接写入打包好的颜色
+// 块线性布局中 x 对齐到 8 的 8 个像素连续存放，整组用 16 字节写入
+static inline void drawSpanSolidRaw(s32 y, s32 x0, s32 x1, u16 raw) {
+    if (!g_currentFramebuffer || y < 0 || y >= (s32)CFG_FramebufferHeight) return;
+    if (x0 < 0) x0 = 0;
+    if (x1 > (s32)CFG_FramebufferWidth) x1 = CFG_FramebufferWidth;
+    if (x0 < x1) g_framePixels += (u64)(x1 - x0);
+    u16 *fb = (u16*)g_currentFramebuffer;
+    s32 x = x0;
+    for (; x < x1 && (x & 7); ++x) fb[getPixelOffset(x, y)] = raw;
+    if (x + 8 <= x1) {
+        const u16 group[8] = { raw, raw, raw, raw, raw, raw, raw, raw };
+        for (; x + 8 <= x1; x += 8) memcpy(fb + getPixelOffset(x, y), group, sizeof(group));
+    }
+    for (; x < x1; ++x) fb[getPixelOffset(x, y)] = raw;
+}
+
 static inline void fillScreenSolid(Color color) {
     if (!g_currentFramebuffer) return;
     for (s32 xi = 0; xi < (s32)CFG_FramebufferWidth; ++xi) {
@@ -170,79 +218,71 @@ static inline void fillScreen(Color color) {
 // 帧控制
 static inline void startFrame(void) {
     g_currentFramebuffer = framebufferBegin(&g_framebuffer, NULL);
+    g_frameStartTick = armGetSystemTick();
+    if (g_lastFrameTick) metrics_observe(Metric_FrameInterval, armTicksToNs(g_frameStartTick - g_lastFrameTick));
+    g_lastFrameTick = g_frameStartTick;
 }
 
 static inline void endFrame(void) {
+    metrics_observe(Metric_FrameDraw, armTicksToNs(armGetSystemTick() - g_frameStartTick));
+    metrics_add(Metric_PixelsDrawn, g_framePixels);
+    metrics_inc(Metric_Frames);
+    g_framePixels = 0;
     eventWait(&g_vsyncEvent, UINT64_MAX);
     framebufferEnd(&g_framebuffer);
     g_currentFramebuffer = NULL;
 }
 
 // 图形初始化与释放（仿照 pop-windows-main 的防御式策略）
+// 每一步的耗时记入启动追踪，只在失败时单独写日志（日志每条都会同步刷 SD）
+#define GFX_STEP(name, expr) do { \
+        u32 _t = trace_begin(name); \
+        rc = (expr); \
+        trace_end(_t, rc); \
+        if (R_FAILED(rc)) { log_error("%s 失败: 0x%x", name, rc); return rc; } \
+    } while (0)
+
 static Result gfx_init(void) {
     // 计算 Layer 尺寸，继续缩小高度以形成更小的"弹窗"效果并水平居中
-    CFG_LayerHeight = (u16)(SCREEN_HEIGHT * 0.35f);
+    CFG_LayerHeight = (u16)(SCREEN_HEIGHT * g_config.layer_fraction);
     CFG_LayerWidth  = (u16)(SCREEN_HEIGHT * ((float)CFG_FramebufferWidth / (float)CFG_FramebufferHeight));
     CFG_LayerPosX = (u16)((SCREEN_WIDTH - CFG_LayerWidth) / 2);
     CFG_LayerPosY = (u16)((SCREEN_HEIGHT - CFG_LayerHeight) / 2); // 等于 0
 
-    log_info("viInitialize(ViServiceType_Manager)");
-    Result rc = viInitialize(ViServiceType_Manager);
-    if (R_FAILED(rc)) return rc;
-
-    log_info("viOpenDefaultDisplay...");
-    rc = viOpenDefaultDisplay(&g_display);
-    if (R_FAILED(rc)) return rc;
+    // NV 仅帧缓冲需要，推迟到这里按需初始化（不使用 fatalThrow，因为某些环境可能不需要）
+    Result rc = service_require(ServiceId_NvFence);
+    if (R_FAILED(rc)) {
+        log_error("NV 初始化失败: 0x%x (force type=%d, tmem=0x%x)", rc, __nx_nv_service_type, __nx_nv_transfermem_size);
+    }
 
-    log_info("viGetDisplayVsyncEvent...");
-    rc = viGetDisplayVsyncEvent(&g_display, &g_vsyncEvent);
-    if (R_FAILED(rc)) return rc;
+    GFX_STEP("viInitialize", viInitialize(ViServiceType_Manager));
+    GFX_STEP("viOpenDefaultDisplay", viOpenDefaultDisplay(&g_display));
+    GFX_STEP("viGetDisplayVsyncEvent", viGetDisplayVsyncEvent(&g_display, &g_vsyncEvent));
 
     // 确保显示全局 Alpha 为不透明
-    log_info("viSetDisplayAlpha(1.0f)...");
     viSetDisplayAlpha(&g_display, 1.0f);
 
-    log_info("viCreateManagedLayer...");
-    rc = viCreateManagedLayer(&g_display, (ViLayerFlags)0, 0, &__nx_vi_layer_id);
-    if (R_FAILED(rc)) return rc;
-
-    log_info("viCreateLayer...");
-    rc = viCreateLayer(&g_display, &g_layer);
-    if (R_FAILED(rc)) return rc;
-
-    log_info("viSetLayerScalingMode(FitToLayer)...");
-    rc = viSetLayerScalingMode(&g_layer, ViScalingMode_FitToLayer);
-    if (R_FAILED(rc)) return rc;
+    GFX_STEP("viCreateManagedLayer", viCreateManagedLayer(&g_display, (ViLayerFlags)0, 0, &__nx_vi_layer_id));
+    GFX_STEP("viCreateLayer", viCreateLayer(&g_display, &g_layer));
+    GFX_STEP("viSetLayerScalingMode", viSetLayerScalingMode(&g_layer, ViScalingMode_FitToLayer));
 
     s32 layerZ = 250;
-        log_info("viSetLayerZ(%d)...", layerZ);
-        rc = viSetLayerZ(&g_layer, layerZ);
-        if (R_FAILED(rc)) return rc;
+    GFX_STEP("viSetLayerZ", viSetLayerZ(&g_layer, layerZ));
 
     // 添加到图层栈（保守策略：仅 Default 和 Screenshot，避免冲突）
-    log_info("viAddToLayerStack(Default and Screenshot)...");
-    rc = viAddToLayerStack(&g_layer, ViLayerStack_Default);
-    if (R_FAILED(rc)) return rc;
-    rc = viAddToLayerStack(&g_layer, ViLayerStack_Screenshot);
-    if (R_FAILED(rc)) return rc;
-
-    log_info("viSetLayerSize(%u,%u)...", CFG_LayerWidth, CFG_LayerHeight);
-    rc = viSetLayerSize(&g_layer, CFG_LayerWidth, CFG_LayerHeight);
-    if (R_FAILED(rc)) return rc;
-    log_info("viSetLayerPosition(%u,%u) 屏幕居中", CFG_LayerPosX, CFG_LayerPosY);
-    rc = viSetLayerPosition(&g_layer, CFG_LayerPosX, CFG_LayerPosY);
-    if (R_FAILED(rc)) return rc;
-
-    log_info("nwindowCreateFromLayer...");
-    rc = nwindowCreateFromLayer(&g_window, &g_layer);
-    if (R_FAILED(rc)) return rc;
-
-    log_info("framebufferCreate(%u,%u,RGBA_4444,2)...", CFG_FramebufferWidth, CFG_FramebufferHeight);
-    rc = framebufferCreate(&g_framebuffer, &g_window, CFG_FramebufferWidth, CFG_FramebufferHeight, PIXEL_FORMAT_RGBA_4444, 2);
-    if (R_FAILED(rc)) return rc;
+    GFX_STEP("viAddToLayerStack(Default)", viAddToLayerStack(&g_layer, ViLayerStack_Default));
+    GFX_STEP("viAddToLayerStack(Screenshot)", viAddToLayerStack(&g_layer, ViLayerStack_Screenshot));
+
+    GFX_STEP("viSetLayerSize", viSetLayerSize(&g_layer, CFG_LayerWidth, CFG_LayerHeight));
+    // 屏幕居中
+    GFX_STEP("viSetLayerPosition", viSetLayerPosition(&g_layer, CFG_LayerPosX, CFG_LayerPosY));
+
+    GFX_STEP("nwindowCreateFromLayer", nwindowCreateFromLayer(&g_window, &g_layer));
+    GFX_STEP("framebufferCreate", framebufferCreate(&g_framebuffer, &g_window, CFG_FramebufferWidth, CFG_FramebufferHeight, PIXEL_FORMAT_RGBA_4444, g_config.buffer_count));
 
     g_gfxInitialized = true;
-    log_info("gfx_init 完成");
+    log_info("gfx_init 完成：Layer %ux%u @(%u,%u)，帧缓冲 %ux%u RGBA_4444 x%u", CFG_LayerWidth, CFG_LayerHeight,
+             CFG_LayerPosX, CFG_LayerPosY, CFG_FramebufferWidth, CFG_FramebufferHeight, g_config.buffer_count);
     return 0;
 }
 
@@ -292,7 +332,7 @@ extern "C" {
 
 // 后台程序：不使用 Applet 环境
 u32 __nx_applet_type = AppletType_None;
-u32 __nx_fs_num_sessions = 1;
+u32 __nx_fs_num_sessions = FSPOOL_MAX_SESSIONS; // 实际并发由 fspool 按配置的槽数限制
 
 // 配置 newlib 堆（使 malloc/free 可用）
 void __libnx_initheap(void)
@@ -305,94 +345,36 @@ void __libnx_initheap(void)
 }
 
 // 必要服务初始化（仿照 pop-windows-main 的严格错误处理）
+// 这里只初始化日志所需的 sm/fs；其余服务（NV 等）在首次使用时由 service_require 按需初始化，
+// hid/set 在本程序中没有用到，不再初始化，缩短 boot2 阶段的启动时间
 void __appInit(void)
 {
-    log_info("应用程序初始化开始...");
-    
-    Result rc = 0;
-    
-    // 基础服务初始化（严格错误检查）
-    rc = smInitialize();
+    Result rc = service_require(ServiceId_Sm);
     if (R_FAILED(rc)) {
-        log_error("smInitialize失败: 0x%x", rc);
         fatalThrow(rc);
     }
-    
-    rc = fsInitialize();
-    if (R_FAILED(rc)) {
-        log_error("fsInitialize失败: 0x%x", rc);
-        fatalThrow(rc);
-    }
-    
-    fsdevMountSdmc();
-    
-    // 其他服务初始化
-    rc = hidInitialize();
-    if (R_FAILED(rc)) {
-        log_error("hidInitialize失败: 0x%x", rc);
-        fatalThrow(rc);
-    }
-    
-    rc = setInitialize();
+
+    rc = service_require(ServiceId_Fs);
     if (R_FAILED(rc)) {
-        log_error("setInitialize失败: 0x%x", rc);
         fatalThrow(rc);
     }
-    
-    // NV 初始化（不使用 fatalThrow，因为某些环境可能不需要）
-    AppletType appType = appletGetAppletType();
-    log_info("appletGetAppletType=%d", (int)appType);
-    log_info("nvInitialize... (force type=%d, tmem=0x%x)", __nx_nv_service_type, __nx_nv_transfermem_size);
-    Result rc2 = nvInitialize();
-    if (R_FAILED(rc2)) {
-        log_error("nvInitialize 失败: 0x%x", rc2);
-    } else {
-        log_info("nvInitialize 成功");
-    }
-    log_info("nvMapInit...");
-    rc2 = nvMapInit();
-    if (R_FAILED(rc2)) {
-        log_error("nvMapInit 失败: 0x%x", rc2);
-    } else {
-        log_info("nvMapInit 成功");
-    }
-    log_info("nvFenceInit...");
-    rc2 = nvFenceInit();
-    if (R_FAILED(rc2)) {
-        log_error("nvFenceInit 失败: 0x%x", rc2);
-    } else {
-        log_info("nvFenceInit 成功");
-    }
-    
-    log_info("应用程序初始化完成");
 }
 
 // 服务释放（仿照 pop-windows-main 的清理顺序）
 void __appExit(void)
 {
     log_info("应用程序退出开始...");
-    
+
+    // 等待备份线程结束（它持有 socket 与 sdmc 上打开的文件）
+    backup_wait();
+    metrics_stop();
+
     // 优先清理图形资源，避免与其他叠加层冲突
     gfx_exit();
-    
-    // 清理其他服务
-    setExit();
-    hidExit();
-    
-    // NV 相关清理
-    log_info("nvFenceExit...");
-    nvFenceExit();
-    log_info("nvMapExit...");
-    nvMapExit();
-    log_info("nvExit...");
-    nvExit();
-    
-    // 最后清理基础服务
-    fsdevUnmountAll();
-    fsExit();
-    smExit();
-    
+
+    // 其余服务按初始化的逆序释放（NV -> fs/sdmc -> sm）
     log_info("应用程序退出完成");
+    service_exit_all();
 }
 
 #ifdef __cplusplus
@@ -404,18 +386,34 @@ void __appExit(void)
 #define GLYPH_W 16
 #define GLYPH_H 15
 
-// 字形位图绘制（支持独立横纵缩放）
+// 取字形一行中的下一段连续置位列 [*c0, *c1)：row 为左对齐到 bit31 的行位图（MSB -> 左侧）
+// 用 clz 直接跳到段首/段尾，不再逐位测试；返回 false 表示本行已无置位
+static inline bool glyph_row_next_run(u32 *row, int *c0, int *c1) {
+    u32 v = *row;
+    if (!v) return false;
+    int start = __builtin_clz(v);
+    u32 gaps = ~v & (0xFFFFFFFFu >> start); // start 之后的空位；低 16 位恒为空位，保证非零
+    int end = __builtin_clz(gaps);
+    *row = v & (0xFFFFFFFFu >> end);
+    *c0 = start;
+    *c1 = end;
+    return true;
+}
+
+static inline u32 glyph_row_bits(const unsigned char *bits, int row, int width) {
+    u32 v = ((u32)bits[row*2 + 0] << 24) | ((u32)bits[row*2 + 1] << 16); // MSB -> 左侧
+    if (width < GLYPH_W) v &= ~(0xFFFFFFFFu >> width);
+    return v;
+}
+
+// 字形位图绘制（支持独立横纵缩放）：每段连续置位列只绘制一个矩形
 static void draw_glyph_bitmap_scaled(s32 left, s32 top, s32 scale_x, s32 scale_y, const unsigned char *bits, int width, int height, Color color) {
     if (!g_currentFramebuffer) return;
     for (int row = 0; row < height; ++row) {
-        unsigned char b0 = bits[row*2 + 0];
-        unsigned char b1 = bits[row*2 + 1];
-        unsigned short rowBits = ((unsigned short)b0 << 8) | (unsigned short)b1; // MSB -> 左侧
-        for (int col = 0; col < width; ++col) {
-            unsigned short mask = (unsigned short)1 << (15 - col);
-            if (rowBits & mask) {
-                drawRect(left + col*scale_x, top + row*scale_y, scale_x, scale_y, color);
-            }
+        u32 v = glyph_row_bits(bits, row, width);
+        int c0, c1;
+        while (glyph_row_next_run(&v, &c0, &c1)) {
+            drawRect(left + c0*scale_x, top + row*scale_y, (c1 - c0)*scale_x, scale_y, color);
         }
     }
 }
@@ -425,52 +423,42 @@ static void draw_glyph_bitmap(s32 left, s32 top, s32 scale, const unsigned char
     draw_glyph_bitmap_scaled(left, top, scale, scale, bits, width, height, color);
 }
 
-// UTF-8 简易解码（仅支持到 U+10FFFF）
-static const char* utf8_next_simple(const char *s, u32 *out_cp) {
-    if (!s || !*s) {
-        if (out_cp) { *out_cp = 0; }
-        return s;
+// UTF-8 解码：先按整块判断纯 ASCII 段，再逐个解码多字节序列
+// 返回从 s 起连续 ASCII 字节（< 0x80）的个数；aarch64 上每次用 NEON 检查 16 字节，其余按 8 字节整字检查
+static size_t utf8_ascii_prefix(const unsigned char *s, size_t len) {
+    size_t i = 0;
+#if defined(__aarch64__)
+    for (; i + 16 <= len; i += 16) {
+        if (vmaxvq_u8(vld1q_u8(s + i)) & 0x80) break;
     }
-    unsigned char c = (unsigned char)s[0];
-    if (c < 0x80) {
-        if (out_cp) { *out_cp = c; }
-        return s + 1;
-    }
-    if ((c >> 5) == 0x6) { // 110xxxxx
-        unsigned char c1 = (unsigned char)s[1];
-        if ((c1 & 0xC0) != 0x80) {
-            if (out_cp) { *out_cp = 0; }
-            return s + 1;
-        }
-        u32 cp = ((u32)(c & 0x1F) << 6) | (u32)(c1 & 0x3F);
-        if (out_cp) { *out_cp = cp; }
-        return s + 2;
-    }
-    if ((c >> 4) == 0xE) { // 1110xxxx
-        unsigned char c1 = (unsigned char)s[1];
-        unsigned char c2 = (unsigned char)s[2];
-        if (((c1 & 0xC0) != 0x80) || ((c2 & 0xC0) != 0x80)) {
-            if (out_cp) { *out_cp = 0; }
-            return s + 1;
-        }
-        u32 cp = ((u32)(c & 0x0F) << 12) | ((u32)(c1 & 0x3F) << 6) | (u32)(c2 & 0x3F);
-        if (out_cp) { *out_cp = cp; }
-        return s + 3;
+#endif
+    for (; i + 8 <= len; i += 8) {
+        u64 w;
+        memcpy(&w, s + i, sizeof(w));
+        if (w & 0x8080808080808080ULL) break;
     }
-    if ((c >> 3) == 0x1E) { // 11110xxx
-        unsigned char c1 = (unsigned char)s[1];
-        unsigned char c2 = (unsigned char)s[2];
-        unsigned char c3 = (unsigned char)s[3];
-        if (((c1 & 0xC0) != 0x80) || ((c2 & 0xC0) != 0x80) || ((c3 & 0xC0) != 0x80)) {
-            if (out_cp) { *out_cp = 0; }
-            return s + 1;
-        }
-        u32 cp = ((u32)(c & 0x07) << 18) | ((u32)(c1 & 0x3F) << 12) | ((u32)(c2 & 0x3F) << 6) | (u32)(c3 & 0x3F);
-        if (out_cp) { *out_cp = cp; }
-        return s + 4;
+    while (i < len && s[i] < 0x80) ++i;
+    return i;
+}
+
+// 解码一个多字节序列（s[0] >= 0x80）：拒绝截断、过长编码、代理区与超出 U+10FFFF 的码点。
+// 返回消耗的字节数，0 表示非法
+static size_t utf8_decode_multibyte(const unsigned char *s, size_t avail, u32 *out_cp) {
+    unsigned char c = s[0];
+    size_t n;
+    u32 cp, min;
+    if ((c & 0xE0) == 0xC0)      { n = 2; cp = c & 0x1F; min = 0x80; }    // 110xxxxx
+    else if ((c & 0xF0) == 0xE0) { n = 3; cp = c & 0x0F; min = 0x800; }   // 1110xxxx
+    else if ((c & 0xF8) == 0xF0) { n = 4; cp = c & 0x07; min = 0x10000; } // 11110xxx
+    else return 0;
+    if (n > avail) return 0;
+    for (size_t i = 1; i < n; ++i) {
+        if ((s[i] & 0xC0) != 0x80) return 0;
+        cp = (cp << 6) | (u32)(s[i] & 0x3F);
     }
-    if (out_cp) { *out_cp = 0; }
-    return s + 1;
+    if (cp < min || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) return 0;
+    *out_cp = cp;
+    return n;
 }
 
 // 字形位图数据：正
@@ -663,32 +651,117 @@ static const unsigned char glyph_bai_bits[] = {
     0x82, 0x00,
 };
 
-// 将指定 codepoint 映射到已知字形并绘制（支持独立横纵缩放）
-static bool draw_known_glyph_scaled(u32 cp, s32 left, s32 top, s32 scale_x, s32 scale_y, Color color) {
+// 将指定 codepoint 映射到已知字形位图；未知字符返回 NULL
+static const unsigned char *known_glyph_bits(u32 cp) {
     switch (cp) {
-        case 0x6B63: // 正
-            draw_glyph_bitmap_scaled(left, top, scale_x, scale_y, glyph_zheng_bits, GLYPH_W, GLYPH_H, color); return true;
-        case 0x5728: // 在
-            draw_glyph_bitmap_scaled(left, top, scale_x, scale_y, glyph_zai_bits, GLYPH_W, GLYPH_H, color); return true;
-        case 0x5907: // 备
-            draw_glyph_bitmap_scaled(left, top, scale_x, scale_y, glyph_bei_bits, GLYPH_W, GLYPH_H, color); return true;
-        case 0x4EFD: // 份
-            draw_glyph_bitmap_scaled(left, top, scale_x, scale_y, glyph_fen_bits, GLYPH_W, GLYPH_H, color); return true;
-        case 0x4E0A: // 上
-            draw_glyph_bitmap_scaled(left, top, scale_x, scale_y, glyph_shang_bits, GLYPH_W, GLYPH_H, color); return true;
-        case 0x4F20: // 传
-            draw_glyph_bitmap_scaled(left, top, scale_x, scale_y, glyph_chuan_bits, GLYPH_W, GLYPH_H, color); return true;
-        case 0x6210: // 成
-            draw_glyph_bitmap_scaled(left, top, scale_x, scale_y, glyph_cheng_bits, GLYPH_W, GLYPH_H, color); return true;
-        case 0x529F: // 功
-            draw_glyph_bitmap_scaled(left, top, scale_x, scale_y, glyph_gong_bits, GLYPH_W, GLYPH_H, color); return true;
-        case 0x5931: // 失
-            draw_glyph_bitmap_scaled(left, top, scale_x, scale_y, glyph_shi_bits, GLYPH_W, GLYPH_H, color); return true;
-        case 0x8D25: // 败
-            draw_glyph_bitmap_scaled(left, top, scale_x, scale_y, glyph_bai_bits, GLYPH_W, GLYPH_H, color); return true;
-        default:
-            return false;
+        case 0x6B63: return glyph_zheng_bits; // 正
+        case 0x5728: return glyph_zai_bits;   // 在
+        case 0x5907: return glyph_bei_bits;   // 备
+        case 0x4EFD: return glyph_fen_bits;   // 份
+        case 0x4E0A: return glyph_shang_bits; // 上
+        case 0x4F20: return glyph_chuan_bits; // 传
+        case 0x6210: return glyph_cheng_bits; // 成
+        case 0x529F: return glyph_gong_bits;  // 功
+        case 0x5931: return glyph_shi_bits;   // 失
+        case 0x8D25: return glyph_bai_bits;   // 败
+        default:     return NULL;
+    }
+}
+
+// 文字排版：字符串只解码、校验一次，逐字解析出字形与步进，结果按字符串哈希缓存。
+// 绘制与测宽都遍历缓存的字形序列；同一串文字每帧重复绘制时不再重新解码。
+// 只在渲染线程使用，不加锁
+#define TEXT_LAYOUT_MAX_GLYPHS 128      // 超出部分截断（已远超一行能放下的字数）
+#define TEXT_LAYOUT_KEY_MAX 128         // 更长的字符串不进缓存，每次重新排版
+#define TEXT_LAYOUT_CACHE_SLOTS 4
+
+typedef struct {
+    const unsigned char *bits;  // NULL = 未知字符，按一个字宽留空
+    u16 pen_x;                  // 未缩放的起笔位置：之前各字步进之和（不含字间距）
+    u16 advance;                // 未缩放的步进
+} TextGlyph;
+
+typedef struct {
+    u64 hash;
+    u32 len;                    // 0 = 空槽
+    u32 glyph_count;
+    u32 drawn_count;            // 有字形的字数
+    u32 advance_sum;
+    char key[TEXT_LAYOUT_KEY_MAX];
+    TextGlyph glyphs[TEXT_LAYOUT_MAX_GLYPHS];
+} TextRun;
+
+static TextRun s_textRuns[TEXT_LAYOUT_CACHE_SLOTS];
+static TextRun s_textRunScratch;
+static u32 s_textRunNext;
+
+static void text_run_push(TextRun *run, u32 cp) {
+    if (run->glyph_count == TEXT_LAYOUT_MAX_GLYPHS) return;
+    TextGlyph *g = &run->glyphs[run->glyph_count++];
+    g->bits = known_glyph_bits(cp);
+    g->pen_x = (u16)run->advance_sum;
+    g->advance = GLYPH_W;
+    run->advance_sum += g->advance;
+    if (g->bits) run->drawn_count++;
+}
+
+// 解码到第一个非法序列为止（与之前逐字解码遇到非法字节即停止一致）
+static void text_run_build(TextRun *run, const char *text, size_t len) {
+    const unsigned char *s = (const unsigned char*)text;
+    run->glyph_count = 0;
+    run->drawn_count = 0;
+    run->advance_sum = 0;
+    size_t i = 0;
+    while (i < len && run->glyph_count < TEXT_LAYOUT_MAX_GLYPHS) {
+        size_t n = utf8_ascii_prefix(s + i, len - i);
+        for (size_t k = 0; k < n; ++k) text_run_push(run, s[i + k]);
+        i += n;
+        if (i >= len) break;
+        u32 cp = 0;
+        n = utf8_decode_multibyte(s + i, len - i, &cp);
+        if (!n) break;
+        text_run_push(run, cp);
+        i += n;
+    }
+}
+
+static const TextRun *text_layout(const char *text) {
+    size_t len = strlen(text);
+    if (len >= TEXT_LAYOUT_KEY_MAX) {
+        text_run_build(&s_textRunScratch, text, len);
+        return &s_textRunScratch;
+    }
+    u64 hash = fasthash(text, len);
+    for (int i = 0; i < TEXT_LAYOUT_CACHE_SLOTS; ++i) {
+        TextRun *run = &s_textRuns[i];
+        if (run->len == len && run->hash == hash && memcmp(run->key, text, len) == 0) return run;
     }
+    TextRun *run = &s_textRuns[s_textRunNext];
+    s_textRunNext = (s_textRunNext + 1) % TEXT_LAYOUT_CACHE_SLOTS;
+    run->hash = hash;
+    run->len = (u32)len;
+    memcpy(run->key, text, len);
+    text_run_build(run, text, len);
+    return run;
+}
+
+// 第 i 个字的左边界（帧缓冲像素）
+static inline s32 text_run_pen(const TextRun *run, u32 i, s32 left, s32 scale_x, s32 letter_spacing) {
+    return left + ((s32)run->glyphs[i].pen_x + (s32)i * letter_spacing) * scale_x;
+}
+
+// 整串宽度：各字步进之和加上字间距（最后一个字后不加）
+static s32 text_run_width(const TextRun *run, s32 scale, s32 letter_spacing) {
+    if (run->glyph_count == 0) return 0;
+    return ((s32)run->advance_sum + (s32)(run->glyph_count - 1) * letter_spacing) * scale;
+}
+
+// 将指定 codepoint 映射到已知字形并绘制（支持独立横纵缩放）
+static bool draw_known_glyph_scaled(u32 cp, s32 left, s32 top, s32 scale_x, s32 scale_y, Color color) {
+    const unsigned char *bits = known_glyph_bits(cp);
+    if (!bits) return false;
+    draw_glyph_bitmap_scaled(left, top, scale_x, scale_y, bits, GLYPH_W, GLYPH_H, color);
+    return true;
 }
 
 // 等比例缩放（兼容旧调用）
@@ -696,21 +769,19 @@ static bool draw_known_glyph(u32 cp, s32 left, s32 top, s32 scale, Color color)
     return draw_known_glyph_scaled(cp, left, top, scale, scale, color);
 }
 
+// 按排版结果逐字绘制（未知字符只占位）
+static void draw_text_run_scaled(const TextRun *run, s32 left, s32 top, s32 scale_x, s32 scale_y, Color color, s32 letter_spacing) {
+    for (u32 i = 0; i < run->glyph_count; ++i) {
+        const unsigned char *bits = run->glyphs[i].bits;
+        if (!bits) continue;
+        draw_glyph_bitmap_scaled(text_run_pen(run, i, left, scale_x, letter_spacing), top, scale_x, scale_y, bits, GLYPH_W, GLYPH_H, color);
+    }
+}
+
 // 使用位图字形绘制 UTF-8 字符串（支持独立横纵缩放）
 static void draw_text_bitmap_scaled(const char *text, s32 left, s32 top, s32 scale_x, s32 scale_y, Color color, s32 letter_spacing) {
     if (!text || !g_currentFramebuffer) return;
-    s32 x = left;
-    const char *p = text;
-    while (*p) {
-        u32 cp = 0; p = utf8_next_simple(p, &cp);
-        if (cp == 0) break;
-        if (draw_known_glyph_scaled(cp, x, top, scale_x, scale_y, color)) {
-            x += (GLYPH_W + letter_spacing) * scale_x;
-        } else {
-            // 未知字符：空格宽度处理
-            x += (GLYPH_W + letter_spacing) * scale_x;
-        }
-    }
+    draw_text_run_scaled(text_layout(text), left, top, scale_x, scale_y, color, letter_spacing);
 }
 
 // 等比例缩放（兼容旧调用）
@@ -721,51 +792,413 @@ static void draw_text_bitmap(const char *text, s32 left, s32 top, s32 scale, Col
 // 计算位图字符串的像素宽度（按照每字 GLYPH_W 与字间距）
 static __attribute__((unused)) s32 text_bitmap_width(const char *text, s32 scale, s32 letter_spacing) {
     if (!text) return 0;
-    s32 count = 0;
-    const char *p = text;
-    while (*p) {
-        u32 cp = 0;
-        const char *np = utf8_next_simple(p, &cp);
-        if (np == p) break;
-        if (cp == 0) break;
-        count++;
-        p = np;
+    return text_run_width(text_layout(text), scale, letter_spacing);
+}
+
+// 粗体描边单遍光栅化
+// 原做法把整串文字按 8 个描边偏移 + 16 个加粗偏移重复绘制 24 次；两种颜色都不透明，
+// 结果等价于：加粗覆盖区 F = 字形 ⊕ [0,3]x[0,3] 填砖块色，描边区 O = 字形 ⊕ [-1,1]x[-1,1] 去掉 F 后填白色。
+// 每个字形先按行计算一次水平膨胀后的覆盖掩码，逐行再做纵向膨胀、拼入整行掩码，按段输出
+#define TEXT_GLYPH_MASK_WORDS 4   // 单字掩码宽度上限 256 像素（scale_x <= 15）
+#define TEXT_LINE_MASK_WORDS 32   // 整行掩码覆盖帧缓冲宽度上限 2048 像素
+#define TEXT_RUN_MAX_GLYPHS 32
+
+typedef struct {
+    s32 origin_x;                                   // 掩码 bit0 对应的帧缓冲 x（字形左边界 - 1）
+    u64 fill[GLYPH_H][TEXT_GLYPH_MASK_WORDS];       // 水平 +0..+3 像素加粗
+    u64 outline[GLYPH_H][TEXT_GLYPH_MASK_WORDS];    // 水平 -1..+1 像素描边
+} DilatedGlyph;
+
+// 多字位集：bit i 对应 x = i（LSB 在左）
+static inline void bitset_set_range(u64 *words, s32 a, s32 b) {
+    for (s32 i = a; i < b; ) {
+        s32 w = i >> 6, bit = i & 63;
+        s32 n = 64 - bit;
+        if (n > b - i) n = b - i;
+        words[w] |= (n == 64) ? ~0ULL : (((1ULL << n) - 1) << bit);
+        i += n;
     }
-    if (count <= 0) return 0;
-    return count * GLYPH_W * scale + (count - 1) * letter_spacing * scale;
 }
 
-// 粗体文字渲染（使用砖块颜色，带白色描边，支持独立横纵缩放）
-static void draw_text_bold_outline_scaled(const char *text, s32 left, s32 top, s32 scale_x, s32 scale_y, s32 letter_spacing) {
-    if (!text || !g_currentFramebuffer) return;
-    Color outline = (Color){15, 15, 15, 15}; // 白色描边
-    // 使用砖块颜色（从 SCN_GROUND 的棕色系 0xE2C2，手动转换为 RGBA4444）
-    // RGB565: 0xE2C2 = R:28(11100), G:17(010001), B:2(00010)
-    // 转 RGBA4444: R≈14, G≈8, B≈1
-    Color fill = {14, 8, 1, 15};
+// dst |= src 平移 shift 位（shift 可为负，超出 dst 的部分丢弃）
+static inline void bitset_or_shifted(u64 *dst, int dst_words, const u64 *src, int src_words, s32 shift) {
+    for (int i = 0; i < src_words; ++i) {
+        u64 v = src[i];
+        if (!v) continue;
+        s32 p = i * 64 + shift;
+        s32 wi = (p >= 0) ? (p / 64) : -((-p + 63) / 64);
+        s32 bit = p - wi * 64;
+        if (wi >= 0 && wi < dst_words) dst[wi] |= v << bit;
+        if (bit && wi + 1 >= 0 && wi + 1 < dst_words) dst[wi + 1] |= v >> (64 - bit);
+    }
+}
 
+static void dilate_glyph(DilatedGlyph *g, const unsigned char *bits, s32 left, s32 scale_x) {
+    g->origin_x = left - 1;
+    for (int row = 0; row < GLYPH_H; ++row) {
+        u64 cover[TEXT_GLYPH_MASK_WORDS] = {0};
+        u32 v = glyph_row_bits(bits, row, GLYPH_W);
+        int c0, c1;
+        while (glyph_row_next_run(&v, &c0, &c1)) {
+            bitset_set_range(cover, 1 + c0 * scale_x, 1 + c1 * scale_x);
+        }
+        memset(g->fill[row], 0, sizeof(g->fill[row]));
+        memset(g->outline[row], 0, sizeof(g->outline[row]));
+        for (s32 dx = 0; dx < 4; ++dx) {
+            bitset_or_shifted(g->fill[row], TEXT_GLYPH_MASK_WORDS, cover, TEXT_GLYPH_MASK_WORDS, dx);
+        }
+        for (s32 dx = -1; dx <= 1; ++dx) {
+            bitset_or_shifted(g->outline[row], TEXT_GLYPH_MASK_WORDS, cover, TEXT_GLYPH_MASK_WORDS, dx);
+        }
+    }
+}
+
+// 按 ctz 找出位集中的每一段连续置位并输出为水平线段（跨字边界的段会合并）
+static void emit_mask_runs(const u64 *mask, int words, s32 y, u16 raw) {
+    s32 run_start = -1;
+    for (int i = 0; i < words; ++i) {
+        u64 m = mask[i];
+        s32 base = i * 64;
+        if (run_start >= 0) {
+            u64 gaps = ~m;
+            if (!gaps) continue; // 整字置位，段继续延伸
+            s32 e = __builtin_ctzll(gaps);
+            drawSpanSolidRaw(y, run_start, base + e, raw);
+            run_start = -1;
+            m &= ~0ULL << e;
+        }
+        while (m) {
+            s32 s = __builtin_ctzll(m);
+            u64 gaps = ~m & (~0ULL << s);
+            if (!gaps) { run_start = base + s; break; }
+            s32 e = __builtin_ctzll(gaps);
+            drawSpanSolidRaw(y, base + s, base + e, raw);
+            m &= ~0ULL << e;
+        }
+    }
+    if (run_start >= 0) drawSpanSolidRaw(y, run_start, words * 64, raw);
+}
+
+// 多遍偏移绘制（超出单遍掩码上限时的兜底路径）
+static void draw_text_bold_outline_multipass(const TextRun *run, s32 left, s32 top, s32 scale_x, s32 scale_y, s32 letter_spacing, Color outline, Color fill) {
     // 白色描边：在周围1像素位置绘制（帧缓冲像素单位）
     static const s32 off[8][2] = {
         {-1, 0}, {1, 0}, {0, -1}, {0, 1},
         {-1, -1}, {-1, 1}, {1, -1}, {1, 1}
     };
     for (int i = 0; i < 8; ++i) {
-        draw_text_bitmap_scaled(text, left + off[i][0], top + off[i][1], scale_x, scale_y, outline, letter_spacing);
+        draw_text_run_scaled(run, left + off[i][0], top + off[i][1], scale_x, scale_y, outline, letter_spacing);
     }
 
     // 砖块色填充：多次偏移模拟加粗（4倍加粗效果）
     for (s32 dy = 0; dy < 4; dy++) {
         for (s32 dx = 0; dx < 4; dx++) {
-            draw_text_bitmap_scaled(text, left + dx, top + dy, scale_x, scale_y, fill, letter_spacing);
+            draw_text_run_scaled(run, left + dx, top + dy, scale_x, scale_y, fill, letter_spacing);
         }
     }
 }
 
+// 粗体文字渲染（使用砖块颜色，带白色描边，支持独立横纵缩放）
+static void draw_text_bold_outline_scaled(const char *text, s32 left, s32 top, s32 scale_x, s32 scale_y, s32 letter_spacing) {
+    if (!text || !g_currentFramebuffer) return;
+    Color outline = (Color){15, 15, 15, 15}; // 白色描边
+    // 使用砖块颜色（从 SCN_GROUND 的棕色系 0xE2C2，手动转换为 RGBA4444）
+    // RGB565: 0xE2C2 = R:28(11100), G:17(010001), B:2(00010)
+    // 转 RGBA4444: R≈14, G≈8, B≈1
+    Color fill = {14, 8, 1, 15};
+
+    const TextRun *run = text_layout(text);
+    if (run->drawn_count == 0) return;
+    if (scale_x <= 0 || scale_y <= 0 || GLYPH_W * scale_x + 4 > TEXT_GLYPH_MASK_WORDS * 64 ||
+        (s32)CFG_FramebufferWidth > TEXT_LINE_MASK_WORDS * 64 || run->drawn_count > TEXT_RUN_MAX_GLYPHS) {
+        draw_text_bold_outline_multipass(run, left, top, scale_x, scale_y, letter_spacing, outline, fill);
+        return;
+    }
+
+    // 每个字形只膨胀一次
+    static DilatedGlyph glyphs[TEXT_RUN_MAX_GLYPHS];
+    int count = 0;
+    for (u32 i = 0; i < run->glyph_count; ++i) {
+        const unsigned char *bits = run->glyphs[i].bits;
+        if (bits) dilate_glyph(&glyphs[count++], bits, text_run_pen(run, i, left, scale_x, letter_spacing), scale_x);
+    }
+
+    u16 fill_raw = color_to_u16(fill);
+    u16 outline_raw = color_to_u16(outline);
+    s32 glyph_h = GLYPH_H * scale_y;
+    s32 y0 = top - 1, y1 = top + glyph_h + 3;
+    if (y0 < 0) y0 = 0;
+    if (y1 > (s32)CFG_FramebufferHeight) y1 = CFG_FramebufferHeight;
+    int line_words = ((s32)CFG_FramebufferWidth + 63) / 64;
+
+    for (s32 y = y0; y < y1; ++y) {
+        u64 line_fill[TEXT_LINE_MASK_WORDS] = {0};
+        u64 line_outline[TEXT_LINE_MASK_WORDS] = {0};
+        s32 yr = y - top;
+        // 纵向膨胀：加粗取 yr-3..yr，描边取 yr-1..yr+1 覆盖到的源行
+        s32 f_lo = yr - 3 < 0 ? 0 : yr - 3, f_hi = yr < glyph_h - 1 ? yr : glyph_h - 1;
+        s32 o_lo = yr - 1 < 0 ? 0 : yr - 1, o_hi = yr + 1 < glyph_h - 1 ? yr + 1 : glyph_h - 1;
+        for (int g = 0; g < count; ++g) {
+            if (f_lo <= f_hi) {
+                for (s32 r = f_lo / scale_y; r <= f_hi / scale_y; ++r) {
+                    bitset_or_shifted(line_fill, line_words, glyphs[g].fill[r], TEXT_GLYPH_MASK_WORDS, glyphs[g].origin_x);
+                }
+            }
+            if (o_lo <= o_hi) {
+                for (s32 r = o_lo / scale_y; r <= o_hi / scale_y; ++r) {
+                    bitset_or_shifted(line_outline, line_words, glyphs[g].outline[r], TEXT_GLYPH_MASK_WORDS, glyphs[g].origin_x);
+                }
+            }
+        }
+        for (int i = 0; i < line_words; ++i) line_outline[i] &= ~line_fill[i];
+        emit_mask_runs(line_fill, line_words, y, fill_raw);
+        emit_mask_runs(line_outline, line_words, y, outline_raw);
+    }
+}
+
 // 等比例缩放（兼容旧调用）
 static __attribute__((unused)) void draw_text_bold_outline(const char *text, s32 left, s32 top, s32 scale, s32 letter_spacing) {
     draw_text_bold_outline_scaled(text, left, top, scale, scale, letter_spacing);
 }
 
+// 备份进度控件：进度条 + 吞吐/文件数/ETA 文本
+// 数字与单位使用 8x15 的 ASCII 位图字形（每行 1 字节，MSB -> 左侧），启动时按控件缩放预展开成图集
+#define ASCII_GLYPH_W 8
+
+// 字形位图数据：0-9 . / : % K M G B s E T A -
+static const unsigned char glyph_ascii_bits[][GLYPH_H] = {
+    { 0x00, 0x00, 0x38, 0x44, 0x82, 0x86, 0x8A, 0x92, 0xA2, 0xC2, 0x82, 0x44, 0x38, 0x00, 0x00 }, // 0
+    { 0x00, 0x00, 0x10, 0x30, 0x50, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x7C, 0x00, 0x00 }, // 1
+    { 0x00, 0x00, 0x7C, 0x82, 0x02, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0xFE, 0x00, 0x00 }, // 2
+    { 0x00, 0x00, 0x7C, 0x82, 0x02, 0x02, 0x3C, 0x02, 0x02, 0x02, 0x02, 0x82, 0x7C, 0x00, 0x00 }, // 3
+    { 0x00, 0x00, 0x04, 0x0C, 0x14, 0x24, 0x44, 0x84, 0xFE, 0x04, 0x04, 0x04, 0x04, 0x00, 0x00 }, // 4
+    { 0x00, 0x00, 0xFE, 0x80, 0x80, 0x80, 0xFC, 0x02, 0x02, 0x02, 0x02, 0x82, 0x7C, 0x00, 0x00 }, // 5
+    { 0x00, 0x00, 0x3C, 0x40, 0x80, 0x80, 0xFC, 0x82, 0x82, 0x82, 0x82, 0x82, 0x7C, 0x00, 0x00 }, // 6
+    { 0x00, 0x00, 0xFE, 0x02, 0x04, 0x04, 0x08, 0x08, 0x10, 0x10, 0x20, 0x20, 0x20, 0x00, 0x00 }, // 7
+    { 0x00, 0x00, 0x7C, 0x82, 0x82, 0x82, 0x7C, 0x82, 0x82, 0x82, 0x82, 0x82, 0x7C, 0x00, 0x00 }, // 8
+    { 0x00, 0x00, 0x7C, 0x82, 0x82, 0x82, 0x82, 0x7E, 0x02, 0x02, 0x04, 0x08, 0x70, 0x00, 0x00 }, // 9
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x30, 0x30, 0x00, 0x00 }, // .
+    { 0x00, 0x00, 0x02, 0x02, 0x04, 0x04, 0x08, 0x10, 0x20, 0x40, 0x40, 0x80, 0x80, 0x00, 0x00 }, // /
+    { 0x00, 0x00, 0x00, 0x00, 0x30, 0x30, 0x00, 0x00, 0x00, 0x30, 0x30, 0x00, 0x00, 0x00, 0x00 }, // :
+    { 0x00, 0x00, 0x62, 0x92, 0x64, 0x04, 0x08, 0x10, 0x20, 0x40, 0x4C, 0x92, 0x8C, 0x00, 0x00 }, // %
+    { 0x00, 0x00, 0x82, 0x84, 0x88, 0x90, 0xA0, 0xC0, 0xA0, 0x90, 0x88, 0x84, 0x82, 0x00, 0x00 }, // K
+    { 0x00, 0x00, 0x82, 0xC6, 0xAA, 0x92, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x00, 0x00 }, // M
+    { 0x00, 0x00, 0x7C, 0x82, 0x80, 0x80, 0x80, 0x9E, 0x82, 0x82, 0x82, 0x82, 0x7C, 0x00, 0x00 }, // G
+    { 0x00, 0x00, 0xFC, 0x82, 0x82, 0x82, 0xFC, 0x82, 0x82, 0x82, 0x82, 0x82, 0xFC, 0x00, 0x00 }, // B
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x7C, 0x82, 0x80, 0x7C, 0x02, 0x02, 0x82, 0x7C, 0x00, 0x00 }, // s
+    { 0x00, 0x00, 0xFE, 0x80, 0x80, 0x80, 0x80, 0xFC, 0x80, 0x80, 0x80, 0x80, 0xFE, 0x00, 0x00 }, // E
+    { 0x00, 0x00, 0xFE, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x00, 0x00 }, // T
+    { 0x00, 0x00, 0x38, 0x44, 0x82, 0x82, 0x82, 0xFE, 0x82, 0x82, 0x82, 0x82, 0x82, 0x00, 0x00 }, // A
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // -
+};
+#define ASCII_GLYPH_COUNT ((int)(sizeof(glyph_ascii_bits) / sizeof(glyph_ascii_bits[0])))
+
+// 将 ASCII 字符映射到 glyph_ascii_bits 的下标；-1 表示空白（含空格与未知字符）
+static int ascii_glyph_index(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    switch (c) {
+        case '.': return 10;
+        case '/': return 11;
+        case ':': return 12;
+        case '%': return 13;
+        case 'K': return 14;
+        case 'M': return 15;
+        case 'G': return 16;
+        case 'B': return 17;
+        case 's': return 18;
+        case 'E': return 19;
+        case 'T': return 20;
+        case 'A': return 21;
+        case '-': return 22;
+        default:  return -1;
+    }
+}
+
+// 预缩放字形图集：每个字格按 scale_x/scale_y 展开成 RGBA4444 原始像素（0 为透明）
+typedef struct {
+    s32 cell_w;
+    s32 cell_h;
+    u16 *pixels; // ASCII_GLYPH_COUNT 个字格连续存放，每格 cell_w * cell_h
+} GlyphAtlas;
+
+static bool glyph_atlas_build(GlyphAtlas *atlas, s32 scale_x, s32 scale_y, Color color) {
+    atlas->cell_w = ASCII_GLYPH_W * scale_x;
+    atlas->cell_h = GLYPH_H * scale_y;
+    size_t cell_px = (size_t)atlas->cell_w * atlas->cell_h;
+    atlas->pixels = (u16*)calloc(cell_px * ASCII_GLYPH_COUNT, sizeof(u16));
+    if (!atlas->pixels) return false;
+    u16 raw = color_to_u16(color);
+    for (int g = 0; g < ASCII_GLYPH_COUNT; ++g) {
+        u16 *cell = atlas->pixels + cell_px * g;
+        for (int row = 0; row < GLYPH_H; ++row) {
+            u16 *dst = cell + (size_t)row * scale_y * atlas->cell_w;
+            unsigned char bits = glyph_ascii_bits[g][row];
+            for (int col = 0; col < ASCII_GLYPH_W; ++col) {
+                if (!(bits & (0x80 >> col))) continue;
+                for (s32 sx = 0; sx < scale_x; ++sx) dst[col * scale_x + sx] = raw;
+            }
+            // 纵向放大：复制已展开的首行
+            for (s32 sy = 1; sy < scale_y; ++sy) {
+                memcpy(dst + (size_t)sy * atlas->cell_w, dst, (size_t)atlas->cell_w * sizeof(u16));
+            }
+        }
+    }
+    return true;
+}
+
+static inline const u16 *glyph_atlas_cell(const GlyphAtlas *atlas, int index) {
+    return atlas->pixels + (size_t)atlas->cell_w * atlas->cell_h * index;
+}
+
+#define PROGRESS_TEXT_COLS 26
+#define PROGRESS_UPDATE_INTERVAL_NS 250000000ULL // 文本最多每秒刷新 4 次
+#define PROGRESS_BAR_H 14
+
+typedef struct {
+    bool ready;
+    s32 left;
+    s32 top;
+    s32 width;
+    GlyphAtlas atlas;
+    u16 *text_pixels;                 // 文本行缓存：PROGRESS_TEXT_COLS 个字格横向拼接
+    char cells[PROGRESS_TEXT_COLS];   // 缓存中当前已光栅化的字符
+    BackupProgress snap;
+    u64 last_update_tick;
+    u64 last_sample_bytes;
+    double rate;                      // 平滑后的吞吐（字节/秒）
+} ProgressWidget;
+
+static ProgressWidget g_progressWidget;
+
+static bool progress_widget_init(ProgressWidget *w, s32 left, s32 top, s32 scale_x, s32 scale_y) {
+    memset(w, 0, sizeof(*w));
+    if (!glyph_atlas_build(&w->atlas, scale_x, scale_y, (Color){15, 15, 15, 15})) return false;
+    w->left = left;
+    w->top = top;
+    w->width = PROGRESS_TEXT_COLS * w->atlas.cell_w;
+    w->text_pixels = (u16*)calloc((size_t)w->width * w->atlas.cell_h, sizeof(u16));
+    if (!w->text_pixels) {
+        free(w->atlas.pixels);
+        w->atlas.pixels = NULL;
+        return false;
+    }
+    memset(w->cells, ' ', sizeof(w->cells));
+    w->ready = true;
+    return true;
+}
+
+// 把字节数格式化为 4 位宽度 + 单位前缀，例如 " 512" "12.3M" " 105K"（调用方再拼接 "B"）
+static void format_bytes_short(char *out, size_t n, double v) {
+    static const char units[] = { 'K', 'M', 'G' };
+    int u = -1;
+    while (v >= 1000.0 && u < 2) { v /= 1024.0; ++u; }
+    if (u < 0) snprintf(out, n, "%4.0f", v);
+    else if (v >= 100.0) snprintf(out, n, "%4.0f%c", v, units[u]);
+    else snprintf(out, n, "%4.1f%c", v, units[u]);
+}
+
+// 文件数缩写：不足 5 位原样输出，否则换成 K/M 单位（截断取整）
+static void format_count_short(char *out, size_t n, u64 v) {
+    if (v < 10000) snprintf(out, n, "%llu", (unsigned long long)v);
+    else if (v < 10000000) snprintf(out, n, "%lluK", (unsigned long long)(v / 1000));
+    else snprintf(out, n, "%lluM", (unsigned long long)(v / 1000000));
+}
+
+// 拼出 "吞吐 文件数 ETA"，保证不超过 PROGRESS_TEXT_COLS：文件数依次退化为
+// "已完成/总数" → 缩写的 "已完成/总数" → 只有缩写的已完成数，ETA 始终完整保留
+static void progress_format_text(char *out, size_t n, const char *rate_txt, u64 done, u64 total, const char *eta_txt) {
+    char done_txt[24], total_txt[24];
+    int len = snprintf(out, n, "%sB/s %llu/%llu ETA%s", rate_txt, (unsigned long long)done, (unsigned long long)total, eta_txt);
+    if (len >= 0 && len <= PROGRESS_TEXT_COLS) return;
+    format_count_short(done_txt, sizeof(done_txt), done);
+    format_count_short(total_txt, sizeof(total_txt), total);
+    len = snprintf(out, n, "%sB/s %s/%s ETA%s", rate_txt, done_txt, total_txt, eta_txt);
+    if (len >= 0 && len <= PROGRESS_TEXT_COLS) return;
+    snprintf(out, n, "%sB/s %s ETA%s", rate_txt, done_txt, eta_txt);
+}
+
+// 只重绘与上次不同的字格
+static void progress_widget_set_text(ProgressWidget *w, const char *text) {
+    size_t len = strlen(text);
+    s32 cw = w->atlas.cell_w;
+    s32 ch = w->atlas.cell_h;
+    for (int i = 0; i < PROGRESS_TEXT_COLS; ++i) {
+        char c = (size_t)i < len ? text[i] : ' ';
+        if (c == w->cells[i]) continue;
+        w->cells[i] = c;
+        int g = ascii_glyph_index(c);
+        const u16 *src = g >= 0 ? glyph_atlas_cell(&w->atlas, g) : NULL;
+        for (s32 row = 0; row < ch; ++row) {
+            u16 *dst = w->text_pixels + (size_t)row * w->width + (size_t)i * cw;
+            if (src) memcpy(dst, src + (size_t)row * cw, (size_t)cw * sizeof(u16));
+            else memset(dst, 0, (size_t)cw * sizeof(u16));
+        }
+    }
+}
+
+// 读取进度计数器（无锁）并按节流间隔刷新文本
+static void progress_widget_update(ProgressWidget *w) {
+    if (!w->ready) return;
+    u64 now = armGetSystemTick();
+    u64 elapsed_ns = armTicksToNs(now - w->last_update_tick);
+    if (w->last_update_tick != 0 && elapsed_ns < PROGRESS_UPDATE_INTERVAL_NS) return;
+
+    u64 prev_start = w->snap.start_tick;
+    progress_snapshot(&w->snap);
+    if (w->snap.start_tick != prev_start) {
+        // 新一轮备份：重置速率采样
+        w->last_sample_bytes = 0;
+        w->rate = 0;
+        elapsed_ns = 0;
+    }
+    if (elapsed_ns > 0 && w->last_update_tick != 0) {
+        double inst = (double)(w->snap.bytes_done - w->last_sample_bytes) * 1e9 / (double)elapsed_ns;
+        w->rate = (w->rate <= 0) ? inst : (w->rate * 0.7 + inst * 0.3);
+    }
+    w->last_sample_bytes = w->snap.bytes_done;
+    w->last_update_tick = now;
+
+    char rate_txt[16];
+    format_bytes_short(rate_txt, sizeof(rate_txt), w->rate);
+    char eta_txt[8] = "--:--";
+    if (w->snap.state == BackupState_Running && w->rate >= 1.0 && w->snap.bytes_total > w->snap.bytes_done) {
+        u64 eta = (u64)((double)(w->snap.bytes_total - w->snap.bytes_done) / w->rate);
+        if (eta > 99 * 60 + 59) eta = 99 * 60 + 59;
+        snprintf(eta_txt, sizeof(eta_txt), "%02u:%02u", (unsigned)(eta / 60), (unsigned)(eta % 60));
+    } else if (w->snap.state == BackupState_Succeeded) {
+        snprintf(eta_txt, sizeof(eta_txt), "00:00");
+    }
+    char text[PROGRESS_TEXT_COLS * 2];
+    progress_format_text(text, sizeof(text), rate_txt, w->snap.files_done, w->snap.files_total, eta_txt);
+    progress_widget_set_text(w, text);
+}
+
+static void progress_widget_draw(const ProgressWidget *w) {
+    if (!w->ready || !g_currentFramebuffer || w->snap.state == BackupState_Idle) return;
+
+    // 进度条：边框 + 按字节（未知总量时按文件数）填充
+    Color frame = {15, 15, 15, 15};
+    Color track = {1, 2, 4, 15};
+    Color fill = (w->snap.state == BackupState_Failed) ? (Color){14, 2, 1, 15} : (Color){2, 12, 3, 15};
+    s32 inner_w = w->width - 4;
+    u64 done = w->snap.bytes_total ? w->snap.bytes_done : w->snap.files_done;
+    u64 total = w->snap.bytes_total ? w->snap.bytes_total : w->snap.files_total;
+    s32 fill_w = total ? (s32)((double)inner_w * (double)done / (double)total) : 0;
+    if (w->snap.state == BackupState_Succeeded) fill_w = inner_w;
+    drawRectSolid(w->left, w->top, w->width, PROGRESS_BAR_H, frame);
+    drawRectSolid(w->left + 2, w->top + 2, inner_w, PROGRESS_BAR_H - 4, track);
+    drawRectSolid(w->left + 2, w->top + 2, fill_w, PROGRESS_BAR_H - 4, fill);
+
+    // 文本：从缓存逐行拷贝非透明像素
+    s32 text_top = w->top + PROGRESS_BAR_H + 4;
+    for (s32 row = 0; row < w->atlas.cell_h; ++row) {
+        const u16 *src = w->text_pixels + (size_t)row * w->width;
+        for (s32 col = 0; col < w->width; ++col) {
+            if (src[col]) setPixelRaw(w->left + col, text_top + row, src[col]);
+        }
+    }
+}
+
 // 马里奥点阵图（基于 mariobros-clock-main 的专业实现）
 // RGB565 颜色定义（转换为 RGBA4444）
 #define RGB565_TO_R4(c) ((((c) >> 11) & 0x1F) >> 1)
@@ -778,7 +1211,7 @@ static __attribute__((unused)) void draw_text_bold_outline(const char *text, s32
 #define M_SHOES  0xC300  // 鞋子（深红/棕色）
 #define M_SHIRT  0xFFFF  // 衬衫（白色）
 #define M_HAIR   0x0000  // 头发（黑色）
-#define M_MASK   0x000E  // 透明色（天空色，不绘制）
+#define M_MASK   BLIT_RGB565_KEY // 透明色（天空色，不绘制）
 
 // RGB565 转 Color 结构
 static inline Color rgb565_to_color(u16 rgb565) {
@@ -835,20 +1268,25 @@ static const u16 MARIO_JUMP[] = {
 #define MARIO_JUMP_H 16
 
 // 绘制 RGB565 点阵图（支持透明色，支持独立横纵缩放）
+// 由 util/blit 按缩放比例特化的 blitter 写入，超出展开缓冲的超宽精灵退回逐像素矩形路径
 static void draw_rgb565_bitmap_scaled(s32 x, s32 y, const u16 *bitmap, s32 width, s32 height, s32 scale_x, s32 scale_y) {
-    if (!g_currentFramebuffer || !bitmap) return;
-    
-    for (s32 row = 0; row < height; row++) {
-        for (s32 col = 0; col < width; col++) {
-            u16 pixel = bitmap[row * width + col];
-            // 跳过透明色（与 mariobros-clock-main 的 _MASK 一致）
-            if (pixel == M_MASK) continue;
-            
-            Color color = rgb565_to_color(pixel);
-            // 使用实心绘制，避免半透明混合导致的失真/边缘发灰
-            drawRectSolid(x + col * scale_x, y + row * scale_y, scale_x, scale_y, color);
+    if (!g_currentFramebuffer || !bitmap || scale_x <= 0 || scale_y <= 0) return;
+
+    if (!blit_span_fits(width, scale_x)) {
+        for (s32 row = 0; row < height; row++) {
+            for (s32 col = 0; col < width; col++) {
+                u16 pixel = bitmap[row * width + col];
+                // 跳过透明色（与 mariobros-clock-main 的 _MASK 一致）
+                if (pixel == M_MASK) continue;
+                // 使用实心绘制，避免半透明混合导致的失真/边缘发灰
+                drawRectSolid(x + col * scale_x, y + row * scale_y, scale_x, scale_y, rgb565_to_color(pixel));
+            }
         }
+        return;
     }
+
+    BlitTarget target = frame_target();
+    g_framePixels += blit_rgb565_scaled(&target, x, y, bitmap, width, height, scale_x, scale_y);
 }
 
 // 绘制 RGB565 点阵图（等比例缩放，兼容旧调用）
@@ -856,6 +1294,64 @@ static void draw_rgb565_bitmap(s32 x, s32 y, const u16 *bitmap, s32 width, s32 h
     draw_rgb565_bitmap_scaled(x, y, bitmap, width, height, scale, scale);
 }
 
+// 绘制资源包精灵（RGBA4444 + 不透明段，支持独立横纵缩放）
+// 透明像素不在数据中，只需展开各段；写出方式与 RGB565 路径相同
+static void draw_sprite4444_scaled(s32 x, s32 y, const AssetSprite *sprite, s32 scale_x, s32 scale_y) {
+    if (!g_currentFramebuffer || !sprite || scale_x <= 0 || scale_y <= 0) return;
+    s32 x0 = x, y0 = y;
+    s32 x1 = x + sprite->width * scale_x;
+    s32 y1 = y + sprite->height * scale_y;
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > (s32)CFG_FramebufferWidth) x1 = CFG_FramebufferWidth;
+    if (y1 > (s32)CFG_FramebufferHeight) y1 = CFG_FramebufferHeight;
+    if (x0 >= x1 || y0 >= y1) return;
+
+    const AssetRun *runs = sprite->runs;
+    const u16 *px = sprite->pixels;
+    if (!blit_span_fits(sprite->width, scale_x)) {
+        // 超宽精灵：逐像素写入
+        for (u32 r = 0; r < sprite->run_count; px += runs[r].len, ++r) {
+            for (u16 k = 0; k < runs[r].len; ++k) {
+                s32 left = x + (runs[r].x + k) * scale_x, top = y + runs[r].y * scale_y;
+                for (s32 dy = top; dy < top + scale_y; ++dy)
+                    for (s32 dx = left; dx < left + scale_x; ++dx) setPixelRaw(dx, dy, px[k]);
+            }
+        }
+        return;
+    }
+
+    s32 gx0 = x0 & ~7;
+    s32 gx1 = (x1 + 7) & ~7;
+    u16 span[BLIT_SPAN_MAX];
+    u8 opaque[BLIT_SPAN_MAX / 8];
+    BlitTarget target = frame_target();
+    u32 r = 0;
+    while (r < sprite->run_count) {
+        s32 row = runs[r].y;
+        s32 dy0 = y + row * scale_y;
+        s32 dy1 = dy0 + scale_y;
+        if (dy0 >= y1) break;
+        if (dy0 < y0) dy0 = y0;
+        bool visible = dy0 < dy1;
+        if (visible) memset(opaque, 0, (size_t)((gx1 - gx0) >> 3));
+        for (; r < sprite->run_count && runs[r].y == row; px += runs[r].len, ++r) {
+            if (!visible) continue;
+            s32 dx = x + runs[r].x * scale_x;
+            for (u16 k = 0; k < runs[r].len; ++k) {
+                u16 raw = px[k];
+                for (s32 sx = 0; sx < scale_x; ++sx, ++dx) {
+                    if (dx < x0 || dx >= x1) continue;
+                    s32 i = dx - gx0;
+                    span[i] = raw;
+                    opaque[i >> 3] |= (u8)(1u << (i & 7));
+                }
+            }
+        }
+        if (visible) g_framePixels += blit_span_rows(&target, span, opaque, gx0, gx1, dy0, dy1);
+    }
+}
+
 // 复用 mariobros-clock-main 的场景素材（重命名为 SCN_* 以避免命名冲突）
 // CLOUD1 从 mariobros-clock-main 精确复制（13列×12行=156，行主序）
 static const u16 SCN_CLOUD1[156] = {
@@ -953,57 +1449,134 @@ static const u16 SCN_HILL[440] = {
 #define SCN_HILL_W 20
 #define SCN_HILL_H 22
 
+// 场景精灵：默认使用编译进程序的 RGB565 素材；SD 卡上有主题资源包时改用包内同名精灵
+typedef enum {
+    SceneSprite_MarioIdle = 0,
+    SceneSprite_MarioJump,
+    SceneSprite_Cloud1,
+    SceneSprite_Cloud2,
+    SceneSprite_Bush,
+    SceneSprite_Ground,
+    SceneSprite_Hill,
+    SceneSprite_Count,
+} SceneSpriteId;
+
+typedef struct {
+    const char *name;           // 资源包中的名字
+    const u16 *builtin;         // 内置 RGB565 素材
+    s32 width;
+    s32 height;
+    const AssetSprite *themed;  // 资源包中的精灵（未加载时为 NULL）
+} SceneSprite;
+
+static SceneSprite g_sceneSprites[SceneSprite_Count] = {
+    [SceneSprite_MarioIdle] = { "mario_idle", MARIO_IDLE, MARIO_IDLE_W, MARIO_IDLE_H, NULL },
+    [SceneSprite_MarioJump] = { "mario_jump", MARIO_JUMP, MARIO_JUMP_W, MARIO_JUMP_H, NULL },
+    [SceneSprite_Cloud1]    = { "cloud1",     SCN_CLOUD1, SCN_CLOUD_W,  SCN_CLOUD_H,  NULL },
+    [SceneSprite_Cloud2]    = { "cloud2",     SCN_CLOUD2, SCN_CLOUD_W,  SCN_CLOUD_H,  NULL },
+    [SceneSprite_Bush]      = { "bush",       SCN_BUSH,   SCN_BUSH_W,   SCN_BUSH_H,   NULL },
+    [SceneSprite_Ground]    = { "ground",     SCN_GROUND, SCN_GROUND_W, SCN_GROUND_H, NULL },
+    [SceneSprite_Hill]      = { "hill",       SCN_HILL,   SCN_HILL_W,   SCN_HILL_H,   NULL },
+};
+
+static AssetArena g_assetArena;
+static AssetSet g_assetSet;
+
+// 只读取场景引用到的资源；资源包缺失或损坏时保持内置素材
+static void scene_load_theme(const char *path) {
+    const char *names[SceneSprite_Count];
+    for (int i = 0; i < SceneSprite_Count; ++i) names[i] = g_sceneSprites[i].name;
+    // arena 按索引中被引用资源的大小申请
+    Result rc = assetpack_load_scene(path, &g_assetArena, names, SceneSprite_Count, &g_assetSet);
+    if (R_FAILED(rc)) {
+        if (rc != MAKERESULT(Module_Libnx, LibnxError_NotFound)) log_error("主题资源包加载失败: 0x%x", rc);
+        return;
+    }
+    for (int i = 0; i < SceneSprite_Count; ++i) {
+        const AssetSprite *sp = assetset_find(&g_assetSet, g_sceneSprites[i].name);
+        if (!sp) continue;
+        g_sceneSprites[i].themed = sp;
+        g_sceneSprites[i].width = sp->width;
+        g_sceneSprites[i].height = sp->height;
+    }
+    log_info("主题资源包已加载：%u 个精灵，%u 字节常驻", g_assetSet.count, (unsigned)g_assetArena.used);
+}
+
+static void draw_scene_sprite(SceneSpriteId id, s32 x, s32 y, s32 scale_x, s32 scale_y) {
+    const SceneSprite *sp = &g_sceneSprites[id];
+    if (sp->themed) draw_sprite4444_scaled(x, y, sp->themed, scale_x, scale_y);
+    else draw_rgb565_bitmap_scaled(x, y, sp->builtin, sp->width, sp->height, scale_x, scale_y);
+}
+
+#define SCENE_W(id) (g_sceneSprites[id].width)
+#define SCENE_H(id) (g_sceneSprites[id].height)
+
 static void draw_scene_mariobros(void) {
     // 天空底色改为半透明蓝色
     Color semi_blue = {3, 6, 12, 8}; // 半透明蓝色（alpha=8，约50%透明度）
     fillScreenSolid(semi_blue);
 
     // 地面平铺（稍微下移）
-    s32 tile_scale = 6; // 地面砖块扩大2倍（原3→6）
+    s32 tile_scale = g_config.tile_scale; // 地面砖块扩大2倍（原3→6）
     s32 ground_offset = 60; // 砖块上移量减少（从80→60，相当于下移20）
-    s32 ground_y = (s32)CFG_FramebufferHeight - (SCN_GROUND_H * tile_scale) - ground_offset;
-    for (s32 x = 0; x < (s32)CFG_FramebufferWidth; x += SCN_GROUND_W * tile_scale) {
-        draw_rgb565_bitmap(x, ground_y, SCN_GROUND, SCN_GROUND_W, SCN_GROUND_H, tile_scale);
+    s32 ground_y = (s32)CFG_FramebufferHeight - (SCENE_H(SceneSprite_Ground) * tile_scale) - ground_offset;
+    s32 ground_step = SCENE_W(SceneSprite_Ground) * tile_scale;
+    if (ground_step <= 0) ground_step = (s32)CFG_FramebufferWidth; // 防御：步进为 0 时只画一块
+    for (s32 x = 0; x < (s32)CFG_FramebufferWidth; x += ground_step) {
+        draw_scene_sprite(SceneSprite_Ground, x, ground_y, tile_scale, tile_scale);
     }
 
     // 小山与灌木（放大并纵向拉伸）
-    s32 hill_scale_x = 6; // 小山横向6倍
-    s32 hill_scale_y = 8; // 小山纵向8倍（拉伸）
+    s32 hill_scale_x = g_config.hill_scale_x; // 小山横向6倍
+    s32 hill_scale_y = g_config.hill_scale_y; // 小山纵向8倍（拉伸）
     s32 hill_left = -10; // 小山左移
-    s32 hill_top = ground_y - (SCN_HILL_H * hill_scale_y);
+    s32 hill_top = ground_y - (SCENE_H(SceneSprite_Hill) * hill_scale_y);
     if (hill_top < 0) hill_top = 0; // 防止越界到可视区域之外
-    draw_rgb565_bitmap_scaled(hill_left, hill_top, SCN_HILL, SCN_HILL_W, SCN_HILL_H, hill_scale_x, hill_scale_y);
+    draw_scene_sprite(SceneSprite_Hill, hill_left, hill_top, hill_scale_x, hill_scale_y);
 
-    s32 bush_scale_x = 6; // 灌木横向6倍
-    s32 bush_scale_y = 8; // 灌木纵向8倍（拉伸）
-    s32 bush_left = (s32)CFG_FramebufferWidth - (SCN_BUSH_W * bush_scale_x) + 10; // 灌木右移
-    s32 bush_top = ground_y - (SCN_BUSH_H * bush_scale_y) + 2;
-    draw_rgb565_bitmap_scaled(bush_left, bush_top, SCN_BUSH, SCN_BUSH_W, SCN_BUSH_H, bush_scale_x, bush_scale_y);
+    s32 bush_scale_x = g_config.hill_scale_x; // 灌木横向6倍
+    s32 bush_scale_y = g_config.hill_scale_y; // 灌木纵向8倍（拉伸）
+    s32 bush_left = (s32)CFG_FramebufferWidth - (SCENE_W(SceneSprite_Bush) * bush_scale_x) + 10; // 灌木右移
+    s32 bush_top = ground_y - (SCENE_H(SceneSprite_Bush) * bush_scale_y) + 2;
+    draw_scene_sprite(SceneSprite_Bush, bush_left, bush_top, bush_scale_x, bush_scale_y);
 
     // 云朵（放大并下移）
-    s32 cloud_scale = 6; // 云朵扩大到6倍（从5→6）
+    s32 cloud_scale = g_config.cloud_scale; // 云朵扩大到6倍（从5→6）
     s32 cloud_down = 70; // 云朵整体下移更多（从60→70）
-    s32 cloud_h = SCN_CLOUD_H * cloud_scale;
+    s32 cloud_h = SCENE_H(SceneSprite_Cloud1) * cloud_scale;
     s32 cloud_max_top = ground_y - cloud_h - 10; if (cloud_max_top < 0) cloud_max_top = 0;
     s32 c1_top = 30 + cloud_down; if (c1_top > cloud_max_top) c1_top = cloud_max_top;
     s32 c2_top = 50 + cloud_down; if (c2_top > cloud_max_top) c2_top = cloud_max_top;
     s32 c3_top = 40 + cloud_down; if (c3_top > cloud_max_top) c3_top = cloud_max_top;
-    draw_rgb565_bitmap(30, c1_top, SCN_CLOUD1, SCN_CLOUD_W, SCN_CLOUD_H, cloud_scale);
-    draw_rgb565_bitmap(180, c2_top, SCN_CLOUD2, SCN_CLOUD_W, SCN_CLOUD_H, cloud_scale);
-    draw_rgb565_bitmap((s32)CFG_FramebufferWidth - 30 - SCN_CLOUD_W*cloud_scale, c3_top, SCN_CLOUD1, SCN_CLOUD_W, SCN_CLOUD_H, cloud_scale);
+    draw_scene_sprite(SceneSprite_Cloud1, 30, c1_top, cloud_scale, cloud_scale);
+    draw_scene_sprite(SceneSprite_Cloud2, 180, c2_top, cloud_scale, cloud_scale);
+    draw_scene_sprite(SceneSprite_Cloud1, (s32)CFG_FramebufferWidth - 30 - SCENE_W(SceneSprite_Cloud1)*cloud_scale, c3_top, cloud_scale, cloud_scale);
 }
 
 // 绘制马里奥（居中，可选状态）
 static void draw_mario_bitmap(s32 cx, s32 cy, s32 scale, bool jumping) {
-    if (jumping) {
-        s32 left = cx - (MARIO_JUMP_W * scale) / 2;
-        s32 top = cy - (MARIO_JUMP_H * scale) / 2;
-        draw_rgb565_bitmap(left, top, MARIO_JUMP, MARIO_JUMP_W, MARIO_JUMP_H, scale);
-    } else {
-        s32 left = cx - (MARIO_IDLE_W * scale) / 2;
-        s32 top = cy - (MARIO_IDLE_H * scale) / 2;
-        draw_rgb565_bitmap(left, top, MARIO_IDLE, MARIO_IDLE_W, MARIO_IDLE_H, scale);
+    SceneSpriteId id = jumping ? SceneSprite_MarioJump : SceneSprite_MarioIdle;
+    s32 left = cx - (SCENE_W(id) * scale) / 2;
+    s32 top = cy - (SCENE_H(id) * scale) / 2;
+    draw_scene_sprite(id, left, top, scale, scale);
+}
+
+// 配置文件变化时重新加载：帧率与缩放立即生效，分辨率/图层/缓冲数需要重启后生效
+static void config_reload_if_changed(void) {
+    if (!config_watch_poll(&g_configWatch)) return;
+    AppConfig next;
+    config_load(&next, CONFIG_FILE_PATH);
+    if (next.framebuffer_width != g_config.framebuffer_width || next.framebuffer_height != g_config.framebuffer_height ||
+        next.layer_fraction != g_config.layer_fraction || next.buffer_count != g_config.buffer_count) {
+        log_info("配置已变化：分辨率/图层/缓冲数将在下次启动时生效");
+        next.framebuffer_width = g_config.framebuffer_width;
+        next.framebuffer_height = g_config.framebuffer_height;
+        next.layer_fraction = g_config.layer_fraction;
+        next.buffer_count = g_config.buffer_count;
     }
+    g_config = next;
+    backup_update_config(&g_config);
+    log_info("配置已重新加载：帧间隔 %u ms", g_config.frame_ms);
 }
 
 // 移除未使用的声明以消除编译警告
@@ -1013,7 +1586,26 @@ int main(int argc, char *argv[])
 {
     log_info("后台程序启动（移植 tesla 绘制逻辑）");
 
-    Result rc = gfx_init();
+    Result rc = threading_apply_current(ThreadRole_Render);
+    if (R_FAILED(rc)) log_error("主线程调度策略设置失败: 0x%x", rc);
+    u32 t = trace_begin("config");
+    bool have_config = config_load(&g_config, CONFIG_FILE_PATH);
+    config_watch_init(&g_configWatch, CONFIG_FILE_PATH);
+    fspool_configure(g_config.fs_sessions);
+    trace_end(t, 0);
+    if (!have_config) log_info("未找到 %s，使用默认配置", CONFIG_FILE_PATH);
+    metrics_set(Metric_HeapSize, INNER_HEAP_SIZE);
+    rc = metrics_start(&g_config);
+    if (R_FAILED(rc)) log_error("指标导出线程启动失败: 0x%x", rc);
+    CFG_FramebufferWidth = g_config.framebuffer_width;
+    CFG_FramebufferHeight = g_config.framebuffer_height;
+
+    t = trace_begin("assets");
+    scene_load_theme(ASSETPACK_FILE_PATH);
+    trace_end(t, 0);
+
+    rc = gfx_init();
+    trace_log_summary("启动耗时");
     if (R_SUCCEEDED(rc)) {
         // 字体初始化已移除，不再加载共享字体或绘制文本
         log_info("开始首帧绘制：framebufferBegin...");
@@ -1022,32 +1614,42 @@ int main(int argc, char *argv[])
         // 绘制 mariobros 风格场景
         draw_scene_mariobros();
         // 初始马里奥位置与比例
-        s32 mario_scale = 5;
+        s32 mario_scale = g_config.mario_scale;
         s32 tile_scale = 3;
-        s32 ground_y = (s32)CFG_FramebufferHeight - (SCN_GROUND_H * tile_scale);
+        s32 ground_y = (s32)CFG_FramebufferHeight - (SCENE_H(SceneSprite_Ground) * tile_scale);
         // 从左侧入场
         s32 mario_x0 = 30;
         s32 mario_bottom0 = ground_y;
-        s32 mario_top0 = mario_bottom0 - (MARIO_IDLE_H * mario_scale);
-        draw_mario_bitmap(mario_x0, mario_top0 + (MARIO_IDLE_H * mario_scale)/2, mario_scale, false);
+        s32 mario_top0 = mario_bottom0 - (SCENE_H(SceneSprite_MarioIdle) * mario_scale);
+        draw_mario_bitmap(mario_x0, mario_top0 + (SCENE_H(SceneSprite_MarioIdle) * mario_scale)/2, mario_scale, false);
         log_info("提交首帧：framebufferEnd...");
         endFrame();
 
+        // 备份进度控件：放在标题文字下方，字格 2x2 缩放（16x30）
+        s32 widget_left = ((s32)CFG_FramebufferWidth - PROGRESS_TEXT_COLS * ASCII_GLYPH_W * 2) / 2;
+        if (!progress_widget_init(&g_progressWidget, widget_left, 390, 2, 2)) {
+            log_error("进度控件初始化失败（内存不足）");
+        }
+
         // 保持图层与帧缓冲不释放，持续显示马里奥图案
     } else {
         log_error("图形初始化失败: 0x%x", rc);
     }
 
+    // 后台备份：配置了 ftp_url 才启动，与渲染线程互不阻塞
+    rc = backup_start(&g_config);
+    if (R_FAILED(rc)) log_error("备份线程启动失败: 0x%x", rc);
+
 	// 动画循环：两帧（静止/跳跃顶点）
     u32 frame_index = 0;
     while (true) {
         startFrame();
         // 完整场景：mariobros 风格 + 马里奥动作（行走+周期跳跃）
         draw_scene_mariobros();
-        static s32 mario_scale = 5;
+        s32 mario_scale = g_config.mario_scale;
         static s32 tile_scale = 3;
         static s32 ground_y = 0;
-        if (ground_y == 0) ground_y = (s32)CFG_FramebufferHeight - (SCN_GROUND_H * tile_scale) - 60; // 同步砖块上移
+        if (ground_y == 0) ground_y = (s32)CFG_FramebufferHeight - (SCENE_H(SceneSprite_Ground) * tile_scale) - 60; // 同步砖块上移
         static s32 mario_x = 30;
         static s32 mario_bottom = 0;
         static s32 vy = 0;
@@ -1072,15 +1674,18 @@ int main(int argc, char *argv[])
             }
         }
         // 计算绘制用中心Y（把 bottom 转为中心），整体上移 50 像素
-        s32 sprite_h = jumping ? MARIO_JUMP_H : MARIO_IDLE_H;
+        s32 sprite_h = SCENE_H(jumping ? SceneSprite_MarioJump : SceneSprite_MarioIdle);
         s32 cy2 = mario_bottom - (sprite_h * mario_scale)/2 - 50;
         draw_mario_bitmap(mario_x, cy2 + (sprite_h * mario_scale)/2, mario_scale, jumping);
         
-        // 在窗口上半部分显示"正在备份"（居中，纵向拉伸，上移）
+        // 在窗口上半部分显示备份状态（居中，纵向拉伸，上移）
+        progress_widget_update(&g_progressWidget);
         {
             const char *text = "正在备份";
-            s32 text_scale_x = 5; // 横向5倍
-            s32 text_scale_y = 7; // 纵向7倍（拉伸）
+            if (g_progressWidget.snap.state == BackupState_Succeeded) text = "备份成功";
+            else if (g_progressWidget.snap.state == BackupState_Failed) text = "备份失败";
+            s32 text_scale_x = g_config.text_scale_x; // 横向5倍
+            s32 text_scale_y = g_config.text_scale_y; // 纵向7倍（拉伸）
             s32 letter_spacing = 1;
             s32 text_height = GLYPH_H * text_scale_y;
             // 上移：减少基准高度，下移1.5倍文字高度
@@ -1089,10 +1694,12 @@ int main(int argc, char *argv[])
             s32 text_left = ((s32)CFG_FramebufferWidth - text_width) / 2;
             draw_text_bold_outline_scaled(text, text_left, text_top, text_scale_x, text_scale_y, letter_spacing);
         }
+        progress_widget_draw(&g_progressWidget);
         
         endFrame();
         frame_index++;
-        svcSleepThread(60000000ULL); // 60ms per frame ≈ 16.7 fps（更快）
+        config_reload_if_changed();
+        svcSleepThread((s64)config_frame_period_ns(&g_config)); // 默认 60ms 一帧
     }
 
     gfx_exit();
@@ -0,0 +1,179 @@
+#include "assetpack.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ASSETPACK_ERR(desc) MAKERESULT(Module_Libnx, desc)
+
+bool asset_arena_init(AssetArena *arena, size_t size) {
+    arena->base = (u8*)malloc(size);
+    arena->size = arena->base ? size : 0;
+    arena->used = 0;
+    return arena->base != NULL;
+}
+
+void asset_arena_reset(AssetArena *arena) {
+    arena->used = 0;
+}
+
+void asset_arena_free(AssetArena *arena) {
+    free(arena->base);
+    arena->base = NULL;
+    arena->size = 0;
+    arena->used = 0;
+}
+
+void *asset_arena_alloc(AssetArena *arena, size_t size) {
+    size_t start = (arena->used + 15) & ~(size_t)15;
+    if (!arena->base || start + size > arena->size) return NULL;
+    arena->used = start + size;
+    return arena->base + start;
+}
+
+// 校验单个资源：段在图像范围内、按 (y, x) 有序、像素总数与数据大小一致
+static bool assetpack_bind_sprite(const AssetPackEntry *e, const u8 *data, AssetSprite *out) {
+    // 宽或高为 0 的精灵没有意义，按它平铺时步进为 0
+    if (e->width == 0 || e->height == 0) return false;
+    if ((u64)e->run_count * sizeof(AssetRun) > e->size) return false;
+    const AssetRun *runs = (const AssetRun*)data;
+    u32 pixels = 0;
+    u32 prev = 0;
+    for (u32 i = 0; i < e->run_count; ++i) {
+        const AssetRun *r = &runs[i];
+        if (r->len == 0 || r->y >= e->height || (u32)r->x + r->len > e->width) return false;
+        u32 key = ((u32)r->y << 16) | r->x;
+        if (i > 0 && key < prev) return false;
+        prev = key;
+        pixels += r->len;
+    }
+    if (assetpack_data_size(e->run_count, pixels) != e->size) return false;
+    memcpy(out->name, e->name, ASSETPACK_NAME_MAX);
+    out->name[ASSETPACK_NAME_MAX - 1] = '\0';
+    out->width = e->width;
+    out->height = e->height;
+    out->run_count = e->run_count;
+    out->runs = runs;
+    out->pixels = (const u16*)(data + e->run_count * sizeof(AssetRun));
+    return true;
+}
+
+static Result assetpack_read_index(FILE *f, AssetPackHeader *hdr, AssetPackEntry *entries) {
+    if (fread(hdr, sizeof(*hdr), 1, f) != 1) return ASSETPACK_ERR(LibnxError_IoError);
+    if (hdr->magic != ASSETPACK_MAGIC || hdr->version != ASSETPACK_VERSION) return ASSETPACK_ERR(LibnxError_BadInput);
+    if (hdr->count > ASSETPACK_MAX_SPRITES || hdr->index_offset < sizeof(*hdr)) return ASSETPACK_ERR(LibnxError_BadInput);
+    if (hdr->index_offset != sizeof(*hdr) && fseek(f, hdr->index_offset, SEEK_SET) != 0) return ASSETPACK_ERR(LibnxError_IoError);
+    if (hdr->count && fread(entries, sizeof(AssetPackEntry), hdr->count, f) != hdr->count) return ASSETPACK_ERR(LibnxError_IoError);
+    u64 data_start = (u64)hdr->index_offset + (u64)hdr->count * sizeof(AssetPackEntry);
+    for (u32 i = 0; i < hdr->count; ++i) {
+        const AssetPackEntry *e = &entries[i];
+        if (e->offset < data_start || (u64)e->offset + e->size > data_start + hdr->data_size || (e->offset & 7)) {
+            return ASSETPACK_ERR(LibnxError_BadInput);
+        }
+    }
+    return 0;
+}
+
+Result assetpack_load_all(const char *path, AssetArena *arena, AssetSet *out) {
+    out->count = 0;
+    FILE *f = fopen(path, "rb");
+    if (!f) return ASSETPACK_ERR(LibnxError_NotFound);
+    fseek(f, 0, SEEK_END);
+    long file_size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (file_size < (long)sizeof(AssetPackHeader)) {
+        fclose(f);
+        return ASSETPACK_ERR(LibnxError_BadInput);
+    }
+    size_t mark = arena->used;
+    u8 *file = (u8*)asset_arena_alloc(arena, (size_t)file_size);
+    if (!file) {
+        fclose(f);
+        return ASSETPACK_ERR(LibnxError_OutOfMemory);
+    }
+    size_t got = fread(file, 1, (size_t)file_size, f);
+    fclose(f);
+
+    const AssetPackHeader *hdr = (const AssetPackHeader*)file;
+    Result rc = 0;
+    if (got != (size_t)file_size) rc = ASSETPACK_ERR(LibnxError_IoError);
+    else if (hdr->magic != ASSETPACK_MAGIC || hdr->version != ASSETPACK_VERSION || hdr->count > ASSETPACK_MAX_SPRITES ||
+             (u64)hdr->index_offset + (u64)hdr->count * sizeof(AssetPackEntry) + hdr->data_size > (u64)file_size) {
+        rc = ASSETPACK_ERR(LibnxError_BadInput);
+    }
+    for (u32 i = 0; R_SUCCEEDED(rc) && i < hdr->count; ++i) {
+        const AssetPackEntry *e = (const AssetPackEntry*)(file + hdr->index_offset) + i;
+        if ((u64)e->offset + e->size > (u64)file_size || (e->offset & 7) ||
+            !assetpack_bind_sprite(e, file + e->offset, &out->sprites[out->count])) {
+            rc = ASSETPACK_ERR(LibnxError_BadInput);
+            break;
+        }
+        out->count++;
+    }
+    if (R_FAILED(rc)) {
+        arena->used = mark;
+        out->count = 0;
+    }
+    return rc;
+}
+
+static bool assetpack_name_wanted(const AssetPackEntry *e, const char *const *names, u32 name_count) {
+    for (u32 n = 0; n < name_count; ++n) {
+        if (strncmp(e->name, names[n], ASSETPACK_NAME_MAX) == 0) return true;
+    }
+    return false;
+}
+
+Result assetpack_load_scene(const char *path, AssetArena *arena, const char *const *names, u32 name_count, AssetSet *out) {
+    out->count = 0;
+    FILE *f = fopen(path, "rb");
+    if (!f) return ASSETPACK_ERR(LibnxError_NotFound);
+
+    AssetPackHeader hdr;
+    AssetPackEntry entries[ASSETPACK_MAX_SPRITES];
+    Result rc = assetpack_read_index(f, &hdr, entries);
+    bool owns_arena = false;
+    if (R_SUCCEEDED(rc) && !arena->base) {
+        // 按被引用资源的大小之和（每块含 16 字节对齐余量）申请，不为包中其余资源留空间
+        size_t need = 0;
+        for (u32 i = 0; i < hdr.count; ++i) {
+            if (assetpack_name_wanted(&entries[i], names, name_count)) need += entries[i].size + 15;
+        }
+        if (need == 0) {
+            fclose(f);
+            return 0;
+        }
+        if (!asset_arena_init(arena, need)) rc = ASSETPACK_ERR(LibnxError_OutOfMemory);
+        owns_arena = R_SUCCEEDED(rc);
+    }
+    size_t mark = arena->used;
+    // 索引按偏移递增排列，顺序读取被引用的资源即可保持 SD 读取基本连续
+    for (u32 i = 0; R_SUCCEEDED(rc) && i < hdr.count; ++i) {
+        const AssetPackEntry *e = &entries[i];
+        if (!assetpack_name_wanted(e, names, name_count)) continue;
+        u8 *data = (u8*)asset_arena_alloc(arena, e->size);
+        if (!data) { rc = ASSETPACK_ERR(LibnxError_OutOfMemory); break; }
+        if (fseek(f, e->offset, SEEK_SET) != 0 || fread(data, 1, e->size, f) != e->size) {
+            rc = ASSETPACK_ERR(LibnxError_IoError);
+            break;
+        }
+        if (!assetpack_bind_sprite(e, data, &out->sprites[out->count])) {
+            rc = ASSETPACK_ERR(LibnxError_BadInput);
+            break;
+        }
+        out->count++;
+    }
+    fclose(f);
+    if (R_FAILED(rc)) {
+        if (owns_arena) asset_arena_free(arena);
+        else arena->used = mark;
+        out->count = 0;
+    }
+    return rc;
+}
+
+const AssetSprite *assetset_find(const AssetSet *set, const char *name) {
+    for (u32 i = 0; i < set->count; ++i) {
+        if (strncmp(set->sprites[i].name, name, ASSETPACK_NAME_MAX) == 0) return &set->sprites[i];
+    }
+    return NULL;
+}
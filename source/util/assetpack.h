@@ -0,0 +1,79 @@
+#pragma once
+// 主题资源包：单文件打包的预转换精灵（RGBA4444 + 不透明像素段）
+//
+// 文件布局（小端）：
+//   AssetPackHeader
+//   AssetPackEntry[count]          索引，按数据偏移递增排列
+//   每个资源：AssetRun[run_count] + u16 pixels[Σlen]，按 8 字节对齐
+// 段按 (y, x) 排序，像素按段的顺序连续存放；透明像素不占空间
+#include "platform.h"
+
+#define ASSETPACK_MAGIC 0x4B41504D // "MPAK"
+#define ASSETPACK_VERSION 1
+#define ASSETPACK_NAME_MAX 16
+#define ASSETPACK_MAX_SPRITES 32
+#define ASSETPACK_FILE_PATH "/config/mario-pop/assets.pak"
+
+typedef struct {
+    u32 magic;
+    u16 version;
+    u16 count;
+    u32 index_offset;
+    u32 data_size;      // 索引之后全部资源数据的字节数
+} AssetPackHeader;
+
+typedef struct {
+    char name[ASSETPACK_NAME_MAX]; // 以 0 结尾
+    u32 offset;         // 资源数据在文件中的偏移
+    u32 size;           // 资源数据字节数（段 + 像素）
+    u16 width;
+    u16 height;
+    u32 run_count;
+} AssetPackEntry;
+
+typedef struct {
+    u16 y;
+    u16 x;
+    u16 len;
+    u16 reserved;
+} AssetRun;
+
+typedef struct {
+    char name[ASSETPACK_NAME_MAX];
+    u16 width;
+    u16 height;
+    u32 run_count;
+    const AssetRun *runs;
+    const u16 *pixels;  // RGBA4444 原始值
+} AssetSprite;
+
+typedef struct {
+    AssetSprite sprites[ASSETPACK_MAX_SPRITES];
+    u32 count;
+} AssetSet;
+
+// 资源内存：一次性申请的线性分配区，整体复位
+typedef struct {
+    u8 *base;
+    size_t size;
+    size_t used;
+} AssetArena;
+
+bool asset_arena_init(AssetArena *arena, size_t size);
+void asset_arena_reset(AssetArena *arena);
+void asset_arena_free(AssetArena *arena);
+void *asset_arena_alloc(AssetArena *arena, size_t size);
+
+// 一次顺序读取整个资源包到 arena（资源多且大部分都会用到时最快）
+Result assetpack_load_all(const char *path, AssetArena *arena, AssetSet *out);
+// 只读取 names 中列出的资源（按文件偏移顺序逐个读取），其余资源不占内存。
+// arena 尚未申请（base 为 NULL）时先读索引，按被引用资源的大小之和申请；失败时释放，包中没有被引用的资源时不申请
+Result assetpack_load_scene(const char *path, AssetArena *arena, const char *const *names, u32 name_count, AssetSet *out);
+
+const AssetSprite *assetset_find(const AssetSet *set, const char *name);
+
+// 资源数据大小（段 + 像素，已按 8 字节对齐）
+static inline u32 assetpack_data_size(u32 run_count, u32 pixel_count) {
+    u32 size = run_count * (u32)sizeof(AssetRun) + pixel_count * (u32)sizeof(u16);
+    return (size + 7) & ~7u;
+}
@@ -0,0 +1,99 @@
+#include "blit.h"
+#include <string.h>
+
+// blitter 内联它，每个源行不再多一次函数调用；资源包精灵走导出的 blit_span_rows
+static inline __attribute__((always_inline)) u64 span_rows(const BlitTarget *t, const u16 *span, const u8 *opaque, s32 gx0, s32 gx1, s32 dy0, s32 dy1) {
+    u64 written = 0;
+    for (s32 dy = dy0; dy < dy1; ++dy) {
+        for (s32 gx = gx0; gx < gx1; gx += 8) {
+            s32 i = gx - gx0;
+            u8 m = opaque[i >> 3];
+            if (m == 0) continue;
+            u16 *dst = t->pixels + blit_pixel_offset(t->width, gx, dy);
+            written += (u64)__builtin_popcount(m);
+            if (m == 0xFF) {
+                memcpy(dst, &span[i], 8 * sizeof(u16));
+            } else {
+                for (s32 k = 0; k < 8; ++k) {
+                    if (m & (1u << k)) dst[k] = span[i + k];
+                }
+            }
+        }
+    }
+    return written;
+}
+
+u64 blit_span_rows(const BlitTarget *t, const u16 *span, const u8 *opaque, s32 gx0, s32 gx1, s32 dy0, s32 dy1) {
+    return span_rows(t, span, opaque, gx0, gx1, dy0, dy1);
+}
+
+static inline __attribute__((always_inline)) u64 blit_rgb565_impl(const BlitTarget *t, s32 x, s32 y, const u16 *bitmap, s32 width, s32 height, const s32 scale_x, const s32 scale_y) {
+    // 整个精灵只裁剪一次
+    s32 x0 = x, y0 = y;
+    s32 x1 = x + width * scale_x;
+    s32 y1 = y + height * scale_y;
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > t->width) x1 = t->width;
+    if (y1 > t->height) y1 = t->height;
+    if (x0 >= x1 || y0 >= y1) return 0;
+
+    // 展开缓冲以 8 像素组对齐：span[0] 对应帧缓冲 x = gx0
+    s32 gx0 = x0 & ~7;
+    s32 gx1 = (x1 + 7) & ~7;
+    u16 span[BLIT_SPAN_MAX];
+    u8 opaque[BLIT_SPAN_MAX / 8]; // 每组的不透明位图
+    u64 written = 0;
+
+    s32 row_first = (y0 - y) / scale_y;
+    s32 row_last = (y1 - 1 - y) / scale_y;
+    for (s32 row = row_first; row <= row_last; ++row) {
+        // 源行只转换、展开一次
+        memset(opaque, 0, (size_t)((gx1 - gx0) >> 3));
+        const u16 *src = bitmap + row * width;
+        s32 col_first = (x0 - x) / scale_x;
+        s32 col_last = (x1 - 1 - x) / scale_x;
+        for (s32 col = col_first; col <= col_last; ++col) {
+            u16 pixel = src[col];
+            if (pixel == BLIT_RGB565_KEY) continue;
+            u16 raw = blit_rgb565_to_raw(pixel);
+            s32 dx = x + col * scale_x;
+            for (s32 sx = 0; sx < scale_x; ++sx, ++dx) {
+                if (dx < x0 || dx >= x1) continue;
+                s32 i = dx - gx0;
+                span[i] = raw;
+                opaque[i >> 3] |= (u8)(1u << (i & 7));
+            }
+        }
+
+        // 同一展开行复制 scale_y 次
+        s32 dy0 = y + row * scale_y;
+        s32 dy1 = dy0 + scale_y;
+        if (dy0 < y0) dy0 = y0;
+        if (dy1 > y1) dy1 = y1;
+        written += span_rows(t, span, opaque, gx0, gx1, dy0, dy1);
+    }
+    return written;
+}
+
+// 按场景实际使用的缩放比例特化（编译期常量，内层循环可完全展开）
+#define DEFINE_RGB565_BLITTER(SX, SY) \
+    static u64 blit_rgb565_##SX##x##SY(const BlitTarget *t, s32 x, s32 y, const u16 *bitmap, s32 width, s32 height) { \
+        return blit_rgb565_impl(t, x, y, bitmap, width, height, SX, SY); \
+    }
+DEFINE_RGB565_BLITTER(5, 5) // 马里奥
+DEFINE_RGB565_BLITTER(6, 6) // 地面砖块、云朵
+DEFINE_RGB565_BLITTER(6, 8) // 小山、灌木
+
+// 其他比例的通用路径
+static u64 blit_rgb565_generic(const BlitTarget *t, s32 x, s32 y, const u16 *bitmap, s32 width, s32 height, s32 scale_x, s32 scale_y) {
+    return blit_rgb565_impl(t, x, y, bitmap, width, height, scale_x, scale_y);
+}
+
+u64 blit_rgb565_scaled(const BlitTarget *t, s32 x, s32 y, const u16 *bitmap, s32 width, s32 height, s32 scale_x, s32 scale_y) {
+    if (!t->pixels || !bitmap || scale_x <= 0 || scale_y <= 0 || !blit_span_fits(width, scale_x)) return 0;
+    if (scale_x == 5 && scale_y == 5) return blit_rgb565_5x5(t, x, y, bitmap, width, height);
+    if (scale_x == 6 && scale_y == 6) return blit_rgb565_6x6(t, x, y, bitmap, width, height);
+    if (scale_x == 6 && scale_y == 8) return blit_rgb565_6x8(t, x, y, bitmap, width, height);
+    return blit_rgb565_generic(t, x, y, bitmap, width, height, scale_x, scale_y);
+}
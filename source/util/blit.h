@@ -0,0 +1,44 @@
+#pragma once
+// 块线性 RGBA4444 帧缓冲上的精灵写入
+//
+// 块线性布局中 x 对齐到 8 的 8 个像素在内存中连续（16 字节）：精灵按行展开成 8 像素组对齐的一段，
+// 再以组为单位整块写入目标的各行，只有含透明像素的组才逐像素写。RGB565 点阵图按场景用到的缩放比例特化
+#include "platform.h"
+
+#define BLIT_SPAN_MAX 512           // 展开缓冲的像素数，更宽的精灵由调用方逐像素绘制
+#define BLIT_RGB565_KEY 0x000E      // RGB565 点阵图的透明色（天空色，不绘制）
+
+typedef struct {
+    u16 *pixels;    // 帧缓冲（块线性）
+    s32 width;      // 宽度同时决定块行的跨度
+    s32 height;
+} BlitTarget;
+
+// 将 x,y 映射为块线性帧缓冲中的偏移（与 tesla.hpp getPixelOffset 一致），边界由调用者保证
+static inline u32 blit_pixel_offset(s32 width, s32 x, s32 y) {
+    u32 tmpPos = ((y & 127) / 16) + (x / 32 * 8) + ((y / 16 / 8) * (((width / 2) / 16 * 8)));
+    tmpPos *= 16 * 16 * 4;
+    tmpPos += ((y % 16) / 8) * 512 + ((x % 32) / 16) * 256 + ((y % 8) / 2) * 64 + ((x % 16) / 8) * 32 + (y % 2) * 16 + (x % 8) * 2;
+    return tmpPos / 2;
+}
+
+// RGB565 转不透明的 RGBA4444（各分量取高 4 位）
+static inline u16 blit_rgb565_to_raw(u16 c) {
+    u16 r = (u16)(((c >> 11) & 0x1F) >> 1);
+    u16 g = (u16)(((c >> 5) & 0x3F) >> 2);
+    u16 b = (u16)((c & 0x1F) >> 1);
+    return (u16)(r | (g << 4) | (b << 8) | (0xF << 12));
+}
+
+// 展开缓冲能否容纳宽 width、横向缩放 scale_x 的精灵（两端各留一组对齐余量）
+static inline bool blit_span_fits(s32 width, s32 scale_x) {
+    return width * scale_x + 16 <= BLIT_SPAN_MAX;
+}
+
+// 把按 8 像素组展开好的一行（span/opaque，span[0] 对应 x = gx0，opaque 每组一个字节的不透明位图）
+// 写到 [dy0, dy1) 的每一行；返回写入的像素数
+u64 blit_span_rows(const BlitTarget *t, const u16 *span, const u8 *opaque, s32 gx0, s32 gx1, s32 dy0, s32 dy1);
+
+// 绘制 RGB565 点阵图（跳过 BLIT_RGB565_KEY，独立横纵缩放），整个精灵只裁剪一次；返回写入的像素数。
+// 要求 blit_span_fits(width, scale_x)，否则什么也不画
+u64 blit_rgb565_scaled(const BlitTarget *t, s32 x, s32 y, const u16 *bitmap, s32 width, s32 height, s32 scale_x, s32 scale_y);
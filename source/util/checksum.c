@@ -0,0 +1,242 @@
+#include "checksum.h"
+#include <string.h>
+
+#if defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define CHECKSUM_HW_CRC32C 1
+#endif
+#if defined(__aarch64__) && (defined(__ARM_FEATURE_SHA2) || defined(__ARM_FEATURE_CRYPTO))
+#include <arm_neon.h>
+#define CHECKSUM_HW_SHA256 1
+#endif
+
+#define CRC32C_POLY 0x82F63B78u // 反射形式
+
+static bool s_force_portable;
+
+void checksum_force_portable(bool on) {
+    s_force_portable = on;
+}
+
+bool checksum_hw_crc32c(void) {
+#ifdef CHECKSUM_HW_CRC32C
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool checksum_hw_sha256(void) {
+#ifdef CHECKSUM_HW_SHA256
+    return true;
+#else
+    return false;
+#endif
+}
+
+static inline u64 read64le(const u8 *p) { u64 v; memcpy(&v, p, 8); return v; }
+static inline u32 read32be(const u8 *p) { return (u32)p[0] << 24 | (u32)p[1] << 16 | (u32)p[2] << 8 | p[3]; }
+
+// ---- CRC32C ----
+
+// slicing-by-8 查表：table[k][b] 是字节 b 后面再跟 k 个零字节的 CRC。
+// 首次使用时生成；并发生成写入的是相同的值
+static u32 s_crc_table[8][256];
+static bool s_crc_table_ready;
+
+static void crc32c_table_init(void) {
+    for (u32 b = 0; b < 256; ++b) {
+        u32 c = b;
+        for (int i = 0; i < 8; ++i) c = (c >> 1) ^ (CRC32C_POLY & (0u - (c & 1)));
+        s_crc_table[0][b] = c;
+    }
+    for (u32 b = 0; b < 256; ++b) {
+        for (int k = 1; k < 8; ++k) {
+            u32 c = s_crc_table[k - 1][b];
+            s_crc_table[k][b] = (c >> 8) ^ s_crc_table[0][c & 0xFF];
+        }
+    }
+    __atomic_store_n(&s_crc_table_ready, true, __ATOMIC_RELEASE);
+}
+
+// 假定小端（Switch 与 x86 都是）
+u32 crc32c_portable(u32 crc, const void *data, size_t len) {
+    if (!__atomic_load_n(&s_crc_table_ready, __ATOMIC_ACQUIRE)) crc32c_table_init();
+    const u8 *p = (const u8*)data;
+    u32 c = ~crc;
+    while (len >= 8) {
+        u64 v = read64le(p) ^ c;
+        c = s_crc_table[7][v & 0xFF] ^ s_crc_table[6][(v >> 8) & 0xFF] ^
+            s_crc_table[5][(v >> 16) & 0xFF] ^ s_crc_table[4][(v >> 24) & 0xFF] ^
+            s_crc_table[3][(v >> 32) & 0xFF] ^ s_crc_table[2][(v >> 40) & 0xFF] ^
+            s_crc_table[1][(v >> 48) & 0xFF] ^ s_crc_table[0][v >> 56];
+        p += 8;
+        len -= 8;
+    }
+    while (len--) c = (c >> 8) ^ s_crc_table[0][(c ^ *p++) & 0xFF];
+    return ~c;
+}
+
+#ifdef CHECKSUM_HW_CRC32C
+// crc32cx 每条处理 8 字节；先按字节对齐到 8，主循环每次 32 字节
+static u32 crc32c_hw(u32 crc, const u8 *p, size_t len) {
+    u32 c = ~crc;
+    while (len && ((uintptr_t)p & 7)) {
+        c = __crc32cb(c, *p++);
+        --len;
+    }
+    while (len >= 32) {
+        c = __crc32cd(c, read64le(p));
+        c = __crc32cd(c, read64le(p + 8));
+        c = __crc32cd(c, read64le(p + 16));
+        c = __crc32cd(c, read64le(p + 24));
+        p += 32;
+        len -= 32;
+    }
+    while (len >= 8) {
+        c = __crc32cd(c, read64le(p));
+        p += 8;
+        len -= 8;
+    }
+    while (len--) c = __crc32cb(c, *p++);
+    return ~c;
+}
+#endif
+
+u32 crc32c(u32 crc, const void *data, size_t len) {
+#ifdef CHECKSUM_HW_CRC32C
+    if (!s_force_portable) return crc32c_hw(crc, (const u8*)data, len);
+#endif
+    return crc32c_portable(crc, data, len);
+}
+
+// ---- SHA-256 ----
+
+static const u32 K256[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static inline u32 ror32(u32 x, int r) { return (x >> r) | (x << (32 - r)); }
+
+static void sha256_blocks_portable(u32 state[8], const u8 *p, size_t blocks) {
+    while (blocks--) {
+        u32 w[64];
+        for (int i = 0; i < 16; ++i) w[i] = read32be(p + i * 4);
+        for (int i = 16; i < 64; ++i) {
+            u32 s0 = ror32(w[i - 15], 7) ^ ror32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            u32 s1 = ror32(w[i - 2], 17) ^ ror32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        u32 a = state[0], b = state[1], c = state[2], d = state[3];
+        u32 e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 64; ++i) {
+            u32 t1 = h + (ror32(e, 6) ^ ror32(e, 11) ^ ror32(e, 25)) + ((e & f) ^ (~e & g)) + K256[i] + w[i];
+            u32 t2 = (ror32(a, 2) ^ ror32(a, 13) ^ ror32(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
+        }
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+        p += SHA256_BLOCK_SIZE;
+    }
+}
+
+#ifdef CHECKSUM_HW_SHA256
+// 每组 4 轮：sha256h/sha256h2 更新 abcd/efgh 两半状态，sha256su0/su1 就地推出后面第 4 组的消息字
+static void sha256_blocks_hw(u32 state[8], const u8 *p, size_t blocks) {
+    uint32x4_t abcd = vld1q_u32(&state[0]);
+    uint32x4_t efgh = vld1q_u32(&state[4]);
+    while (blocks--) {
+        uint32x4_t abcd0 = abcd, efgh0 = efgh;
+        uint32x4_t msg[4];
+        for (int i = 0; i < 4; ++i) msg[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(p + i * 16)));
+        for (int i = 0; i < 16; ++i) {
+            uint32x4_t wk = vaddq_u32(msg[i & 3], vld1q_u32(&K256[i * 4]));
+            if (i < 12) {
+                msg[i & 3] = vsha256su1q_u32(vsha256su0q_u32(msg[i & 3], msg[(i + 1) & 3]),
+                                             msg[(i + 2) & 3], msg[(i + 3) & 3]);
+            }
+            uint32x4_t prev = abcd;
+            abcd = vsha256hq_u32(abcd, efgh, wk);
+            efgh = vsha256h2q_u32(efgh, prev, wk);
+        }
+        abcd = vaddq_u32(abcd, abcd0);
+        efgh = vaddq_u32(efgh, efgh0);
+        p += SHA256_BLOCK_SIZE;
+    }
+    vst1q_u32(&state[0], abcd);
+    vst1q_u32(&state[4], efgh);
+}
+#endif
+
+static void sha256_blocks(u32 state[8], const u8 *p, size_t blocks) {
+#ifdef CHECKSUM_HW_SHA256
+    if (!s_force_portable) {
+        sha256_blocks_hw(state, p, blocks);
+        return;
+    }
+#endif
+    sha256_blocks_portable(state, p, blocks);
+}
+
+void sha256_init(Sha256 *s) {
+    static const u32 iv[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+    memset(s, 0, sizeof(*s));
+    memcpy(s->state, iv, sizeof(iv));
+}
+
+void sha256_update(Sha256 *s, const void *data, size_t len) {
+    const u8 *p = (const u8*)data;
+    s->total_len += len;
+    if (s->block_len) {
+        size_t fill = SHA256_BLOCK_SIZE - s->block_len;
+        if (len < fill) {
+            memcpy(s->block + s->block_len, p, len);
+            s->block_len += (u32)len;
+            return;
+        }
+        memcpy(s->block + s->block_len, p, fill);
+        sha256_blocks(s->state, s->block, 1);
+        p += fill;
+        len -= fill;
+        s->block_len = 0;
+    }
+    // 整块直接从调用方缓冲区处理，不经过 block
+    size_t blocks = len / SHA256_BLOCK_SIZE;
+    if (blocks) {
+        sha256_blocks(s->state, p, blocks);
+        p += blocks * SHA256_BLOCK_SIZE;
+        len -= blocks * SHA256_BLOCK_SIZE;
+    }
+    memcpy(s->block, p, len);
+    s->block_len = (u32)len;
+}
+
+void sha256_final(Sha256 *s, u8 out[SHA256_DIGEST_SIZE]) {
+    u64 bits = s->total_len * 8;
+    u32 n = s->block_len;
+    s->block[n++] = 0x80;
+    if (n > SHA256_BLOCK_SIZE - 8) {
+        memset(s->block + n, 0, SHA256_BLOCK_SIZE - n);
+        sha256_blocks(s->state, s->block, 1);
+        n = 0;
+    }
+    memset(s->block + n, 0, SHA256_BLOCK_SIZE - 8 - n);
+    for (int i = 0; i < 8; ++i) s->block[SHA256_BLOCK_SIZE - 1 - i] = (u8)(bits >> (i * 8));
+    sha256_blocks(s->state, s->block, 1);
+    for (int i = 0; i < 8; ++i) {
+        out[i * 4] = (u8)(s->state[i] >> 24);
+        out[i * 4 + 1] = (u8)(s->state[i] >> 16);
+        out[i * 4 + 2] = (u8)(s->state[i] >> 8);
+        out[i * 4 + 3] = (u8)s->state[i];
+    }
+}
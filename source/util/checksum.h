@@ -0,0 +1,29 @@
+#pragma once
+// 完整性校验：CRC32C（Castagnoli 多项式）与 SHA-256。
+// 以 -march=armv8-a+crc+crypto 构建时（Switch）使用 ARMv8 的 CRC32 与 SHA2 指令，
+// 其他平台（x86 主机构建）使用查表/纯 C 实现；两种实现结果一致，基准工具可强制走纯 C 路径对比
+#include "platform.h"
+
+#define SHA256_DIGEST_SIZE 32
+#define SHA256_BLOCK_SIZE 64
+
+typedef struct {
+    u32 state[8];
+    u64 total_len;
+    u8 block[SHA256_BLOCK_SIZE]; // 不足一块的尾部
+    u32 block_len;
+} Sha256;
+
+// 与 zlib 的 crc32() 用法相同：首次传 0，之后传上一次的返回值，可分段计算
+u32 crc32c(u32 crc, const void *data, size_t len);
+u32 crc32c_portable(u32 crc, const void *data, size_t len);
+
+void sha256_init(Sha256 *s);
+void sha256_update(Sha256 *s, const void *data, size_t len);
+void sha256_final(Sha256 *s, u8 out[SHA256_DIGEST_SIZE]);
+
+// 本次构建是否带硬件指令
+bool checksum_hw_crc32c(void);
+bool checksum_hw_sha256(void);
+// 基准用：为真时 crc32c/sha256 也走纯 C 实现（全局开关，不要在上传过程中切换）
+void checksum_force_portable(bool on);
@@ -0,0 +1,222 @@
+#include "config.h"
+#include "fspool.h"
+#include "log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <sys/stat.h>
+
+#define CONFIG_MAX_FILE_SIZE 4096
+
+typedef enum {
+    ConfigType_U16,
+    ConfigType_U32,
+    ConfigType_S32,
+    ConfigType_Float,
+    ConfigType_String,  // max 为目标缓冲区大小（含结尾 0）
+} ConfigType;
+
+typedef struct {
+    const char *key;
+    ConfigType type;
+    size_t offset;
+    double min;
+    double max;
+    u32 multiple; // 非 0 时要求为其整数倍
+} ConfigField;
+
+static const ConfigField s_fields[] = {
+    { "framebuffer_width",  ConfigType_U16,   offsetof(AppConfig, framebuffer_width),  64,   1280, 32 },
+    { "framebuffer_height", ConfigType_U16,   offsetof(AppConfig, framebuffer_height), 64,   1080, 16 },
+    { "layer_fraction",     ConfigType_Float, offsetof(AppConfig, layer_fraction),     0.05, 1.0,  0 },
+    { "buffer_count",       ConfigType_U32,   offsetof(AppConfig, buffer_count),       1,    3,    0 },
+    { "frame_ms",           ConfigType_U32,   offsetof(AppConfig, frame_ms),           16,   1000, 0 },
+    { "mario_scale",        ConfigType_S32,   offsetof(AppConfig, mario_scale),        1,    16,   0 },
+    { "tile_scale",         ConfigType_S32,   offsetof(AppConfig, tile_scale),         1,    16,   0 },
+    { "cloud_scale",        ConfigType_S32,   offsetof(AppConfig, cloud_scale),        1,    16,   0 },
+    { "hill_scale_x",       ConfigType_S32,   offsetof(AppConfig, hill_scale_x),       1,    16,   0 },
+    { "hill_scale_y",       ConfigType_S32,   offsetof(AppConfig, hill_scale_y),       1,    16,   0 },
+    { "text_scale_x",       ConfigType_S32,   offsetof(AppConfig, text_scale_x),       1,    15,   0 },
+    { "text_scale_y",       ConfigType_S32,   offsetof(AppConfig, text_scale_y),       1,    16,   0 },
+    { "fs_sessions",        ConfigType_U32,   offsetof(AppConfig, fs_sessions),        1,    4,    0 },
+    { "worker_threads",     ConfigType_U32,   offsetof(AppConfig, worker_threads),     1,    4,    0 },
+    { "scan_cache",         ConfigType_U32,   offsetof(AppConfig, scan_cache),         0,    1,    0 },
+    { "upload_connections", ConfigType_U32,   offsetof(AppConfig, upload_connections), 1,    4,    0 },
+    { "upload_buffers",     ConfigType_U32,   offsetof(AppConfig, upload_buffers),     2,    8,    0 },
+    { "upload_buffer_kb",   ConfigType_U32,   offsetof(AppConfig, upload_buffer_kb),   16,   1024, 16 },
+    { "upload_chunk_mb",    ConfigType_U32,   offsetof(AppConfig, upload_chunk_mb),    1,    256,  0 },
+    { "io_pool_kb",         ConfigType_U32,   offsetof(AppConfig, io_pool_kb),         256,  2048, 0 },
+    { "run_arena_kb",       ConfigType_U32,   offsetof(AppConfig, run_arena_kb),       256,  2048, 0 },
+    { "remote_cache",       ConfigType_U32,   offsetof(AppConfig, remote_cache),       0,    1,    0 },
+    { "pack_small_kb",      ConfigType_U32,   offsetof(AppConfig, pack_small_kb),      0,    1024, 0 },
+    { "snapshot",           ConfigType_U32,   offsetof(AppConfig, snapshot),           0,    1,    0 },
+    { "snapshot_ram_kb",    ConfigType_U32,   offsetof(AppConfig, snapshot_ram_kb),    0,    2048, 0 },
+    { "compression",        ConfigType_U32,   offsetof(AppConfig, compression),        0,    1,    0 },
+    { "compression_level",  ConfigType_U32,   offsetof(AppConfig, compression_level),  0,    9,    0 },
+    { "dedup",              ConfigType_U32,   offsetof(AppConfig, dedup),              0,    1,    0 },
+    { "bg_disk_kbps",       ConfigType_U32,   offsetof(AppConfig, bg_disk_kbps),       0,    1048576, 0 },
+    { "bg_net_kbps",        ConfigType_U32,   offsetof(AppConfig, bg_net_kbps),        0,    1048576, 0 },
+    { "trigger_title_exit", ConfigType_U32,   offsetof(AppConfig, trigger_title_exit), 0,    1,    0 },
+    { "trigger_dir_poll_s", ConfigType_U32,   offsetof(AppConfig, trigger_dir_poll_s), 0,    86400, 0 },
+    { "trigger_interval_min", ConfigType_U32, offsetof(AppConfig, trigger_interval_min), 0,  10080, 0 },
+    { "trigger_debounce_s", ConfigType_U32,   offsetof(AppConfig, trigger_debounce_s), 0,    3600, 0 },
+    { "trigger_max_delay_s", ConfigType_U32,  offsetof(AppConfig, trigger_max_delay_s), 0,   86400, 0 },
+    { "metrics_interval_s", ConfigType_U32,   offsetof(AppConfig, metrics_interval_s), 0,    3600, 0 },
+    { "metrics_port",       ConfigType_U32,   offsetof(AppConfig, metrics_port),       0,    65535, 0 },
+    { "backup_source",      ConfigType_String, offsetof(AppConfig, backup_source), 0, sizeof(((AppConfig*)0)->backup_source), 0 },
+    { "ftp_url",            ConfigType_String, offsetof(AppConfig, ftp_url),       0, sizeof(((AppConfig*)0)->ftp_url),       0 },
+    { "ftp_user",           ConfigType_String, offsetof(AppConfig, ftp_user),      0, sizeof(((AppConfig*)0)->ftp_user),      0 },
+    { "ftp_password",       ConfigType_String, offsetof(AppConfig, ftp_password),  0, sizeof(((AppConfig*)0)->ftp_password),  0 },
+};
+
+void config_defaults(AppConfig *cfg) {
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->framebuffer_width = 448;
+    cfg->framebuffer_height = 720;
+    cfg->layer_fraction = 0.35f;
+    cfg->buffer_count = 2;
+    cfg->frame_ms = 60;     // 约 16 fps
+    cfg->mario_scale = 5;
+    cfg->tile_scale = 6;
+    cfg->cloud_scale = 6;
+    cfg->hill_scale_x = 6;
+    cfg->hill_scale_y = 8;
+    cfg->text_scale_x = 5;
+    cfg->text_scale_y = 7;
+    cfg->fs_sessions = FSPOOL_DEFAULT_SESSIONS;
+    cfg->worker_threads = 2;
+    cfg->scan_cache = 1;
+    cfg->upload_connections = 2;
+    cfg->upload_buffers = 3;
+    cfg->upload_buffer_kb = 128;
+    cfg->upload_chunk_mb = 8;
+    cfg->io_pool_kb = 1024;
+    cfg->run_arena_kb = 1024;
+    cfg->remote_cache = 1;
+    cfg->snapshot_ram_kb = 512;
+    cfg->bg_disk_kbps = 8192;
+    cfg->bg_net_kbps = 4096;
+    cfg->trigger_title_exit = 1;
+    cfg->trigger_dir_poll_s = 60;
+    cfg->trigger_debounce_s = 15;
+    cfg->trigger_max_delay_s = 120;
+    cfg->metrics_interval_s = 30;
+    strcpy(cfg->backup_source, "/switch/JKSV");
+    strcpy(cfg->ftp_user, "anonymous");
+}
+
+static char *trim(char *s) {
+    while (isspace((unsigned char)*s)) ++s;
+    char *end = s + strlen(s);
+    while (end > s && isspace((unsigned char)end[-1])) --end;
+    *end = '\0';
+    return s;
+}
+
+static bool config_set_field(AppConfig *cfg, const ConfigField *f, const char *value) {
+    if (f->type == ConfigType_String) {
+        size_t len = strlen(value);
+        if (len >= (size_t)f->max) return false;
+        memcpy((u8*)cfg + f->offset, value, len + 1);
+        return true;
+    }
+    char *end = NULL;
+    double v = strtod(value, &end);
+    if (end == value || *end != '\0') return false;
+    if (v < f->min || v > f->max) return false;
+    if (f->type != ConfigType_Float) {
+        if (v != (double)(s64)v) return false;
+        if (f->multiple && ((s64)v % f->multiple) != 0) return false;
+    }
+    void *dst = (u8*)cfg + f->offset;
+    switch (f->type) {
+        case ConfigType_U16:   *(u16*)dst = (u16)v; break;
+        case ConfigType_U32:   *(u32*)dst = (u32)v; break;
+        case ConfigType_S32:   *(s32*)dst = (s32)v; break;
+        case ConfigType_Float: *(float*)dst = (float)v; break;
+        case ConfigType_String: break;
+    }
+    return true;
+}
+
+int config_parse(AppConfig *cfg, const char *text) {
+    int rejected = 0;
+    char line[384];
+    const char *p = text;
+    while (p && *p) {
+        const char *nl = strchr(p, '\n');
+        size_t len = nl ? (size_t)(nl - p) : strlen(p);
+        if (len >= sizeof(line)) len = sizeof(line) - 1;
+        memcpy(line, p, len);
+        line[len] = '\0';
+        p = nl ? nl + 1 : NULL;
+
+        char *eq = strchr(line, '=');
+        if (!eq) continue;
+        *eq = '\0';
+        char *key = trim(line);
+        if (!*key || *key == '#' || *key == ';') continue;
+
+        const ConfigField *field = NULL;
+        for (size_t i = 0; i < sizeof(s_fields) / sizeof(s_fields[0]); ++i) {
+            if (strcmp(s_fields[i].key, key) == 0) { field = &s_fields[i]; break; }
+        }
+        // 字符串值（口令、URL）可能含 # 或 ;，只对数值项去掉行尾注释
+        if (!field || field->type != ConfigType_String) {
+            char *comment = strpbrk(eq + 1, "#;");
+            if (comment) *comment = '\0';
+        }
+        char *value = trim(eq + 1);
+        if (!field) {
+            log_warning("配置项未知，已忽略: %s", key);
+            ++rejected;
+        } else if (!config_set_field(cfg, field, value)) {
+            log_warning("配置项非法，使用默认值: %s=%s", key, value);
+            ++rejected;
+        }
+    }
+    return rejected;
+}
+
+bool config_load(AppConfig *cfg, const char *path) {
+    config_defaults(cfg);
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+    char buf[CONFIG_MAX_FILE_SIZE + 1];
+    size_t n = fread(buf, 1, CONFIG_MAX_FILE_SIZE, f);
+    fclose(f);
+    buf[n] = '\0';
+    config_parse(cfg, buf);
+    return true;
+}
+
+static void config_watch_stat(ConfigWatch *watch) {
+    struct stat st;
+    if (stat(watch->path, &st) == 0) {
+        watch->exists = true;
+        watch->mtime = (s64)st.st_mtime;
+        watch->size = (s64)st.st_size;
+    } else {
+        watch->exists = false;
+        watch->mtime = 0;
+        watch->size = 0;
+    }
+}
+
+void config_watch_init(ConfigWatch *watch, const char *path) {
+    watch->path = path;
+    watch->last_check_tick = armGetSystemTick();
+    config_watch_stat(watch);
+}
+
+bool config_watch_poll(ConfigWatch *watch) {
+    u64 now = armGetSystemTick();
+    if (armTicksToNs(now - watch->last_check_tick) < CONFIG_POLL_INTERVAL_NS) return false;
+    watch->last_check_tick = now;
+    bool old_exists = watch->exists;
+    s64 old_mtime = watch->mtime;
+    s64 old_size = watch->size;
+    config_watch_stat(watch);
+    return watch->exists != old_exists || watch->mtime != old_mtime || watch->size != old_size;
+}
@@ -0,0 +1,79 @@
+#pragma once
+// 运行时配置：启动时从 SD 卡读取一次紧凑的 key=value 文件，解析为类型化结构；
+// 之后每隔几秒只比较文件的 mtime/size，变化时才重新解析
+#include "platform.h"
+
+#define CONFIG_FILE_PATH "/config/mario-pop/config.ini"
+#define CONFIG_POLL_INTERVAL_NS 5000000000ULL // 5 秒检查一次
+
+typedef struct {
+    // 渲染开销相关（需要重建图层，只在启动时生效）
+    u16 framebuffer_width;    // 渲染分辨率（宽，32 的倍数）
+    u16 framebuffer_height;   // 渲染分辨率（高，16 的倍数）
+    float layer_fraction;     // 弹窗高度占屏幕高度的比例
+    u32 buffer_count;         // 帧缓冲数量（2 = 双缓冲）
+    // 渲染开销相关（可热更新）
+    u32 frame_ms;             // 帧间隔（毫秒）
+    s32 mario_scale;
+    s32 tile_scale;
+    s32 cloud_scale;
+    s32 hill_scale_x;
+    s32 hill_scale_y;
+    s32 text_scale_x;
+    s32 text_scale_y;
+    // 备份引擎
+    u32 fs_sessions;          // 文件系统会话槽数（启动时生效）
+    u32 worker_threads;       // 备份目录遍历线程数
+    u32 scan_cache;           // 1 = 按目录修改时间缓存目录列表
+    u32 upload_connections;   // 并行 FTP 连接数
+    u32 upload_buffers;       // 每条连接的预读环形缓冲块数
+    u32 upload_buffer_kb;     // 每块大小（KB，16 的倍数）
+    u32 upload_chunk_mb;      // 断点续传的分块大小（MB）
+    u32 io_pool_kb;           // 启动时预留的 I/O 缓冲池（KB，按 upload_buffer_kb 切块；启动时生效）
+    u32 run_arena_kb;         // 每次备份的路径与任务队列上限（KB，启动时生效）
+    u32 remote_cache;         // 1 = 上传前用 MLSD 列出远端目录，按缓存建目录、查续传长度
+    u32 pack_small_kb;        // 不超过它的小文件按顶层目录打包成一个归档上传（KB，0 = 不打包）
+    u32 snapshot;             // 1 = 先把要上传的文件复制到暂存区，再从副本上传
+    u32 snapshot_ram_kb;      // 总量不超过它的快照放在内存里，否则写到 SD 暂存目录（KB）
+    u32 compression;          // 1 = gzip 压缩后上传
+    u32 compression_level;    // 0 = 自动，1..9 = 固定级别
+    u32 dedup;                // 1 = 按内容分块去重备份（远端块库 + 配方），不再逐文件上传
+    u32 bg_disk_kbps;         // 前台有应用时的 SD 读取限速（KB/s，0 = 不限）
+    u32 bg_net_kbps;          // 前台有应用时的上传限速（KB/s，0 = 不限）
+    u32 trigger_title_exit;   // 1 = 应用退出后备份（启动时生效）
+    u32 trigger_dir_poll_s;   // 检查存档目录变化的间隔（秒，0 = 不检查；启动时生效）
+    u32 trigger_interval_min; // 定时备份间隔（分钟，0 = 不定时；启动时生效）
+    u32 trigger_debounce_s;   // 事件后的安静期（秒）
+    u32 trigger_max_delay_s;  // 第一个事件到备份的最长推迟（秒，0 = 不限）
+    // 运行指标（启动时生效）
+    u32 metrics_interval_s;   // 指标文件的写入间隔（秒，0 = 不写）
+    u32 metrics_port;         // 以 HTTP 提供指标的端口（0 = 不监听）
+    char backup_source[256];  // 要备份的 SD 目录
+    char ftp_url[256];        // 远端根目录，如 ftp://192.168.1.2:21/switch；为空则不备份
+    char ftp_user[64];
+    char ftp_password[64];
+} AppConfig;
+
+typedef struct {
+    const char *path;
+    u64 last_check_tick;
+    bool exists;
+    s64 mtime;
+    s64 size;
+} ConfigWatch;
+
+void config_defaults(AppConfig *cfg);
+// 解析配置文本；缺失或非法的项保持 cfg 中已有的值（通常为默认值），返回被拒绝的项数
+int config_parse(AppConfig *cfg, const char *text);
+// 从文件加载（先填默认值）；文件不存在时返回 false，cfg 为默认值
+bool config_load(AppConfig *cfg, const char *path);
+
+// 初始化变更检测（记录当前 mtime/size）
+void config_watch_init(ConfigWatch *watch, const char *path);
+// 到达检查间隔时比较 mtime/size；有变化返回 true（调用方再 config_load）
+bool config_watch_poll(ConfigWatch *watch);
+
+// 帧间隔（纳秒）
+static inline u64 config_frame_period_ns(const AppConfig *cfg) {
+    return (u64)cfg->frame_ms * 1000000ULL;
+}
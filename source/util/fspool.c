@@ -0,0 +1,55 @@
+#include "fspool.h"
+#include <stdatomic.h>
+
+static Mutex s_slots[FSPOOL_MAX_SESSIONS];
+static atomic_uint s_sessions = FSPOOL_DEFAULT_SESSIONS;
+static atomic_uint s_next_ticket;
+static atomic_ullong s_ops[FsRole_Count];
+static atomic_ullong s_waits[FsRole_Count];
+static atomic_ullong s_wait_ns[FsRole_Count];
+
+// 线程首次使用时领取的序号；槽号每次按当前槽数换算，fspool_configure 之后也不会越界
+static __thread u32 t_ticket;
+static __thread bool t_has_ticket;
+static __thread u32 t_held[FsRole_Count];
+
+void fspool_configure(u32 sessions) {
+    if (sessions < 1) sessions = 1;
+    if (sessions > FSPOOL_MAX_SESSIONS) sessions = FSPOOL_MAX_SESSIONS;
+    atomic_store(&s_sessions, sessions);
+}
+
+static u32 slot_for(FsRole role) {
+    u32 n = atomic_load_explicit(&s_sessions, memory_order_relaxed);
+    if (role == FsRole_Log || n == 1) return 0;
+    if (!t_has_ticket) {
+        t_ticket = atomic_fetch_add_explicit(&s_next_ticket, 1, memory_order_relaxed);
+        t_has_ticket = true;
+    }
+    return 1 + t_ticket % (n - 1);
+}
+
+void fspool_enter(FsRole role) {
+    u32 slot = slot_for(role);
+    Mutex *m = &s_slots[slot];
+    t_held[role] = slot;
+    atomic_fetch_add_explicit(&s_ops[role], 1, memory_order_relaxed);
+    if (mutexTryLock(m)) return;
+    u64 start = armGetSystemTick();
+    mutexLock(m);
+    atomic_fetch_add_explicit(&s_waits[role], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&s_wait_ns[role], armTicksToNs(armGetSystemTick() - start), memory_order_relaxed);
+}
+
+void fspool_leave(FsRole role) {
+    mutexUnlock(&s_slots[t_held[role]]);
+}
+
+void fspool_stats(FsPoolStats *out) {
+    out->sessions = atomic_load(&s_sessions);
+    for (int i = 0; i < FsRole_Count; ++i) {
+        out->ops[i] = atomic_load_explicit(&s_ops[i], memory_order_relaxed);
+        out->waits[i] = atomic_load_explicit(&s_waits[i], memory_order_relaxed);
+        out->wait_ns[i] = atomic_load_explicit(&s_wait_ns[i], memory_order_relaxed);
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+// 文件系统会话池：进程向 fsp-srv 开 FSPOOL_MAX_SESSIONS 个会话（__nx_fs_num_sessions），libnx 为每个请求挑一个空闲会话。
+// 本模块把会话分成槽：日志固定使用 0 号槽，其他线程首次做文件操作时绑定到其余槽之一（轮流分配），
+// 同一槽上的操作串行、不同槽并行，同时在途的请求数不超过会话数，目录遍历与数据读取不会让日志在 libnx 内部排队。
+// 逻辑与平台无关，主机上同样作用于普通的文件描述符操作
+#include "platform.h"
+
+#define FSPOOL_MAX_SESSIONS 4
+#define FSPOOL_DEFAULT_SESSIONS 3  // 未调用 fspool_configure 时的槽数
+
+typedef enum {
+    FsRole_Log = 0,     // 日志写入（固定 0 号槽）
+    FsRole_Scan,        // 目录遍历
+    FsRole_Data,        // 备份数据读取
+    FsRole_Count,
+} FsRole;
+
+typedef struct {
+    u32 sessions;
+    u64 ops[FsRole_Count];
+    u64 waits[FsRole_Count];    // 进入时槽被占用的次数
+    u64 wait_ns[FsRole_Count];
+} FsPoolStats;
+
+// 设置使用的槽数（1..FSPOOL_MAX_SESSIONS）；为 1 时所有操作共用一个槽
+void fspool_configure(u32 sessions);
+// 一次文件系统操作（或一批连续操作）前后调用，不可嵌套同一角色
+void fspool_enter(FsRole role);
+void fspool_leave(FsRole role);
+void fspool_stats(FsPoolStats *out);
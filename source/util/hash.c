@@ -0,0 +1,114 @@
+#include "hash.h"
+#include <string.h>
+
+#define P1 0x9E3779B185EBCA87ULL
+#define P2 0xC2B2AE3D27D4EB4FULL
+#define P3 0x165667B19E3779F9ULL
+#define P4 0x85EBCA77C2B2AE63ULL
+#define P5 0x27D4EB2F165667C5ULL
+
+static inline u64 rotl64(u64 x, int r) { return (x << r) | (x >> (64 - r)); }
+
+static inline u64 read64(const u8 *p) { u64 v; memcpy(&v, p, 8); return v; }
+static inline u32 read32(const u8 *p) { u32 v; memcpy(&v, p, 4); return v; }
+
+static inline u64 round64(u64 acc, u64 input) {
+    acc += input * P2;
+    acc = rotl64(acc, 31);
+    return acc * P1;
+}
+
+static inline u64 merge64(u64 acc, u64 v) {
+    acc ^= round64(0, v);
+    return acc * P1 + P4;
+}
+
+void fasthash_init(FastHash *h) {
+    memset(h, 0, sizeof(*h));
+    h->v[0] = P1 + P2;
+    h->v[1] = P2;
+    h->v[2] = 0;
+    h->v[3] = 0 - P1;
+}
+
+// 每次吃 32 字节，四路累加器互不依赖
+static const u8 *consume_stripes(u64 v[4], const u8 *p, const u8 *end) {
+    u64 v0 = v[0], v1 = v[1], v2 = v[2], v3 = v[3];
+    while (p + 32 <= end) {
+        v0 = round64(v0, read64(p));
+        v1 = round64(v1, read64(p + 8));
+        v2 = round64(v2, read64(p + 16));
+        v3 = round64(v3, read64(p + 24));
+        p += 32;
+    }
+    v[0] = v0; v[1] = v1; v[2] = v2; v[3] = v3;
+    return p;
+}
+
+void fasthash_update(FastHash *h, const void *data, size_t len) {
+    const u8 *p = (const u8*)data;
+    const u8 *end = p + len;
+    h->total_len += len;
+    if (h->stash_len) {
+        size_t fill = 32 - h->stash_len;
+        if (len < fill) {
+            memcpy(h->stash + h->stash_len, p, len);
+            h->stash_len += (u32)len;
+            return;
+        }
+        memcpy(h->stash + h->stash_len, p, fill);
+        consume_stripes(h->v, h->stash, h->stash + 32);
+        p += fill;
+        h->stash_len = 0;
+    }
+    p = consume_stripes(h->v, p, end);
+    if (p < end) {
+        memcpy(h->stash, p, (size_t)(end - p));
+        h->stash_len = (u32)(end - p);
+    }
+}
+
+u64 fasthash_final(const FastHash *h) {
+    u64 acc;
+    if (h->total_len >= 32) {
+        acc = rotl64(h->v[0], 1) + rotl64(h->v[1], 7) + rotl64(h->v[2], 12) + rotl64(h->v[3], 18);
+        for (int i = 0; i < 4; ++i) acc = merge64(acc, h->v[i]);
+    } else {
+        acc = h->v[2] + P5; // 种子为 0
+    }
+    acc += h->total_len;
+
+    const u8 *p = h->stash;
+    const u8 *end = p + h->stash_len;
+    while (p + 8 <= end) {
+        acc ^= round64(0, read64(p));
+        acc = rotl64(acc, 27) * P1 + P4;
+        p += 8;
+    }
+    if (p + 4 <= end) {
+        acc ^= (u64)read32(p) * P1;
+        acc = rotl64(acc, 23) * P2 + P3;
+        p += 4;
+    }
+    while (p < end) {
+        acc ^= (*p++) * P5;
+        acc = rotl64(acc, 11) * P1;
+    }
+    acc ^= acc >> 33;
+    acc *= P2;
+    acc ^= acc >> 29;
+    acc *= P3;
+    acc ^= acc >> 32;
+    return acc;
+}
+
+u64 fasthash(const void *data, size_t len) {
+    FastHash h;
+    fasthash_init(&h);
+    fasthash_update(&h, data, len);
+    return fasthash_final(&h);
+}
+
+u64 fasthash_str(const char *s) {
+    return fasthash(s, strlen(s));
+}
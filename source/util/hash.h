@@ -0,0 +1,17 @@
+#pragma once
+// 快速 64 位内容哈希（XXH64 算法），支持分块流式计算；用于判断文件内容是否变化，不用于安全校验
+#include "platform.h"
+
+typedef struct {
+    u64 total_len;
+    u64 v[4];
+    u8 stash[32];   // 不足 32 字节的尾部
+    u32 stash_len;
+} FastHash;
+
+void fasthash_init(FastHash *h);
+void fasthash_update(FastHash *h, const void *data, size_t len);
+u64 fasthash_final(const FastHash *h);
+u64 fasthash(const void *data, size_t len);
+// 字符串哈希（路径索引用）
+u64 fasthash_str(const char *s);
@@ -3,18 +3,26 @@
 #include "log.h"
 #include <stdarg.h>
 #include <string.h>
-#include <switch/services/time.h>
 #include <time.h>
-#include <switch.h>
+#include "platform.h"
+#include "fspool.h"
+#include "metrics.h"
+#ifdef __SWITCH__
+#include <switch/services/time.h>
+#endif
 
 
-static Mutex log_mutex = 0;
+static Mutex log_mutex;
 #define LOG_FILE_PATH "/atmosphere/logs/test.log"
 static FILE *log_file = NULL;
 
 static char *cur_time() {
     u64 timestamp = 0;
+#ifdef __SWITCH__
     timeGetCurrentTime(TimeType_LocalSystemClock, &timestamp);
+#else
+    timestamp = (u64)time(NULL);
+#endif
     // Convert to UTC+8 by adding 8*3600 seconds
     time_t t = (time_t)timestamp + 8 * 3600;
     struct tm *tm_ptr = gmtime(&t);
@@ -33,9 +41,12 @@ static char *cur_time() {
 
 static void log_write(const char *level, const char *file, int line, const char *fmt, va_list args) {
     mutexLock(&log_mutex);
+    fspool_enter(FsRole_Log);
     if (!log_file) {
         log_file = fopen(LOG_FILE_PATH, "a");
         if (!log_file) {
+            metrics_inc(Metric_LogDropped);
+            fspool_leave(FsRole_Log);
             mutexUnlock(&log_mutex);
             return;
         }
@@ -49,7 +60,15 @@ static void log_write(const char *level, const char *file, int line, const char
     fprintf(log_file, "%s [%s:%d] [%s] ", cur_time(), short_file, line, level);
     vfprintf(log_file, fmt, args);
     fprintf(log_file, "\n");
-    fflush(log_file);
+    // 写失败时关掉文件，下一行重新打开
+    if (fflush(log_file) != 0 || ferror(log_file)) {
+        metrics_inc(Metric_LogDropped);
+        fclose(log_file);
+        log_file = NULL;
+    } else {
+        metrics_inc(Metric_LogLines);
+    }
+    fspool_leave(FsRole_Log);
     mutexUnlock(&log_mutex);
 }
 
@@ -0,0 +1,171 @@
+#include "mempool.h"
+#include <stdlib.h>
+#include <string.h>
+
+struct MemArenaBlock {
+    MemArenaBlock *next;
+    size_t size;
+    size_t used;
+    _Alignas(MEMARENA_ALIGN) u8 data[]; // malloc 返回的地址按 16 对齐，块内偏移对齐即地址对齐
+};
+
+Result bufpool_init(BufPool *p, u32 block_size, u32 count) {
+    memset(p, 0, sizeof(*p));
+    mutexInit(&p->lock);
+    condvarInit(&p->cv);
+    block_size = (block_size + MEMPOOL_ALIGN - 1) & ~(u32)(MEMPOOL_ALIGN - 1);
+    if (block_size == 0 || count == 0) return MAKERESULT(Module_Libnx, LibnxError_BadInput);
+    p->base = aligned_alloc(MEMPOOL_ALIGN, (size_t)block_size * count);
+    p->free_list = malloc(count * sizeof(u32));
+    if (!p->base || !p->free_list) {
+        bufpool_exit(p);
+        return MAKERESULT(Module_Libnx, LibnxError_OutOfMemory);
+    }
+    p->block_size = block_size;
+    p->count = count;
+    // 倒序入栈，先取出低地址的块
+    for (u32 i = 0; i < count; ++i) p->free_list[i] = count - 1 - i;
+    p->free_count = count;
+    return 0;
+}
+
+void bufpool_exit(BufPool *p) {
+    free(p->base);
+    free(p->free_list);
+    p->base = NULL;
+    p->free_list = NULL;
+    p->count = p->free_count = 0;
+}
+
+void *bufpool_acquire(BufPool *p, u64 timeout_ns) {
+    mutexLock(&p->lock);
+    if (p->free_count == 0 && timeout_ns) {
+        p->waits++;
+        u64 start = armGetSystemTick();
+        u64 waited = 0;
+        while (p->free_count == 0 && waited < timeout_ns) {
+            condvarWaitTimeout(&p->cv, &p->lock, timeout_ns - waited);
+            waited = armTicksToNs(armGetSystemTick() - start);
+        }
+        p->wait_ns += waited;
+    }
+    void *block = NULL;
+    if (p->free_count) {
+        block = p->base + (size_t)p->free_list[--p->free_count] * p->block_size;
+        p->acquires++;
+        u32 in_use = p->count - p->free_count;
+        if (in_use > p->high_water) p->high_water = in_use;
+    } else {
+        p->failures++;
+    }
+    mutexUnlock(&p->lock);
+    return block;
+}
+
+void bufpool_release(BufPool *p, void *block) {
+    if (!block) return;
+    u32 index = (u32)(((u8*)block - p->base) / p->block_size);
+    mutexLock(&p->lock);
+    p->free_list[p->free_count++] = index;
+    condvarWakeOne(&p->cv);
+    mutexUnlock(&p->lock);
+}
+
+u32 bufpool_available(BufPool *p) {
+    mutexLock(&p->lock);
+    u32 n = p->free_count;
+    mutexUnlock(&p->lock);
+    return n;
+}
+
+void bufpool_stats(BufPool *p, BufPoolStats *out) {
+    mutexLock(&p->lock);
+    out->block_size = p->block_size;
+    out->count = p->count;
+    out->in_use = p->count - p->free_count;
+    out->high_water = p->high_water;
+    out->acquires = p->acquires;
+    out->waits = p->waits;
+    out->wait_ns = p->wait_ns;
+    out->failures = p->failures;
+    mutexUnlock(&p->lock);
+}
+
+void mem_arena_init(MemArena *a, size_t budget) {
+    memset(a, 0, sizeof(*a));
+    a->budget = budget;
+    mutexInit(&a->lock);
+}
+
+void mem_arena_exit(MemArena *a) {
+    for (MemArenaBlock *b = a->first; b;) {
+        MemArenaBlock *next = b->next;
+        free(b);
+        b = next;
+    }
+    a->first = a->current = NULL;
+    a->reserved = a->used = 0;
+}
+
+void mem_arena_reset(MemArena *a) {
+    mutexLock(&a->lock);
+    a->current = a->first;
+    if (a->first) a->first->used = 0;
+    a->used = 0;
+    mutexUnlock(&a->lock);
+}
+
+// 当前块放不下就换到下一个保留的块（复位后的块从头用起），都没有时在预算内申请新块
+void *mem_arena_alloc(MemArena *a, size_t size) {
+    mutexLock(&a->lock);
+    void *out = NULL;
+    MemArenaBlock *b = a->current;
+    for (;;) {
+        if (b) {
+            size_t start = (b->used + MEMARENA_ALIGN - 1) & ~(size_t)(MEMARENA_ALIGN - 1);
+            if (start <= b->size && size <= b->size - start) {
+                out = b->data + start;
+                a->used += start - b->used + size;
+                b->used = start + size;
+                break;
+            }
+            if (b->next) {
+                b = b->next;
+                b->used = 0;
+                a->current = b;
+                continue;
+            }
+        }
+        // 普通块连同块头正好 MEMARENA_BLOCK_SIZE，预算能整块用满
+        size_t data_size = MEMARENA_BLOCK_SIZE - sizeof(MemArenaBlock);
+        if (size > data_size) data_size = size;
+        size_t total = sizeof(MemArenaBlock) + data_size;
+        MemArenaBlock *nb = a->reserved + total <= a->budget ? malloc(total) : NULL;
+        if (!nb) break;
+        nb->next = NULL;
+        nb->size = data_size;
+        nb->used = 0;
+        if (b) b->next = nb;
+        else a->first = nb;
+        a->reserved += total;
+        b = a->current = nb;
+    }
+    if (out && a->used > a->high_water) a->high_water = a->used;
+    if (!out) a->failures++;
+    mutexUnlock(&a->lock);
+    return out;
+}
+
+void *mem_arena_calloc(MemArena *a, size_t count, size_t size) {
+    if (size && count > SIZE_MAX / size) return NULL;
+    void *p = mem_arena_alloc(a, count * size);
+    if (p) memset(p, 0, count * size);
+    return p;
+}
+
+char *mem_arena_strdup(MemArena *a, const char *s) {
+    size_t len = strlen(s) + 1;
+    char *p = mem_arena_alloc(a, len);
+    if (p) memcpy(p, s, len);
+    return p;
+}
@@ -0,0 +1,71 @@
+#pragma once
+// 固定预算的内存：进程只有 4MB 堆（INNER_HEAP_SIZE），备份过程中零散的 malloc 会把堆切碎，
+// 游戏运行时也可能在半路申请失败。这里提供两种分配器：
+//   BufPool  启动时一次申请的定长 I/O 缓冲块。块用完时申请方等待别人归还（背压），而不是再去堆上要
+//   MemArena 每次备份一个的线性分配区（路径字符串、任务队列等），按块向堆申请、总量不超过预算，
+//            备份结束时 O(1) 复位，块留给下一次备份复用
+// 两者都记录峰值与失败次数，备份结束时写入日志
+#include "platform.h"
+
+#define MEMPOOL_ALIGN 0x1000              // I/O 缓冲块按页对齐
+#define MEMARENA_ALIGN 16
+#define MEMARENA_BLOCK_SIZE (64 * 1024)   // 运行区每次向堆申请的大小（超过它的单次申请单独成块）
+
+typedef struct {
+    u8 *base;
+    u32 block_size;
+    u32 count;
+    u32 *free_list;         // 空闲块下标（栈）
+    u32 free_count;
+    Mutex lock;
+    CondVar cv;
+    // 统计（启动以来）
+    u32 high_water;         // 同时占用块数的峰值
+    u64 acquires;
+    u64 waits;              // 申请时没有空闲块、需要等待的次数
+    u64 wait_ns;
+    u64 failures;           // 等待超时或 try 申请落空的次数
+} BufPool;
+
+typedef struct {
+    u32 block_size;
+    u32 count;
+    u32 in_use;
+    u32 high_water;
+    u64 acquires;
+    u64 waits;
+    u64 wait_ns;
+    u64 failures;
+} BufPoolStats;
+
+// 一次申请 count 个 block_size 字节的块（block_size 向上取到 MEMPOOL_ALIGN 的倍数）
+Result bufpool_init(BufPool *p, u32 block_size, u32 count);
+void bufpool_exit(BufPool *p);
+// 取一块；没有空闲块时最多等 timeout_ns（0 = 不等），超时返回 NULL 并计入 failures
+void *bufpool_acquire(BufPool *p, u64 timeout_ns);
+void bufpool_release(BufPool *p, void *block);
+u32 bufpool_available(BufPool *p);
+void bufpool_stats(BufPool *p, BufPoolStats *out);
+
+typedef struct MemArenaBlock MemArenaBlock;
+
+typedef struct {
+    MemArenaBlock *first;
+    MemArenaBlock *current;
+    size_t budget;          // 各块合计的上限
+    size_t reserved;        // 已向堆申请的字节数（复位后保留）
+    size_t used;            // 本轮已分配的字节数（含对齐）
+    size_t high_water;      // 启动以来单轮 used 的峰值
+    u64 failures;           // 超出预算或堆上申请失败的次数
+    Mutex lock;             // 扫描线程会并发分配
+} MemArena;
+
+void mem_arena_init(MemArena *a, size_t budget);
+// 归还全部块
+void mem_arena_exit(MemArena *a);
+// 丢弃本轮的全部分配，块留着复用
+void mem_arena_reset(MemArena *a);
+// 超出预算时返回 NULL（计入 failures），不会再向堆多要
+void *mem_arena_alloc(MemArena *a, size_t size);
+void *mem_arena_calloc(MemArena *a, size_t count, size_t size);
+char *mem_arena_strdup(MemArena *a, const char *s);
@@ -0,0 +1,297 @@
+#include "metrics.h"
+#include "fspool.h"
+#include "service.h"
+#include "log.h"
+#include "threading.h"
+#include <stdatomic.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <malloc.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define METRICS_POLL_NS 500000000ULL            // 监听端口时每次 select 的最长等待（也是响应 stop 的粒度）
+#define METRICS_REQUEST_TIMEOUT_NS 1000000000ULL // 等请求头的时间，不发请求的客户端不会拖住导出线程
+#define MS(x) ((x) * 1000000ULL)
+#define SEC(x) ((x) * 1000000000ULL)
+
+#ifdef MSG_NOSIGNAL
+#define METRICS_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define METRICS_SEND_FLAGS 0
+#endif
+
+typedef struct {
+    const char *name;
+    const char *help;
+    MetricType type;
+    bool seconds;           // 值以纳秒记录，导出为秒
+    const u64 *bounds;      // 直方图各桶上界（升序，含等于）
+    u32 bound_count;
+} MetricDesc;
+
+typedef struct {
+    atomic_ullong value;    // 计数器/仪表的值；直方图为观测值之和
+    atomic_ullong buckets[METRICS_MAX_BUCKETS + 1]; // 直方图各桶（非累计），最后一个为 +Inf
+} MetricCell;
+
+static const u64 s_frame_draw_bounds[] = { MS(1), MS(2), MS(4), MS(8), MS(16), MS(33), MS(50), MS(100), MS(250) };
+static const u64 s_frame_interval_bounds[] = { MS(16), MS(33), MS(50), MS(66), MS(83), MS(100), MS(150), MS(250), MS(500), MS(1000) };
+static const u64 s_backup_bounds[] = { SEC(1), SEC(5), SEC(10), SEC(30), SEC(60), SEC(120), SEC(300), SEC(600), SEC(1800) };
+
+#define HISTOGRAM(b) MetricType_Histogram, true, b, sizeof(b) / sizeof(b[0])
+
+static const MetricDesc s_desc[Metric_Count] = {
+    [Metric_Frames]           = { "mario_pop_frames_total", "已提交的帧数", MetricType_Counter },
+    [Metric_FrameDraw]        = { "mario_pop_frame_draw_seconds", "每帧的绘制耗时（不含等待垂直同步）", HISTOGRAM(s_frame_draw_bounds) },
+    [Metric_FrameInterval]    = { "mario_pop_frame_interval_seconds", "相邻两帧开始的间隔", HISTOGRAM(s_frame_interval_bounds) },
+    [Metric_PixelsDrawn]      = { "mario_pop_pixels_drawn_total", "写入帧缓冲的像素数", MetricType_Counter },
+    [Metric_LogLines]         = { "mario_pop_log_lines_total", "写入日志的行数", MetricType_Counter },
+    [Metric_LogDropped]       = { "mario_pop_log_dropped_total", "因日志文件打不开或写入失败而丢掉的行数", MetricType_Counter },
+    [Metric_Backups]          = { "mario_pop_backups_total", "执行的备份次数", MetricType_Counter },
+    [Metric_BackupFailures]   = { "mario_pop_backup_failures_total", "失败的备份次数", MetricType_Counter },
+    [Metric_BackupDuration]   = { "mario_pop_backup_duration_seconds", "每次备份的总耗时", HISTOGRAM(s_backup_bounds) },
+    [Metric_UploadBytes]      = { "mario_pop_upload_bytes_total", "交给 FTP 连接的字节数（含重传）", MetricType_Counter },
+    [Metric_UploadFiles]      = { "mario_pop_upload_files_total", "上传成功的文件数", MetricType_Counter },
+    [Metric_UploadFailedFiles] = { "mario_pop_upload_failed_files_total", "上传失败的文件数", MetricType_Counter },
+    [Metric_UploadRetries]    = { "mario_pop_upload_retries_total", "传输中断后的重试次数", MetricType_Counter },
+    [Metric_HeapUsed]         = { "mario_pop_heap_used_bytes", "已分配的堆字节数", MetricType_Gauge },
+    [Metric_HeapArena]        = { "mario_pop_heap_arena_bytes", "malloc 已取得的堆字节数", MetricType_Gauge },
+    [Metric_HeapSize]         = { "mario_pop_heap_size_bytes", "进程堆的总大小", MetricType_Gauge },
+};
+
+static MetricCell s_cells[Metric_Count];
+
+void metrics_add(MetricId id, u64 n) {
+    atomic_fetch_add_explicit(&s_cells[id].value, n, memory_order_relaxed);
+}
+
+void metrics_set(MetricId id, u64 value) {
+    atomic_store_explicit(&s_cells[id].value, value, memory_order_relaxed);
+}
+
+void metrics_observe(MetricId id, u64 value) {
+    const MetricDesc *d = &s_desc[id];
+    u32 b = 0;
+    while (b < d->bound_count && value > d->bounds[b]) b++;
+    atomic_fetch_add_explicit(&s_cells[id].buckets[b], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&s_cells[id].value, value, memory_order_relaxed);
+}
+
+u64 metrics_get(MetricId id) {
+    if (s_desc[id].type != MetricType_Histogram) return atomic_load_explicit(&s_cells[id].value, memory_order_relaxed);
+    u64 count = 0;
+    for (u32 b = 0; b <= s_desc[id].bound_count; ++b) count += atomic_load_explicit(&s_cells[id].buckets[b], memory_order_relaxed);
+    return count;
+}
+
+typedef struct {
+    char *out;
+    size_t size;
+    size_t len;
+    bool full;
+} MetricsText;
+
+// 放不下的行整行丢弃，之后的行也不再写
+static void text_line(MetricsText *t, const char *fmt, ...) {
+    if (t->full) return;
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(t->out + t->len, t->size - t->len, fmt, args);
+    va_end(args);
+    if (n < 0 || (size_t)n >= t->size - t->len) {
+        t->full = true;
+        t->out[t->len] = '\0';
+        return;
+    }
+    t->len += (size_t)n;
+}
+
+static void text_value(char *out, size_t size, u64 value, bool seconds) {
+    if (seconds) snprintf(out, size, "%.6f", (double)value / 1e9);
+    else snprintf(out, size, "%llu", (unsigned long long)value);
+}
+
+size_t metrics_format(char *out, size_t size) {
+    if (!size) return 0;
+    MetricsText t = { out, size, 0, false };
+    out[0] = '\0';
+    static const char *const type_names[] = { "counter", "gauge", "histogram" };
+    char value[32];
+    for (int i = 0; i < Metric_Count; ++i) {
+        const MetricDesc *d = &s_desc[i];
+        text_line(&t, "# HELP %s %s\n# TYPE %s %s\n", d->name, d->help, d->name, type_names[d->type]);
+        if (d->type != MetricType_Histogram) {
+            text_value(value, sizeof(value), atomic_load_explicit(&s_cells[i].value, memory_order_relaxed), d->seconds);
+            text_line(&t, "%s %s\n", d->name, value);
+            continue;
+        }
+        // 各桶逐个读取，与并发的 observe 之间不保证一致；count 取各桶之和，保证与 +Inf 桶相等
+        u64 cumulative = 0;
+        for (u32 b = 0; b < d->bound_count; ++b) {
+            cumulative += atomic_load_explicit(&s_cells[i].buckets[b], memory_order_relaxed);
+            text_line(&t, "%s_bucket{le=\"%g\"} %llu\n", d->name, d->seconds ? (double)d->bounds[b] / 1e9 : (double)d->bounds[b],
+                      (unsigned long long)cumulative);
+        }
+        cumulative += atomic_load_explicit(&s_cells[i].buckets[d->bound_count], memory_order_relaxed);
+        text_line(&t, "%s_bucket{le=\"+Inf\"} %llu\n", d->name, (unsigned long long)cumulative);
+        text_value(value, sizeof(value), atomic_load_explicit(&s_cells[i].value, memory_order_relaxed), d->seconds);
+        text_line(&t, "%s_sum %s\n%s_count %llu\n", d->name, value, d->name, (unsigned long long)cumulative);
+    }
+    return t.len;
+}
+
+// ---- 导出线程 ----
+
+static AppThread s_thread;
+static bool s_started;
+static Mutex s_lock;
+static CondVar s_cv;
+static atomic_bool s_stop;
+static u32 s_interval_s;
+static u16 s_port;
+static char s_text[METRICS_TEXT_MAX];   // 只由导出线程使用
+static bool s_write_warned;
+
+static void metrics_sample_heap(void) {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 mi = mallinfo2();
+#else
+    struct mallinfo mi = mallinfo();
+#endif
+    metrics_set(Metric_HeapUsed, (u64)mi.uordblks);
+    metrics_set(Metric_HeapArena, (u64)mi.arena);
+}
+
+// 先写 .tmp 再替换，读取方不会看到写了一半的文件
+static void metrics_write_file(void) {
+    metrics_sample_heap();
+    size_t len = metrics_format(s_text, sizeof(s_text));
+    const char *tmp = METRICS_FILE_PATH ".tmp";
+    fspool_enter(FsRole_Log);
+    FILE *f = fopen(tmp, "wb");
+    bool ok = f && fwrite(s_text, 1, len, f) == len;
+    if (f) ok = fclose(f) == 0 && ok;
+    if (ok) {
+        remove(METRICS_FILE_PATH);
+        ok = rename(tmp, METRICS_FILE_PATH) == 0;
+    }
+    if (!ok) remove(tmp);
+    fspool_leave(FsRole_Log);
+    // 只报一次，SD 不可写时不刷屏
+    if (!ok && !s_write_warned) log_warning("指标文件写入失败：%s", METRICS_FILE_PATH);
+    s_write_warned = s_write_warned || !ok;
+}
+
+static int metrics_listen(u16 port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 2) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool wait_readable(int fd, u64 timeout_ns) {
+    fd_set set;
+    FD_ZERO(&set);
+    FD_SET(fd, &set);
+    struct timeval tv = { (time_t)(timeout_ns / 1000000000ULL), (long)(timeout_ns % 1000000000ULL / 1000) };
+    return select(fd + 1, &set, NULL, NULL, &tv) > 0;
+}
+
+static bool send_all(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, METRICS_SEND_FLAGS);
+        if (n <= 0) return false;
+        data += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+// 读完请求头再回复（不解析路径，任何请求都返回指标文本）；回复不超过 TCP 发送缓冲，不会阻塞在对方不读上
+static void metrics_serve(int listen_fd) {
+    int fd = accept(listen_fd, NULL, NULL);
+    if (fd < 0) return;
+    char req[1024];
+    size_t req_len = 0;
+    while (req_len < sizeof(req) - 1 && wait_readable(fd, METRICS_REQUEST_TIMEOUT_NS)) {
+        ssize_t n = recv(fd, req + req_len, sizeof(req) - 1 - req_len, 0);
+        if (n <= 0) break;
+        req_len += (size_t)n;
+        req[req_len] = '\0';
+        if (strstr(req, "\r\n\r\n")) break;
+    }
+    metrics_sample_heap();
+    size_t len = metrics_format(s_text, sizeof(s_text));
+    char head[160];
+    int n = snprintf(head, sizeof(head),
+                     "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n", len);
+    if (send_all(fd, head, (size_t)n)) send_all(fd, s_text, len);
+    close(fd);
+}
+
+static void metrics_thread_main(void *arg) {
+    (void)arg;
+    int listen_fd = -1;
+    if (s_port) {
+        Result rc = service_require(ServiceId_Socket);
+        if (R_SUCCEEDED(rc)) listen_fd = metrics_listen(s_port);
+        if (listen_fd < 0) log_error("指标端口 %u 监听失败", s_port);
+        else log_info("指标：端口 %u 以 HTTP 提供", s_port);
+    }
+    u64 interval_ns = (u64)s_interval_s * 1000000000ULL;
+    u64 next_write = armGetSystemTick();
+    while (!atomic_load(&s_stop)) {
+        u64 now = armGetSystemTick();
+        if (interval_ns && now >= next_write) {
+            metrics_write_file();
+            next_write = now + armNsToTicks(interval_ns);
+        }
+        u64 wait_ns = interval_ns ? armTicksToNs(next_write - now) : METRICS_POLL_NS;
+        if (listen_fd >= 0) {
+            if (wait_ns > METRICS_POLL_NS) wait_ns = METRICS_POLL_NS;
+            if (wait_readable(listen_fd, wait_ns)) metrics_serve(listen_fd);
+        } else {
+            mutexLock(&s_lock);
+            if (!atomic_load(&s_stop)) condvarWaitTimeout(&s_cv, &s_lock, wait_ns);
+            mutexUnlock(&s_lock);
+        }
+    }
+    if (listen_fd >= 0) close(listen_fd);
+    if (interval_ns) metrics_write_file(); // 退出前留下最后一份
+}
+
+Result metrics_start(const AppConfig *cfg) {
+    if (s_started || (!cfg->metrics_interval_s && !cfg->metrics_port)) return 0;
+    s_interval_s = cfg->metrics_interval_s;
+    s_port = (u16)cfg->metrics_port;
+    atomic_store(&s_stop, false);
+    Result rc = app_thread_start(&s_thread, ThreadRole_Export, NULL, metrics_thread_main, NULL);
+    if (R_FAILED(rc)) return rc;
+    s_started = true;
+    return 0;
+}
+
+void metrics_stop(void) {
+    if (!s_started) return;
+    mutexLock(&s_lock);
+    atomic_store(&s_stop, true);
+    condvarWakeAll(&s_cv);
+    mutexUnlock(&s_lock);
+    app_thread_join(&s_thread);
+    s_started = false;
+}
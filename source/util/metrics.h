@@ -0,0 +1,50 @@
+#pragma once
+// 运行指标：计数器、仪表与定长分桶直方图，任意线程都可以更新（只做 relaxed 原子操作，不加锁、不做 IO）。
+// 导出线程每隔 metrics_interval_s 秒把全部指标格式化成 Prometheus 文本，写到 SD 上的小文件
+// （先写 .tmp 再替换）；metrics_port 非 0 时还在该端口上以 HTTP 提供同样的文本。
+// 格式化只读取原子变量，渲染与上传线程永远不会因为导出而等待
+#include "platform.h"
+#include "config.h"
+
+#define METRICS_FILE_PATH "/config/mario-pop/metrics.prom"
+#define METRICS_TEXT_MAX 8192
+#define METRICS_MAX_BUCKETS 12
+
+typedef enum {
+    MetricType_Counter,
+    MetricType_Gauge,
+    MetricType_Histogram,
+} MetricType;
+
+typedef enum {
+    Metric_Frames = 0,
+    Metric_FrameDraw,           // 直方图（纳秒）：startFrame 到提交前的绘制耗时
+    Metric_FrameInterval,       // 直方图（纳秒）：相邻两帧开始的间隔
+    Metric_PixelsDrawn,
+    Metric_LogLines,
+    Metric_LogDropped,          // 日志文件打不开或写入失败而丢掉的行
+    Metric_Backups,
+    Metric_BackupFailures,
+    Metric_BackupDuration,      // 直方图（纳秒）
+    Metric_UploadBytes,         // 交给 FTP 连接的字节数（重传部分也计入）
+    Metric_UploadFiles,
+    Metric_UploadFailedFiles,
+    Metric_UploadRetries,
+    Metric_HeapUsed,            // 仪表：已分配的堆字节数（导出时采样）
+    Metric_HeapArena,           // 仪表：malloc 已向系统取得的字节数
+    Metric_HeapSize,            // 仪表：堆的总大小（启动时设置）
+    Metric_Count,
+} MetricId;
+
+void metrics_add(MetricId id, u64 n);
+static inline void metrics_inc(MetricId id) { metrics_add(id, 1); }
+void metrics_set(MetricId id, u64 value);
+void metrics_observe(MetricId id, u64 value);
+u64 metrics_get(MetricId id);  // 计数器与仪表的当前值，直方图为观测次数
+
+// 格式化成 Prometheus 文本（超出 size 时截断在整行处），返回写入的长度
+size_t metrics_format(char *out, size_t size);
+
+// 启动导出线程（间隔与端口都为 0 时不启动）；metrics_stop 等它退出
+Result metrics_start(const AppConfig *cfg);
+void metrics_stop(void);
@@ -0,0 +1,100 @@
+#pragma once
+// 平台适配：在 Switch 上直接使用 libnx；在 Linux 主机上提供同名的最小替身，
+// 让不直接依赖系统服务的模块（进度、追踪、服务调度等）可以在主机上编译与测试
+#ifdef __SWITCH__
+
+#include <switch.h>
+
+#else
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+#include <pthread.h>
+
+typedef uint8_t  u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t   s8;
+typedef int16_t  s16;
+typedef int32_t  s32;
+typedef int64_t  s64;
+typedef u32 Result;
+
+#define R_SUCCEEDED(res) ((res) == 0)
+#define R_FAILED(res)    ((res) != 0)
+#define MAKERESULT(module, description) \
+    ((((module) & 0x1FF)) | ((description) & 0x1FFF) << 9)
+#define Module_Libnx 345
+enum {
+    LibnxError_BadInput = 1,
+    LibnxError_OutOfMemory = 2,
+    LibnxError_NotFound = 3,
+    LibnxError_IoError = 4,
+    LibnxError_NotInitialized = 5,
+};
+
+// 互斥量：与 libnx 一样零初始化即可使用
+typedef pthread_mutex_t Mutex;
+static inline void mutexInit(Mutex *m) { pthread_mutex_init(m, NULL); }
+static inline void mutexLock(Mutex *m) { pthread_mutex_lock(m); }
+static inline void mutexUnlock(Mutex *m) { pthread_mutex_unlock(m); }
+static inline bool mutexTryLock(Mutex *m) { return pthread_mutex_trylock(m) == 0; }
+
+// 条件变量：零初始化即可使用
+typedef pthread_cond_t CondVar;
+static inline void condvarInit(CondVar *c) { pthread_cond_init(c, NULL); }
+static inline Result condvarWait(CondVar *c, Mutex *m) { return (Result)pthread_cond_wait(c, m); }
+static inline Result condvarWaitTimeout(CondVar *c, Mutex *m, u64 timeout_ns) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    u64 ns = (u64)ts.tv_nsec + timeout_ns;
+    ts.tv_sec += (time_t)(ns / 1000000000ULL);
+    ts.tv_nsec = (long)(ns % 1000000000ULL);
+    return (Result)pthread_cond_timedwait(c, m, &ts);
+}
+static inline Result condvarWakeOne(CondVar *c) { return (Result)pthread_cond_signal(c); }
+static inline Result condvarWakeAll(CondVar *c) { return (Result)pthread_cond_broadcast(c); }
+
+// 线程：参数与 libnx threadCreate 一致，栈/优先级/核心在主机上忽略
+typedef void (*ThreadFunc)(void *);
+typedef struct {
+    pthread_t handle;
+    ThreadFunc entry;
+    void *arg;
+} Thread;
+
+static inline void *host_thread_trampoline(void *p) {
+    Thread *t = (Thread*)p;
+    t->entry(t->arg);
+    return NULL;
+}
+static inline Result threadCreate(Thread *t, ThreadFunc entry, void *arg, void *stack_mem, size_t stack_sz, int prio, int cpuid) {
+    (void)stack_mem; (void)stack_sz; (void)prio; (void)cpuid;
+    t->entry = entry;
+    t->arg = arg;
+    return 0;
+}
+static inline Result threadStart(Thread *t) { return (Result)pthread_create(&t->handle, NULL, host_thread_trampoline, t); }
+static inline Result threadWaitForExit(Thread *t) { return (Result)pthread_join(t->handle, NULL); }
+static inline Result threadClose(Thread *t) { (void)t; return 0; }
+
+// 系统时钟：与 Switch 一致按 19.2MHz 计数
+#define HOST_TICK_FREQ 19200000ULL
+static inline u64 armGetSystemTick(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * HOST_TICK_FREQ + (u64)ts.tv_nsec * 12 / 625;
+}
+static inline u64 armTicksToNs(u64 tick) { return tick * 625 / 12; }
+static inline u64 armNsToTicks(u64 ns) { return ns * 12 / 625; }
+
+static inline void svcSleepThread(s64 nano) {
+    if (nano <= 0) return;
+    struct timespec ts = { (time_t)(nano / 1000000000LL), (long)(nano % 1000000000LL) };
+    nanosleep(&ts, NULL);
+}
+
+#endif
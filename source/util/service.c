@@ -0,0 +1,175 @@
+#include "service.h"
+#include "trace.h"
+
+#ifdef __SWITCH__
+#include <switch/runtime/devices/fs_dev.h>
+#include <switch/services/nv.h>
+#include <switch/nvidia/map.h>
+#include <switch/nvidia/fence.h>
+#endif
+
+typedef struct {
+    const char *name;
+    Result (*init)(void);
+    void (*exit)(void);
+    ServiceId deps[2];  // ServiceId_Count 表示无
+} ServiceDesc;
+
+#ifdef __SWITCH__
+
+static Result fs_sdmc_init(void) {
+    Result rc = fsInitialize();
+    if (R_SUCCEEDED(rc)) fsdevMountSdmc();
+    return rc;
+}
+
+static void fs_sdmc_exit(void) {
+    fsdevUnmountAll();
+    fsExit();
+}
+
+// 套接字传输内存从本进程堆中分配：默认配置约需 2MB，这里收紧发送窗口并降低 sb_efficiency，
+// 总共约 0.6MB，给上传缓冲与 curl 留出空间
+static Result socket_init(void) {
+    static const SocketInitConfig cfg = {
+        .tcp_tx_buf_size     = 0x8000,
+        .tcp_rx_buf_size     = 0x4000,
+        .tcp_tx_buf_max_size = 0x40000,
+        .tcp_rx_buf_max_size = 0x8000,
+        .udp_tx_buf_size     = 0x2400,
+        .udp_rx_buf_size     = 0xA500,
+        .sb_efficiency       = 2,
+        .num_bsd_sessions    = 3,
+        .bsd_service_type    = BsdServiceType_User,
+    };
+    return socketInitialize(&cfg);
+}
+
+#define SERVICE_FN(init_fn, exit_fn) init_fn, exit_fn
+
+#else
+
+// 主机替身：只记录调用顺序
+static Result s_mock_results[ServiceId_Count];
+static int s_mock_events[ServiceId_Count * 4];
+static int s_mock_event_count;
+
+static void mock_record(int ev) {
+    if (s_mock_event_count < (int)(sizeof(s_mock_events) / sizeof(s_mock_events[0]))) {
+        s_mock_events[s_mock_event_count++] = ev;
+    }
+}
+
+#define DEFINE_MOCK_SERVICE(id) \
+    static Result mock_init_##id(void) { mock_record(ServiceId_##id); return s_mock_results[ServiceId_##id]; } \
+    static void mock_exit_##id(void) { mock_record(~ServiceId_##id); }
+DEFINE_MOCK_SERVICE(Sm)
+DEFINE_MOCK_SERVICE(Fs)
+DEFINE_MOCK_SERVICE(Hid)
+DEFINE_MOCK_SERVICE(Set)
+DEFINE_MOCK_SERVICE(Nv)
+DEFINE_MOCK_SERVICE(NvMap)
+DEFINE_MOCK_SERVICE(NvFence)
+DEFINE_MOCK_SERVICE(Socket)
+DEFINE_MOCK_SERVICE(PmDmnt)
+
+#define smInitialize  mock_init_Sm
+#define smExit        mock_exit_Sm
+#define fs_sdmc_init  mock_init_Fs
+#define fs_sdmc_exit  mock_exit_Fs
+#define hidInitialize mock_init_Hid
+#define hidExit       mock_exit_Hid
+#define setInitialize mock_init_Set
+#define setExit       mock_exit_Set
+#define nvInitialize  mock_init_Nv
+#define nvExit        mock_exit_Nv
+#define nvMapInit     mock_init_NvMap
+#define nvMapExit     mock_exit_NvMap
+#define nvFenceInit   mock_init_NvFence
+#define nvFenceExit   mock_exit_NvFence
+#define socket_init   mock_init_Socket
+#define socketExit    mock_exit_Socket
+#define pmdmntInitialize mock_init_PmDmnt
+#define pmdmntExit    mock_exit_PmDmnt
+
+void service_mock_set_result(ServiceId id, Result rc) {
+    if (id < ServiceId_Count) s_mock_results[id] = rc;
+}
+
+int service_mock_events(int *out, int max) {
+    int n = s_mock_event_count < max ? s_mock_event_count : max;
+    for (int i = 0; i < n; ++i) out[i] = s_mock_events[i];
+    return s_mock_event_count;
+}
+
+void service_mock_reset(void) {
+    service_exit_all();
+    s_mock_event_count = 0;
+    for (int i = 0; i < ServiceId_Count; ++i) s_mock_results[i] = 0;
+}
+
+#endif
+
+static const ServiceDesc s_services[ServiceId_Count] = {
+    [ServiceId_Sm]      = { "sm",      smInitialize,  smExit,       { ServiceId_Count, ServiceId_Count } },
+    [ServiceId_Fs]      = { "fs",      fs_sdmc_init,  fs_sdmc_exit, { ServiceId_Sm,    ServiceId_Count } },
+    [ServiceId_Hid]     = { "hid",     hidInitialize, hidExit,      { ServiceId_Sm,    ServiceId_Count } },
+    [ServiceId_Set]     = { "set",     setInitialize, setExit,      { ServiceId_Sm,    ServiceId_Count } },
+    [ServiceId_Nv]      = { "nv",      nvInitialize,  nvExit,       { ServiceId_Sm,    ServiceId_Count } },
+    [ServiceId_NvMap]   = { "nvMap",   nvMapInit,     nvMapExit,    { ServiceId_Nv,    ServiceId_Count } },
+    [ServiceId_NvFence] = { "nvFence", nvFenceInit,   nvFenceExit,  { ServiceId_Nv,    ServiceId_NvMap } },
+    [ServiceId_Socket]  = { "socket",  socket_init,   socketExit,   { ServiceId_Sm,    ServiceId_Count } },
+    [ServiceId_PmDmnt]  = { "pmdmnt",  pmdmntInitialize, pmdmntExit, { ServiceId_Sm,   ServiceId_Count } },
+};
+
+static Mutex s_service_mutex;
+static bool s_ready[ServiceId_Count];
+static ServiceId s_init_order[ServiceId_Count];
+static int s_init_count;
+
+static Result service_require_locked(ServiceId id) {
+    if (s_ready[id]) return 0;
+    const ServiceDesc *desc = &s_services[id];
+    for (int i = 0; i < 2; ++i) {
+        if (desc->deps[i] == ServiceId_Count) continue;
+        Result rc = service_require_locked(desc->deps[i]);
+        if (R_FAILED(rc)) return rc;
+    }
+    u32 t = trace_begin(desc->name);
+    Result rc = desc->init();
+    trace_end(t, rc);
+    if (R_FAILED(rc)) return rc;
+    s_ready[id] = true;
+    s_init_order[s_init_count++] = id;
+    return 0;
+}
+
+Result service_require(ServiceId id) {
+    if (id >= ServiceId_Count) return MAKERESULT(Module_Libnx, LibnxError_BadInput);
+    mutexLock(&s_service_mutex);
+    Result rc = service_require_locked(id);
+    mutexUnlock(&s_service_mutex);
+    return rc;
+}
+
+bool service_is_ready(ServiceId id) {
+    if (id >= ServiceId_Count) return false;
+    mutexLock(&s_service_mutex);
+    bool ready = s_ready[id];
+    mutexUnlock(&s_service_mutex);
+    return ready;
+}
+
+const char *service_name(ServiceId id) {
+    return id < ServiceId_Count ? s_services[id].name : "?";
+}
+
+void service_exit_all(void) {
+    mutexLock(&s_service_mutex);
+    while (s_init_count > 0) {
+        ServiceId id = s_init_order[--s_init_count];
+        s_services[id].exit();
+        s_ready[id] = false;
+    }
+    mutexUnlock(&s_service_mutex);
+}
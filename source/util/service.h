@@ -0,0 +1,32 @@
+#pragma once
+// 按需初始化系统服务：首次 service_require 时才连同依赖一起初始化，
+// 每个服务的初始化耗时记入启动追踪（trace.h）；退出时按初始化的逆序释放
+#include "platform.h"
+
+typedef enum {
+    ServiceId_Sm = 0,
+    ServiceId_Fs,       // fsInitialize + 挂载 sdmc
+    ServiceId_Hid,
+    ServiceId_Set,
+    ServiceId_Nv,
+    ServiceId_NvMap,
+    ServiceId_NvFence,
+    ServiceId_Socket,   // bsd 套接字（上传用），缓冲按 4MB 堆收紧
+    ServiceId_PmDmnt,   // 查询前台应用（备份限速用）
+    ServiceId_Count,
+} ServiceId;
+
+// 初始化服务（已初始化时直接返回 0），依赖先于自身初始化；线程安全
+Result service_require(ServiceId id);
+bool service_is_ready(ServiceId id);
+const char *service_name(ServiceId id);
+// 逆序释放所有已初始化的服务
+void service_exit_all(void);
+
+#ifndef __SWITCH__
+// 主机替身：记录初始化/释放顺序，并可注入初始化失败
+void service_mock_set_result(ServiceId id, Result rc);
+// 返回已记录的事件数；初始化记为 id，释放记为 ~id
+int service_mock_events(int *out, int max);
+void service_mock_reset(void);
+#endif
@@ -0,0 +1,236 @@
+#ifndef __SWITCH__
+#define _GNU_SOURCE
+#endif
+#include "threading.h"
+#include "log.h"
+#include <stdio.h>
+#include <string.h>
+#ifndef __SWITCH__
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+// 游戏占用 0–2 号核心，本进程的所有角色都只用 3 号核心（与 sysmodule.json 的 default_cpu_id 一致）
+#define THREADING_SYSTEM_CORE_MASK (1ULL << 3)
+#define THREADING_PRIORITY_HIGHEST 0x18     // sysmodule.json 允许的范围
+#define THREADING_PRIORITY_LOWEST 0x3F
+
+static const ThreadPolicy s_policies[ThreadRole_Count] = {
+    // 与 sysmodule.json 的 main_thread_priority、main_thread_stack_size 一致
+    [ThreadRole_Render] = { "render", 0x31, THREADING_SYSTEM_CORE_MASK, 0x4000 },
+    // curl 的调用栈较深
+    [ThreadRole_Backup] = { "backup", 0x2D, THREADING_SYSTEM_CORE_MASK, 0x10000 },
+    // 略高于备份线程，保证环中总有数据可发
+    [ThreadRole_Reader] = { "reader", 0x2C, THREADING_SYSTEM_CORE_MASK, 0x4000 },
+    [ThreadRole_Scan]   = { "scan",   0x2D, THREADING_SYSTEM_CORE_MASK, 0x4000 },
+    // 低于渲染与备份线程
+    [ThreadRole_Export] = { "export", 0x3B, THREADING_SYSTEM_CORE_MASK, 0x4000 },
+};
+
+typedef struct {
+    u32 started;
+    u32 running;
+    u64 exited_cpu_ns;
+} RoleState;
+
+static Mutex s_lock;
+static RoleState s_roles[ThreadRole_Count];
+static AppThread *s_live[THREADING_MAX_LIVE];
+static AppThread s_main;
+
+const ThreadPolicy *threading_policy(ThreadRole role) {
+    return &s_policies[role];
+}
+
+#ifdef __SWITCH__
+
+static int clamp_priority(int prio) {
+    if (prio < THREADING_PRIORITY_HIGHEST) return THREADING_PRIORITY_HIGHEST;
+    if (prio > THREADING_PRIORITY_LOWEST) return THREADING_PRIORITY_LOWEST;
+    return prio;
+}
+
+// 进程允许的核心（npdm 的 lowest_cpu_id..highest_cpu_id）
+static u64 process_core_mask(void) {
+    static u64 mask;
+    if (!mask) {
+        u64 m = 0;
+        if (R_FAILED(svcGetInfo(&m, InfoType_CoreMask, CUR_PROCESS_HANDLE, 0)) || !m) m = THREADING_SYSTEM_CORE_MASK;
+        mask = m;
+    }
+    return mask;
+}
+
+static u64 effective_core_mask(u64 wanted) {
+    u64 allowed = process_core_mask();
+    return (wanted & allowed) ? (wanted & allowed) : allowed;
+}
+
+static u64 handle_cpu_ns(Handle handle) {
+    u64 ticks = 0;
+    if (R_FAILED(svcGetInfo(&ticks, InfoType_ThreadTickCount, handle, UINT64_MAX))) return 0;
+    return armTicksToNs(ticks);
+}
+
+static u64 thread_cpu_ns(const AppThread *t) {
+    return handle_cpu_ns(t->thread.handle);
+}
+
+static u64 current_thread_cpu_ns(void) {
+    return handle_cpu_ns(CUR_THREAD_HANDLE);
+}
+
+#else
+
+// 第 n 位对应第 n % CPU 数 个 CPU，再与进程当前的亲和性取交集；交集为空返回 false（不设亲和性）
+static bool host_cpu_set(u64 mask, cpu_set_t *out) {
+    cpu_set_t allowed;
+    CPU_ZERO(out);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return false;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus < 1) cpus = 1;
+    for (int n = 0; n < 64; ++n) {
+        int cpu = (int)(n % cpus);
+        if ((mask >> n) & 1 && CPU_ISSET(cpu, &allowed)) CPU_SET(cpu, out);
+    }
+    return CPU_COUNT(out) > 0;
+}
+
+static u64 clock_ns(clockid_t clk) {
+    struct timespec ts;
+    if (clock_gettime(clk, &ts) != 0) return 0;
+    return (u64)ts.tv_sec * 1000000000ULL + (u64)ts.tv_nsec;
+}
+
+static u64 thread_cpu_ns(const AppThread *t) {
+    clockid_t clk;
+    if (pthread_getcpuclockid(t->thread.handle, &clk) != 0) return 0;
+    return clock_ns(clk);
+}
+
+static u64 current_thread_cpu_ns(void) {
+    return clock_ns(CLOCK_THREAD_CPUTIME_ID);
+}
+
+#endif
+
+// 登记到运行中的线程表（表满时不登记，只影响运行中 CPU 时间的统计）；调用方持有 s_lock
+static void register_thread(AppThread *t) {
+    t->slot = -1;
+    for (int i = 0; i < THREADING_MAX_LIVE; ++i) {
+        if (!s_live[i]) {
+            s_live[i] = t;
+            t->slot = i;
+            break;
+        }
+    }
+    s_roles[t->role].started++;
+    s_roles[t->role].running++;
+}
+
+static void unregister_thread(AppThread *t, u64 cpu_ns) {
+    mutexLock(&s_lock);
+    if (t->slot >= 0) s_live[t->slot] = NULL;
+    t->slot = -1;
+    s_roles[t->role].running--;
+    s_roles[t->role].exited_cpu_ns += cpu_ns;
+    mutexUnlock(&s_lock);
+}
+
+static void app_thread_main(void *arg) {
+    AppThread *t = (AppThread*)arg;
+#ifndef __SWITCH__
+    pthread_setname_np(pthread_self(), t->name);
+#endif
+    t->entry(t->arg);
+    unregister_thread(t, current_thread_cpu_ns());
+}
+
+Result app_thread_start(AppThread *t, ThreadRole role, const char *name, ThreadFunc entry, void *arg) {
+    const ThreadPolicy *p = &s_policies[role];
+    memset(t, 0, sizeof(*t));
+    t->role = role;
+    t->entry = entry;
+    t->arg = arg;
+    t->slot = -1;
+    snprintf(t->name, sizeof(t->name), "%s", name && name[0] ? name : p->name);
+    // 创建与登记都在锁内：线程即使马上结束，也要等登记完成才能注销
+    mutexLock(&s_lock);
+    Result rc;
+#ifdef __SWITCH__
+    u64 mask = effective_core_mask(p->core_mask);
+    int core = __builtin_ctzll(mask);
+    rc = threadCreate(&t->thread, app_thread_main, t, NULL, p->stack_size, clamp_priority(p->priority), core);
+    if (R_SUCCEEDED(rc)) {
+        rc = svcSetThreadCoreMask(t->thread.handle, core, (u32)mask);
+        if (R_SUCCEEDED(rc)) rc = threadStart(&t->thread);
+        if (R_FAILED(rc)) threadClose(&t->thread);
+    }
+#else
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, p->stack_size < THREADING_HOST_MIN_STACK ? THREADING_HOST_MIN_STACK : p->stack_size);
+    cpu_set_t set;
+    if (host_cpu_set(p->core_mask, &set)) pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+    t->thread.entry = app_thread_main;
+    t->thread.arg = t;
+    rc = (Result)pthread_create(&t->thread.handle, &attr, host_thread_trampoline, &t->thread);
+    pthread_attr_destroy(&attr);
+#endif
+    if (R_SUCCEEDED(rc)) register_thread(t);
+    mutexUnlock(&s_lock);
+    return rc;
+}
+
+void app_thread_join(AppThread *t) {
+    threadWaitForExit(&t->thread);
+    threadClose(&t->thread);
+}
+
+Result threading_apply_current(ThreadRole role) {
+    const ThreadPolicy *p = &s_policies[role];
+    memset(&s_main, 0, sizeof(s_main));
+    s_main.role = role;
+    snprintf(s_main.name, sizeof(s_main.name), "%s", p->name);
+    Result rc = 0;
+#ifdef __SWITCH__
+    u64 mask = effective_core_mask(p->core_mask);
+    s_main.thread.handle = threadGetCurHandle();
+    rc = svcSetThreadPriority(CUR_THREAD_HANDLE, (u32)clamp_priority(p->priority));
+    if (R_SUCCEEDED(rc)) rc = svcSetThreadCoreMask(CUR_THREAD_HANDLE, __builtin_ctzll(mask), (u32)mask);
+#else
+    s_main.thread.handle = pthread_self();
+    cpu_set_t set;
+    if (host_cpu_set(p->core_mask, &set)) rc = (Result)pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+    mutexLock(&s_lock);
+    register_thread(&s_main);
+    mutexUnlock(&s_lock);
+    return rc;
+}
+
+void threading_stats(ThreadRole role, ThreadRoleStats *out) {
+    mutexLock(&s_lock);
+    out->started = s_roles[role].started;
+    out->running = s_roles[role].running;
+    out->cpu_ns = s_roles[role].exited_cpu_ns;
+    for (int i = 0; i < THREADING_MAX_LIVE; ++i) {
+        if (s_live[i] && s_live[i]->role == role) out->cpu_ns += thread_cpu_ns(s_live[i]);
+    }
+    mutexUnlock(&s_lock);
+}
+
+void threading_log_summary(void) {
+    char line[256];
+    size_t len = 0;
+    for (int i = 0; i < ThreadRole_Count; ++i) {
+        ThreadRoleStats st;
+        threading_stats((ThreadRole)i, &st);
+        if (!st.started) continue;
+        int n = snprintf(line + len, sizeof(line) - len, "%s%s %u 个/%llu ms", len ? "，" : "", s_policies[i].name,
+                         st.started, (unsigned long long)(st.cpu_ns / 1000000));
+        if (n < 0 || (size_t)n >= sizeof(line) - len) break;
+        len += (size_t)n;
+    }
+    if (len) log_info("线程 CPU 时间（启动以来）：%s", line);
+}
@@ -0,0 +1,54 @@
+#pragma once
+// 线程策略：进程内每个线程按角色取优先级、核心掩码与栈大小，在创建时一次设好，不再继承主线程的调度。
+// sysmodule.json 只允许 24..63 的优先级（数值越小越优先）与 3 号核心；角色的核心掩码与进程允许的核心取交集，
+// 交集为空时退回进程允许的全部核心，放宽 npdm 的核心范围后各角色自然落到各自的核心上。
+// 主线程的栈只有 0x4000，其余线程的栈在这里按实际调用深度逐个定，而不是一律给大栈。
+// 每个线程的 CPU 时间按角色累计（线程退出时记入），备份结束时写一行日志。
+// 主机上核心掩码映射为 pthread 亲和性（第 n 位对应第 n % CPU 数 个 CPU），栈至少 THREADING_HOST_MIN_STACK，优先级忽略
+#include "platform.h"
+
+#define THREADING_NAME_MAX 16
+#define THREADING_MAX_LIVE 16               // 同时登记的线程数上限（超出的照常运行，只是不计运行中的 CPU 时间）
+#define THREADING_HOST_MIN_STACK 0x40000    // 主机 libc 与 curl 的栈用量远大于 newlib
+
+typedef enum {
+    ThreadRole_Render = 0,  // 主线程：渲染循环与帧提交
+    ThreadRole_Backup,      // 触发引擎与备份流程，驱动 curl multi
+    ThreadRole_Reader,      // 上传读线程：读盘、摘要与压缩
+    ThreadRole_Scan,        // 目录遍历
+    ThreadRole_Export,      // 指标导出
+    ThreadRole_Count,
+} ThreadRole;
+
+typedef struct {
+    const char *name;
+    int priority;
+    u64 core_mask;          // 期望的核心（第 n 位 = n 号核心）
+    size_t stack_size;      // 主线程的栈由 npdm 决定，这里只作记录
+} ThreadPolicy;
+
+typedef struct {
+    Thread thread;
+    ThreadRole role;
+    ThreadFunc entry;
+    void *arg;
+    char name[THREADING_NAME_MAX];
+    s32 slot;               // 登记表中的位置，-1 = 未登记
+} AppThread;
+
+typedef struct {
+    u32 started;            // 启动以来创建的线程数（主线程计 1）
+    u32 running;
+    u64 cpu_ns;             // 已退出线程的合计加上运行中线程的当前值
+} ThreadRoleStats;
+
+const ThreadPolicy *threading_policy(ThreadRole role);
+// 按角色策略创建并启动线程；name 为空时用角色名
+Result app_thread_start(AppThread *t, ThreadRole role, const char *name, ThreadFunc entry, void *arg);
+// 等待线程退出并释放
+void app_thread_join(AppThread *t);
+// 把角色策略（优先级与核心掩码）应用到调用线程并登记，主线程启动时调用
+Result threading_apply_current(ThreadRole role);
+void threading_stats(ThreadRole role, ThreadRoleStats *out);
+// 以一行日志输出各角色的线程数与 CPU 时间
+void threading_log_summary(void);
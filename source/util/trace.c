@@ -0,0 +1,94 @@
+#include "trace.h"
+#include "log.h"
+#include <stdio.h>
+#include <string.h>
+
+static Mutex s_trace_mutex;
+static TracePhase s_phases[TRACE_MAX_PHASES];
+static u32 s_count;
+
+u32 trace_begin(const char *name) {
+    u64 now = armGetSystemTick();
+    mutexLock(&s_trace_mutex);
+    u32 id = TRACE_NONE;
+    if (s_count < TRACE_MAX_PHASES) {
+        id = s_count++;
+        s_phases[id].name = name;
+        s_phases[id].start_tick = now;
+        s_phases[id].end_tick = 0;
+        s_phases[id].rc = 0;
+    }
+    mutexUnlock(&s_trace_mutex);
+    return id;
+}
+
+void trace_end(u32 id, Result rc) {
+    u64 now = armGetSystemTick();
+    if (id == TRACE_NONE) return;
+    mutexLock(&s_trace_mutex);
+    if (id < s_count) {
+        s_phases[id].end_tick = now;
+        s_phases[id].rc = rc;
+    }
+    mutexUnlock(&s_trace_mutex);
+}
+
+u32 trace_count(void) {
+    mutexLock(&s_trace_mutex);
+    u32 n = s_count;
+    mutexUnlock(&s_trace_mutex);
+    return n;
+}
+
+bool trace_get(u32 id, TracePhase *out) {
+    bool ok = false;
+    mutexLock(&s_trace_mutex);
+    if (id < s_count && out) {
+        *out = s_phases[id];
+        ok = true;
+    }
+    mutexUnlock(&s_trace_mutex);
+    return ok;
+}
+
+u64 trace_elapsed_ns(void) {
+    u64 now = armGetSystemTick();
+    mutexLock(&s_trace_mutex);
+    u64 start = s_count ? s_phases[0].start_tick : now;
+    mutexUnlock(&s_trace_mutex);
+    return armTicksToNs(now - start);
+}
+
+void trace_log_summary(const char *title) {
+    // 汇总成一行：每条日志都会同步刷 SD，逐阶段打印本身就会拖慢启动
+    char line[1024];
+    size_t len = 0;
+    TracePhase phases[TRACE_MAX_PHASES];
+    mutexLock(&s_trace_mutex);
+    u32 n = s_count;
+    memcpy(phases, s_phases, sizeof(TracePhase) * n);
+    mutexUnlock(&s_trace_mutex);
+
+    for (u32 i = 0; i < n && len < sizeof(line); ++i) {
+        const TracePhase *p = &phases[i];
+        int w;
+        if (p->end_tick == 0) {
+            w = snprintf(line + len, sizeof(line) - len, "%s=? ", p->name);
+        } else {
+            u64 us = armTicksToNs(p->end_tick - p->start_tick) / 1000;
+            if (R_FAILED(p->rc)) {
+                w = snprintf(line + len, sizeof(line) - len, "%s=%u.%03ums(0x%x) ", p->name,
+                             (unsigned)(us / 1000), (unsigned)(us % 1000), p->rc);
+            } else {
+                w = snprintf(line + len, sizeof(line) - len, "%s=%u.%03ums ", p->name,
+                             (unsigned)(us / 1000), (unsigned)(us % 1000));
+            }
+        }
+        if (w < 0) break;
+        len += (size_t)w;
+    }
+    if (len >= sizeof(line)) len = sizeof(line) - 1;
+    line[len] = '\0';
+    u64 total_us = trace_elapsed_ns() / 1000;
+    log_info("%s: 总计 %u.%03ums | %s", title, (unsigned)(total_us / 1000), (unsigned)(total_us % 1000), line);
+}
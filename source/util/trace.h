@@ -0,0 +1,26 @@
+#pragma once
+// 启动追踪：记录各初始化阶段的 tick 耗时，启动结束后汇总成一行日志
+// 记录本身不做任何 IO，可以在日志可用之前（__appInit 早期）调用
+#include "platform.h"
+
+#define TRACE_MAX_PHASES 32
+#define TRACE_NONE ((u32)-1)
+
+typedef struct {
+    const char *name;   // 必须是静态字符串
+    u64 start_tick;
+    u64 end_tick;       // 0 表示尚未结束
+    Result rc;
+} TracePhase;
+
+u32 trace_begin(const char *name);
+void trace_end(u32 id, Result rc);
+
+// 查询（主机测试与汇总用）
+u32 trace_count(void);
+bool trace_get(u32 id, TracePhase *out);
+// 第一个阶段开始到现在的总耗时（纳秒）
+u64 trace_elapsed_ns(void);
+
+// 以一行日志输出所有阶段耗时（毫秒）
+void trace_log_summary(const char *title);
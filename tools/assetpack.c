@@ -0,0 +1,193 @@
+// 主题资源包打包工具（主机端）
+//
+// 构建：cc -O2 -Isource -o assetpack tools/assetpack.c source/util/assetpack.c -lpthread
+// 用法：
+//   assetpack pack <out.pak> [-k RRGGBB] <name>=<image.ppm> ...
+//       把 P6 PPM 图像转换为 RGBA4444 并按不透明像素段打包；-k 指定透明色（默认 000073，即 RGB565 的 0x000E 按位复制展开）
+//   assetpack list <file.pak>
+//   assetpack bench <file.pak> [name ...]
+//       对比整包一次读取与只读取指定资源的加载耗时
+// 场景使用的资源名：mario_idle mario_jump cloud1 cloud2 bush ground hill
+#include "util/assetpack.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+typedef struct {
+    char name[ASSETPACK_NAME_MAX];
+    u16 width;
+    u16 height;
+    u32 run_count;
+    u32 pixel_count;
+    AssetRun *runs;
+    u16 *pixels;
+} PackedSprite;
+
+static int ppm_token(FILE *f) {
+    int c = fgetc(f);
+    while (c == '#' || isspace(c)) {
+        if (c == '#') while (c != '\n' && c != EOF) c = fgetc(f);
+        c = fgetc(f);
+    }
+    int v = 0;
+    if (!isdigit(c)) return -1;
+    while (isdigit(c)) { v = v * 10 + (c - '0'); c = fgetc(f); }
+    return v;
+}
+
+static u8 *ppm_load(const char *path, int *w, int *h) {
+    FILE *f = fopen(path, "rb");
+    if (!f) { fprintf(stderr, "无法打开 %s\n", path); return NULL; }
+    u8 *rgb = NULL;
+    if (fgetc(f) == 'P' && fgetc(f) == '6') {
+        *w = ppm_token(f);
+        *h = ppm_token(f);
+        int maxval = ppm_token(f);
+        if (*w > 0 && *h > 0 && *w <= 0xFFFF && *h <= 0xFFFF && maxval == 255) {
+            size_t n = (size_t)*w * *h * 3;
+            rgb = (u8*)malloc(n);
+            if (rgb && fread(rgb, 1, n, f) != n) { free(rgb); rgb = NULL; }
+        }
+    }
+    fclose(f);
+    if (!rgb) fprintf(stderr, "%s 不是 8 位 P6 PPM\n", path);
+    return rgb;
+}
+
+static bool sprite_from_ppm(PackedSprite *sp, const char *name, const char *path, u32 key) {
+    int w = 0, h = 0;
+    u8 *rgb = ppm_load(path, &w, &h);
+    if (!rgb) return false;
+    memset(sp, 0, sizeof(*sp));
+    snprintf(sp->name, sizeof(sp->name), "%s", name);
+    sp->width = (u16)w;
+    sp->height = (u16)h;
+    sp->runs = (AssetRun*)calloc((size_t)w * h, sizeof(AssetRun));
+    sp->pixels = (u16*)calloc((size_t)w * h, sizeof(u16));
+    for (int y = 0; y < h; ++y) {
+        AssetRun *run = NULL;
+        for (int x = 0; x < w; ++x) {
+            const u8 *p = rgb + ((size_t)y * w + x) * 3;
+            u32 c = ((u32)p[0] << 16) | ((u32)p[1] << 8) | p[2];
+            if (c == key) { run = NULL; continue; }
+            if (!run) {
+                run = &sp->runs[sp->run_count++];
+                run->y = (u16)y;
+                run->x = (u16)x;
+                run->len = 0;
+            }
+            run->len++;
+            sp->pixels[sp->pixel_count++] = (u16)((p[0] >> 4) | ((p[1] >> 4) << 4) | ((p[2] >> 4) << 8) | (0xF << 12));
+        }
+    }
+    free(rgb);
+    return true;
+}
+
+static int cmd_pack(int argc, char **argv) {
+    const char *out_path = argv[0];
+    u32 key = 0x000073;
+    PackedSprite sprites[ASSETPACK_MAX_SPRITES];
+    u32 count = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-k") == 0 && i + 1 < argc) {
+            key = (u32)strtoul(argv[++i], NULL, 16);
+            continue;
+        }
+        char *eq = strchr(argv[i], '=');
+        if (!eq || eq == argv[i] || eq - argv[i] >= ASSETPACK_NAME_MAX || count == ASSETPACK_MAX_SPRITES) {
+            fprintf(stderr, "参数无效: %s\n", argv[i]);
+            return 1;
+        }
+        *eq = '\0';
+        if (!sprite_from_ppm(&sprites[count], argv[i], eq + 1, key)) return 1;
+        count++;
+    }
+
+    AssetPackHeader hdr = { ASSETPACK_MAGIC, ASSETPACK_VERSION, (u16)count, sizeof(AssetPackHeader), 0 };
+    AssetPackEntry entries[ASSETPACK_MAX_SPRITES];
+    memset(entries, 0, sizeof(entries));
+    u32 offset = (u32)(sizeof(hdr) + count * sizeof(AssetPackEntry));
+    offset = (offset + 7) & ~7u;
+    u32 data_start = (u32)(sizeof(hdr) + count * sizeof(AssetPackEntry));
+    for (u32 i = 0; i < count; ++i) {
+        memcpy(entries[i].name, sprites[i].name, ASSETPACK_NAME_MAX);
+        entries[i].offset = offset;
+        entries[i].size = assetpack_data_size(sprites[i].run_count, sprites[i].pixel_count);
+        entries[i].width = sprites[i].width;
+        entries[i].height = sprites[i].height;
+        entries[i].run_count = sprites[i].run_count;
+        offset += entries[i].size;
+    }
+    hdr.data_size = offset - data_start;
+
+    FILE *f = fopen(out_path, "wb");
+    if (!f) { fprintf(stderr, "无法写入 %s\n", out_path); return 1; }
+    fwrite(&hdr, sizeof(hdr), 1, f);
+    fwrite(entries, sizeof(AssetPackEntry), count, f);
+    static const u8 zeros[8];
+    long pos = ftell(f);
+    fwrite(zeros, 1, (size_t)(((pos + 7) & ~7L) - pos), f);
+    for (u32 i = 0; i < count; ++i) {
+        fwrite(sprites[i].runs, sizeof(AssetRun), sprites[i].run_count, f);
+        fwrite(sprites[i].pixels, sizeof(u16), sprites[i].pixel_count, f);
+        u32 used = sprites[i].run_count * (u32)sizeof(AssetRun) + sprites[i].pixel_count * (u32)sizeof(u16);
+        fwrite(zeros, 1, entries[i].size - used, f);
+        printf("%-16s %3ux%-3u %4u 段 %5u 像素 %6u 字节\n", sprites[i].name, sprites[i].width, sprites[i].height,
+               sprites[i].run_count, sprites[i].pixel_count, entries[i].size);
+        free(sprites[i].runs);
+        free(sprites[i].pixels);
+    }
+    fclose(f);
+    printf("%s: %u 个资源，%u 字节\n", out_path, count, offset);
+    return 0;
+}
+
+static int cmd_list(const char *path) {
+    AssetArena arena;
+    if (!asset_arena_init(&arena, 4 << 20)) return 1;
+    AssetSet set;
+    Result rc = assetpack_load_all(path, &arena, &set);
+    if (R_FAILED(rc)) { fprintf(stderr, "加载失败: 0x%x\n", rc); return 1; }
+    for (u32 i = 0; i < set.count; ++i) {
+        const AssetSprite *sp = &set.sprites[i];
+        printf("%-16s %3ux%-3u %4u 段\n", sp->name, sp->width, sp->height, sp->run_count);
+    }
+    asset_arena_free(&arena);
+    return 0;
+}
+
+static int cmd_bench(const char *path, int name_count, char **names) {
+    const int iterations = 200;
+    AssetArena arena;
+    if (!asset_arena_init(&arena, 4 << 20)) return 1;
+    AssetSet set;
+    u64 t0 = armGetSystemTick();
+    for (int i = 0; i < iterations; ++i) {
+        asset_arena_reset(&arena);
+        if (R_FAILED(assetpack_load_all(path, &arena, &set))) { fprintf(stderr, "加载失败\n"); return 1; }
+    }
+    u64 t1 = armGetSystemTick();
+    size_t all_bytes = arena.used;
+    for (int i = 0; i < iterations; ++i) {
+        asset_arena_reset(&arena);
+        if (R_FAILED(assetpack_load_scene(path, &arena, (const char *const *)names, (u32)name_count, &set))) {
+            fprintf(stderr, "加载失败\n");
+            return 1;
+        }
+    }
+    u64 t2 = armGetSystemTick();
+    printf("load_all:   %8.1f us  %7zu 字节常驻\n", armTicksToNs(t1 - t0) / 1000.0 / iterations, all_bytes);
+    printf("load_scene: %8.1f us  %7zu 字节常驻（%u 个资源）\n", armTicksToNs(t2 - t1) / 1000.0 / iterations, arena.used, set.count);
+    asset_arena_free(&arena);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc >= 3 && strcmp(argv[1], "pack") == 0) return cmd_pack(argc - 2, argv + 2);
+    if (argc == 3 && strcmp(argv[1], "list") == 0) return cmd_list(argv[2]);
+    if (argc >= 3 && strcmp(argv[1], "bench") == 0) return cmd_bench(argv[2], argc - 3, argv + 3);
+    fprintf(stderr, "用法: %s pack <out.pak> [-k RRGGBB] name=image.ppm ... | list <file.pak> | bench <file.pak> [name ...]\n", argv[0]);
+    return 2;
+}
@@ -0,0 +1,1159 @@
+// 备份吞吐基准（主机端）：在回环地址上起一个 FTP 替身（每条回复加固定延迟，所有数据连接共用一个带宽上限），
+// 生成合成存档树，端到端调用 backup_run（遍历、清单、上传），每次运行输出一行 JSON：
+// MB/s、文件/s、CPU 时间、堆峰值与替身统计到的控制命令数。两次构建的输出可以用 compare 对比
+//
+// 构建：cc -O2 -DUPLOAD_COUNT_COMMANDS=1 -Isource -o backupbench tools/backupbench.c source/backup/*.c source/util/config.c source/util/service.c source/util/trace.c source/util/hash.c source/util/fspool.c source/util/checksum.c source/util/mempool.c source/util/metrics.c source/util/threading.c -lcurl -lz -lpthread
+// 用法：
+//   backupbench gen <dir> <tiny|large|mixed> [scale]
+//       tiny：200 个标题 × 2 个存档槽 × 10 个 256B–4KB 的小文件；large：4 个 32MB 的文件；
+//       mixed：40 个标题，每槽 8 个小文件加 1 个 64KB–1MB 的文件，每 10 个标题另有一个 16MB 的文件。
+//       scale 按倍数放大标题数（large 放大文件大小）。内容由固定种子生成（一半随机、一半重复），各次生成完全相同
+//   backupbench run <tree> [latency_ms] [bandwidth_kbps] [connections] [runs]
+//       每次运行前清空远端与本地状态（清单、续传日志、遍历缓存），做一次完整备份；
+//       FTP 连接在各次运行之间保留（与设备上一样），所以第 1 次包含连接与登录。bandwidth_kbps（KB/s）为 0 时不限速。
+//       环境变量：COMPRESSION=1 压缩上传，REMOTE_CACHE=0 关闭远端目录缓存，PACK_KB=n 打包不超过 n KB 的小文件，
+//       SNAPSHOT_KB=n 先做快照（总量不超过 n KB 放内存，否则写 SD 暂存目录），
+//       LABEL 原样写入输出，VERBOSE=1 输出备份日志。files 为树中的文件数，jobs 为实际上传的文件与归档数。
+//       故障注入：DROP_KB=n 替身收到 n KB 后断开接下来 DROPS（默认 1）条 STOR/APPE 数据连接，SIZE_DROPS=k 对前 k 条 SIZE 断开控制连接
+//   backupbench suite <workdir> [latency_ms] [bandwidth_kbps] [connections] [runs]
+//       在 workdir 下生成（已存在则沿用）三种树并依次运行
+//   backupbench resume [size_mb] [cut_kb]
+//       断点续传检查：生成一个 size_mb MB（默认 6）的文件，按 1MB 分块上传；第 1 次备份在收到 cut_kb KB（默认 2560）后
+//       断开数据连接并让所有重试也断开，第 2 次备份的第一条 SIZE 断开控制连接。检查第 2 次只用 APPE 续传（resumed_bytes > 0）、
+//       没有 STOR，且远端文件与源文件逐字节一致。另查一种情况：远端有一个更短的旧副本、没有续传日志，
+//       第一条 STOR 在截断旧副本之前断开控制连接，检查重试从头 STOR、远端不会变成旧内容接新内容。
+//       关闭与开启远端目录缓存各做一次，都通过时以 0 退出
+//   backupbench stream
+//       环形缓冲检查：单连接、upload_buffers = 2、每块 16KB、1MB 分块，上传 12 个大小落在块与分块边界两侧的文件
+//       （0 字节到 8MB），逐个比较远端文件与源文件，并检查替身收到的字节数等于文件总大小；全部通过时以 0 退出
+//   backupbench compare <old.jsonl> <new.jsonl> [threshold_pct]
+//       按 (scenario, run) 配对，吞吐下降或 CPU、堆峰值、命令数上升超过阈值（默认 5%）时标出，有则以 1 退出
+#define _GNU_SOURCE // nftw
+#include "backup/backup.h"
+#include "backup/progress.h"
+#include "backup/manifest.h"
+#include "backup/journal.h"
+#include "backup/scan.h"
+#include "backup/upload.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <errno.h>
+#include <ftw.h>
+#include <malloc.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#define BENCH_PATH_MAX 1024
+#define BENCH_IO_SIZE 0x10000
+#define BENCH_ACCEPT_TIMEOUT_MS 10000
+
+static bool s_verbose;
+
+static void log_stderr(const char *level, const char *fmt, va_list args) {
+    fprintf(stderr, "[%s] ", level);
+    vfprintf(stderr, fmt, args);
+    fprintf(stderr, "\n");
+}
+
+void log_info_impl(const char *file, int line, const char *fmt, ...) {
+    if (!s_verbose) return;
+    va_list args;
+    va_start(args, fmt);
+    log_stderr("INFO", fmt, args);
+    va_end(args);
+}
+
+void log_warning_impl(const char *file, int line, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    log_stderr("WARNING", fmt, args);
+    va_end(args);
+}
+
+void log_error_impl(const char *file, int line, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    log_stderr("ERROR", fmt, args);
+    va_end(args);
+}
+
+void log_debug_impl(const char *file, int line, const char *fmt, ...) {
+}
+
+// ---- 堆峰值：替换 malloc 一族，按 malloc_usable_size 记账（包括 libcurl、zlib 的分配） ----
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *p, size_t size);
+extern void *__libc_memalign(size_t align, size_t size);
+extern void __libc_free(void *p);
+
+static s64 s_heap_current;
+static s64 s_heap_peak;
+
+static void *heap_track(void *p) {
+    if (!p) return p;
+    s64 now = __atomic_add_fetch(&s_heap_current, (s64)malloc_usable_size(p), __ATOMIC_RELAXED);
+    s64 peak = __atomic_load_n(&s_heap_peak, __ATOMIC_RELAXED);
+    while (now > peak && !__atomic_compare_exchange_n(&s_heap_peak, &peak, now, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+    return p;
+}
+
+static void heap_untrack(void *p) {
+    if (p) __atomic_sub_fetch(&s_heap_current, (s64)malloc_usable_size(p), __ATOMIC_RELAXED);
+}
+
+void *malloc(size_t size) {
+    return heap_track(__libc_malloc(size));
+}
+
+void *calloc(size_t n, size_t size) {
+    return heap_track(__libc_calloc(n, size));
+}
+
+void *realloc(void *p, size_t size) {
+    heap_untrack(p);
+    void *q = __libc_realloc(p, size);
+    // 失败时原块仍在
+    return q ? heap_track(q) : (size ? heap_track(p) : NULL);
+}
+
+void *memalign(size_t align, size_t size) {
+    return heap_track(__libc_memalign(align, size));
+}
+
+void *aligned_alloc(size_t align, size_t size) {
+    return heap_track(__libc_memalign(align, size));
+}
+
+int posix_memalign(void **out, size_t align, size_t size) {
+    void *p = heap_track(__libc_memalign(align, size));
+    if (!p) return ENOMEM;
+    *out = p;
+    return 0;
+}
+
+void free(void *p) {
+    heap_untrack(p);
+    __libc_free(p);
+}
+
+static void heap_reset_peak(void) {
+    __atomic_store_n(&s_heap_peak, __atomic_load_n(&s_heap_current, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+}
+
+// ---- FTP 替身：在子进程中运行，每条控制连接一个线程，文件写入 root ----
+
+// 与父进程共享（mmap），只增不减
+typedef struct {
+    u64 commands;
+    u64 cwd;
+    u64 mkd;
+    u64 mlsd;
+    u64 size;
+    u64 data_conns;
+    u64 bytes;
+    u64 stor;
+    u64 appe;
+    u64 data_drops;         // 注入的数据连接断开
+    u64 size_drops;         // 注入的控制连接断开（收到 SIZE 时）
+    u64 stor_drops;         // 注入的控制连接断开（收到 STOR、还没打开文件时）
+} ServerStats;
+
+// 故障注入（与父进程共享，运行中可以改）：收到的总字节数达到 drop_after 后，接下来 data_drops 条
+// STOR/APPE 数据连接被直接断开（RST，回复 426），已收到的部分照常写入；size_drops 为接下来几条 SIZE 不作答、直接断开控制连接；
+// stor_drops 为接下来几条 STOR 在截断文件之前断开控制连接（远端原有的文件保持不变）
+typedef struct {
+    u64 drop_after;
+    u32 data_drops;
+    u32 size_drops;
+    u32 stor_drops;
+} ServerFaults;
+
+typedef struct {
+    pid_t pid;
+    int port;
+    ServerStats *stats;
+    ServerFaults *faults;
+} FtpServer;
+
+typedef struct {
+    int fd;
+    int pasv;
+    char cwd[BENCH_PATH_MAX];       // 虚拟路径，以 / 开头
+    char buf[2048];
+    size_t len;
+} FtpSession;
+
+static char s_srv_root[BENCH_PATH_MAX];
+static u64 s_srv_latency_ns;
+static double s_srv_rate;           // 字节/秒，0 = 不限
+static ServerStats *s_srv_stats;
+static ServerFaults *s_srv_faults;
+static pthread_mutex_t s_pace_lock = PTHREAD_MUTEX_INITIALIZER;
+static double s_pace_next;          // 带宽上限：下一个字节最早可以到达的时刻（秒）
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void sleep_s(double s) {
+    if (s <= 0) return;
+    struct timespec ts = { (time_t)s, (long)((s - (double)(time_t)s) * 1e9) };
+    nanosleep(&ts, NULL);
+}
+
+// 所有数据连接排在同一条"链路"上：收到 n 字节后等到它们按上限应当传完的时刻
+static void server_pace(size_t n) {
+    if (s_srv_rate <= 0) return;
+    pthread_mutex_lock(&s_pace_lock);
+    double now = now_s();
+    if (s_pace_next < now) s_pace_next = now;
+    s_pace_next += (double)n / s_srv_rate;
+    double until = s_pace_next;
+    pthread_mutex_unlock(&s_pace_lock);
+    sleep_s(until - now_s());
+}
+
+static void server_count(u64 *field) {
+    __atomic_add_fetch(field, 1, __ATOMIC_RELAXED);
+}
+
+// 取走一次注入名额（*left 为 0 时返回 false）
+static bool fault_take(u32 *left) {
+    u32 n = __atomic_load_n(left, __ATOMIC_RELAXED);
+    while (n > 0) {
+        if (__atomic_compare_exchange_n(left, &n, n - 1, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) return true;
+    }
+    return false;
+}
+
+static bool fault_data_due(void) {
+    return __atomic_load_n(&s_srv_faults->data_drops, __ATOMIC_RELAXED) > 0 &&
+           __atomic_load_n(&s_srv_stats->bytes, __ATOMIC_RELAXED) >= __atomic_load_n(&s_srv_faults->drop_after, __ATOMIC_RELAXED) &&
+           fault_take(&s_srv_faults->data_drops);
+}
+
+// 以 RST 断开，客户端看到的是连接被重置而不是正常结束
+static void close_reset(int fd) {
+    struct linger lg = { 1, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+    close(fd);
+}
+
+static void session_reply(FtpSession *s, const char *fmt, ...) {
+    char line[BENCH_PATH_MAX + 64];
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(line, sizeof(line) - 2, fmt, args);
+    va_end(args);
+    if (n < 0) return;
+    if ((size_t)n > sizeof(line) - 3) n = (int)sizeof(line) - 3;
+    line[n++] = '\r';
+    line[n++] = '\n';
+    if (s_srv_latency_ns) sleep_s((double)s_srv_latency_ns / 1e9);
+    send(s->fd, line, (size_t)n, MSG_NOSIGNAL);
+}
+
+static bool session_line(FtpSession *s, char *out, size_t size) {
+    for (;;) {
+        char *nl = memchr(s->buf, '\n', s->len);
+        if (nl) {
+            size_t n = (size_t)(nl - s->buf);
+            size_t copy = n < size - 1 ? n : size - 1;
+            memcpy(out, s->buf, copy);
+            if (copy && out[copy - 1] == '\r') copy--;
+            out[copy] = '\0';
+            s->len -= n + 1;
+            memmove(s->buf, nl + 1, s->len);
+            return true;
+        }
+        if (s->len == sizeof(s->buf)) s->len = 0; // 超长行丢弃
+        ssize_t r = recv(s->fd, s->buf + s->len, sizeof(s->buf) - s->len, 0);
+        if (r <= 0) return false;
+        s->len += (size_t)r;
+    }
+}
+
+// 把参数解析成虚拟路径（处理 . 与 ..，不会越出根目录）与实际路径
+static bool session_path(FtpSession *s, const char *arg, char *virt, char *real) {
+    char tmp[BENCH_PATH_MAX];
+    int n = snprintf(tmp, sizeof(tmp), "%s/%s", arg[0] == '/' ? "" : s->cwd, arg);
+    if (n < 0 || (size_t)n >= sizeof(tmp)) return false;
+    size_t len = 0;
+    virt[0] = '\0';
+    for (char *save = NULL, *seg = strtok_r(tmp, "/", &save); seg; seg = strtok_r(NULL, "/", &save)) {
+        if (strcmp(seg, ".") == 0) continue;
+        if (strcmp(seg, "..") == 0) {
+            while (len > 0 && virt[len - 1] != '/') len--;
+            if (len > 0) len--;
+            virt[len] = '\0';
+            continue;
+        }
+        size_t seg_len = strlen(seg);
+        if (len + seg_len + 2 > BENCH_PATH_MAX) return false;
+        virt[len++] = '/';
+        memcpy(virt + len, seg, seg_len + 1);
+        len += seg_len;
+    }
+    if (len == 0) strcpy(virt, "/");
+    n = snprintf(real, BENCH_PATH_MAX, "%s%s", s_srv_root, virt);
+    return n >= 0 && n < BENCH_PATH_MAX;
+}
+
+static int session_accept_data(FtpSession *s) {
+    if (s->pasv < 0) return -1;
+    struct pollfd pfd = { s->pasv, POLLIN, 0 };
+    int fd = poll(&pfd, 1, BENCH_ACCEPT_TIMEOUT_MS) == 1 ? accept(s->pasv, NULL, NULL) : -1;
+    close(s->pasv);
+    s->pasv = -1;
+    if (fd >= 0) server_count(&s_srv_stats->data_conns);
+    return fd;
+}
+
+static void session_passive(FtpSession *s, bool extended) {
+    if (s->pasv >= 0) close(s->pasv);
+    s->pasv = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    socklen_t alen = sizeof(addr);
+    if (s->pasv < 0 || bind(s->pasv, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(s->pasv, 1) != 0 ||
+        getsockname(s->pasv, (struct sockaddr*)&addr, &alen) != 0) {
+        session_reply(s, "425 no data port");
+        return;
+    }
+    int port = ntohs(addr.sin_port);
+    if (extended) session_reply(s, "229 Entering Extended Passive Mode (|||%d|)", port);
+    else session_reply(s, "227 Entering Passive Mode (127,0,0,1,%d,%d)", port >> 8, port & 0xFF);
+}
+
+static void session_store(FtpSession *s, const char *real, bool append) {
+    int out = open(real, O_WRONLY | O_CREAT | (append ? O_APPEND : O_TRUNC), 0644);
+    if (out < 0) {
+        if (s->pasv >= 0) close(s->pasv);
+        s->pasv = -1;
+        session_reply(s, "553 cannot create");
+        return;
+    }
+    server_count(append ? &s_srv_stats->appe : &s_srv_stats->stor);
+    session_reply(s, "150 ok");
+    int d = session_accept_data(s);
+    bool ok = d >= 0;
+    bool dropped = false;
+    static __thread char buf[BENCH_IO_SIZE];
+    while (ok) {
+        if (fault_data_due()) {
+            dropped = true;
+            break;
+        }
+        ssize_t n = recv(d, buf, sizeof(buf), 0);
+        if (n < 0) ok = false;
+        if (n <= 0) break;
+        __atomic_add_fetch(&s_srv_stats->bytes, (u64)n, __ATOMIC_RELAXED);
+        server_pace((size_t)n);
+        if (write(out, buf, (size_t)n) != n) ok = false;
+    }
+    if (dropped) {
+        server_count(&s_srv_stats->data_drops);
+        close_reset(d);
+        ok = false;
+    } else if (d >= 0) {
+        close(d);
+    }
+    close(out);
+    session_reply(s, ok ? "226 done" : "426 aborted");
+}
+
+static void session_mlsd(FtpSession *s, const char *real) {
+    DIR *dir = opendir(real);
+    if (!dir) {
+        if (s->pasv >= 0) close(s->pasv);
+        s->pasv = -1;
+        session_reply(s, "550 no such directory");
+        return;
+    }
+    session_reply(s, "150 ok");
+    int d = session_accept_data(s);
+    char line[BENCH_PATH_MAX + 64], path[BENCH_PATH_MAX * 2];
+    struct dirent *ent;
+    while (d >= 0 && (ent = readdir(dir)) != NULL) {
+        if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0) continue;
+        struct stat st;
+        snprintf(path, sizeof(path), "%s/%s", real, ent->d_name);
+        if (stat(path, &st) != 0) continue;
+        int n = S_ISDIR(st.st_mode) ? snprintf(line, sizeof(line), "type=dir; %s\r\n", ent->d_name)
+                                    : snprintf(line, sizeof(line), "type=file;size=%lld; %s\r\n", (long long)st.st_size, ent->d_name);
+        if (n > 0 && (size_t)n < sizeof(line)) send(d, line, (size_t)n, MSG_NOSIGNAL);
+    }
+    closedir(dir);
+    if (d >= 0) close(d);
+    session_reply(s, d >= 0 ? "226 done" : "425 no data connection");
+}
+
+static void *session_main(void *arg) {
+    FtpSession *s = arg;
+    char line[BENCH_PATH_MAX], virt[BENCH_PATH_MAX], real[BENCH_PATH_MAX];
+    session_reply(s, "220 backupbench");
+    while (session_line(s, line, sizeof(line))) {
+        server_count(&s_srv_stats->commands);
+        char *a = strchr(line, ' ');
+        const char *param = a ? a + 1 : "";
+        if (a) *a = '\0';
+        for (char *c = line; *c; ++c) *c = (char)toupper((unsigned char)*c);
+        bool path_ok = session_path(s, param, virt, real);
+        if (strcmp(line, "USER") == 0) session_reply(s, "331 password");
+        else if (strcmp(line, "PASS") == 0) session_reply(s, "230 logged in");
+        else if (strcmp(line, "SYST") == 0) session_reply(s, "215 UNIX Type: L8");
+        else if (strcmp(line, "PWD") == 0) session_reply(s, "257 \"%s\"", s->cwd);
+        else if (strcmp(line, "TYPE") == 0 || strcmp(line, "NOOP") == 0 || strcmp(line, "OPTS") == 0) session_reply(s, "200 ok");
+        else if (strcmp(line, "REST") == 0) session_reply(s, "350 ok");
+        else if (strcmp(line, "EPSV") == 0) session_passive(s, true);
+        else if (strcmp(line, "PASV") == 0) session_passive(s, false);
+        else if (strcmp(line, "CWD") == 0) {
+            server_count(&s_srv_stats->cwd);
+            struct stat st;
+            if (path_ok && stat(real, &st) == 0 && S_ISDIR(st.st_mode)) {
+                strcpy(s->cwd, virt);
+                session_reply(s, "250 ok");
+            } else {
+                session_reply(s, "550 no such directory");
+            }
+        } else if (strcmp(line, "MKD") == 0) {
+            server_count(&s_srv_stats->mkd);
+            if (path_ok && mkdir(real, 0755) == 0) session_reply(s, "257 \"%s\" created", virt);
+            else session_reply(s, "550 cannot create");
+        } else if (strcmp(line, "SIZE") == 0) {
+            server_count(&s_srv_stats->size);
+            if (fault_take(&s_srv_faults->size_drops)) {
+                server_count(&s_srv_stats->size_drops);
+                break;
+            }
+            struct stat st;
+            if (path_ok && stat(real, &st) == 0 && S_ISREG(st.st_mode)) session_reply(s, "213 %lld", (long long)st.st_size);
+            else session_reply(s, "550 no such file");
+        } else if (strcmp(line, "STOR") == 0 || strcmp(line, "APPE") == 0) {
+            if (line[0] == 'S' && fault_take(&s_srv_faults->stor_drops)) {
+                server_count(&s_srv_stats->stor_drops);
+                break;
+            }
+            if (path_ok) session_store(s, real, line[0] == 'A');
+            else session_reply(s, "553 bad path");
+        } else if (strcmp(line, "MLSD") == 0) {
+            server_count(&s_srv_stats->mlsd);
+            if (path_ok) session_mlsd(s, real);
+            else session_reply(s, "550 bad path");
+        } else if (strcmp(line, "QUIT") == 0) {
+            session_reply(s, "221 bye");
+            break;
+        } else {
+            session_reply(s, "502 not implemented");
+        }
+    }
+    if (s->pasv >= 0) close(s->pasv);
+    close(s->fd);
+    free(s);
+    return NULL;
+}
+
+static void server_main(int listener) {
+    signal(SIGPIPE, SIG_IGN);
+    for (;;) {
+        int fd = accept(listener, NULL, NULL);
+        if (fd < 0) continue;
+        FtpSession *s = calloc(1, sizeof(FtpSession));
+        pthread_t thread;
+        if (!s) {
+            close(fd);
+            continue;
+        }
+        // 应答都很短，不关 Nagle 时会与客户端的延迟确认互相等待，每条命令凭空多出约 40ms
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        s->fd = fd;
+        s->pasv = -1;
+        strcpy(s->cwd, "/");
+        if (pthread_create(&thread, NULL, session_main, s) != 0) {
+            close(fd);
+            free(s);
+            continue;
+        }
+        pthread_detach(thread);
+    }
+}
+
+static bool server_start(FtpServer *srv, const char *root, u32 latency_ms, u32 bandwidth_kbps) {
+    srv->stats = mmap(NULL, sizeof(ServerStats) + sizeof(ServerFaults), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (srv->stats == MAP_FAILED) return false;
+    memset(srv->stats, 0, sizeof(ServerStats) + sizeof(ServerFaults));
+    srv->faults = (ServerFaults*)(srv->stats + 1);
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    socklen_t alen = sizeof(addr);
+    if (listener < 0 || bind(listener, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(listener, 16) != 0 ||
+        getsockname(listener, (struct sockaddr*)&addr, &alen) != 0) {
+        return false;
+    }
+    srv->port = ntohs(addr.sin_port);
+    snprintf(s_srv_root, sizeof(s_srv_root), "%s", root);
+    s_srv_latency_ns = (u64)latency_ms * 1000000ULL;
+    s_srv_rate = (double)bandwidth_kbps * 1024.0;
+    s_srv_stats = srv->stats;
+    s_srv_faults = srv->faults;
+    fflush(NULL);
+    srv->pid = fork();
+    if (srv->pid == 0) {
+        server_main(listener);
+        _exit(0);
+    }
+    close(listener);
+    return srv->pid > 0;
+}
+
+static void server_stop(FtpServer *srv) {
+    if (srv->pid > 0) {
+        kill(srv->pid, SIGTERM);
+        waitpid(srv->pid, NULL, 0);
+    }
+    munmap(srv->stats, sizeof(ServerStats) + sizeof(ServerFaults));
+}
+
+// ---- 合成存档树 ----
+
+typedef struct {
+    u64 s;
+} Rng;
+
+static u64 rng_next(Rng *r) {
+    r->s ^= r->s >> 12;
+    r->s ^= r->s << 25;
+    r->s ^= r->s >> 27;
+    return r->s * 0x2545F4914F6CDD1DULL;
+}
+
+static u32 s_gen_files;
+static u64 s_gen_bytes;
+
+// 每 4KB 一页，随机页与重复页交替，压缩率约 2:1
+static bool gen_file(const char *path, u64 size, u64 seed) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return false;
+    static u8 buf[BENCH_IO_SIZE];
+    Rng r = { seed * 0x9E3779B97F4A7C15ULL + 1 };
+    u64 left = size;
+    while (left > 0) {
+        size_t n = left < sizeof(buf) ? (size_t)left : sizeof(buf);
+        for (size_t page = 0; page < n; page += 0x1000) {
+            size_t len = n - page < 0x1000 ? n - page : 0x1000;
+            if ((page >> 12) & 1) {
+                memset(buf + page, (int)(rng_next(&r) & 0xFF), len);
+            } else {
+                for (size_t i = 0; i < len; i += 8) {
+                    u64 v = rng_next(&r);
+                    memcpy(buf + page + i, &v, len - i < 8 ? len - i : 8);
+                }
+            }
+        }
+        if (fwrite(buf, 1, n, f) != n) {
+            fclose(f);
+            return false;
+        }
+        left -= n;
+    }
+    fclose(f);
+    s_gen_files++;
+    s_gen_bytes += size;
+    return true;
+}
+
+static bool gen_slot(char *path, const char *root, u32 title, u32 slot) {
+    snprintf(path, BENCH_PATH_MAX, "%s/title%04u", root, title);
+    mkdir(path, 0755);
+    snprintf(path, BENCH_PATH_MAX, "%s/title%04u/slot%u", root, title, slot);
+    return mkdir(path, 0755) == 0 || errno == EEXIST;
+}
+
+static int cmd_gen(const char *root, const char *kind, u32 scale) {
+    char dir[BENCH_PATH_MAX], path[BENCH_PATH_MAX * 2];
+    if (mkdir(root, 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "无法创建 %s\n", root);
+        return 1;
+    }
+    Rng r = { 0x5EED };
+    bool ok = true;
+    s_gen_files = 0;
+    s_gen_bytes = 0;
+    if (strcmp(kind, "tiny") == 0) {
+        for (u32 t = 0; t < 200 * scale && ok; ++t) {
+            for (u32 s = 0; s < 2 && ok; ++s) {
+                ok = gen_slot(dir, root, t, s);
+                for (u32 i = 0; i < 10 && ok; ++i) {
+                    snprintf(path, sizeof(path), "%s/save%02u.bin", dir, i);
+                    ok = gen_file(path, 256 + rng_next(&r) % 3840, rng_next(&r));
+                }
+            }
+        }
+    } else if (strcmp(kind, "large") == 0) {
+        for (u32 t = 0; t < 4 && ok; ++t) {
+            ok = gen_slot(dir, root, t, 0);
+            snprintf(path, sizeof(path), "%s/save.bin", dir);
+            if (ok) ok = gen_file(path, (u64)32 * 1024 * 1024 * scale, rng_next(&r));
+        }
+    } else if (strcmp(kind, "mixed") == 0) {
+        for (u32 t = 0; t < 40 * scale && ok; ++t) {
+            for (u32 s = 0; s < 2 && ok; ++s) {
+                ok = gen_slot(dir, root, t, s);
+                for (u32 i = 0; i < 8 && ok; ++i) {
+                    snprintf(path, sizeof(path), "%s/save%02u.bin", dir, i);
+                    ok = gen_file(path, 256 + rng_next(&r) % 3840, rng_next(&r));
+                }
+                snprintf(path, sizeof(path), "%s/data.bin", dir);
+                if (ok) ok = gen_file(path, 64 * 1024 + rng_next(&r) % (960 * 1024), rng_next(&r));
+                if (ok && s == 0 && t % 10 == 0) {
+                    snprintf(path, sizeof(path), "%s/world.bin", dir);
+                    ok = gen_file(path, 16 * 1024 * 1024, rng_next(&r));
+                }
+            }
+        }
+    } else {
+        fprintf(stderr, "未知的树类型 %s（tiny、large、mixed）\n", kind);
+        return 1;
+    }
+    if (!ok) {
+        fprintf(stderr, "生成 %s 失败\n", root);
+        return 1;
+    }
+    fprintf(stderr, "%s：%u 个文件，%llu 字节\n", root, s_gen_files, (unsigned long long)s_gen_bytes);
+    return 0;
+}
+
+// ---- 运行 ----
+
+typedef struct {
+    u32 latency_ms;
+    u32 bandwidth_kbps;
+    u32 connections;
+    u32 runs;
+    bool compression;
+    bool remote_cache;
+    u32 pack_kb;
+    int snapshot;           // -1 = 沿用默认；否则为 snapshot_ram_kb（0 = 总是写 SD 暂存目录）
+    u32 drop_kb;            // 故障注入（见 ServerFaults），从替身启动时算起
+    u32 drops;
+    u32 size_drops;
+    const char *label;
+} BenchParams;
+
+static u64 s_tree_files;
+
+static int count_entry(const char *path, const struct stat *st, int flag, struct FTW *ftw) {
+    (void)path;
+    (void)st;
+    (void)ftw;
+    if (flag == FTW_F) s_tree_files++;
+    return 0;
+}
+
+static int rm_entry(const char *path, const struct stat *st, int flag, struct FTW *ftw) {
+    (void)st;
+    (void)flag;
+    (void)ftw;
+    remove(path);
+    return 0;
+}
+
+static void rm_tree(const char *path) {
+    nftw(path, rm_entry, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+static double cpu_ms(const struct timeval *tv) {
+    return (double)tv->tv_sec * 1e3 + (double)tv->tv_usec / 1e3;
+}
+
+static const char *scenario_name(const char *tree) {
+    size_t len = strlen(tree);
+    while (len > 1 && tree[len - 1] == '/') len--;
+    const char *p = tree + len;
+    while (p > tree && p[-1] != '/') p--;
+    static char name[64];
+    snprintf(name, sizeof(name), "%.*s", (int)(tree + len - p), p);
+    return name;
+}
+
+static Result bench_tree(FtpServer *srv, const char *remote_root, const char *tree, const BenchParams *p) {
+    AppConfig cfg;
+    config_defaults(&cfg);
+    snprintf(cfg.backup_source, sizeof(cfg.backup_source), "%s", tree);
+    snprintf(cfg.ftp_url, sizeof(cfg.ftp_url), "ftp://127.0.0.1:%d/bk", srv->port);
+    cfg.upload_connections = p->connections;
+    cfg.compression = p->compression;
+    cfg.remote_cache = p->remote_cache;
+    cfg.pack_small_kb = p->pack_kb;
+    if (p->snapshot >= 0) {
+        cfg.snapshot = 1;
+        cfg.snapshot_ram_kb = (u32)p->snapshot;
+    }
+    s_tree_files = 0;
+    nftw(tree, count_entry, 16, FTW_PHYS);
+    char remote[BENCH_PATH_MAX];
+    snprintf(remote, sizeof(remote), "%s/bk", remote_root);
+    const char *scenario = scenario_name(tree);
+    Result last = 0;
+
+    for (u32 run = 1; run <= p->runs; ++run) {
+        // 每次都是远端只有空的根目录、本地没有任何状态的完整备份
+        rm_tree(remote);
+        mkdir(remote, 0755);
+        unlink(MANIFEST_FILE_PATH);
+        unlink(JOURNAL_FILE_PATH);
+        unlink(SCAN_CACHE_FILE_PATH);
+        ServerStats before = *srv->stats;
+        struct rusage ru0, ru1;
+        heap_reset_peak();
+        s64 heap_base = __atomic_load_n(&s_heap_current, __ATOMIC_RELAXED);
+        getrusage(RUSAGE_SELF, &ru0);
+        u64 t0 = armGetSystemTick();
+        Result rc = backup_run(&cfg);
+        u64 wall_ns = armTicksToNs(armGetSystemTick() - t0);
+        getrusage(RUSAGE_SELF, &ru1);
+        s64 peak = __atomic_load_n(&s_heap_peak, __ATOMIC_RELAXED) - heap_base;
+        ServerStats after = *srv->stats;
+        BackupProgress prog;
+        progress_snapshot(&prog);
+        if (R_FAILED(rc)) last = rc;
+
+        double secs = (double)wall_ns / 1e9;
+        double user_ms = cpu_ms(&ru1.ru_utime) - cpu_ms(&ru0.ru_utime);
+        double sys_ms = cpu_ms(&ru1.ru_stime) - cpu_ms(&ru0.ru_stime);
+        printf("{\"label\":\"%s\",\"scenario\":\"%s\",\"run\":%u,\"rc\":%u,\"files\":%llu,\"jobs\":%llu,\"jobs_ok\":%llu,\"bytes\":%llu,"
+               "\"latency_ms\":%u,\"bandwidth_kbps\":%u,\"connections\":%u,\"compression\":%d,\"remote_cache\":%d,\"pack_kb\":%u,\"snapshot_kb\":%d,"
+               "\"wall_ms\":%.1f,\"mb_s\":%.3f,\"files_s\":%.1f,\"cpu_ms\":%.1f,\"cpu_user_ms\":%.1f,\"cpu_sys_ms\":%.1f,"
+               "\"peak_heap_kb\":%lld,\"commands\":%llu,\"cwd\":%llu,\"mkd\":%llu,\"mlsd\":%llu,\"size\":%llu,"
+               "\"data_conns\":%llu,\"wire_bytes\":%llu}\n",
+               p->label, scenario, run, rc, (unsigned long long)s_tree_files, (unsigned long long)prog.files_total,
+               (unsigned long long)prog.files_done, (unsigned long long)prog.bytes_done, p->latency_ms, p->bandwidth_kbps,
+               p->connections, p->compression, p->remote_cache, p->pack_kb, p->snapshot, secs * 1e3,
+               secs > 0 ? (double)prog.bytes_done / (1024.0 * 1024.0) / secs : 0.0,
+               secs > 0 ? (double)s_tree_files / secs : 0.0,
+               user_ms + sys_ms, user_ms, sys_ms, (long long)(peak / 1024),
+               (unsigned long long)(after.commands - before.commands), (unsigned long long)(after.cwd - before.cwd),
+               (unsigned long long)(after.mkd - before.mkd), (unsigned long long)(after.mlsd - before.mlsd),
+               (unsigned long long)(after.size - before.size), (unsigned long long)(after.data_conns - before.data_conns),
+               (unsigned long long)(after.bytes - before.bytes));
+        fflush(stdout);
+    }
+    return last;
+}
+
+static void parse_params(BenchParams *p, int argc, char **argv, int first) {
+    p->latency_ms = argc > first ? (u32)atoi(argv[first]) : 0;
+    p->bandwidth_kbps = argc > first + 1 ? (u32)atoi(argv[first + 1]) : 0;
+    p->connections = argc > first + 2 ? (u32)atoi(argv[first + 2]) : 2;
+    p->runs = argc > first + 3 ? (u32)atoi(argv[first + 3]) : 3;
+    if (p->connections < 1) p->connections = 1;
+    if (p->connections > 4) p->connections = 4;
+    if (p->runs < 1) p->runs = 1;
+    const char *env = getenv("COMPRESSION");
+    p->compression = env && atoi(env) != 0;
+    env = getenv("REMOTE_CACHE");
+    p->remote_cache = !env || atoi(env) != 0;
+    env = getenv("PACK_KB");
+    p->pack_kb = env ? (u32)atoi(env) : 0;
+    env = getenv("SNAPSHOT_KB");
+    p->snapshot = env && env[0] ? atoi(env) : -1;
+    env = getenv("DROP_KB");
+    p->drop_kb = env ? (u32)atoi(env) : 0;
+    env = getenv("DROPS");
+    p->drops = env ? (u32)atoi(env) : (p->drop_kb ? 1 : 0);
+    env = getenv("SIZE_DROPS");
+    p->size_drops = env ? (u32)atoi(env) : 0;
+    p->label = getenv("LABEL") ? getenv("LABEL") : "";
+}
+
+static int cmd_run(const char **trees, u32 tree_count, const BenchParams *p) {
+    char remote_root[] = "/tmp/backupbench.XXXXXX";
+    if (!mkdtemp(remote_root)) {
+        fprintf(stderr, "无法创建临时目录\n");
+        return 1;
+    }
+    mkdir("/config", 0755);
+    mkdir("/config/mario-pop", 0755);
+    FtpServer srv = { 0 };
+    if (!server_start(&srv, remote_root, p->latency_ms, p->bandwidth_kbps)) {
+        fprintf(stderr, "FTP 替身启动失败\n");
+        return 1;
+    }
+    srv.faults->drop_after = (u64)p->drop_kb * 1024;
+    srv.faults->data_drops = p->drops;
+    srv.faults->size_drops = p->size_drops;
+    Result rc = 0;
+    for (u32 i = 0; i < tree_count; ++i) {
+        Result r = bench_tree(&srv, remote_root, trees[i], p);
+        if (R_FAILED(r)) rc = r;
+    }
+    server_stop(&srv);
+    rm_tree(remote_root);
+    return R_SUCCEEDED(rc) ? 0 : 1;
+}
+
+static int cmd_suite(const char *workdir, const BenchParams *p) {
+    static const char *const kinds[] = { "tiny", "large", "mixed" };
+    static char paths[3][BENCH_PATH_MAX];
+    const char *trees[3];
+    mkdir(workdir, 0755);
+    for (u32 i = 0; i < 3; ++i) {
+        snprintf(paths[i], sizeof(paths[i]), "%s/%s", workdir, kinds[i]);
+        struct stat st;
+        if (stat(paths[i], &st) != 0 && cmd_gen(paths[i], kinds[i], 1) != 0) return 1;
+        trees[i] = paths[i];
+    }
+    return cmd_run(trees, 3, p);
+}
+
+// ---- 断点续传检查 ----
+
+static bool files_equal(const char *a, const char *b) {
+    FILE *fa = fopen(a, "rb"), *fb = fopen(b, "rb");
+    bool same = fa && fb;
+    static u8 ba[BENCH_IO_SIZE], bb[BENCH_IO_SIZE];
+    while (same) {
+        size_t na = fread(ba, 1, sizeof(ba), fa);
+        size_t nb = fread(bb, 1, sizeof(bb), fb);
+        if (na != nb || memcmp(ba, bb, na) != 0) same = false;
+        if (na == 0 || na != nb) break;
+    }
+    if (fa) fclose(fa);
+    if (fb) fclose(fb);
+    return same;
+}
+
+// 第 1 次备份：收到 cut_kb KB 后断开数据连接，之后每次重试也被断开，直到用完重试次数、文件失败（续传日志留下已确认的块）。
+// 第 2 次备份：不再断数据连接，但第一条 SIZE 断开控制连接（查询失败不等于远端没有文件）。
+// 期望第 2 次只用 APPE 接着传、不发 STOR，收到的字节少于文件大小，最后远端内容与源文件一致
+static bool resume_check(FtpServer *srv, const char *remote_root, const char *tree, const char *rel, u64 size, u32 cut_kb, bool remote_cache) {
+    AppConfig cfg;
+    config_defaults(&cfg);
+    snprintf(cfg.backup_source, sizeof(cfg.backup_source), "%s", tree);
+    snprintf(cfg.ftp_url, sizeof(cfg.ftp_url), "ftp://127.0.0.1:%d/bk", srv->port);
+    cfg.upload_connections = 1;
+    cfg.upload_chunk_mb = 1;
+    cfg.compression = 0;
+    cfg.remote_cache = remote_cache;
+    char remote[BENCH_PATH_MAX], local[BENCH_PATH_MAX * 2], remote_file[BENCH_PATH_MAX * 2];
+    snprintf(remote, sizeof(remote), "%s/bk", remote_root);
+    snprintf(local, sizeof(local), "%s/%s", tree, rel);
+    snprintf(remote_file, sizeof(remote_file), "%s/%s", remote, rel);
+    rm_tree(remote);
+    mkdir(remote, 0755);
+    unlink(MANIFEST_FILE_PATH);
+    unlink(JOURNAL_FILE_PATH);
+    unlink(SCAN_CACHE_FILE_PATH);
+
+    ServerStats s0 = *srv->stats;
+    srv->faults->drop_after = s0.bytes + (u64)cut_kb * 1024;
+    srv->faults->data_drops = UPLOAD_MAX_RETRIES + 1;
+    srv->faults->size_drops = 0;
+    Result rc1 = backup_run(&cfg);
+    ServerStats s1 = *srv->stats;
+    struct stat st;
+    bool journal = stat(JOURNAL_FILE_PATH, &st) == 0;
+
+    srv->faults->data_drops = 0;
+    srv->faults->size_drops = 1;
+    Result rc2 = backup_run(&cfg);
+    ServerStats s2 = *srv->stats;
+    srv->faults->size_drops = 0;
+
+    u64 wire = s2.bytes - s1.bytes;
+    u64 stor = s2.stor - s1.stor, appe = s2.appe - s1.appe;
+    u64 resumed = wire < size ? size - wire : 0;
+    bool match = files_equal(local, remote_file);
+    bool ok = s1.data_drops - s0.data_drops == UPLOAD_MAX_RETRIES + 1 && journal && R_SUCCEEDED(rc2) &&
+              stor == 0 && appe > 0 && resumed > 0 && match;
+    printf("{\"scenario\":\"resume\",\"remote_cache\":%d,\"size\":%llu,\"cut_kb\":%u,\"run1_rc\":%u,\"run1_drops\":%llu,\"journal\":%d,"
+           "\"rc\":%u,\"size_drops\":%llu,\"stor\":%llu,\"appe\":%llu,\"wire_bytes\":%llu,\"resumed_bytes\":%llu,\"match\":%d,\"ok\":%d}\n",
+           remote_cache, (unsigned long long)size, cut_kb, rc1, (unsigned long long)(s1.data_drops - s0.data_drops), journal,
+           rc2, (unsigned long long)(s2.size_drops - s1.size_drops), (unsigned long long)stor, (unsigned long long)appe,
+           (unsigned long long)wire, (unsigned long long)resumed, match, ok);
+    fflush(stdout);
+    return ok;
+}
+
+// 远端留着上次备份的旧副本（内容不同、只有一半长），没有续传日志；第一条 STOR 在截断它之前断开控制连接。
+// SIZE 量到的是旧副本的长度，不能当作本次已传的部分接着 APPE：期望重试用 STOR 从头传，最后远端与源文件一致
+static bool stale_check(FtpServer *srv, const char *remote_root, const char *tree, const char *rel, u64 size, bool remote_cache) {
+    AppConfig cfg;
+    config_defaults(&cfg);
+    snprintf(cfg.backup_source, sizeof(cfg.backup_source), "%s", tree);
+    snprintf(cfg.ftp_url, sizeof(cfg.ftp_url), "ftp://127.0.0.1:%d/bk", srv->port);
+    cfg.upload_connections = 1;
+    cfg.upload_chunk_mb = 1;
+    cfg.compression = 0;
+    cfg.remote_cache = remote_cache;
+    char remote[BENCH_PATH_MAX], dir[BENCH_PATH_MAX], local[BENCH_PATH_MAX * 2], remote_file[BENCH_PATH_MAX * 2];
+    snprintf(remote, sizeof(remote), "%s/bk", remote_root);
+    snprintf(local, sizeof(local), "%s/%s", tree, rel);
+    snprintf(remote_file, sizeof(remote_file), "%s/%s", remote, rel);
+    rm_tree(remote);
+    mkdir(remote, 0755);
+    bool old = gen_slot(dir, remote, 1, 0) && gen_file(remote_file, size / 2, 2);
+    unlink(MANIFEST_FILE_PATH);
+    unlink(JOURNAL_FILE_PATH);
+    unlink(SCAN_CACHE_FILE_PATH);
+
+    ServerStats s0 = *srv->stats;
+    srv->faults->data_drops = 0;
+    srv->faults->size_drops = 0;
+    srv->faults->stor_drops = 1;
+    Result rc = backup_run(&cfg);
+    ServerStats s1 = *srv->stats;
+    srv->faults->stor_drops = 0;
+
+    u64 stor = s1.stor - s0.stor, appe = s1.appe - s0.appe;
+    bool match = files_equal(local, remote_file);
+    bool ok = old && s1.stor_drops - s0.stor_drops == 1 && R_SUCCEEDED(rc) && stor > 0 && match;
+    printf("{\"scenario\":\"stale\",\"remote_cache\":%d,\"size\":%llu,\"old_size\":%llu,\"rc\":%u,\"stor_drops\":%llu,"
+           "\"stor\":%llu,\"appe\":%llu,\"wire_bytes\":%llu,\"match\":%d,\"ok\":%d}\n",
+           remote_cache, (unsigned long long)size, (unsigned long long)(size / 2), rc,
+           (unsigned long long)(s1.stor_drops - s0.stor_drops), (unsigned long long)stor, (unsigned long long)appe,
+           (unsigned long long)(s1.bytes - s0.bytes), match, ok);
+    fflush(stdout);
+    return ok;
+}
+
+// 生成只有一个文件的树，分别在关闭与开启远端目录缓存时做续传检查与旧副本检查；全部通过时返回 0
+static int cmd_resume(u32 size_mb, u32 cut_kb) {
+    char work[] = "/tmp/backupbench-resume.XXXXXX";
+    char tree[BENCH_PATH_MAX], dir[BENCH_PATH_MAX], path[BENCH_PATH_MAX * 2];
+    const char *rel = "title0001/slot0/save.bin";
+    u64 size = (u64)size_mb * 1024 * 1024;
+    if (!mkdtemp(work)) {
+        fprintf(stderr, "无法创建临时目录\n");
+        return 1;
+    }
+    snprintf(tree, sizeof(tree), "%s/tree", work);
+    mkdir(tree, 0755);
+    if (!gen_slot(dir, tree, 1, 0) || snprintf(path, sizeof(path), "%s/%s", tree, rel) < 0 || !gen_file(path, size, 1)) {
+        fprintf(stderr, "无法生成 %s\n", path);
+        rm_tree(work);
+        return 1;
+    }
+    mkdir("/config", 0755);
+    mkdir("/config/mario-pop", 0755);
+    FtpServer srv = { 0 };
+    if (!server_start(&srv, work, 0, 0)) {
+        fprintf(stderr, "FTP 替身启动失败\n");
+        rm_tree(work);
+        return 1;
+    }
+    bool ok = resume_check(&srv, work, tree, rel, size, cut_kb, false);
+    ok &= resume_check(&srv, work, tree, rel, size, cut_kb, true);
+    ok &= stale_check(&srv, work, tree, rel, size, false);
+    ok &= stale_check(&srv, work, tree, rel, size, true);
+    server_stop(&srv);
+    rm_tree(work);
+    return ok ? 0 : 1;
+}
+
+// ---- 环形缓冲检查 ----
+
+// 单连接、最小的环（upload_buffers = 2，每块 16KB）、1MB 分块，上传大小落在块边界两侧的一组文件，
+// 让读线程与 curl 的读回调在环上反复绕圈、在分块边界换 APPE；之后逐个比较远端文件与源文件。全部一致时返回 0
+static int cmd_stream(void) {
+    static const u64 slot = 16 * 1024;
+    static const u64 sizes[] = {
+        0, 1, 16 * 1024 - 1, 16 * 1024, 16 * 1024 + 1, 2 * 16 * 1024, 3 * 16 * 1024 + 7,
+        1024 * 1024 - 1, 1024 * 1024, 1024 * 1024 + 1, 3 * 1024 * 1024 + 16 * 1024 + 13, 8 * 1024 * 1024 + 5,
+    };
+    const u32 count = (u32)(sizeof(sizes) / sizeof(sizes[0]));
+    char work[] = "/tmp/backupbench-stream.XXXXXX";
+    char tree[sizeof(work) + 8], remote[sizeof(work) + 8], dir[BENCH_PATH_MAX];
+    char local_file[BENCH_PATH_MAX * 2], remote_file[BENCH_PATH_MAX * 2];
+    if (!mkdtemp(work)) {
+        fprintf(stderr, "无法创建临时目录\n");
+        return 1;
+    }
+    snprintf(tree, sizeof(tree), "%s/tree", work);
+    snprintf(remote, sizeof(remote), "%s/bk", work);
+    mkdir(tree, 0755);
+    mkdir(remote, 0755);
+    u64 total = 0;
+    bool ok = gen_slot(dir, tree, 1, 0);
+    for (u32 i = 0; ok && i < count; ++i) {
+        snprintf(local_file, sizeof(local_file), "%s/file%02u.bin", dir, i);
+        ok = gen_file(local_file, sizes[i], 100 + i);
+        total += sizes[i];
+    }
+    if (!ok) {
+        fprintf(stderr, "无法生成 %s\n", local_file);
+        rm_tree(work);
+        return 1;
+    }
+    mkdir("/config", 0755);
+    mkdir("/config/mario-pop", 0755);
+    unlink(MANIFEST_FILE_PATH);
+    unlink(JOURNAL_FILE_PATH);
+    unlink(SCAN_CACHE_FILE_PATH);
+    FtpServer srv = { 0 };
+    if (!server_start(&srv, work, 0, 0)) {
+        fprintf(stderr, "FTP 替身启动失败\n");
+        rm_tree(work);
+        return 1;
+    }
+
+    AppConfig cfg;
+    config_defaults(&cfg);
+    snprintf(cfg.backup_source, sizeof(cfg.backup_source), "%s", tree);
+    snprintf(cfg.ftp_url, sizeof(cfg.ftp_url), "ftp://127.0.0.1:%d/bk", srv.port);
+    cfg.upload_connections = 1;
+    cfg.upload_buffers = 2;
+    cfg.upload_buffer_kb = (u32)(slot / 1024);
+    cfg.upload_chunk_mb = 1;
+    cfg.compression = 0;
+    ServerStats s0 = *srv.stats;
+    Result rc = backup_run(&cfg);
+    ServerStats s1 = *srv.stats;
+    server_stop(&srv);
+
+    u32 matched = 0;
+    for (u32 i = 0; i < count; ++i) {
+        snprintf(local_file, sizeof(local_file), "%s/title0001/slot0/file%02u.bin", tree, i);
+        snprintf(remote_file, sizeof(remote_file), "%s/title0001/slot0/file%02u.bin", remote, i);
+        if (files_equal(local_file, remote_file)) matched++;
+        else fprintf(stderr, "远端文件与源文件不一致：file%02u.bin（%llu 字节）\n", i, (unsigned long long)sizes[i]);
+    }
+    u64 wire = s1.bytes - s0.bytes;
+    ok = R_SUCCEEDED(rc) && matched == count && wire == total;
+    printf("{\"scenario\":\"stream\",\"rc\":%u,\"files\":%u,\"matched\":%u,\"bytes\":%llu,\"wire_bytes\":%llu,"
+           "\"buffers\":%u,\"buffer_kb\":%u,\"stor\":%llu,\"appe\":%llu,\"ok\":%d}\n",
+           rc, count, matched, (unsigned long long)total, (unsigned long long)wire, cfg.upload_buffers, cfg.upload_buffer_kb,
+           (unsigned long long)(s1.stor - s0.stor), (unsigned long long)(s1.appe - s0.appe), ok);
+    fflush(stdout);
+    rm_tree(work);
+    return ok ? 0 : 1;
+}
+
+// ---- 对比 ----
+
+static bool json_number(const char *line, const char *key, double *out) {
+    char pat[64];
+    snprintf(pat, sizeof(pat), "\"%s\":", key);
+    const char *p = strstr(line, pat);
+    if (!p) return false;
+    *out = strtod(p + strlen(pat), NULL);
+    return true;
+}
+
+static bool json_string(const char *line, const char *key, char *out, size_t size) {
+    char pat[64];
+    snprintf(pat, sizeof(pat), "\"%s\":\"", key);
+    const char *p = strstr(line, pat);
+    if (!p) return false;
+    p += strlen(pat);
+    const char *end = strchr(p, '"');
+    if (!end) return false;
+    snprintf(out, size, "%.*s", (int)(end - p), p);
+    return true;
+}
+
+typedef struct {
+    char scenario[64];
+    u32 run;
+    char line[1024];
+} BenchLine;
+
+static u32 load_lines(const char *path, BenchLine *out, u32 max) {
+    FILE *f = fopen(path, "r");
+    if (!f) return 0;
+    u32 n = 0;
+    double run;
+    while (n < max && fgets(out[n].line, sizeof(out[n].line), f)) {
+        if (json_string(out[n].line, "scenario", out[n].scenario, sizeof(out[n].scenario)) && json_number(out[n].line, "run", &run)) {
+            out[n].run = (u32)run;
+            n++;
+        }
+    }
+    fclose(f);
+    return n;
+}
+
+static int cmd_compare(const char *old_path, const char *new_path, double threshold) {
+    static BenchLine old_lines[256], new_lines[256];
+    u32 old_count = load_lines(old_path, old_lines, 256);
+    u32 new_count = load_lines(new_path, new_lines, 256);
+    static const struct {
+        const char *key;
+        bool higher_better;
+    } metrics[] = {
+        { "mb_s", true }, { "files_s", true }, { "cpu_ms", false }, { "peak_heap_kb", false }, { "commands", false },
+    };
+    u32 regressions = 0;
+    printf("%-10s %-4s %-14s %14s %14s %9s\n", "scenario", "run", "metric", "old", "new", "change");
+    for (u32 i = 0; i < new_count; ++i) {
+        const BenchLine *n = &new_lines[i];
+        const BenchLine *o = NULL;
+        for (u32 j = 0; j < old_count && !o; ++j) {
+            if (old_lines[j].run == n->run && strcmp(old_lines[j].scenario, n->scenario) == 0) o = &old_lines[j];
+        }
+        if (!o) continue;
+        for (u32 m = 0; m < sizeof(metrics) / sizeof(metrics[0]); ++m) {
+            double a, b;
+            if (!json_number(o->line, metrics[m].key, &a) || !json_number(n->line, metrics[m].key, &b)) continue;
+            double change = a != 0 ? (b - a) / a * 100.0 : 0.0;
+            bool worse = metrics[m].higher_better ? change < -threshold : change > threshold;
+            regressions += worse;
+            printf("%-10s %-4u %-14s %14.2f %14.2f %+8.1f%%%s\n", n->scenario, n->run, metrics[m].key, a, b, change, worse ? "  !" : "");
+        }
+    }
+    printf("阈值 %.1f%%，退步 %u 项\n", threshold, regressions);
+    return regressions ? 1 : 0;
+}
+
+int main(int argc, char **argv) {
+    s_verbose = getenv("VERBOSE") && atoi(getenv("VERBOSE")) != 0;
+    if (argc >= 4 && strcmp(argv[1], "gen") == 0) return cmd_gen(argv[2], argv[3], argc > 4 ? (u32)atoi(argv[4]) : 1);
+    if (argc >= 4 && strcmp(argv[1], "compare") == 0) return cmd_compare(argv[2], argv[3], argc > 4 ? atof(argv[4]) : 5.0);
+    BenchParams p;
+    if (argc >= 3 && strcmp(argv[1], "run") == 0) {
+        parse_params(&p, argc, argv, 3);
+        const char *tree = argv[2];
+        return cmd_run(&tree, 1, &p);
+    }
+    if (argc >= 2 && strcmp(argv[1], "resume") == 0) {
+        u32 size_mb = argc > 2 ? (u32)atoi(argv[2]) : 6;
+        u32 cut_kb = argc > 3 ? (u32)atoi(argv[3]) : 2560;
+        if (size_mb < 2) size_mb = 2;
+        if (cut_kb < 1024 || cut_kb >= size_mb * 1024) cut_kb = size_mb * 1024 / 2;
+        return cmd_resume(size_mb, cut_kb);
+    }
+    if (argc >= 2 && strcmp(argv[1], "stream") == 0) return cmd_stream();
+    if (argc >= 3 && strcmp(argv[1], "suite") == 0) {
+        parse_params(&p, argc, argv, 3);
+        return cmd_suite(argv[2], &p);
+    }
+    fprintf(stderr, "用法:\n  %s gen <dir> <tiny|large|mixed> [scale]\n"
+                    "  %s run <tree> [latency_ms] [bandwidth_kbps] [connections] [runs]\n"
+                    "  %s suite <workdir> [latency_ms] [bandwidth_kbps] [connections] [runs]\n"
+                    "  %s resume [size_mb] [cut_kb]\n"
+                    "  %s stream\n"
+                    "  %s compare <old.jsonl> <new.jsonl> [threshold_pct]\n",
+            argv[0], argv[0], argv[0], argv[0], argv[0], argv[0]);
+    return 1;
+}
@@ -0,0 +1,183 @@
+// 精灵 blitter 基准（主机端）：比较 util/blit 按缩放比例特化的 RGB565 blitter 与原先逐像素调用 drawRectSolid 的路径，
+// 在默认 448x720 的块线性帧缓冲上按场景用到的尺寸与缩放（马里奥 5x5，砖块与云朵 6x6，小山与灌木 6x8，另加一个通用比例）
+// 逐个位置绘制（含越出四边被裁剪的位置），输出每次绘制的平均耗时；两条路径写出的帧缓冲不一致时报错
+//
+// 构建：cc -O2 -Isource -o blitbench tools/blitbench.c source/util/blit.c
+// 用法：
+//   blitbench [rounds]
+//       每种精灵把整套位置各画 rounds 轮（默认 200），取三次中最快的一次
+#include "util/blit.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FB_WIDTH 448
+#define FB_HEIGHT 720
+#define FB_ALLOC_HEIGHT ((FB_HEIGHT + 127) & ~127) // 块线性布局按 128 行一块排列，最后一块要分配完整
+
+typedef struct {
+    const char *name;
+    s32 width;
+    s32 height;
+    s32 scale_x;
+    s32 scale_y;
+} BenchSprite;
+
+// 与 main.c 中场景精灵的尺寸一致，内容为合成的（见 gen_bitmap）
+static const BenchSprite s_sprites[] = {
+    { "mario 13x16 @5x5",  13, 16, 5, 5 },
+    { "ground 8x8 @6x6",    8,  8, 6, 6 },
+    { "cloud 13x12 @6x6",  13, 12, 6, 6 },
+    { "hill 20x22 @6x8",   20, 22, 6, 8 },
+    { "bush 21x9 @6x8",    21,  9, 6, 8 },
+    { "mario 13x16 @4x3",  13, 16, 4, 3 }, // 通用路径
+};
+
+// ---- 原路径：每个源像素一个 drawRectSolid，矩形内按列逐像素裁剪、swizzle、写入 ----
+
+static u16 *s_fb;
+
+static inline void setPixel_old(s32 x, s32 y, u16 raw) {
+    if (x < 0 || y < 0 || x >= FB_WIDTH || y >= FB_HEIGHT || s_fb == NULL) return;
+    s_fb[blit_pixel_offset(FB_WIDTH, x, y)] = raw;
+}
+
+static inline void drawRectSolid_old(s32 x, s32 y, s32 w, s32 h, u16 raw) {
+    s32 x2 = x + w;
+    s32 y2 = y + h;
+    if (x2 < 0 || y2 < 0) return;
+    if (x >= FB_WIDTH || y >= FB_HEIGHT) return;
+    if (x < 0) x = 0;
+    if (y < 0) y = 0;
+    if (x2 > FB_WIDTH) x2 = FB_WIDTH;
+    if (y2 > FB_HEIGHT) y2 = FB_HEIGHT;
+    for (s32 xi = x; xi < x2; ++xi) {
+        for (s32 yi = y; yi < y2; ++yi) {
+            setPixel_old(xi, yi, raw);
+        }
+    }
+}
+
+static void draw_old(s32 x, s32 y, const u16 *bitmap, s32 width, s32 height, s32 scale_x, s32 scale_y) {
+    for (s32 row = 0; row < height; row++) {
+        for (s32 col = 0; col < width; col++) {
+            u16 pixel = bitmap[row * width + col];
+            if (pixel == BLIT_RGB565_KEY) continue;
+            drawRectSolid_old(x + col * scale_x, y + row * scale_y, scale_x, scale_y, blit_rgb565_to_raw(pixel));
+        }
+    }
+}
+
+// ---- 基准 ----
+
+typedef struct {
+    s32 x, y;
+} BenchPos;
+
+static u64 s_rng = 0x9E3779B97F4A7C15ULL;
+
+static u64 rng_next(void) {
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 7;
+    s_rng ^= s_rng << 17;
+    return s_rng;
+}
+
+// 与场景精灵相似的形状：每行两端各有一段透明边，中间是从少数几种颜色中取的色块
+static void gen_bitmap(u16 *bitmap, s32 width, s32 height) {
+    static const u16 palette[] = { 0xF801, 0xFD28, 0xC300, 0xFFFF, 0x0000, 0x07E0 };
+    for (s32 row = 0; row < height; ++row) {
+        s32 left = (s32)(rng_next() % (u64)(width / 4 + 1));
+        s32 right = width - (s32)(rng_next() % (u64)(width / 4 + 1));
+        u16 c = palette[rng_next() % 6];
+        for (s32 col = 0; col < width; ++col) {
+            if (rng_next() % 4 == 0) c = palette[rng_next() % 6];
+            bitmap[row * width + col] = col < left || col >= right ? BLIT_RGB565_KEY : c;
+        }
+    }
+}
+
+// 位置：帧缓冲内的网格（x 不按 8 对齐），加上越出四边各一半的位置
+static u32 gen_positions(BenchPos *out, u32 max, s32 w, s32 h) {
+    u32 n = 0;
+    for (s32 y = -h / 2; y <= FB_HEIGHT - h / 2 && n < max; y += 37) {
+        for (s32 x = -w / 2; x <= FB_WIDTH - w / 2 && n < max; x += 29) {
+            out[n++] = (BenchPos){ x, y };
+        }
+    }
+    return n;
+}
+
+static double now_ns(void) {
+    return (double)armTicksToNs(armGetSystemTick());
+}
+
+// 把整套位置画 rounds 轮，取三次中最快的一次，返回每次绘制的平均纳秒数
+static double bench_path(bool specialized, const BenchSprite *sp, const u16 *bitmap, const BenchPos *pos, u32 count, u32 rounds) {
+    BlitTarget target = { s_fb, FB_WIDTH, FB_HEIGHT };
+    double best = 0;
+    for (int pass = 0; pass < 3; ++pass) {
+        double t = now_ns();
+        for (u32 r = 0; r < rounds; ++r) {
+            for (u32 i = 0; i < count; ++i) {
+                if (specialized) blit_rgb565_scaled(&target, pos[i].x, pos[i].y, bitmap, sp->width, sp->height, sp->scale_x, sp->scale_y);
+                else draw_old(pos[i].x, pos[i].y, bitmap, sp->width, sp->height, sp->scale_x, sp->scale_y);
+            }
+        }
+        double ns = now_ns() - t;
+        if (pass == 0 || ns < best) best = ns;
+    }
+    return best / ((double)rounds * (double)count);
+}
+
+// 每个位置在清空的帧缓冲上各画一次，逐字节比较两条路径的结果
+static bool check_identical(const BenchSprite *sp, const u16 *bitmap, const BenchPos *pos, u32 count, u16 *fb_old, u16 *fb_new) {
+    size_t bytes = (size_t)FB_WIDTH * FB_ALLOC_HEIGHT * sizeof(u16);
+    BlitTarget target = { fb_new, FB_WIDTH, FB_HEIGHT };
+    for (u32 i = 0; i < count; ++i) {
+        memset(fb_old, 0, bytes);
+        memset(fb_new, 0, bytes);
+        s_fb = fb_old;
+        draw_old(pos[i].x, pos[i].y, bitmap, sp->width, sp->height, sp->scale_x, sp->scale_y);
+        blit_rgb565_scaled(&target, pos[i].x, pos[i].y, bitmap, sp->width, sp->height, sp->scale_x, sp->scale_y);
+        if (memcmp(fb_old, fb_new, bytes) != 0) {
+            fprintf(stderr, "%s 在 (%d, %d) 处结果不一致\n", sp->name, pos[i].x, pos[i].y);
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    u32 rounds = argc > 1 ? (u32)strtoul(argv[1], NULL, 10) : 200;
+    if (rounds == 0) {
+        fprintf(stderr, "用法: %s [rounds]\n", argv[0]);
+        return 1;
+    }
+    size_t bytes = (size_t)FB_WIDTH * FB_ALLOC_HEIGHT * sizeof(u16);
+    u16 *fb_old = aligned_alloc(64, bytes), *fb_new = aligned_alloc(64, bytes);
+    static BenchPos pos[4096];
+    static u16 bitmap[64 * 64];
+    if (!fb_old || !fb_new) {
+        fprintf(stderr, "内存不足\n");
+        return 1;
+    }
+
+    printf("帧缓冲 %dx%d，每种精灵每轮 N 个位置，%u 轮\n", FB_WIDTH, FB_HEIGHT, rounds);
+    printf("%-20s %6s %12s %12s %8s\n", "sprite", "N", "old us", "blit us", "speedup");
+    int rc = 0;
+    for (size_t k = 0; k < sizeof(s_sprites) / sizeof(s_sprites[0]); ++k) {
+        const BenchSprite *sp = &s_sprites[k];
+        gen_bitmap(bitmap, sp->width, sp->height);
+        u32 count = gen_positions(pos, sizeof(pos) / sizeof(pos[0]), sp->width * sp->scale_x, sp->height * sp->scale_y);
+        if (!check_identical(sp, bitmap, pos, count, fb_old, fb_new)) rc = 1;
+        s_fb = fb_old;
+        double old_ns = bench_path(false, sp, bitmap, pos, count, rounds);
+        s_fb = fb_new;
+        double new_ns = bench_path(true, sp, bitmap, pos, count, rounds);
+        printf("%-20s %6u %12.2f %12.2f %7.1fx\n", sp->name, count, old_ns / 1000.0, new_ns / 1000.0, new_ns > 0 ? old_ns / new_ns : 0.0);
+    }
+    free(fb_old);
+    free(fb_new);
+    return rc;
+}
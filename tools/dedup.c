@@ -0,0 +1,209 @@
+// 去重备份工具（主机端）
+//
+// 构建：cc -O2 -Isource -o dedup tools/dedup.c source/backup/dedup.c source/backup/cdc.c source/backup/throttle.c source/backup/progress.c source/util/checksum.c source/util/hash.c source/util/fspool.c source/util/service.c source/util/trace.c source/util/metrics.c source/util/threading.c -lcurl -lpthread
+// 用法：
+//   dedup restore <ftp_url> <dest_dir> [recipe] [user] [password]
+//       按远端配方（默认 latest，也可写代数如 00000003）把文件还原到 dest_dir，逐块并逐文件校验 SHA-256
+//   dedup bench <file> [generations] [edits]
+//       模拟同一个存档的连续备份：每一代在随机位置改写 edits 处（默认 8 处，每处 64 字节）并插入 100 字节，
+//       输出每一代内容分块需要上传的新字节，并与 16KB 定长分块、整文件上传对比
+//   dedup files <v1> <v2> ...
+//       把几个文件当作同一存档依次的版本，输出每个版本需要上传的新字节
+#include "backup/dedup.h"
+#include "backup/cdc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <curl/curl.h>
+
+#define BENCH_FIXED_SIZE CDC_AVG_SIZE
+#define BENCH_EDIT_SIZE 64
+#define BENCH_INSERT_SIZE 100
+#define BENCH_MAX_INSERTS 64     // read_file 为插入预留的空间
+
+static void log_stderr(const char *level, const char *fmt, va_list args) {
+    fprintf(stderr, "[%s] ", level);
+    vfprintf(stderr, fmt, args);
+    fprintf(stderr, "\n");
+}
+
+void log_info_impl(const char *file, int line, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    log_stderr("INFO", fmt, args);
+    va_end(args);
+}
+
+void log_warning_impl(const char *file, int line, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    log_stderr("WARNING", fmt, args);
+    va_end(args);
+}
+
+void log_error_impl(const char *file, int line, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    log_stderr("ERROR", fmt, args);
+    va_end(args);
+}
+
+void log_debug_impl(const char *file, int line, const char *fmt, ...) {
+}
+
+static u8 *read_file(const char *path, size_t *len) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    u8 *data = malloc(size > 0 ? (size_t)size + BENCH_INSERT_SIZE * BENCH_MAX_INSERTS : 1);
+    if (data && fread(data, 1, (size_t)size, f) != (size_t)size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    *len = (size_t)size;
+    return data;
+}
+
+// 块不在索引里就计为新字节并加入索引
+static u64 add_chunk(ChunkIndex *idx, const u8 *data, size_t len, u64 *chunks) {
+    u8 digest[SHA256_DIGEST_SIZE];
+    Sha256 sha;
+    sha256_init(&sha);
+    sha256_update(&sha, data, len);
+    sha256_final(&sha, digest);
+    ++*chunks;
+    if (chunk_index_contains(idx, digest)) return 0;
+    chunk_index_add(idx, digest, (u32)len);
+    return len;
+}
+
+static u64 new_bytes_cdc(ChunkIndex *idx, const u8 *data, size_t len, u64 *chunks) {
+    u64 fresh = 0;
+    for (size_t off = 0; off < len;) {
+        size_t n = cdc_cut(data + off, len - off, true);
+        fresh += add_chunk(idx, data + off, n, chunks);
+        off += n;
+    }
+    return fresh;
+}
+
+static u64 new_bytes_fixed(ChunkIndex *idx, const u8 *data, size_t len) {
+    u64 fresh = 0, chunks = 0;
+    for (size_t off = 0; off < len; off += BENCH_FIXED_SIZE) {
+        fresh += add_chunk(idx, data + off, len - off < BENCH_FIXED_SIZE ? len - off : BENCH_FIXED_SIZE, &chunks);
+    }
+    return fresh;
+}
+
+typedef struct {
+    ChunkIndex cdc;
+    ChunkIndex fixed;
+    u64 total;
+    u64 sent_cdc;
+    u64 sent_fixed;
+} BenchState;
+
+static void bench_generation(BenchState *b, u32 gen, const u8 *data, size_t len) {
+    u64 chunks = 0;
+    u64 cdc = new_bytes_cdc(&b->cdc, data, len, &chunks);
+    u64 fixed = new_bytes_fixed(&b->fixed, data, len);
+    b->total += len;
+    b->sent_cdc += cdc;
+    b->sent_fixed += fixed;
+    printf("%4u %10zu %7llu %12llu %12llu %7.1f%%\n", gen, len, (unsigned long long)chunks,
+           (unsigned long long)cdc, (unsigned long long)fixed, len ? 100.0 * (1.0 - (double)cdc / (double)len) : 0.0);
+}
+
+static void bench_summary(BenchState *b) {
+    printf("合计：整文件上传 %llu 字节，内容分块 %llu 字节（省 %.1f%%），16KB 定长分块 %llu 字节（省 %.1f%%）\n",
+           (unsigned long long)b->total,
+           (unsigned long long)b->sent_cdc, b->total ? 100.0 * (1.0 - (double)b->sent_cdc / (double)b->total) : 0.0,
+           (unsigned long long)b->sent_fixed, b->total ? 100.0 * (1.0 - (double)b->sent_fixed / (double)b->total) : 0.0);
+    chunk_index_free(&b->cdc);
+    chunk_index_free(&b->fixed);
+}
+
+static void bench_begin(BenchState *b) {
+    memset(b, 0, sizeof(*b));
+    chunk_index_load(&b->cdc, "", 0);
+    chunk_index_load(&b->fixed, "", 0);
+    printf("代数       大小      块   内容分块新字节  定长分块新字节    省去\n");
+}
+
+static int cmd_bench(const char *path, u32 generations, u32 edits) {
+    size_t len;
+    u8 *data = read_file(path, &len);
+    if (!data) {
+        fprintf(stderr, "无法读取 %s\n", path);
+        return 1;
+    }
+    BenchState b;
+    bench_begin(&b);
+    srand(1);
+    bench_generation(&b, 1, data, len);
+    for (u32 gen = 2; gen <= generations; ++gen) {
+        for (u32 i = 0; i < edits && len > BENCH_EDIT_SIZE; ++i) {
+            size_t at = (size_t)rand() % (len - BENCH_EDIT_SIZE);
+            for (u32 k = 0; k < BENCH_EDIT_SIZE; ++k) data[at + k] = (u8)rand();
+        }
+        // 插入会让其后的定长块全部错位，内容分块只影响插入点附近
+        if (gen <= BENCH_MAX_INSERTS) {
+            size_t at = len ? (size_t)rand() % len : 0;
+            memmove(data + at + BENCH_INSERT_SIZE, data + at, len - at);
+            for (u32 k = 0; k < BENCH_INSERT_SIZE; ++k) data[at + k] = (u8)rand();
+            len += BENCH_INSERT_SIZE;
+        }
+        bench_generation(&b, gen, data, len);
+    }
+    bench_summary(&b);
+    free(data);
+    return 0;
+}
+
+static int cmd_files(int count, char **paths) {
+    BenchState b;
+    bench_begin(&b);
+    for (int i = 0; i < count; ++i) {
+        size_t len;
+        u8 *data = read_file(paths[i], &len);
+        if (!data) {
+            fprintf(stderr, "无法读取 %s\n", paths[i]);
+            continue;
+        }
+        bench_generation(&b, (u32)i + 1, data, len);
+        free(data);
+    }
+    bench_summary(&b);
+    return 0;
+}
+
+static int cmd_restore(int argc, char **argv) {
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    DedupOptions opt = {
+        .local_root = argv[1],
+        .url = argv[0],
+        .user = argc > 3 ? argv[3] : NULL,
+        .password = argc > 4 ? argv[4] : NULL,
+    };
+    DedupRestoreStats s;
+    Result rc = dedup_restore(&opt, argc > 2 ? argv[2] : NULL, &s);
+    printf("配方 #%u：恢复 %u 个文件（失败 %u），%llu 字节，%llu 块，%.2f 秒\n", s.generation, s.files, s.files_failed,
+           (unsigned long long)s.bytes, (unsigned long long)s.chunks, (double)s.elapsed_ns / 1e9);
+    curl_global_cleanup();
+    return R_SUCCEEDED(rc) ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+    if (argc >= 4 && strcmp(argv[1], "restore") == 0) return cmd_restore(argc - 2, argv + 2);
+    if (argc >= 3 && strcmp(argv[1], "bench") == 0) {
+        return cmd_bench(argv[2], argc > 3 ? (u32)atoi(argv[3]) : 10, argc > 4 ? (u32)atoi(argv[4]) : 8);
+    }
+    if (argc >= 3 && strcmp(argv[1], "files") == 0) return cmd_files(argc - 2, argv + 2);
+    fprintf(stderr, "用法:\n  %s restore <ftp_url> <dest_dir> [recipe] [user] [password]\n"
+                    "  %s bench <file> [generations] [edits]\n  %s files <v1> <v2> ...\n", argv[0], argv[0], argv[0]);
+    return 1;
+}
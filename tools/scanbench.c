@@ -0,0 +1,126 @@
+// 目录遍历基准（主机端）
+//
+// 构建：cc -O2 -Isource -o scanbench tools/scanbench.c source/backup/scan.c source/util/hash.c source/util/fspool.c source/util/mempool.c source/util/threading.c -lpthread
+// 用法：
+//   scanbench gen <dir> <files> [files_per_dir]
+//       生成合成目录树：每个目录 files_per_dir 个小文件（默认 50），目录按每层 8 个分叉
+//   scanbench run <dir> [threads ...]
+//       依次用各线程数遍历（默认 1 2 4）：无缓存冷遍历、建立缓存后的热遍历，以及改动一个目录后的遍历。
+//       环境变量 FS_SESSIONS 指定文件系统会话槽数（默认 3；为 1 时所有遍历线程共用一个槽）
+//       worker_cpu 为额外遍历线程（不含调用线程）用掉的 CPU 时间
+#include "backup/scan.h"
+#include "util/fspool.h"
+#include "util/threading.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <utime.h>
+
+#define BENCH_CACHE_PATH "/tmp/scanbench.cache"
+
+static u32 s_made;
+
+// 在 dir 下建 count 个文件，剩余的均分到 8 个子目录
+static void gen_dir(const char *dir, u32 count, u32 per_dir) {
+    char path[SCAN_PATH_MAX];
+    mkdir(dir, 0755);
+    u32 here = count < per_dir ? count : per_dir;
+    for (u32 i = 0; i < here; ++i) {
+        snprintf(path, sizeof(path), "%s/save_%03u.bin", dir, i);
+        FILE *f = fopen(path, "wb");
+        if (!f) continue;
+        fprintf(f, "%u", s_made++);
+        fclose(f);
+    }
+    u32 rest = count - here;
+    for (u32 i = 0; i < 8 && rest; ++i) {
+        u32 part = rest / (8 - i);
+        snprintf(path, sizeof(path), "%s/d%u", dir, i);
+        gen_dir(path, part, per_dir);
+        rest -= part;
+    }
+}
+
+void log_info_impl(const char *file, int line, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    fprintf(stderr, "[INFO] ");
+    vfprintf(stderr, fmt, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+}
+
+static void report(const char *label, u32 threads, const ScanStats *s, const BackupFileList *list, u64 worker_cpu_ns) {
+    double ms = (double)s->elapsed_ns / 1e6;
+    printf("%-8s threads=%u  %7.1f ms  files=%u (cached %u)  dirs=%u (cached %u)  %.0f files/s  bytes=%llu  worker_cpu=%.1f ms\n",
+           label, threads, ms, s->files, s->files_cached, s->dirs, s->dirs_cached,
+           ms > 0 ? (double)list->count * 1000.0 / ms : 0.0, (unsigned long long)list->total_bytes, (double)worker_cpu_ns / 1e6);
+}
+
+static bool run_once(const char *label, const char *dir, u32 threads, const char *cache, u32 expect) {
+    ScanOptions opt = { dir, threads, cache };
+    BackupFileList list;
+    ScanStats s;
+    ThreadRoleStats before, after;
+    threading_stats(ThreadRole_Scan, &before);
+    Result rc = scan_tree(&opt, &list, &s);
+    threading_stats(ThreadRole_Scan, &after);
+    if (R_FAILED(rc)) {
+        fprintf(stderr, "scan failed: 0x%x\n", rc);
+        return false;
+    }
+    report(label, s.threads, &s, &list, after.cpu_ns - before.cpu_ns);
+    bool ok = expect == 0 || list.count == expect;
+    for (u32 i = 1; i < list.count && ok; ++i) ok = strcmp(list.items[i - 1].path, list.items[i].path) < 0;
+    if (!ok) fprintf(stderr, "%s: unexpected output (%u files)\n", label, list.count);
+    backup_file_list_free(&list);
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    if (argc >= 4 && strcmp(argv[1], "gen") == 0) {
+        u32 per_dir = argc >= 5 ? (u32)atoi(argv[4]) : 50;
+        gen_dir(argv[2], (u32)atoi(argv[3]), per_dir ? per_dir : 50);
+        printf("generated %u files under %s\n", s_made, argv[2]);
+        return 0;
+    }
+    if (argc >= 3 && strcmp(argv[1], "run") == 0) {
+        const char *dir = argv[2];
+        if (getenv("FS_SESSIONS")) fspool_configure((u32)atoi(getenv("FS_SESSIONS")));
+        u32 thread_list[8] = { 1, 2, 4 };
+        u32 thread_count = 3;
+        if (argc > 3) {
+            thread_count = 0;
+            for (int i = 3; i < argc && thread_count < 8; ++i) thread_list[thread_count++] = (u32)atoi(argv[i]);
+        }
+        // 先做一次无缓存遍历取得文件数，同时预热主机的目录缓存
+        ScanOptions opt = { dir, 1, NULL };
+        BackupFileList list;
+        ScanStats s;
+        if (R_FAILED(scan_tree(&opt, &list, &s))) return 1;
+        u32 expect = list.count;
+        backup_file_list_free(&list);
+
+        bool ok = true;
+        for (u32 i = 0; i < thread_count; ++i) {
+            u32 t = thread_list[i];
+            remove(BENCH_CACHE_PATH);
+            ok &= run_once("cold", dir, t, NULL, expect);
+            ok &= run_once("build", dir, t, BENCH_CACHE_PATH, expect);
+            ok &= run_once("warm", dir, t, BENCH_CACHE_PATH, expect);
+        }
+        // 在根目录新建一个文件：根目录修改时间变化，只有它被重新列出
+        char path[SCAN_PATH_MAX];
+        snprintf(path, sizeof(path), "%s/scanbench_touch.bin", dir);
+        FILE *f = fopen(path, "wb");
+        if (f) fclose(f);
+        ok &= run_once("changed", dir, thread_list[thread_count - 1], BENCH_CACHE_PATH, expect + 1);
+        remove(path);
+        remove(BENCH_CACHE_PATH);
+        return ok ? 0 : 1;
+    }
+    fprintf(stderr, "usage: %s gen <dir> <files> [files_per_dir] | run <dir> [threads ...]\n", argv[0]);
+    return 2;
+}
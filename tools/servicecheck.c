@@ -0,0 +1,194 @@
+// 服务初始化顺序检查（主机端）：用 service.c 的主机替身代替真实服务，按启动流程调用 service_require，
+// 检查依赖先于自身初始化、每个服务只初始化一次、没人要的服务不初始化、失败向上传递且不留半初始化状态，
+// 以及退出时按初始化的逆序释放；每个服务的初始化都应在启动追踪里留下一个阶段。全部通过时以 0 退出
+//
+// 构建：cc -O2 -Isource -o servicecheck tools/servicecheck.c source/util/service.c source/util/trace.c -lpthread
+// 用法：
+//   servicecheck
+//       依次运行各检查项，每项输出一行 ok/FAIL；-v 时另外打印每项记录到的初始化/释放序列
+#include "util/service.h"
+#include "util/trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#define CHECK_MAX_EVENTS 64
+#define EV_EXIT(id) (~(int)(id))
+
+static bool s_verbose;
+static int s_failures;
+
+static void log_stderr(const char *level, const char *fmt, va_list args) {
+    fprintf(stderr, "[%s] ", level);
+    vfprintf(stderr, fmt, args);
+    fprintf(stderr, "\n");
+}
+
+void log_info_impl(const char *file, int line, const char *fmt, ...) {
+    if (!s_verbose) return;
+    va_list args;
+    va_start(args, fmt);
+    log_stderr("INFO", fmt, args);
+    va_end(args);
+}
+
+void log_warning_impl(const char *file, int line, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    log_stderr("WARNING", fmt, args);
+    va_end(args);
+}
+
+void log_error_impl(const char *file, int line, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    log_stderr("ERROR", fmt, args);
+    va_end(args);
+}
+
+void log_debug_impl(const char *file, int line, const char *fmt, ...) {
+    (void)file; (void)line; (void)fmt;
+}
+
+static void format_events(char *out, size_t size, const int *ev, int n) {
+    size_t len = 0;
+    out[0] = '\0';
+    for (int i = 0; i < n && len < size; ++i) {
+        bool exit = ev[i] < 0;
+        int id = exit ? ~ev[i] : ev[i];
+        int w = snprintf(out + len, size - len, "%s%s%s", i ? " " : "", exit ? "~" : "", service_name((ServiceId)id));
+        if (w < 0) break;
+        len += (size_t)w;
+    }
+}
+
+// 比较替身记录的事件序列与期望序列（从第 from 个事件开始）
+static bool expect_events(const char *what, int from, const int *want, int want_n) {
+    int ev[CHECK_MAX_EVENTS];
+    int n = service_mock_events(ev, CHECK_MAX_EVENTS);
+    if (n > CHECK_MAX_EVENTS) n = CHECK_MAX_EVENTS;
+    int got_n = n - from;
+    bool ok = got_n == want_n && (want_n == 0 || memcmp(ev + from, want, sizeof(int) * (size_t)want_n) == 0);
+    if (!ok || s_verbose) {
+        char got_txt[256], want_txt[256];
+        format_events(got_txt, sizeof(got_txt), got_n > 0 ? ev + from : ev, got_n > 0 ? got_n : 0);
+        format_events(want_txt, sizeof(want_txt), want, want_n);
+        fprintf(ok ? stdout : stderr, "  %s: 实际 [%s]，期望 [%s]\n", what, got_txt, want_txt);
+    }
+    return ok;
+}
+
+static int event_count(void) {
+    int ev[1];
+    return service_mock_events(ev, 0);
+}
+
+static void report(const char *name, bool ok) {
+    printf("%-28s %s\n", name, ok ? "ok" : "FAIL");
+    if (!ok) s_failures++;
+}
+
+// 启动流程：__appInit 只要 fs（连带 sm），hid/set 没人要就不初始化
+static bool check_boot(void) {
+    service_mock_reset();
+    bool ok = R_SUCCEEDED(service_require(ServiceId_Fs));
+    static const int want[] = { ServiceId_Sm, ServiceId_Fs };
+    ok &= expect_events("boot", 0, want, 2);
+    ok &= service_is_ready(ServiceId_Sm) && service_is_ready(ServiceId_Fs);
+    ok &= !service_is_ready(ServiceId_Hid) && !service_is_ready(ServiceId_Set) && !service_is_ready(ServiceId_Nv);
+    return ok;
+}
+
+// gfx_init 按需要 NV 栈：nvFence 依赖 nv 与 nvMap，依赖先初始化，已初始化的 sm 不重复
+static bool check_lazy_deps(void) {
+    service_mock_reset();
+    bool ok = R_SUCCEEDED(service_require(ServiceId_Fs));
+    int from = event_count();
+    ok &= R_SUCCEEDED(service_require(ServiceId_NvFence));
+    static const int want[] = { ServiceId_Nv, ServiceId_NvMap, ServiceId_NvFence };
+    ok &= expect_events("nvFence", from, want, 3);
+    // 重复 require 不产生新事件
+    from = event_count();
+    ok &= R_SUCCEEDED(service_require(ServiceId_NvFence)) && R_SUCCEEDED(service_require(ServiceId_Nv));
+    ok &= expect_events("repeat", from, NULL, 0);
+    return ok;
+}
+
+// 依赖初始化失败：错误原样返回，失败的服务与依赖它的服务都不算已初始化，之后可以重试
+static bool check_failure(void) {
+    service_mock_reset();
+    Result fail = MAKERESULT(Module_Libnx, LibnxError_IoError);
+    service_mock_set_result(ServiceId_NvMap, fail);
+    Result rc = service_require(ServiceId_NvFence);
+    bool ok = rc == fail;
+    static const int want[] = { ServiceId_Sm, ServiceId_Nv, ServiceId_NvMap };
+    ok &= expect_events("failed", 0, want, 3);
+    ok &= service_is_ready(ServiceId_Nv) && !service_is_ready(ServiceId_NvMap) && !service_is_ready(ServiceId_NvFence);
+
+    // 故障消失后重试：只补初始化还没成功的部分
+    service_mock_set_result(ServiceId_NvMap, 0);
+    int from = event_count();
+    ok &= R_SUCCEEDED(service_require(ServiceId_NvFence));
+    static const int retry[] = { ServiceId_NvMap, ServiceId_NvFence };
+    ok &= expect_events("retry", from, retry, 2);
+    ok &= service_require(ServiceId_Count) == MAKERESULT(Module_Libnx, LibnxError_BadInput);
+    return ok;
+}
+
+// 退出：按实际初始化的逆序释放（不是按表中顺序），失败过的服务不释放
+static bool check_teardown(void) {
+    service_mock_reset();
+    service_mock_set_result(ServiceId_PmDmnt, MAKERESULT(Module_Libnx, LibnxError_NotFound));
+    bool ok = R_SUCCEEDED(service_require(ServiceId_Fs));
+    ok &= R_SUCCEEDED(service_require(ServiceId_Socket));
+    ok &= R_SUCCEEDED(service_require(ServiceId_NvMap));
+    ok &= R_FAILED(service_require(ServiceId_PmDmnt));
+    int from = event_count();
+    service_exit_all();
+    static const int want[] = {
+        EV_EXIT(ServiceId_NvMap), EV_EXIT(ServiceId_Nv), EV_EXIT(ServiceId_Socket),
+        EV_EXIT(ServiceId_Fs), EV_EXIT(ServiceId_Sm),
+    };
+    ok &= expect_events("exit", from, want, 5);
+    for (int i = 0; i < ServiceId_Count; ++i) ok &= !service_is_ready((ServiceId)i);
+    // 释放后可以重新初始化
+    from = event_count();
+    ok &= R_SUCCEEDED(service_require(ServiceId_Fs));
+    static const int again[] = { ServiceId_Sm, ServiceId_Fs };
+    ok &= expect_events("reinit", from, again, 2);
+    return ok;
+}
+
+// 每次初始化（含失败的）都在启动追踪里记下一个以服务名命名、已结束的阶段
+static bool check_trace(void) {
+    service_mock_reset();
+    Result fail = MAKERESULT(Module_Libnx, LibnxError_IoError);
+    service_mock_set_result(ServiceId_Socket, fail);
+    u32 first = trace_count();
+    service_require(ServiceId_Fs);
+    service_require(ServiceId_Socket);
+    static const char *const want[] = { "sm", "fs", "socket" };
+    u32 n = trace_count() - first;
+    bool ok = n == 3;
+    for (u32 i = 0; ok && i < n; ++i) {
+        TracePhase ph;
+        ok &= trace_get(first + i, &ph);
+        ok &= strcmp(ph.name, want[i]) == 0 && ph.end_tick >= ph.start_tick && ph.end_tick != 0;
+        ok &= ph.rc == (i == 2 ? fail : 0);
+    }
+    if (!ok) fprintf(stderr, "  trace: 新增 %u 个阶段，期望 3 个（sm fs socket，socket 失败）\n", n);
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    s_verbose = argc > 1 && strcmp(argv[1], "-v") == 0;
+    // 追踪最多记 TRACE_MAX_PHASES 个阶段，先检查追踪
+    report("startup trace", check_trace());
+    report("boot: fs only", check_boot());
+    report("lazy dependencies", check_lazy_deps());
+    report("failure propagation", check_failure());
+    report("teardown order", check_teardown());
+    service_mock_reset();
+    return s_failures ? 1 : 0;
+}
@@ -0,0 +1,177 @@
+// 小文件归档工具（主机端）：还原 pack_small_kb 打包上传的 .smallfiles.tar（压缩上传时为 .tar.gz）
+//
+// 构建：cc -O2 -Isource -o smallpack tools/smallpack.c source/backup/pack.c source/util/checksum.c source/util/hash.c -lz
+// 用法：
+//   smallpack unpack <tree>
+//       在从 FTP 取回的备份目录树中找出所有归档，在各自所在的目录下解开（覆盖镜像里的同名旧文件），
+//       解开后删除归档；环境变量 KEEP=1 时保留
+//   smallpack extract <archive> <dir>
+//       把一个归档解开到 dir
+//   smallpack list <archive>
+//       列出成员（大小、修改时间、路径）
+// 归档是标准 ustar 格式，也可以直接在组目录下用 tar -xf 解开
+#define _GNU_SOURCE // nftw
+#include "backup/pack.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <ftw.h>
+#include <utime.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+#define SMALLPACK_PATH_MAX 1024
+#define SMALLPACK_IO_SIZE 0x10000
+
+typedef struct {
+    u32 files;
+    u32 dirs;
+    u32 skipped;
+    u64 bytes;
+} UnpackStats;
+
+static bool read_exact(gzFile in, void *dst, size_t len) {
+    return gzread(in, dst, (unsigned)len) == (int)len;
+}
+
+// 归档里的路径不能越出目标目录
+static bool name_safe(const char *name) {
+    if (name[0] == '/' || name[0] == '\0') return false;
+    for (const char *p = name; *p;) {
+        const char *end = strchr(p, '/');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        if (len == 2 && p[0] == '.' && p[1] == '.') return false;
+        p += len;
+        while (*p == '/') p++;
+    }
+    return true;
+}
+
+static bool make_parents(char *path) {
+    for (char *p = strchr(path + 1, '/'); p; p = strchr(p + 1, '/')) {
+        *p = '\0';
+        bool ok = mkdir(path, 0755) == 0 || errno == EEXIST;
+        *p = '/';
+        if (!ok) return false;
+    }
+    return true;
+}
+
+// 逐个成员处理；dir 为 NULL 时只列出
+static int archive_walk(const char *archive, const char *dir, UnpackStats *st) {
+    gzFile in = gzopen(archive, "rb");
+    if (!in) {
+        fprintf(stderr, "无法打开 %s\n", archive);
+        return 1;
+    }
+    gzbuffer(in, SMALLPACK_IO_SIZE);
+    u8 block[PACK_BLOCK_SIZE];
+    static u8 buf[SMALLPACK_IO_SIZE];
+    char name[PACK_PREFIX_MAX + PACK_NAME_MAX + 2], path[SMALLPACK_PATH_MAX];
+    int ret = 0;
+    for (;;) {
+        if (!read_exact(in, block, sizeof(block))) {
+            fprintf(stderr, "%s：归档不完整（缺少结尾）\n", archive);
+            ret = 1;
+            break;
+        }
+        char type;
+        u64 size;
+        s64 mtime;
+        bool end;
+        if (!pack_header_parse(block, name, sizeof(name), &type, &size, &mtime, &end)) {
+            if (end) break;
+            fprintf(stderr, "%s：成员头校验失败\n", archive);
+            ret = 1;
+            break;
+        }
+        u64 padded = (size + PACK_BLOCK_SIZE - 1) / PACK_BLOCK_SIZE * PACK_BLOCK_SIZE;
+        FILE *out = NULL;
+        bool regular = type == '0' || type == '7';
+        if (!dir) {
+            printf("%12llu %12lld %s\n", (unsigned long long)size, (long long)mtime, name);
+        } else if (!name_safe(name) || snprintf(path, sizeof(path), "%s/%s", dir, name) >= (int)sizeof(path)) {
+            fprintf(stderr, "跳过不安全或过长的路径 %s\n", name);
+            st->skipped++;
+        } else if (type == '5') {
+            make_parents(path);
+            if (mkdir(path, 0755) == 0 || errno == EEXIST) st->dirs++;
+        } else if (!regular) {
+            st->skipped++;
+        } else if (!make_parents(path) || !(out = fopen(path, "wb"))) {
+            fprintf(stderr, "无法写入 %s\n", path);
+            st->skipped++;
+        }
+        for (u64 left = padded; left > 0;) {
+            size_t n = left < sizeof(buf) ? (size_t)left : sizeof(buf);
+            if (!read_exact(in, buf, n)) {
+                fprintf(stderr, "%s：%s 的内容不完整\n", archive, name);
+                ret = 1;
+                break;
+            }
+            u64 done = padded - left;
+            if (out && done < size) {
+                size_t keep = size - done < n ? (size_t)(size - done) : n;
+                if (fwrite(buf, 1, keep, out) != keep) ret = 1;
+            }
+            left -= n;
+        }
+        if (out) {
+            if (fclose(out) != 0) ret = 1;
+            struct utimbuf times = { (time_t)mtime, (time_t)mtime };
+            utime(path, &times);
+            st->files++;
+            st->bytes += size;
+        }
+        if (ret) break;
+    }
+    gzclose(in);
+    return ret;
+}
+
+static UnpackStats s_tree_stats;
+static u32 s_archives;
+static int s_tree_ret;
+
+static bool is_archive(const char *base) {
+    return strcmp(base, PACK_ARCHIVE_NAME) == 0 || strcmp(base, PACK_ARCHIVE_NAME ".gz") == 0;
+}
+
+static int unpack_entry(const char *path, const struct stat *sb, int flag, struct FTW *ftw) {
+    (void)sb;
+    if (flag != FTW_F || !is_archive(path + ftw->base)) return 0;
+    char dir[SMALLPACK_PATH_MAX];
+    snprintf(dir, sizeof(dir), "%.*s", ftw->base > 0 ? ftw->base - 1 : 0, path);
+    if (!dir[0]) strcpy(dir, ".");
+    if (archive_walk(path, dir, &s_tree_stats) != 0) {
+        s_tree_ret = 1;
+        return 0;
+    }
+    s_archives++;
+    if (!getenv("KEEP")) remove(path);
+    return 0;
+}
+
+static int cmd_unpack(const char *tree) {
+    if (nftw(tree, unpack_entry, 16, FTW_PHYS) != 0) {
+        fprintf(stderr, "无法遍历 %s\n", tree);
+        return 1;
+    }
+    fprintf(stderr, "解开 %u 个归档：%u 个文件（%llu 字节），%u 个目录，跳过 %u\n", s_archives, s_tree_stats.files,
+            (unsigned long long)s_tree_stats.bytes, s_tree_stats.dirs, s_tree_stats.skipped);
+    return s_tree_ret;
+}
+
+int main(int argc, char **argv) {
+    if (argc == 3 && strcmp(argv[1], "unpack") == 0) return cmd_unpack(argv[2]);
+    if (argc == 4 && strcmp(argv[1], "extract") == 0) {
+        UnpackStats st = {0};
+        int ret = archive_walk(argv[2], argv[3], &st);
+        fprintf(stderr, "%u 个文件（%llu 字节），跳过 %u\n", st.files, (unsigned long long)st.bytes, st.skipped);
+        return ret;
+    }
+    if (argc == 3 && strcmp(argv[1], "list") == 0) return archive_walk(argv[2], NULL, NULL);
+    fprintf(stderr, "用法:\n  %s unpack <tree>\n  %s extract <archive> <dir>\n  %s list <archive>\n", argv[0], argv[0], argv[0]);
+    return 1;
+}
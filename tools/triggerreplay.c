@@ -0,0 +1,232 @@
+// 触发引擎回放工具（主机端）：把合成的事件流喂给触发引擎，输出何时触发了备份、每次合并了哪些事件
+//
+// 构建：cc -O2 -Isource -o triggerreplay tools/triggerreplay.c source/backup/trigger.c source/util/hash.c source/util/fspool.c source/util/service.c source/util/trace.c -lpthread
+// 用法：
+//   triggerreplay run <script> [debounce_ms] [max_delay_ms] [run_ms]
+//       按真实时间回放：引擎线程照常阻塞等待，备份用 sleep run_ms 代替；结束时输出唤醒次数与引擎线程用掉的 CPU 时间
+//   triggerreplay sim <script> [debounce_ms] [max_delay_ms] [run_ms]
+//       按虚拟时间直接驱动去抖状态机，立即输出结果（与 run 的触发时刻应一致，误差在毫秒级）
+//   triggerreplay gen <bursts> [seed]
+//       生成一段随机事件流：若干阵存档目录变化与应用退出，阵内事件间隔几百毫秒，阵间隔数秒
+// 脚本每行为 "<毫秒> <startup|manual|title|dir|schedule>"，# 开头为注释，时间须递增
+#include "backup/trigger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+
+#define REPLAY_MAX_EVENTS 4096
+
+static void log_stderr(const char *level, const char *fmt, va_list args) {
+    fprintf(stderr, "[%s] ", level);
+    vfprintf(stderr, fmt, args);
+    fprintf(stderr, "\n");
+}
+
+void log_info_impl(const char *file, int line, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    log_stderr("INFO", fmt, args);
+    va_end(args);
+}
+
+void log_warning_impl(const char *file, int line, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    log_stderr("WARNING", fmt, args);
+    va_end(args);
+}
+
+void log_error_impl(const char *file, int line, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    log_stderr("ERROR", fmt, args);
+    va_end(args);
+}
+
+void log_debug_impl(const char *file, int line, const char *fmt, ...) {
+}
+
+static const char *const s_kind_keys[TriggerKind_Count] = { "startup", "manual", "title", "dir", "schedule" };
+
+typedef struct {
+    u64 ms;
+    TriggerKind kind;
+} ReplayEvent;
+
+typedef struct {
+    ReplayEvent events[REPLAY_MAX_EVENTS];
+    u32 count;
+    u32 next;
+    u64 base_tick;
+    u64 stop_tick;
+    TriggerEngine *engine;
+} Replay;
+
+typedef struct {
+    u64 base_tick;
+    u64 run_ms;
+    u32 runs;
+} RunState;
+
+static bool load_script(Replay *r, const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) return false;
+    char line[128], key[32];
+    unsigned long long ms;
+    while (fgets(line, sizeof(line), f) && r->count < REPLAY_MAX_EVENTS) {
+        if (line[0] == '#' || sscanf(line, "%llu %31s", &ms, key) != 2) continue;
+        for (int k = 0; k < TriggerKind_Count; ++k) {
+            if (strcmp(key, s_kind_keys[k]) != 0) continue;
+            r->events[r->count++] = (ReplayEvent){ ms, (TriggerKind)k };
+            break;
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+static u64 ms_ticks(u64 ms) {
+    return armNsToTicks(ms * 1000000ULL);
+}
+
+static void print_batch(u64 at_ms, u32 index, const TriggerBatch *b, u64 base_tick) {
+    printf("#%-3u %8llu ms  合并 %3u 个事件（", index, (unsigned long long)at_ms, b->total);
+    bool first = true;
+    for (int k = 0; k < TriggerKind_Count; ++k) {
+        if (!b->counts[k]) continue;
+        printf("%s%s×%u", first ? "" : " ", s_kind_keys[k], b->counts[k]);
+        first = false;
+    }
+    printf("），首个事件在 %llu ms\n", (unsigned long long)(armTicksToNs(b->first_tick - base_tick) / 1000000));
+}
+
+// ---- run：真实时间，回放源只靠 next_deadline 唤醒引擎 ----
+
+static u32 replay_poll(void *ctx, u64 now, TriggerEvent *out, u32 max) {
+    Replay *r = ctx;
+    u32 n = 0;
+    while (r->next < r->count && n < max) {
+        u64 tick = r->base_tick + ms_ticks(r->events[r->next].ms);
+        if (tick > now) break;
+        out[n++] = (TriggerEvent){ r->events[r->next].kind, tick };
+        r->next++;
+    }
+    if (r->next >= r->count && now >= r->stop_tick) trigger_engine_stop(r->engine);
+    return n;
+}
+
+static u64 replay_deadline(void *ctx, u64 now) {
+    Replay *r = ctx;
+    if (r->next < r->count) return r->base_tick + ms_ticks(r->events[r->next].ms);
+    return r->stop_tick;
+}
+
+static void replay_on_run(void *user, const TriggerBatch *batch) {
+    RunState *s = user;
+    u64 now = armGetSystemTick();
+    print_batch(armTicksToNs(now - s->base_tick) / 1000000, ++s->runs, batch, s->base_tick);
+    fflush(stdout);
+    svcSleepThread((s64)(s->run_ms * 1000000ULL));
+}
+
+static double thread_cpu_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
+}
+
+static int cmd_run(Replay *r, const TriggerPolicy *policy, u64 run_ms) {
+    static TriggerEngine engine;
+    if (R_FAILED(trigger_engine_init(&engine, policy))) return 1;
+    r->engine = &engine;
+    r->base_tick = armGetSystemTick();
+    // 最后一个事件之后：至多等一个安静期，再加上可能还在进行和随后的一次备份
+    u64 last_ms = r->count ? r->events[r->count - 1].ms : 0;
+    r->stop_tick = r->base_tick + ms_ticks(last_ms + 2 * run_ms + 100) + armNsToTicks(policy->debounce_ns);
+    TriggerSource src = {
+        .name = "replay",
+        .ctx = r,
+        .poll = replay_poll,
+        .next_deadline = replay_deadline,
+    };
+    trigger_engine_add_source(&engine, &src);
+
+    RunState state = { r->base_tick, run_ms, 0 };
+    double cpu0 = thread_cpu_ms();
+    trigger_engine_run(&engine, replay_on_run, &state);
+    double cpu = thread_cpu_ms() - cpu0;
+    TriggerStats st;
+    trigger_engine_stats(&engine, &st);
+    trigger_engine_exit(&engine);
+    double wall = (double)armTicksToNs(armGetSystemTick() - r->base_tick) / 1e6;
+    printf("事件 %llu 个 -> 备份 %llu 次（合并 %llu 个），唤醒 %llu 次；%.0f ms 内引擎线程 CPU %.2f ms（不含模拟备份）\n",
+           (unsigned long long)st.events, (unsigned long long)st.runs, (unsigned long long)st.coalesced,
+           (unsigned long long)st.wakeups, wall, cpu);
+    return 0;
+}
+
+// ---- sim：虚拟时间 ----
+
+static int cmd_sim(Replay *r, const TriggerPolicy *policy, u64 run_ms) {
+    TriggerDebounce d;
+    memset(&d, 0, sizeof(d));
+    const u64 base = 1;          // 虚拟 tick 从 1 开始（0 表示无）
+    u64 busy_until = 0;          // 模拟备份结束的 tick
+    u32 runs = 0, i = 0;
+    for (;;) {
+        u64 next_event = i < r->count ? base + ms_ticks(r->events[i].ms) : 0;
+        u64 ready = d.due_tick > busy_until ? d.due_tick : busy_until;
+        // 引擎在备份期间不取事件：先处理此刻之前的事件，再看去抖是否到期
+        if (next_event && (!d.due_tick || next_event <= ready)) {
+            TriggerEvent ev = { r->events[i].kind, next_event };
+            trigger_debounce_feed(&d, policy, &ev);
+            i++;
+            continue;
+        }
+        if (!d.due_tick) break;
+        TriggerBatch b;
+        trigger_debounce_take(&d, ready, &b);
+        print_batch(armTicksToNs(ready - base) / 1000000, ++runs, &b, base);
+        busy_until = ready + ms_ticks(run_ms);
+    }
+    printf("事件 %u 个 -> 备份 %u 次\n", r->count, runs);
+    return 0;
+}
+
+static int cmd_gen(u32 bursts, u32 seed) {
+    srand(seed);
+    u64 t = 500;
+    printf("0 startup\n");
+    for (u32 b = 0; b < bursts; ++b) {
+        t += 2000 + (u64)(rand() % 8000);
+        if (rand() % 3 == 0) printf("%llu title\n", (unsigned long long)t);
+        u32 n = 1 + (u32)(rand() % 6);
+        for (u32 k = 0; k < n; ++k) {
+            t += 100 + (u64)(rand() % 600);
+            printf("%llu dir\n", (unsigned long long)t);
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc >= 3 && strcmp(argv[1], "gen") == 0) return cmd_gen((u32)atoi(argv[2]), argc > 3 ? (u32)atoi(argv[3]) : 1);
+    if (argc < 3 || (strcmp(argv[1], "run") != 0 && strcmp(argv[1], "sim") != 0)) {
+        fprintf(stderr, "用法:\n  %s run|sim <script> [debounce_ms] [max_delay_ms] [run_ms]\n  %s gen <bursts> [seed]\n",
+                argv[0], argv[0]);
+        return 1;
+    }
+    static Replay replay;
+    if (!load_script(&replay, argv[2])) {
+        fprintf(stderr, "无法读取 %s\n", argv[2]);
+        return 1;
+    }
+    TriggerPolicy policy = {
+        .debounce_ns = (argc > 3 ? strtoull(argv[3], NULL, 10) : 1000) * 1000000ULL,
+        .max_delay_ns = (argc > 4 ? strtoull(argv[4], NULL, 10) : 5000) * 1000000ULL,
+    };
+    u64 run_ms = argc > 5 ? strtoull(argv[5], NULL, 10) : 0;
+    return strcmp(argv[1], "run") == 0 ? cmd_run(&replay, &policy, run_ms) : cmd_sim(&replay, &policy, run_ms);
+}